@@ -11,6 +11,7 @@
 #include "stdafx.h"
 #include "cCertVerifier.hpp"
 #include <windows.h>  // NEVER include windows.h in a header file in a Managed C++ project !!
+#include <map>
 
 #pragma unmanaged
 
@@ -19,6 +20,20 @@ using namespace std;
 namespace vmime   {
 namespace wrapper {
 
+// The verifiers are shared by all connections, so the root certificates are loaded and indexed only once
+// and the certificate chains which have already been verified are not verified again.
+class cVerifierCache
+{
+public:
+    cVerifierCache()  { InitializeCriticalSection(&mk_Lock); }
+    ~cVerifierCache() { DeleteCriticalSection(&mk_Lock); }
+
+    CRITICAL_SECTION mk_Lock;
+    std::map<int, ref<cCertVerifier> > mi_Verifiers; // key = resource ID and b_AllowInvalidCerts
+};
+
+static cVerifierCache gi_VerifierCache;
+
 // u16_ResIdCert = The IDR identifier in the RCDATA Resources of "RootCA.txt". (IDR_ROOT_CA)
 // If the server sends a certificate that is not signed with a root certificate:
 // b_AllowInvalidCerts = true  -> only write an ERROR to the Trace output.
@@ -47,6 +62,33 @@ cCertVerifier::cCertVerifier(bool b_AllowInvalidCerts, vmime_uint16 u16_ResIdCer
     mb_InitDone          = false;
 }
 
+// static
+ref <cCertVerifier> cCertVerifier::GetInstance(bool b_AllowInvalidCerts, vmime_uint16 u16_ResIdCert)
+{
+    int s32_Key = (u16_ResIdCert << 1) | (b_AllowInvalidCerts ? 1 : 0);
+
+    EnterCriticalSection(&gi_VerifierCache.mk_Lock);
+    try
+    {
+        ref <cCertVerifier>& i_Verifier = gi_VerifierCache.mi_Verifiers[s32_Key];
+        if (!i_Verifier)
+        {
+            i_Verifier = create<cCertVerifier>(b_AllowInvalidCerts, u16_ResIdCert);
+            i_Verifier->Init();
+        }
+
+        ref <cCertVerifier> i_Result = i_Verifier;
+        LeaveCriticalSection(&gi_VerifierCache.mk_Lock);
+        return i_Result;
+    }
+    catch (...)
+    {
+        gi_VerifierCache.mi_Verifiers.erase(s32_Key);
+        LeaveCriticalSection(&gi_VerifierCache.mk_Lock);
+        throw;
+    }
+}
+
 void cCertVerifier::verify(ref <cert::certificateChain> chain, const string& hostname)
 {
     #if VMIME_TRACE
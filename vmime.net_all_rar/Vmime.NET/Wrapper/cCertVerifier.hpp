@@ -27,6 +27,9 @@ class cCertVerifier : public cert::defaultCertificateVerifier
 public:
     cCertVerifier(bool b_AllowInvalidCerts, vmime_uint16 u16_ResIdCert);
 
+    // Returns a verifier that is shared by all connections with the same parameters
+    static ref <cCertVerifier> GetInstance(bool b_AllowInvalidCerts, vmime_uint16 u16_ResIdCert);
+
     // overrides virtual function in base class
 	void verify(ref <cert::certificateChain> chain, const string& hostname);
 
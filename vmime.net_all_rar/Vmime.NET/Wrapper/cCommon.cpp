@@ -84,10 +84,63 @@ namespace wrapper {
 //                                     Common
 // ######################################################################################
 
-// Cancels any lengthy operation (communication with the server)
+// The tokens of all living cImap, cPop3 and cSmtp instances.
+// Each instance cancels only its own operations, CancelOperation() cancels all of them.
+class cCancelTokens
+{
+public:
+    cCancelTokens()  { InitializeCriticalSection(&mk_Lock); }
+    ~cCancelTokens() { DeleteCriticalSection(&mk_Lock); }
+
+    CRITICAL_SECTION mk_Lock;
+    vector<ref<utility::cancellationToken>> mi_Tokens;
+};
+
+static cCancelTokens gi_CancelTokens;
+
+// Cancels any lengthy operation (communication with the server) of all connections
 void cCommon::CancelOperation()
 {
-    platform::handler::setCancelFlag(true);
+    EnterCriticalSection(&gi_CancelTokens.mk_Lock);
+
+    for (size_t i=0; i<gi_CancelTokens.mi_Tokens.size(); i++)
+    {
+        gi_CancelTokens.mi_Tokens.at(i)->cancel();
+    }
+
+    LeaveCriticalSection(&gi_CancelTokens.mk_Lock);
+}
+
+// static
+// Creates the token of a new cImap, cPop3 or cSmtp instance
+ref <utility::cancellationToken> cCommon::CreateCancelToken()
+{
+    ref <utility::cancellationToken> i_Token = platform::getHandler()->createCancellationToken();
+
+    EnterCriticalSection(&gi_CancelTokens.mk_Lock);
+    gi_CancelTokens.mi_Tokens.push_back(i_Token);
+    LeaveCriticalSection(&gi_CancelTokens.mk_Lock);
+
+    return i_Token;
+}
+
+// static
+// Must be called by the destructor of the instance that has created the token
+void cCommon::ReleaseCancelToken(ref <utility::cancellationToken> i_Token)
+{
+    EnterCriticalSection(&gi_CancelTokens.mk_Lock);
+
+    vector<ref<utility::cancellationToken>>& i_Tokens = gi_CancelTokens.mi_Tokens;
+    for (size_t i=0; i<i_Tokens.size(); i++)
+    {
+        if (i_Tokens.at(i) == i_Token)
+        {
+            i_Tokens.erase(i_Tokens.begin() + i);
+            break;
+        }
+    }
+
+    LeaveCriticalSection(&gi_CancelTokens.mk_Lock);
 }
 
 // ######################################################################################
@@ -97,10 +150,12 @@ void cCommon::CancelOperation()
 // u32_Interval = Interval (in ms) in which progress is written to Trace output
 // u32_Interval = 0 -> trace all
 // s8_Protocol = "SMTP", "POP3" or "IMAP"
-TraceProgress::TraceProgress(vmime_uint32 u32_Interval, const char* s8_Protocol)
+// i_CancelToken = the token of the connection, which aborts the transfer when cancelled
+TraceProgress::TraceProgress(vmime_uint32 u32_Interval, const char* s8_Protocol, ref <utility::cancellationToken> i_CancelToken)
 {
-    mu32_Interval = u32_Interval;
-    ms_Protocol   = s8_Protocol;
+    mu32_Interval  = u32_Interval;
+    ms_Protocol    = s8_Protocol;
+    mi_CancelToken = i_CancelToken;
 }
 
 // This function is implemented in vmime but it is never called -> useless
@@ -112,7 +167,7 @@ bool TraceProgress::cancel() const
 void TraceProgress::start(const long predictedTotal)
 {
     // Throw exception if the user has canceled
-    platform::handler::checkCanceled();
+    mi_CancelToken->check();
 
     #if VMIME_TRACE
         TRACE("%s Message transfer starting.", ms_Protocol.c_str());
@@ -123,7 +178,7 @@ void TraceProgress::start(const long predictedTotal)
 void TraceProgress::progress(const long current, const long currentTotal)
 {
     // Throw exception if the user has canceled
-    platform::handler::checkCanceled();
+    mi_CancelToken->check();
 
     #if VMIME_TRACE
         if (currentTotal == 0)
@@ -151,24 +206,37 @@ void TraceProgress::stop(const long total)
 //                                     Timeout
 // ######################################################################################
 
+// GetTickCount() is monotonic (not affected by changes of the system clock)
+// and the unsigned subtraction gives the right result when it wraps around.
 TimeoutHandler::TimeoutHandler()
 {
-    m_Interval = TRANSFER_TIMEOUT;
+    mu32_Interval = TRANSFER_TIMEOUT * 1000;
+    mu32_LastTick = GetTickCount();
 }
 
 void TimeoutHandler::ModifyInterval(int s32_Timeout) // Seconds
 {
-    m_Interval = (time_t)s32_Timeout;
+    mu32_Interval = (vmime_uint32)s32_Timeout * 1000;
 }
 
 void TimeoutHandler::resetTimeOut()
 {
-    m_LastUnix = ::time(NULL);
+    mu32_LastTick = GetTickCount();
 }
 
 bool TimeoutHandler::isTimeOut()
 {
-    return (::time(NULL) - m_LastUnix >= m_Interval);
+    return (GetTickCount() - mu32_LastTick >= mu32_Interval);
+}
+
+// The sockets block until this deadline instead of polling isTimeOut()
+unsigned int TimeoutHandler::getRemainingTime()
+{
+    vmime_uint32 u32_Elapsed = GetTickCount() - mu32_LastTick;
+    if (u32_Elapsed >= mu32_Interval)
+        return 0;
+
+    return mu32_Interval - u32_Elapsed;
 }
 
 bool TimeoutHandler::handleTimeOut()
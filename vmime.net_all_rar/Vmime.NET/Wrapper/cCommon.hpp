@@ -41,12 +41,16 @@ public:
     };
 
     static void CancelOperation();
+
+    // Each cImap, cPop3 and cSmtp instance registers its own token, so CancelOperation() reaches all of them
+    static ref <utility::cancellationToken> CreateCancelToken();
+    static void ReleaseCancelToken(ref <utility::cancellationToken> i_Token);
 };
 
 class TraceProgress : public utils::progressListener
 {
 public:
-    TraceProgress(vmime_uint32 u32_Interval, const char* s8_Protocol);
+    TraceProgress(vmime_uint32 u32_Interval, const char* s8_Protocol, ref <utility::cancellationToken> i_CancelToken);
     bool cancel() const;
     void start(const long predictedTotal);
     void progress(const long current, const long currentTotal);
@@ -56,6 +60,7 @@ private:
     vmime_uint32 mu32_LastTick;
     vmime_uint32 mu32_Interval;
     string       ms_Protocol;
+    ref <utility::cancellationToken> mi_CancelToken;
 };
 
 class TimeoutHandler : public net::timeoutHandler
@@ -66,10 +71,11 @@ public:
     void resetTimeOut();
     bool isTimeOut();
     bool handleTimeOut();
+    unsigned int getRemainingTime();
 
 private:
-    time_t m_LastUnix;
-    time_t m_Interval;
+    vmime_uint32 mu32_LastTick;
+    vmime_uint32 mu32_Interval; // milliseconds
 };
 
 
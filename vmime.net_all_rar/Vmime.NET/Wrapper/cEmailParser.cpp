@@ -506,7 +506,7 @@ void cEmailParser::RetrieveEntireMessage()
 	std::ostringstream i_Stream;
 	utility::outputStreamAdapter i_Adapt(i_Stream);
 
-    TraceProgress i_Progress(1000, ms_Protocol.c_str()); // Trace progress once a second
+    TraceProgress i_Progress(1000, ms_Protocol.c_str(), mi_Folder->getStore()->getCancellationToken()); // Trace progress once a second
 
     // This connects to the server and downloads the entire message (which may be slow for large emails)
     mi_MsgHead->extract(i_Adapt, &i_Progress);
@@ -35,10 +35,13 @@ cImap::cImap(const wchar_t* u16_Server, vmime_uint16 u16_Port, cCommon::eSecurit
     mu16_ResIdCert = u16_ResIdCert;
     ms_Folder      = L"INBOX";
     mb_AllowInvalidCerts = b_AllowInvalidCerts;
+    mi_CancelToken       = cCommon::CreateCancelToken();
 }
 
 cImap::~cImap()
 {
+    cCommon::ReleaseCancelToken(mi_CancelToken);
+
     // Erase password from memory
     memset((void*)ms_Password.c_str(), 0, ms_Password.length());
 }
@@ -49,6 +52,13 @@ void cImap::SetAuthData(const wchar_t* u16_User, const wchar_t* u16_Password)
     ms_Password = UTF(u16_Password);
 }
 
+// Aborts the current operation (communication with the server) of this instance -> throws exception
+// This is the only function which may be called from another thread.
+void cImap::Cancel()
+{
+    mi_CancelToken->cancel();
+}
+
 // Disconect from the server
 void cImap::Close()
 {
@@ -88,10 +98,14 @@ void cImap::Connect()
 
     ref<net::store> i_NewStore = mi_Session->getStore(i_Url);
 
-    ref <cCertVerifier> i_Verifier = create<cCertVerifier>(mb_AllowInvalidCerts, mu16_ResIdCert);
+    ref <cCertVerifier> i_Verifier = cCertVerifier::GetInstance(mb_AllowInvalidCerts, mu16_ResIdCert);
     i_NewStore->setCertificateVerifier(i_Verifier);
     i_NewStore->setTimeoutHandlerFactory(create<TimeoutFactory>());
 
+    // A previous Cancel() must not abort the new connection
+    mi_CancelToken->reset();
+    i_NewStore->setCancellationToken(mi_CancelToken);
+
     if (ms_User.length() || ms_Password.length())
     {
         i_NewStore->setProperty("options.need-authentication", true);
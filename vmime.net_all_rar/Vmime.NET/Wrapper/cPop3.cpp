@@ -34,10 +34,13 @@ cPop3::cPop3(const wchar_t* u16_Server, vmime_uint16 u16_Port, cCommon::eSecurit
     me_Security    = e_Security;
     mu16_ResIdCert = u16_ResIdCert;
     mb_AllowInvalidCerts = b_AllowInvalidCerts;
+    mi_CancelToken       = cCommon::CreateCancelToken();
 }
 
 cPop3::~cPop3()
 {
+    cCommon::ReleaseCancelToken(mi_CancelToken);
+
     // Erase password from memory
     memset((void*)ms_Password.c_str(), 0, ms_Password.length());
 }
@@ -48,6 +51,13 @@ void cPop3::SetAuthData(const wchar_t* u16_User, const wchar_t* u16_Password)
     ms_Password = UTF(u16_Password);
 }
 
+// Aborts the current operation (communication with the server) of this instance -> throws exception
+// This is the only function which may be called from another thread.
+void cPop3::Cancel()
+{
+    mi_CancelToken->cancel();
+}
+
 // Close()must be called explicitely, otherwise messages marked as deleted are not expunged from the server.
 void cPop3::Close()
 {
@@ -86,10 +96,14 @@ void cPop3::Connect()
     mi_Session = create <net::session>();
     mi_Store   = mi_Session->getStore(i_Url);
 
-    ref <cCertVerifier> i_Verifier = create<cCertVerifier>(mb_AllowInvalidCerts, mu16_ResIdCert);
+    ref <cCertVerifier> i_Verifier = cCertVerifier::GetInstance(mb_AllowInvalidCerts, mu16_ResIdCert);
     mi_Store->setCertificateVerifier(i_Verifier);
     mi_Store->setTimeoutHandlerFactory(create<TimeoutFactory>());
 
+    // A previous Cancel() must not abort the new connection
+    mi_CancelToken->reset();
+    mi_Store->setCancellationToken(mi_CancelToken);
+
     if (ms_User.length() || ms_Password.length())
     {
         mi_Store->setProperty("options.need-authentication", true);
@@ -26,6 +26,7 @@ public:
     virtual ~cPop3();
 
     void SetAuthData(const wchar_t* u16_User, const wchar_t* u16_Password);
+    void Cancel();
 
     int           GetEmailCount();
     cEmailParser* FetchEmailAt(int s32_Index);
@@ -41,6 +42,7 @@ private:
     cCommon::eSecurity me_Security;
     vmime_uint16       mu16_ResIdCert;
     bool               mb_AllowInvalidCerts;
+    ref<utility::cancellationToken> mi_CancelToken;
     ref<net::session>  mi_Session;
 	ref<net::store>    mi_Store;
     ref<net::folder>   mi_Inbox;
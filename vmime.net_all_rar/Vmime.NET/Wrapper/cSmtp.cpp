@@ -34,10 +34,13 @@ cSmtp::cSmtp(const wchar_t* u16_Server, vmime_uint16 u16_Port, cCommon::eSecurit
     me_Security    = e_Security;
     mu16_ResIdCert = u16_ResIdCert;
     mb_AllowInvalidCerts = b_AllowInvalidCerts;
+    mi_CancelToken       = cCommon::CreateCancelToken();
 }
 
 cSmtp::~cSmtp()
 {
+    cCommon::ReleaseCancelToken(mi_CancelToken);
+
     // Erase password from memory
     memset((void*)ms_Password.c_str(), 0, ms_Password.length());
 }
@@ -48,6 +51,13 @@ void cSmtp::SetAuthData(const wchar_t* u16_User, const wchar_t* u16_Password)
     ms_Password = UTF(u16_Password);
 }
 
+// Aborts the current operation (communication with the server) of this instance -> throws exception
+// This is the only function which may be called from another thread.
+void cSmtp::Cancel()
+{
+    mi_CancelToken->cancel();
+}
+
 // throws
 void cSmtp::Send(cEmailBuilder* pi_Email)
 {
@@ -70,10 +80,14 @@ void cSmtp::Send(cEmailBuilder* pi_Email)
         ref <net::session>   i_Session = create <net::session>();
 	    ref <net::transport> i_Transp  = i_Session->getTransport(i_Url);
 
-        ref <cCertVerifier> i_Verifier = create<cCertVerifier>(mb_AllowInvalidCerts, mu16_ResIdCert);
+        ref <cCertVerifier> i_Verifier = cCertVerifier::GetInstance(mb_AllowInvalidCerts, mu16_ResIdCert);
         i_Transp->setCertificateVerifier(i_Verifier);
         i_Transp->setTimeoutHandlerFactory(create<TimeoutFactory>());
 
+        // A previous Cancel() must not abort the new connection
+        mi_CancelToken->reset();
+        i_Transp->setCancellationToken(mi_CancelToken);
+
         if (ms_User.length() || ms_Password.length())
         {
             i_Transp->setProperty("options.need-authentication", true);
@@ -91,7 +105,7 @@ void cSmtp::Send(cEmailBuilder* pi_Email)
 
         // "options.sasl.fallback" not available for SMTP
 
-        TraceProgress i_Progress(1000, "SMTP"); // Trace progress once a second
+        TraceProgress i_Progress(1000, "SMTP", mi_CancelToken); // Trace progress once a second
 
         #if VMIME_TRACE
             TRACE("SMTP Using vmime %s", VMIME_VERSION);
@@ -26,6 +26,7 @@ public:
     virtual ~cSmtp();
 
     void SetAuthData(const wchar_t* u16_User, const wchar_t* u16_Password);
+    void Cancel();
     void Send(cEmailBuilder* pi_Email);
     
 private:
@@ -36,6 +37,7 @@ private:
     cCommon::eSecurity me_Security;
     vmime_uint16       mu16_ResIdCert;
     bool               mb_AllowInvalidCerts;
+    ref<utility::cancellationToken> mi_CancelToken;
 };
 
 } // namespace wrapper
@@ -38,6 +38,8 @@
 #include "../vmime/stringContentHandler.hpp"
 #include "../vmime/streamContentHandler.hpp"
 
+#include <algorithm>
+
 
 namespace vmime
 {
@@ -424,6 +426,22 @@ void body::generateImpl
 	(const generationContext& ctx, utility::outputStream& os,
 	 const string::size_type /* curLinePos */, string::size_type* newLinePos) const
 {
+	std::vector <encoding> encodings;
+	getGenerationEncodings(ctx, encodings);
+
+	size_t index = 0;
+	generateBody(ctx, os, encodings, index);
+
+	if (newLinePos && getPartCount() != 0)
+		*newLinePos = 0;
+}
+
+
+void body::generateBody(const generationContext& ctx, utility::outputStream& os,
+	const std::vector <encoding>& encodings, size_t& index) const
+{
+	const encoding& enc = encodings[index++];
+
 	// MIME-Multipart
 	if (getPartCount() != 0)
 	{
@@ -472,7 +490,7 @@ void body::generateImpl
 		{
 			os << CRLF;
 
-			getPartAt(p)->generate(ctx, os, 0);
+			getPartAt(p)->generatePart(ctx, os, encodings, index);
 
 			os << CRLF << "--" << boundary;
 		}
@@ -486,9 +504,6 @@ void body::generateImpl
 
 			os << CRLF;
 		}
-
-		if (newLinePos)
-			*newLinePos = 0;
 	}
 	// Simple body
 	else
@@ -497,13 +512,176 @@ void body::generateImpl
 		ref <contentHandler> contents = m_contents->clone();
 		contents->setContentTypeHint(getContentType());
 
-		contents->generate(os, getEncoding(), ctx.getMaxLineLength());
+		contents->generate(os, enc, ctx.getMaxLineLength());
+	}
+}
+
+
+#ifndef VMIME_BUILDING_DOC
+
+// Checks whether data can be transmitted as "8bit" (RFC-2045, 2.8):
+// no NUL character, CR and LF only as part of CRLF sequences, and
+// lines of at most 998 octets, excluding CRLF
+class body_eightBitChecker : public utility::outputStream
+{
+public:
+
+	body_eightBitChecker()
+		: m_valid(true), m_has8bit(false), m_afterCR(false), m_lineLength(0)
+	{
+	}
+
+	void write(const value_type* const data, const size_type count)
+	{
+		for (size_type i = 0 ; m_valid && i < count ; ++i)
+		{
+			const unsigned char c = static_cast <unsigned char>(data[i]);
+
+			if (m_afterCR)
+			{
+				m_valid = (c == '\n');
+				m_afterCR = false;
+				m_lineLength = 0;
+			}
+			else if (c == '\r')
+			{
+				m_afterCR = true;
+			}
+			else if (c == '\n' || c == 0 || ++m_lineLength > 998)
+			{
+				m_valid = false;
+			}
+			else if (c >= 128)
+			{
+				m_has8bit = true;
+			}
+		}
 	}
+
+	void flush()
+	{
+	}
+
+	bool isValid() const { return m_valid && !m_afterCR; }
+	bool has8bit() const { return m_has8bit; }
+
+private:
+
+	bool m_valid;
+	bool m_has8bit;
+	bool m_afterCR;
+	size_type m_lineLength;
+};
+
+
+// Rank of the identity encodings, from the most restrictive
+// to the least restrictive, or -1 for other encodings
+static int body_getIdentityRank(const encoding& enc)
+{
+	if (enc == encoding(encodingTypes::SEVEN_BIT))
+		return 0;
+	else if (enc == encoding(encodingTypes::EIGHT_BIT))
+		return 1;
+	else if (enc == encoding(encodingTypes::BINARY))
+		return 2;
+
+	return -1;
+}
+
+
+static const encoding body_getIdentityEncoding(const int rank)
+{
+	if (rank == 2)
+		return encoding(encodingTypes::BINARY);
+	else if (rank == 1)
+		return encoding(encodingTypes::EIGHT_BIT);
+
+	return encoding(encodingTypes::SEVEN_BIT);
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
+const encoding body::getGenerationEncodings
+	(const generationContext& ctx, std::vector <encoding>& encodings) const
+{
+	const encoding enc = getEncoding();
+	const generationContext::TransferEncodingSupport support = ctx.getTransferEncodingSupport();
+
+	const size_t index = encodings.size();
+	encodings.push_back(enc);
+
+	// MIME-Multipart: the encoding must not be more restrictive than
+	// the encoding of any of the parts (RFC-2045, 6.4)
+	if (getPartCount() != 0)
+	{
+		int rank = body_getIdentityRank(enc);
+
+		for (size_t p = 0 ; p < getPartCount() ; ++p)
+		{
+			const encoding partEnc = getPartAt(p)->getBody()->getGenerationEncodings(ctx, encodings);
+
+			rank = std::max(rank, body_getIdentityRank(partEnc));
+		}
+
+		// Only an identity encoding is valid for a multipart entity
+		if (support != generationContext::TRANSFER_7BIT &&
+		    body_getIdentityRank(enc) >= 0 && rank > body_getIdentityRank(enc))
+		{
+			encodings[index] = body_getIdentityEncoding(rank);
+		}
+
+		return encodings[index];
+	}
+
+	if (support == generationContext::TRANSFER_7BIT)
+		return enc;
+
+	// Only contents which would be encoded for 7-bit transport can be relaxed
+	if (enc != encoding(encodingTypes::BASE64) &&
+	    enc != encoding(encodingTypes::QUOTED_PRINTABLE))
+	{
+		return enc;
+	}
+
+	if (support == generationContext::TRANSFER_BINARY)
+	{
+		encodings[index] = encoding(encodingTypes::BINARY);
+		return encodings[index];
+	}
+
+	// 8-bit transport: only text can be sent as is, if it is made of valid lines
+	if (getContentType().getType() != mediaTypes::TEXT || !m_contents->isBuffered())
+		return enc;
+
+	body_eightBitChecker checker;
+	m_contents->extract(checker);
+
+	if (!checker.isValid())
+		return enc;
+
+	encodings[index] = encoding(checker.has8bit() ? encodingTypes::EIGHT_BIT : encodingTypes::SEVEN_BIT);
+
+	return encodings[index];
 }
 
 
 utility::stream::size_type body::getGeneratedSize(const generationContext& ctx)
 {
+	std::vector <encoding> encodings;
+	getGenerationEncodings(ctx, encodings);
+
+	size_t index = 0;
+
+	return getGeneratedBodySize(ctx, encodings, index);
+}
+
+
+utility::stream::size_type body::getGeneratedBodySize(const generationContext& ctx,
+	const std::vector <encoding>& encodings, size_t& index)
+{
+	const encoding& enc = encodings[index++];
+
 	// MIME-Multipart
 	if (getPartCount() != 0)
 	{
@@ -513,7 +691,7 @@ utility::stream::size_type body::getGeneratedSize(const generationContext& ctx)
 		for (size_t p = 0 ; p < getPartCount() ; ++p)
 		{
 			size += 100;  // boundary, CRLF...
-			size += getPartAt(p)->getGeneratedSize(ctx);
+			size += getPartAt(p)->getGeneratedPartSize(ctx, encodings, index);
 		}
 
 		// Size of prolog/epilog text
@@ -549,7 +727,7 @@ utility::stream::size_type body::getGeneratedSize(const generationContext& ctx)
 	else
 	{
 		ref <utility::encoder::encoder> srcEncoder = m_contents->getEncoding().getEncoder();
-		ref <utility::encoder::encoder> dstEncoder = getEncoding().getEncoder();
+		ref <utility::encoder::encoder> dstEncoder = enc.getEncoder();
 
 		return dstEncoder->getEncodedSize(srcEncoder->getDecodedSize(m_contents->getLength()));
 	}
@@ -287,6 +287,39 @@ private:
 	text getActualPrologText(const generationContext& ctx) const;
 	text getActualEpilogText(const generationContext& ctx) const;
 
+	/** Return the encoding which will actually be used to generate the
+	  * body contents, given the transfer capabilities of the context.
+	  * The declared encoding is returned if it cannot be relaxed. The
+	  * encodings of the sub-parts are computed at the same time, so
+	  * that each body is only examined once per generation.
+	  *
+	  * @param ctx generation context
+	  * @param encodings receives the encoding used for this body, then
+	  * the encodings used for the bodies of the sub-parts, depth-first
+	  * @return encoding used for generation
+	  */
+	const encoding getGenerationEncodings
+		(const generationContext& ctx, std::vector <encoding>& encodings) const;
+
+	/** Generate the body with the encodings returned by
+	  * getGenerationEncodings().
+	  *
+	  * @param ctx generation context
+	  * @param os output stream
+	  * @param encodings encodings of this body and its sub-parts
+	  * @param index position of the encoding of this body; on return,
+	  * position following the encodings of the sub-parts
+	  */
+	void generateBody(const generationContext& ctx, utility::outputStream& os,
+		const std::vector <encoding>& encodings, size_t& index) const;
+
+	/** Return the size of the body generated with the encodings
+	  * returned by getGenerationEncodings(). See generateBody()
+	  * for the parameters.
+	  */
+	utility::stream::size_type getGeneratedBodySize(const generationContext& ctx,
+		const std::vector <encoding>& encodings, size_t& index);
+
 	void setParentPart(ref <bodyPart> parent);
 
 
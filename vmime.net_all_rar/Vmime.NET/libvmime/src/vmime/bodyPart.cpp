@@ -71,20 +71,60 @@ void bodyPart::generateImpl
 	(const generationContext& ctx, utility::outputStream& os,
 	 const string::size_type /* curLinePos */, string::size_type* newLinePos) const
 {
-	m_header->generate(ctx, os);
+	std::vector <encoding> encodings;
+	m_body->getGenerationEncodings(ctx, encodings);
 
-	os << CRLF;
-
-	m_body->generate(ctx, os);
+	size_t index = 0;
+	generatePart(ctx, os, encodings, index);
 
 	if (newLinePos)
 		*newLinePos = 0;
 }
 
 
+void bodyPart::generatePart(const generationContext& ctx, utility::outputStream& os,
+	const std::vector <encoding>& encodings, size_t& index) const
+{
+	getGenerationHeader(encodings[index])->generate(ctx, os);
+
+	os << CRLF;
+
+	m_body->generateBody(ctx, os, encodings, index);
+}
+
+
+ref <header> bodyPart::getGenerationHeader(const encoding& enc) const
+{
+	if (enc == m_body->getEncoding())
+		return m_header;
+
+	// Contents are not encoded as declared: use a copy of the
+	// header with the actual encoding, leaving this part untouched
+	ref <header> hdr = m_header->clone().dynamicCast <header>();
+	hdr->ContentTransferEncoding()->setValue(enc);
+
+	return hdr;
+}
+
+
 utility::stream::size_type bodyPart::getGeneratedSize(const generationContext& ctx)
 {
-	return m_header->getGeneratedSize(ctx) + 2 /* CRLF */ + m_body->getGeneratedSize(ctx);
+	std::vector <encoding> encodings;
+	m_body->getGenerationEncodings(ctx, encodings);
+
+	size_t index = 0;
+
+	return getGeneratedPartSize(ctx, encodings, index);
+}
+
+
+utility::stream::size_type bodyPart::getGeneratedPartSize(const generationContext& ctx,
+	const std::vector <encoding>& encodings, size_t& index)
+{
+	const utility::stream::size_type headerSize =
+		getGenerationHeader(encodings[index])->getGeneratedSize(ctx);
+
+	return headerSize + 2 /* CRLF */ + m_body->getGeneratedBodySize(ctx, encodings, index);
 }
 
 
@@ -112,6 +112,29 @@ private:
 
 	weak_ref <bodyPart> m_parent;
 
+	/** Return the header to generate for this part: the header of the
+	  * part, or a copy of it if the body is not generated with the
+	  * declared encoding.
+	  *
+	  * @param enc encoding used to generate the body
+	  * @return header to generate
+	  */
+	ref <header> getGenerationHeader(const encoding& enc) const;
+
+	/** Generate the part with the encodings returned by
+	  * body::getGenerationEncodings() for its body.
+	  * See body::generateBody() for the parameters.
+	  */
+	void generatePart(const generationContext& ctx, utility::outputStream& os,
+		const std::vector <encoding>& encodings, size_t& index) const;
+
+	/** Return the size of the part generated with the encodings returned
+	  * by body::getGenerationEncodings() for its body.
+	  * See body::generateBody() for the parameters.
+	  */
+	utility::stream::size_type getGeneratedPartSize(const generationContext& ctx,
+		const std::vector <encoding>& encodings, size_t& index);
+
 protected:
 
 	// Component parsing & assembling
@@ -82,6 +82,35 @@ public:
 	  */
 	void setEpilogText(const string& epilogText);
 
+	/** Transfer encodings accepted by the channel through which
+	  * the generated message is sent.
+	  */
+	enum TransferEncodingSupport
+	{
+		TRANSFER_7BIT,    /**< Only 7-bit data, in lines of at most 998 bytes (default). */
+		TRANSFER_8BIT,    /**< 8-bit data in lines of at most 998 bytes (eg. SMTP 8BITMIME). */
+		TRANSFER_BINARY   /**< Any data (eg. SMTP BINARYMIME and CHUNKING). */
+	};
+
+	/** Returns the transfer encodings accepted by the channel through
+	  * which the generated message is sent.
+	  *
+	  * @return transfer encoding support
+	  */
+	TransferEncodingSupport getTransferEncodingSupport() const;
+
+	/** Sets the transfer encodings accepted by the channel through which
+	  * the generated message is sent. When 8-bit or binary data is
+	  * accepted, the contents of single parts declared as "base64" or
+	  * "quoted-printable" are generated without encoding and labelled
+	  * "8bit" or "binary" instead, where the data allows it. The message
+	  * itself is not modified. This is TRANSFER_7BIT by default, which
+	  * generates the parts with their configured encodings.
+	  *
+	  * @param support transfer encoding support
+	  */
+	void setTransferEncodingSupport(const TransferEncodingSupport support);
+
 	/** Returns the default context used for generating messages.
 	  *
 	  * @return a reference to the default generation context
@@ -97,6 +126,8 @@ protected:
 
 	string m_prologText;
 	string m_epilogText;
+
+	TransferEncodingSupport m_transferEncodingSupport;
 };
 
 
@@ -119,6 +119,53 @@ void folder::notifyEvent(ref <events::event> event)
 }
 
 
+folder::uidMapping folder::moveMessages(const folder::path& dest, const messageSet& msgs)
+{
+	copyMessages(dest, msgs);
+	deleteMessages(msgs);
+	expunge();
+
+	return uidMapping();
+}
+
+
+messageSet folder::search(const searchCriteria& criteria, const bool uid)
+{
+	std::vector <ref <message> > msgs;
+
+	if (getMessageCount() > 0)
+		msgs = getMessages(messageSet::byNumber(1, -1));
+
+	int options = criteria.getFetchOptions();
+
+	if (uid)
+		options |= FETCH_UID;
+
+	if (options != 0 && !msgs.empty())
+		fetchMessages(msgs, options);
+
+	std::vector <int> numbers;
+	std::vector <message::uid> uids;
+
+	for (std::vector <ref <message> >::const_iterator
+	     it = msgs.begin() ; it != msgs.end() ; ++it)
+	{
+		if (!criteria.matches(*it))
+			continue;
+
+		if (uid)
+			uids.push_back((*it)->getUID());
+		else
+			numbers.push_back((*it)->getNumber());
+	}
+
+	if (uid)
+		return messageSet::byUID(uids);
+	else
+		return messageSet::byNumber(numbers);
+}
+
+
 } // net
 } // vmime
 
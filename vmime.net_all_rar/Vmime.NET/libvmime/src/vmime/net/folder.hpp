@@ -41,6 +41,7 @@
 #include "../vmime/net/messageSet.hpp"
 #include "../vmime/net/events.hpp"
 #include "../vmime/net/folderStatus.hpp"
+#include "../vmime/net/searchCriteria.hpp"
 
 #include "../vmime/utility/path.hpp"
 #include "../vmime/utility/stream.hpp"
@@ -291,6 +292,29 @@ public:
 	  */
 	virtual void copyMessages(const folder::path& dest, const messageSet& msgs) = 0;
 
+	/** Correspondence between the UIDs of messages in this folder (first)
+	  * and the UIDs of the same messages in another folder (second).
+	  */
+	typedef std::vector <std::pair <message::uid, message::uid> > uidMapping;
+
+	/** Move messages from this folder to another folder.
+	  *
+	  * If the underlying protocol supports it, messages are moved in
+	  * a single operation, and the other messages of this folder are not
+	  * affected. Otherwise, messages are copied and marked as deleted.
+	  * The default implementation then expunges the folder, which also
+	  * expunges any other message marked as deleted; implementations
+	  * may instead leave the messages marked as deleted when they cannot
+	  * expunge only these (see IMAPFolder::moveMessages()).
+	  *
+	  * @param dest destination folder path
+	  * @param msgs index set of messages to move
+	  * @return UIDs of the moved messages in the destination folder, or
+	  * an empty list if the underlying protocol does not report them
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	virtual uidMapping moveMessages(const folder::path& dest, const messageSet& msgs);
+
 	/** Request folder status without opening it.
 	  *
 	  * \deprecated Use the new getStatus() method
@@ -380,6 +404,23 @@ public:
  	  */
 	virtual std::vector <int> getMessageNumbersStartingOnUID(const message::uid& uid) = 0;
 
+	/** Search for the messages which match the specified criteria.
+	  *
+	  * If the underlying protocol supports searching (eg. IMAP), the
+	  * search is performed by the server. Otherwise, the objects needed
+	  * to evaluate the criteria are fetched for every message of the
+	  * folder and the criteria are evaluated locally: this may be slow
+	  * on large folders, especially with searchCriteria::body() and
+	  * searchCriteria::text().
+	  *
+	  * @param criteria search criteria
+	  * @param uid if true, return a set of UIDs; otherwise, return a set
+	  * of message sequence numbers
+	  * @return set of matching messages (may be empty)
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	virtual messageSet search(const searchCriteria& criteria, const bool uid = false);
+
 	// Event listeners
 	void addMessageChangedListener(events::messageChangedListener* l);
 	void removeMessageChangedListener(events::messageChangedListener* l);
@@ -0,0 +1,160 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#ifndef VMIME_NET_IMAP_IMAPCACHE_HPP_INCLUDED
+#define VMIME_NET_IMAP_IMAPCACHE_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+
+#include "../vmime/types.hpp"
+
+#include "../vmime/net/message.hpp"
+
+#include "../vmime/utility/outputStream.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace imap {
+
+
+/** Persistent cache for message data retrieved from an IMAP server.
+  *
+  * When a cache is set on the store (see IMAPStore::setCache()), the
+  * folders look up in the cache the headers, structure, size and flags
+  * of the messages before fetching them, and only fetch what is missing
+  * (flags are always revalidated with the server). Message contents
+  * extracted in "peek" mode are also cached, if the implementation
+  * accepts to store them.
+  *
+  * Entries are identified by the server, the mailbox, the UID validity
+  * of the mailbox and the UID of the message: data cached for a mailbox
+  * whose UID validity has changed is never returned.
+  */
+
+class VMIME_EXPORT IMAPCache : public object
+{
+public:
+
+	/** Identifies a mailbox on a server, for the current UID validity.
+	  */
+	class mailboxKey
+	{
+	public:
+
+		mailboxKey(const string& server, const string& mailbox, const vmime_uint32 uidValidity);
+
+		string server;            /**< server identity (eg. "user@imap.example.com:993") */
+		string mailbox;           /**< full name of the mailbox */
+		vmime_uint32 uidValidity; /**< UID validity of the mailbox */
+	};
+
+	/** Message data stored in the cache.
+	  */
+	class messageInfo
+	{
+	public:
+
+		messageInfo();
+
+		int options;          /**< objects available in this entry (see folder::FetchOptions) */
+		int flags;            /**< message flags (see message::Flags) */
+		int size;             /**< message size, or -1 if unknown */
+		vmime_uint64 modseq;  /**< modification sequence of the flags, or zero */
+		string header;        /**< message header, or an empty string */
+		string structure;     /**< serialized structure (see IMAPMessageStructure::serialize()) */
+	};
+
+
+	virtual ~IMAPCache() { }
+
+	/** Retrieve the cached data of a message.
+	  *
+	  * @param mbox mailbox which contains the message
+	  * @param uid UID of the message
+	  * @param info receives the cached data
+	  * @return true if the message was found in the cache, false otherwise
+	  */
+	virtual bool getMessageInfo(const mailboxKey& mbox, const message::uid& uid, messageInfo& info) = 0;
+
+	/** Store the data of a message, replacing any existing entry.
+	  *
+	  * @param mbox mailbox which contains the message
+	  * @param uid UID of the message
+	  * @param info data to store
+	  */
+	virtual void putMessageInfo(const mailboxKey& mbox, const message::uid& uid, const messageInfo& info) = 0;
+
+	/** Retrieve cached message contents.
+	  *
+	  * @param mbox mailbox which contains the message
+	  * @param uid UID of the message
+	  * @param section identifies the extracted section and range
+	  * @param os stream into which the contents are written
+	  * @return true if the contents were found in the cache, false otherwise
+	  */
+	virtual bool getBodySection(const mailboxKey& mbox, const message::uid& uid,
+		const string& section, utility::outputStream& os) = 0;
+
+	/** Store message contents.
+	  *
+	  * @param mbox mailbox which contains the message
+	  * @param uid UID of the message
+	  * @param section identifies the extracted section and range
+	  * @param data contents to store
+	  */
+	virtual void putBodySection(const mailboxKey& mbox, const message::uid& uid,
+		const string& section, const string& data) = 0;
+
+	/** Return the maximum size of the contents that can be stored with
+	  * putBodySection(). Larger contents are not kept in memory for
+	  * being cached.
+	  *
+	  * @return maximum size in bytes, or zero to disable caching
+	  * of message contents
+	  */
+	virtual size_t getMaxBodySectionSize() const = 0;
+
+	/** Remove all the data cached for a message.
+	  *
+	  * @param mbox mailbox which contains the message
+	  * @param uid UID of the message
+	  */
+	virtual void removeMessage(const mailboxKey& mbox, const message::uid& uid) = 0;
+};
+
+
+} // imap
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+#endif // VMIME_NET_IMAP_IMAPCACHE_HPP_INCLUDED
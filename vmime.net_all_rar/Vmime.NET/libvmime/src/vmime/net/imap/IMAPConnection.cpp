@@ -115,6 +115,7 @@ void IMAPConnection::connect()
 
 	// Create and connect the socket
 	m_socket = store->getSocketFactory()->create(m_timeoutHandler);
+	m_socket->setCancellationToken(store->getCancellationToken());
 
 #if VMIME_HAVE_TLS_SUPPORT
 	if (store->isIMAPS())  // dedicated port/IMAPS
@@ -543,6 +544,7 @@ void IMAPConnection::startTLS()
 		ref <tls::TLSSocket> tlsSocket =
 			tlsSession->getSocket(m_socket);
 
+		tlsSocket->setServerName(m_cntInfos->getHost());
 		tlsSocket->handshake(m_timeoutHandler);
 
 		// FIX by Elmue: Added Trace output
@@ -708,12 +710,20 @@ void IMAPConnection::disconnect()
 void IMAPConnection::internalDisconnect()
 {
 	if (isConnected())
-	{
 		send(true, "LOGOUT", true);
 
+	abort();
+
+	m_socket = NULL;
+}
+
+
+void IMAPConnection::abort()
+{
+	// The socket object is kept, so that commands sent later
+	// fail with an error instead of being ignored
+	if (m_socket && m_socket->isConnected())
 		m_socket->disconnect();
-		m_socket = NULL;
-	}
 
 	m_timeoutHandler = NULL;
 
@@ -804,9 +814,23 @@ void IMAPConnection::sendRaw(const char* buffer, const int count)
 }
 
 
-IMAPParser::response* IMAPConnection::readResponse(IMAPParser::literalHandler* lh)
+IMAPParser::response* IMAPConnection::readResponse
+	(IMAPParser::literalHandler* lh, IMAPParser::responseDataHandler* rh)
+{
+	return (m_parser->readResponse(lh, rh));
+}
+
+
+IMAPParser::response* IMAPConnection::readResponse
+	(const string& tag, IMAPParser::literalHandler* lh, IMAPParser::responseDataHandler* rh)
+{
+	return (m_parser->readTaggedResponse(tag, lh, rh));
+}
+
+
+const string IMAPConnection::getLastTag() const
 {
-	return (m_parser->readResponse(lh));
+	return (*m_tag);
 }
 
 
@@ -852,6 +876,12 @@ ref <const socket> IMAPConnection::getSocket() const
 }
 
 
+ref <socket> IMAPConnection::getSocket()
+{
+	return m_socket;
+}
+
+
 bool IMAPConnection::isMODSEQDisabled() const
 {
 	return m_noModSeq;
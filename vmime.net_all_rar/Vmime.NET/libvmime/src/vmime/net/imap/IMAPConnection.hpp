@@ -62,6 +62,13 @@ public:
 	bool isConnected() const;
 	void disconnect();
 
+	/** Close the connection without logging out. This is used when
+	  * a command cannot be completed, for example when the server
+	  * still expects literal data: nothing else can be sent on the
+	  * connection then.
+	  */
+	void abort();
+
 
 	enum ProtocolStates
 	{
@@ -83,7 +90,27 @@ public:
 	void send(bool tag, const string& what, bool end, const char* s8_Trace=NULL);
 	void sendRaw(const char* buffer, const int count);
 
-	IMAPParser::response* readResponse(IMAPParser::literalHandler* lh = NULL);
+	IMAPParser::response* readResponse(IMAPParser::literalHandler* lh = NULL,
+	                                   IMAPParser::responseDataHandler* rh = NULL);
+
+	/** Read the response to a specific command. This is used when several
+	  * commands have been sent before reading their responses (pipelining):
+	  * responses must then be read in the order the commands were sent.
+	  *
+	  * @param tag tag of the command, as returned by getLastTag() just
+	  * after the command was sent
+	  * @param lh literal handler, or NULL
+	  * @param rh response data handler, or NULL
+	  * @return parsed response
+	  */
+	IMAPParser::response* readResponse(const string& tag, IMAPParser::literalHandler* lh = NULL,
+	                                   IMAPParser::responseDataHandler* rh = NULL);
+
+	/** Return the tag of the last tagged command sent on this connection.
+	  *
+	  * @return command tag
+	  */
+	const string getLastTag() const;
 
 
 	ref <const IMAPStore> getStore() const;
@@ -102,6 +129,7 @@ public:
 	ref <connectionInfos> getConnectionInfos() const;
 
 	ref <const socket> getSocket() const;
+	ref <socket> getSocket();  // eg. to watch the connection with a socketPoller
 
 	bool isMODSEQDisabled() const;
 	void disableMODSEQ();
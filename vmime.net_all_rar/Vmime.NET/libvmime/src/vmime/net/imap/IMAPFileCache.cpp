@@ -0,0 +1,305 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP && VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include "../vmime/net/imap/IMAPFileCache.hpp"
+
+#include "../vmime/utility/fileUtils.hpp"
+#include "../vmime/utility/outputStreamAdapter.hpp"
+#include "../vmime/utility/streamUtils.hpp"
+
+#include "../vmime/exception.hpp"
+#include "../vmime/platform.hpp"
+
+#include <sstream>
+
+
+namespace vmime {
+namespace net {
+namespace imap {
+
+
+#ifndef VMIME_BUILDING_DOC
+
+// Version of the format of ".info" files
+static const int IMAPFileCache_infoVersion = 1;
+
+
+static void IMAPFileCache_recursiveDelete(ref <utility::file> dir)
+{
+	ref <utility::fileIterator> files = dir->getFiles();
+
+	while (files->hasMoreElements())
+	{
+		ref <utility::file> file = files->nextElement();
+
+		if (file->isDirectory())
+		{
+			IMAPFileCache_recursiveDelete(file);
+		}
+		else
+		{
+			try
+			{
+				file->remove();
+			}
+			catch (exceptions::filesystem_exception&)
+			{
+				// Ignore
+			}
+		}
+	}
+
+	try
+	{
+		dir->remove();
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		// Ignore
+	}
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
+
+IMAPFileCache::IMAPFileCache(const utility::file::path& rootDir)
+	: m_rootDir(rootDir), m_maxBodySectionSize(1024 * 1024)
+{
+}
+
+
+void IMAPFileCache::setMaxBodySectionSize(const size_t size)
+{
+	m_maxBodySectionSize = size;
+}
+
+
+size_t IMAPFileCache::getMaxBodySectionSize() const
+{
+	return m_maxBodySectionSize;
+}
+
+
+bool IMAPFileCache::getMessageInfo(const mailboxKey& mbox, const message::uid& uid, messageInfo& info)
+{
+	std::ostringstream oss;
+	utility::outputStreamAdapter ossAdapter(oss);
+
+	if (!readFile(getMailboxDirectory(mbox) / utility::fileUtils::escapeName(static_cast <string>(uid) + ".info"), ossAdapter))
+		return false;
+
+	std::istringstream iss(oss.str());
+	iss.imbue(std::locale::classic());
+
+	int version = 0;
+	iss >> version;
+
+	if (version != IMAPFileCache_infoVersion)
+		return false;
+
+	messageInfo tmp;
+	size_t headerLength = 0, structureLength = 0;
+
+	iss >> tmp.options >> tmp.flags >> tmp.size >> tmp.modseq >> headerLength >> structureLength;
+
+	if (iss.fail() || iss.get() != '\n')
+		return false;
+
+	tmp.header.resize(headerLength);
+	tmp.structure.resize(structureLength);
+
+	if (headerLength != 0)
+		iss.read(&tmp.header[0], headerLength);
+
+	if (structureLength != 0)
+		iss.read(&tmp.structure[0], structureLength);
+
+	if (iss.fail())  // truncated file
+		return false;
+
+	info = tmp;
+
+	return true;
+}
+
+
+void IMAPFileCache::putMessageInfo(const mailboxKey& mbox, const message::uid& uid, const messageInfo& info)
+{
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+
+	oss << IMAPFileCache_infoVersion << ' '
+	    << info.options << ' ' << info.flags << ' ' << info.size << ' ' << info.modseq << ' '
+	    << info.header.length() << ' ' << info.structure.length() << '\n'
+	    << info.header << info.structure;
+
+	writeFile(getMailboxDirectory(mbox) / utility::fileUtils::escapeName(static_cast <string>(uid) + ".info"), oss.str());
+}
+
+
+bool IMAPFileCache::getBodySection(const mailboxKey& mbox, const message::uid& uid,
+	const string& section, utility::outputStream& os)
+{
+	return readFile(getMailboxDirectory(mbox) / utility::fileUtils::escapeName(static_cast <string>(uid) + "." + section + ".body"), os);
+}
+
+
+void IMAPFileCache::putBodySection(const mailboxKey& mbox, const message::uid& uid,
+	const string& section, const string& data)
+{
+	if (data.length() > m_maxBodySectionSize)
+		return;
+
+	writeFile(getMailboxDirectory(mbox) / utility::fileUtils::escapeName(static_cast <string>(uid) + "." + section + ".body"), data);
+}
+
+
+void IMAPFileCache::removeMessage(const mailboxKey& mbox, const message::uid& uid)
+{
+	ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+	ref <utility::file> dir = fsf->create(getMailboxDirectory(mbox));
+
+	if (!dir->exists())
+		return;
+
+	// Delete ".info" file and all ".body" files of the message
+	const string prefix = utility::fileUtils::escapeName(static_cast <string>(uid) + ".").getBuffer();
+
+	ref <utility::fileIterator> files = dir->getFiles();
+
+	while (files->hasMoreElements())
+	{
+		ref <utility::file> file = files->nextElement();
+		const string name = file->getFullPath().getLastComponent().getBuffer();
+
+		if (name.compare(0, prefix.length(), prefix) == 0)
+		{
+			try
+			{
+				file->remove();
+			}
+			catch (exceptions::filesystem_exception&)
+			{
+				// Ignore
+			}
+		}
+	}
+}
+
+
+const utility::file::path IMAPFileCache::getMailboxDirectory(const mailboxKey& mbox)
+{
+	const utility::file::path mboxDir =
+		m_rootDir / utility::fileUtils::escapeName(mbox.server) / utility::fileUtils::escapeName(mbox.mailbox);
+
+	std::ostringstream validity;
+	validity.imbue(std::locale::classic());
+	validity << mbox.uidValidity;
+
+	const utility::file::path::component validityDir(validity.str(), vmime::charset(vmime::charsets::US_ASCII));
+
+	// Delete data cached for other UID validities of this mailbox
+	const string mboxId = mbox.server + '\n' + mbox.mailbox + '\n' + validity.str();
+
+	if (m_checkedMailboxes.find(mboxId) == m_checkedMailboxes.end())
+	{
+		ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+		ref <utility::file> dir = fsf->create(mboxDir);
+
+		if (dir->exists() && dir->isDirectory())
+		{
+			ref <utility::fileIterator> files = dir->getFiles();
+
+			while (files->hasMoreElements())
+			{
+				ref <utility::file> file = files->nextElement();
+				const string name = file->getFullPath().getLastComponent().getBuffer();
+
+				// Only UID validity directories are created here
+				if (file->isDirectory() && name != validityDir.getBuffer() &&
+				    name.find_first_not_of("0123456789") == string::npos)
+				{
+					IMAPFileCache_recursiveDelete(file);
+				}
+			}
+		}
+
+		m_checkedMailboxes.insert(mboxId);
+	}
+
+	return mboxDir / validityDir;
+}
+
+
+bool IMAPFileCache::readFile(const utility::file::path& path, utility::outputStream& os)
+{
+	ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+
+	try
+	{
+		ref <utility::file> file = fsf->create(path);
+
+		if (!file->exists() || !file->isFile())
+			return false;
+
+		ref <utility::fileReader> reader = file->getFileReader();
+		ref <utility::inputStream> is = reader->getInputStream();
+
+		utility::bufferedStreamCopy(*is, os);
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+void IMAPFileCache::writeFile(const utility::file::path& path, const string& data)
+{
+	try
+	{
+		utility::fileUtils::writeFileAtomically(path, data);
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		// Caching is not essential: ignore write errors
+	}
+}
+
+
+} // imap
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP && VMIME_HAVE_FILESYSTEM_FEATURES
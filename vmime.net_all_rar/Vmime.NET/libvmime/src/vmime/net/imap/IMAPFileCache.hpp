@@ -0,0 +1,114 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#ifndef VMIME_NET_IMAP_IMAPFILECACHE_HPP_INCLUDED
+#define VMIME_NET_IMAP_IMAPFILECACHE_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP && VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include <set>
+
+#include "../vmime/net/imap/IMAPCache.hpp"
+
+#include "../vmime/utility/file.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace imap {
+
+
+/** IMAP cache which stores the data in files, in a local directory.
+  *
+  * The directory contains one sub-directory per server, mailbox and
+  * UID validity. When a mailbox is first accessed, the data cached
+  * for other (obsolete) UID validities of this mailbox is deleted.
+  */
+
+class VMIME_EXPORT IMAPFileCache : public IMAPCache
+{
+public:
+
+	/** Construct a new cache which stores its data in the
+	  * specified directory. The directory is created if needed.
+	  *
+	  * @param rootDir full path of the cache directory
+	  */
+	IMAPFileCache(const utility::file::path& rootDir);
+
+	/** Set the maximum size of the message contents stored in
+	  * the cache. The default is 1 MB.
+	  *
+	  * @param size maximum size in bytes, or zero to store only
+	  * message headers, structures and flags
+	  */
+	void setMaxBodySectionSize(const size_t size);
+
+	size_t getMaxBodySectionSize() const;
+
+	bool getMessageInfo(const mailboxKey& mbox, const message::uid& uid, messageInfo& info);
+	void putMessageInfo(const mailboxKey& mbox, const message::uid& uid, const messageInfo& info);
+
+	bool getBodySection(const mailboxKey& mbox, const message::uid& uid,
+		const string& section, utility::outputStream& os);
+	void putBodySection(const mailboxKey& mbox, const message::uid& uid,
+		const string& section, const string& data);
+
+	void removeMessage(const mailboxKey& mbox, const message::uid& uid);
+
+private:
+
+	/** Return the directory for the specified mailbox, and delete
+	  * the data of other UID validities the first time it is called
+	  * for a mailbox.
+	  *
+	  * @param mbox mailbox key
+	  * @return directory path
+	  */
+	const utility::file::path getMailboxDirectory(const mailboxKey& mbox);
+
+	bool readFile(const utility::file::path& path, utility::outputStream& os);
+	void writeFile(const utility::file::path& path, const string& data);
+
+
+	utility::file::path m_rootDir;
+	size_t m_maxBodySectionSize;
+
+	std::set <string> m_checkedMailboxes;
+};
+
+
+} // imap
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP && VMIME_HAVE_FILESYSTEM_FEATURES
+
+#endif // VMIME_NET_IMAP_IMAPFILECACHE_HPP_INCLUDED
@@ -35,6 +35,7 @@
 #include "../vmime/net/imap/IMAPUtils.hpp"
 #include "../vmime/net/imap/IMAPConnection.hpp"
 #include "../vmime/net/imap/IMAPFolderStatus.hpp"
+#include "../vmime/net/imap/IMAPCache.hpp"
 
 #include "../vmime/message.hpp"
 
@@ -52,6 +53,121 @@ namespace net {
 namespace imap {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+//
+// IMAPFolder::fetchResponseHandler
+//
+
+class IMAPFolder::fetchResponseHandler : public IMAPParser::responseDataHandler
+{
+public:
+
+	fetchResponseHandler(ref <IMAPFolder> folder, const int options,
+	                     messageFetchHandler* handler, utility::progressListener* progress,
+	                     const int total)
+		: m_folder(folder), m_options(options), m_handler(handler),
+		  m_progress(progress), m_current(0), m_total(total), m_continue(true),
+		  m_handlerFailed(false)
+	{
+	}
+
+	/** Tests whether the message handler has thrown an exception. The
+	  * messages which follow are then read, but not delivered anymore.
+	  *
+	  * @return true if the handler has failed, false otherwise
+	  */
+	bool hasHandlerFailed() const
+	{
+		return m_handlerFailed;
+	}
+
+	bool handleResponseData(const IMAPParser::continue_req_or_response_data& data)
+	{
+		if (data.response_data() == NULL)
+			return false;
+
+		const IMAPParser::message_data* messageData = data.response_data()->message_data();
+
+		// Other untagged responses are kept for processStatusUpdate()
+		if (messageData == NULL || messageData->type() != IMAPParser::message_data::FETCH)
+			return false;
+
+		if (m_continue)
+		{
+			try
+			{
+				m_continue = m_handler->handleMessage
+					(m_folder->createMessageFromFetchResponse(messageData, m_options));
+			}
+			catch (...)
+			{
+				m_continue = false;
+				m_handlerFailed = true;
+				throw;
+			}
+		}
+
+		if (m_progress)
+			m_progress->progress(++m_current, m_total);
+
+		return true;
+	}
+
+private:
+
+	ref <IMAPFolder> m_folder;
+	const int m_options;
+	messageFetchHandler* m_handler;
+	utility::progressListener* m_progress;
+	int m_current;
+	const int m_total;
+	bool m_continue;
+	bool m_handlerFailed;
+};
+
+
+/** Returns the ESEARCH response which belongs to the command with the
+  * specified tag. ESEARCH responses correlated with another command
+  * (see RFC 4466, "search-correlator") are ignored.
+  *
+  * @param resp response to the command
+  * @param tag tag of the command
+  * @return ESEARCH response, or NULL if there is none
+  */
+static const IMAPParser::esearch_response* findESearchResponse
+	(const IMAPParser::response* resp, const string& tag)
+{
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+	{
+		if ((*it)->response_data() == NULL)
+			continue;
+
+		const IMAPParser::mailbox_data* mailboxData =
+			(*it)->response_data()->mailbox_data();
+
+		if (mailboxData == NULL ||
+		    mailboxData->type() != IMAPParser::mailbox_data::ESEARCH)
+		{
+			continue;
+		}
+
+		const IMAPParser::esearch_response* esearch = mailboxData->esearch_response();
+
+		if (esearch->tag() == NULL || esearch->tag()->value() == tag)
+			return esearch;
+	}
+
+	return NULL;
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
 IMAPFolder::IMAPFolder(const folder::path& path, ref <IMAPStore> store, const int type, const int flags)
 	: m_store(store), m_connection(store->connection()), m_path(path),
 	  m_name(path.isEmpty() ? folder::path::component("") : path.getLastComponent()), m_mode(-1),
@@ -160,134 +276,185 @@ void IMAPFolder::open(const int mode, bool failIfModeIsNotAvailable)
 			throw exceptions::folder_already_open();
 	}
 
-	// Open a connection for this folder
-	ref <IMAPConnection> connection =
-		vmime::create <IMAPConnection>(store, store->getAuthenticator());
-
-	try
+	for (int attempt = 0 ; ; ++attempt)
 	{
-		connection->connect();
+		// Lease a connection for this folder
+		bool reused = false;
+		ref <IMAPFolderStatus> pooledStatus;
+		ref <IMAPConnection> connection = store->acquireConnection(m_path, mode, pooledStatus, reused);
 
-		// Emit the "SELECT" command
-		//
-		// Example:  C: A142 SELECT INBOX
-		//           S: * 172 EXISTS
-		//           S: * 1 RECENT
-		//           S: * OK [UNSEEN 12] Message 12 is first unseen
-		//           S: * OK [UIDVALIDITY 3857529045] UIDs valid
-		//           S: * FLAGS (\Answered \Flagged \Deleted \Seen \Draft)
-		//           S: * OK [PERMANENTFLAGS (\Deleted \Seen \*)] Limited
-		//           S: A142 OK [READ-WRITE] SELECT completed
+		// The mode actually granted by the server is not known in this case
+		if (failIfModeIsNotAvailable && mode == MODE_READ_WRITE)
+			pooledStatus = NULL;
 
-		std::ostringstream oss;
+		try
+		{
+			if (pooledStatus)
+			{
+				// The folder is still selected on this connection: only get the
+				// changes which occurred since it was closed, instead of sending
+				// "SELECT" again
+				connection->send(true, "NOOP", true);
 
-		if (mode == MODE_READ_ONLY)
-			oss << "EXAMINE ";
-		else
-			oss << "SELECT ";
+				utility::auto_ptr <IMAPParser::response> resp(connection->readResponse());
 
-		oss << IMAPUtils::quoteString(IMAPUtils::pathToString
-				(connection->hierarchySeparator(), getFullPath()));
+				if (resp->isBad() || resp->response_done()->response_tagged()->
+						resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+				{
+					throw exceptions::command_error("NOOP", resp->getErrorLog());
+				}
 
-		if (m_connection->hasCapability("CONDSTORE"))
-			oss << " (CONDSTORE)";
+				m_status = pooledStatus;
 
-		connection->send(true, oss.str(), true);
+				processStatusUpdate(resp);
+			}
+			else
+			{
+				// Emit the "SELECT" command
+				//
+				// Example:  C: A142 SELECT INBOX
+				//           S: * 172 EXISTS
+				//           S: * 1 RECENT
+				//           S: * OK [UNSEEN 12] Message 12 is first unseen
+				//           S: * OK [UIDVALIDITY 3857529045] UIDs valid
+				//           S: * FLAGS (\Answered \Flagged \Deleted \Seen \Draft)
+				//           S: * OK [PERMANENTFLAGS (\Deleted \Seen \*)] Limited
+				//           S: A142 OK [READ-WRITE] SELECT completed
 
-		// Read the response
-		utility::auto_ptr <IMAPParser::response> resp(connection->readResponse());
+				std::ostringstream oss;
 
-		if (resp->isBad() || resp->response_done()->response_tagged()->
-				resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
-		{
-			throw exceptions::command_error("SELECT",
-				resp->getErrorLog(), "bad response");
-		}
+				if (mode == MODE_READ_ONLY)
+					oss << "EXAMINE ";
+				else
+					oss << "SELECT ";
 
-		const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
-			resp->continue_req_or_response_data();
+				oss << IMAPUtils::quoteString(IMAPUtils::pathToString
+						(connection->hierarchySeparator(), getFullPath()));
 
-		for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
-		     it = respDataList.begin() ; it != respDataList.end() ; ++it)
-		{
-			if ((*it)->response_data() == NULL)
-			{
-				throw exceptions::command_error("SELECT",
-					resp->getErrorLog(), "invalid response");
-			}
+				if (connection->hasCapability("CONDSTORE"))
+					oss << " (CONDSTORE)";
 
-			const IMAPParser::response_data* responseData = (*it)->response_data();
+				connection->send(true, oss.str(), true);
 
-			// OK Untagged responses: UNSEEN, PERMANENTFLAGS, UIDVALIDITY (optional)
-			if (responseData->resp_cond_state())
-			{
-				const IMAPParser::resp_text_code* code =
-					responseData->resp_cond_state()->resp_text()->resp_text_code();
+				// Read the response
+				utility::auto_ptr <IMAPParser::response> resp(connection->readResponse());
+
+				if (resp->isBad() || resp->response_done()->response_tagged()->
+						resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+				{
+					throw exceptions::command_error("SELECT",
+						resp->getErrorLog(), "bad response");
+				}
 
-				if (code != NULL)
+				const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+					resp->continue_req_or_response_data();
+
+				for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+				     it = respDataList.begin() ; it != respDataList.end() ; ++it)
 				{
-					switch (code->type())
+					if ((*it)->response_data() == NULL)
+					{
+						throw exceptions::command_error("SELECT",
+							resp->getErrorLog(), "invalid response");
+					}
+
+					const IMAPParser::response_data* responseData = (*it)->response_data();
+
+					// OK Untagged responses: UNSEEN, PERMANENTFLAGS, UIDVALIDITY (optional)
+					if (responseData->resp_cond_state())
 					{
-					case IMAPParser::resp_text_code::NOMODSEQ:
+						const IMAPParser::resp_text_code* code =
+							responseData->resp_cond_state()->resp_text()->resp_text_code();
+
+						if (code != NULL)
+						{
+							switch (code->type())
+							{
+							case IMAPParser::resp_text_code::NOMODSEQ:
 
-						connection->disableMODSEQ();
-						break;
+								connection->disableMODSEQ();
+								break;
 
-					default:
+							default:
 
-						break;
+								break;
+							}
+						}
 					}
-				}
-			}
-			// Untagged responses: FLAGS, EXISTS, RECENT (required)
-			else if (responseData->mailbox_data())
-			{
-				switch (responseData->mailbox_data()->type())
-				{
-				default: break;
+					// Untagged responses: FLAGS, EXISTS, RECENT (required)
+					else if (responseData->mailbox_data())
+					{
+						switch (responseData->mailbox_data()->type())
+						{
+						default: break;
 
-				case IMAPParser::mailbox_data::FLAGS:
-				{
-					m_type = IMAPUtils::folderTypeFromFlags
-						(responseData->mailbox_data()->mailbox_flag_list());
+						case IMAPParser::mailbox_data::FLAGS:
+						{
+							m_type = IMAPUtils::folderTypeFromFlags
+								(responseData->mailbox_data()->mailbox_flag_list());
 
-					m_flags = IMAPUtils::folderFlagsFromFlags
-						(responseData->mailbox_data()->mailbox_flag_list());
+							m_flags = IMAPUtils::folderFlagsFromFlags
+								(responseData->mailbox_data()->mailbox_flag_list());
 
-					break;
-				}
+							break;
+						}
 
+						}
+					}
 				}
-			}
-		}
 
-		processStatusUpdate(resp);
+				processStatusUpdate(resp);
 
-		// Check for access mode (read-only or read-write)
-		const IMAPParser::resp_text_code* respTextCode = resp->response_done()->
-			response_tagged()->resp_cond_state()->resp_text()->resp_text_code();
+				// Check for access mode (read-only or read-write)
+				const IMAPParser::resp_text_code* respTextCode = resp->response_done()->
+					response_tagged()->resp_cond_state()->resp_text()->resp_text_code();
 
-		if (respTextCode)
+				if (respTextCode)
+				{
+					const int openMode =
+						(respTextCode->type() == IMAPParser::resp_text_code::READ_WRITE)
+							? MODE_READ_WRITE : MODE_READ_ONLY;
+
+					if (failIfModeIsNotAvailable &&
+					    mode == MODE_READ_WRITE && openMode == MODE_READ_ONLY)
+					{
+						throw exceptions::operation_not_supported();
+					}
+				}
+			}
+		}
+		catch (exceptions::socket_exception&)
 		{
-			const int openMode =
-				(respTextCode->type() == IMAPParser::resp_text_code::READ_WRITE)
-					? MODE_READ_WRITE : MODE_READ_ONLY;
+			m_status = vmime::create <IMAPFolderStatus>();
+
+			// The connection is not usable anymore
+			connection->abort();
+			store->releaseConnection(connection, m_path, -1, NULL);
 
-			if (failIfModeIsNotAvailable &&
-			    mode == MODE_READ_WRITE && openMode == MODE_READ_ONLY)
+			// An idle connection may have been closed by the server while
+			// it was in the pool, and the other idle ones probably too
+			if (reused && attempt == 0)
 			{
-				throw exceptions::operation_not_supported();
+				store->clearConnectionPool();
+				continue;
 			}
+
+			throw;
 		}
+		catch (std::exception&)
+		{
+			m_status = vmime::create <IMAPFolderStatus>();
 
+			// No folder is selected after a failed command
+			store->releaseConnection(connection, m_path, -1, NULL);
+			throw;
+		}
 
 		m_connection = connection;
 		m_open = true;
 		m_mode = mode;
-	}
-	catch (std::exception&)
-	{
-		throw;
+
+		return;
 	}
 }
 
@@ -311,12 +478,47 @@ void IMAPFolder::close(const bool expunge)
 		if (m_mode == MODE_READ_ONLY)
 			throw exceptions::operation_not_supported();
 
-		oldConnection->send(true, "CLOSE", true);
+		try
+		{
+			oldConnection->send(true, "CLOSE", true);
+
+			utility::auto_ptr <IMAPParser::response> resp(oldConnection->readResponse());
+
+			if (resp->isBad() || resp->response_done()->response_tagged()->
+					resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+			{
+				throw exceptions::command_error("CLOSE",
+					resp->getErrorLog(), "bad response");
+			}
+		}
+		catch (std::exception&)
+		{
+			// The folder may still be selected on this connection: it
+			// must not be given back to the pool
+			oldConnection->abort();
+			store->releaseConnection(oldConnection, m_path, -1, NULL);
+
+			resetState();
+			throw;
+		}
+
+		// No folder is selected anymore: the connection can be used
+		// for any folder
+		store->releaseConnection(oldConnection, m_path, -1, NULL);
+	}
+	else
+	{
+		// Give back the connection with this folder still selected, so
+		// that opening it again does not require a "SELECT"
+		store->releaseConnection(oldConnection, m_path, m_mode, m_status);
 	}
 
-	// Close this folder connection
-	oldConnection->disconnect();
+	resetState();
+}
+
 
+void IMAPFolder::resetState()
+{
 	// Now use default store connection
 	m_connection = m_store.acquire()->connection();
 
@@ -763,21 +965,163 @@ void IMAPFolder::fetchMessages(std::vector <ref <message> >& msg, const int opti
 	else if (!isOpen())
 		throw exceptions::illegal_state("Folder not open");
 
+	std::vector <ref <IMAPMessage> > imapMsgs;
+	imapMsgs.reserve(msg.size());
+
+	for (std::vector <ref <message> >::iterator it = msg.begin() ; it != msg.end() ; ++it)
+		imapMsgs.push_back((*it).dynamicCast <IMAPMessage>());
+
+	ref <IMAPCache> cache = getCache();
+
+	if (cache && !imapMsgs.empty())
+		fetchMessagesCached(cache, imapMsgs, options, progress);
+	else
+		fetchMessagesImpl(imapMsgs, options, "", progress);
+}
+
+
+void IMAPFolder::fetchMessagesCached(ref <IMAPCache> cache, const std::vector <ref <IMAPMessage> >& msgs,
+                                     const int options, utility::progressListener* progress)
+{
+	const IMAPCache::mailboxKey key = getCacheKey();
+
+	// Messages are identified by their UID in the cache
+	std::vector <ref <IMAPMessage> > noUID;
+
+	for (std::vector <ref <IMAPMessage> >::const_iterator it = msgs.begin() ; it != msgs.end() ; ++it)
+	{
+		if ((*it)->m_uid.empty())
+			noUID.push_back(*it);
+	}
+
+	if (!noUID.empty())
+		fetchMessagesImpl(noUID, FETCH_UID, "", NULL);
+
+	// Look up messages in the cache. Flags are never taken from the
+	// cache without checking them with the server.
+	const int cachedOptions = options & ~(FETCH_FLAGS | FETCH_UID);
+
+	std::vector <ref <IMAPMessage> > hits, misses;
+	std::vector <IMAPCache::messageInfo> hitInfos;
+
+	vmime_uint64 minModSeq = 0;
+	bool haveFlagsAndModSeq = true;
+
+	for (std::vector <ref <IMAPMessage> >::const_iterator it = msgs.begin() ; it != msgs.end() ; ++it)
+	{
+		IMAPCache::messageInfo info;
+		bool hit = false;
+
+		try
+		{
+			hit = !(*it)->m_uid.empty()
+				&& cache->getMessageInfo(key, (*it)->m_uid, info)
+				&& (info.options & cachedOptions) == cachedOptions;
+
+			if (hit)
+				(*it)->processCachedInfo(info);
+		}
+		catch (exception&)
+		{
+			// Invalid cache entry
+			hit = false;
+		}
+
+		if (!hit)
+		{
+			misses.push_back(*it);
+			continue;
+		}
+
+		hits.push_back(*it);
+		hitInfos.push_back(info);
+
+		if (!(info.options & FETCH_FLAGS) || info.modseq == 0)
+			haveFlagsAndModSeq = false;
+		else if (minModSeq == 0 || info.modseq < minModSeq)
+			minModSeq = info.modseq;
+	}
+
+	// Check flags of cached messages: if the server supports CONDSTORE,
+	// only the flags which changed since they were cached are returned
+	if ((options & FETCH_FLAGS) && !hits.empty())
+	{
+		if (haveFlagsAndModSeq && m_connection->hasCapability("CONDSTORE") &&
+		    !m_connection->isMODSEQDisabled())
+		{
+			std::ostringstream modifiers;
+			modifiers.imbue(std::locale::classic());
+			modifiers << " (CHANGEDSINCE " << minModSeq << ")";
+
+			fetchMessagesImpl(hits, FETCH_FLAGS | FETCH_UID, modifiers.str(), NULL);
+		}
+		else
+		{
+			fetchMessagesImpl(hits, FETCH_FLAGS, "", NULL);
+		}
+	}
+
+	// Fetch messages which are not in the cache
+	if (!misses.empty())
+		fetchMessagesImpl(misses, options | FETCH_UID, "", progress);
+
+	// Update the cache: entries found in the cache are only written
+	// again if their flags have changed
+	try
+	{
+		for (size_t i = 0 ; i < hits.size() ; ++i)
+		{
+			if (options & FETCH_FLAGS)
+			{
+				const IMAPCache::messageInfo& oldInfo = hitInfos[i];
+
+				IMAPCache::messageInfo info;
+				hits[i]->buildCachedInfo(oldInfo.options | options, info);
+
+				if (info.options != oldInfo.options || info.flags != oldInfo.flags ||
+				    info.modseq != oldInfo.modseq)
+				{
+					cache->putMessageInfo(key, hits[i]->m_uid, info);
+				}
+			}
+		}
+
+		for (size_t i = 0 ; i < misses.size() ; ++i)
+		{
+			if (!misses[i]->m_uid.empty())
+			{
+				IMAPCache::messageInfo info;
+				misses[i]->buildCachedInfo(options | FETCH_UID, info);
+
+				cache->putMessageInfo(key, misses[i]->m_uid, info);
+			}
+		}
+	}
+	catch (exception&)
+	{
+		// Ignore: the cache is only an optimization
+	}
+}
+
+
+void IMAPFolder::fetchMessagesImpl(const std::vector <ref <IMAPMessage> >& msg, const int options,
+                                   const string& modifiers, utility::progressListener* progress)
+{
 	// Build message numbers list
 	std::vector <int> list;
 	list.reserve(msg.size());
 
 	std::map <int, ref <IMAPMessage> > numberToMsg;
 
-	for (std::vector <ref <message> >::iterator it = msg.begin() ; it != msg.end() ; ++it)
+	for (std::vector <ref <IMAPMessage> >::const_iterator it = msg.begin() ; it != msg.end() ; ++it)
 	{
 		list.push_back((*it)->getNumber());
-		numberToMsg[(*it)->getNumber()] = (*it).dynamicCast <IMAPMessage>();
+		numberToMsg[(*it)->getNumber()] = *it;
 	}
 
 	// Send the request
 	const string command = IMAPUtils::buildFetchRequest
-		(m_connection, messageSet::byNumber(list), options);
+		(m_connection, messageSet::byNumber(list), options) + modifiers;
 
 	m_connection->send(true, command, true);
 
@@ -856,54 +1200,175 @@ void IMAPFolder::fetchMessage(ref <message> msg, const int options)
 }
 
 
-int IMAPFolder::getFetchCapabilities() const
+void IMAPFolder::fetchMessages(const messageSet& msgs, const int options,
+                               messageFetchHandler* handler, utility::progressListener* progress)
 {
-	return (FETCH_ENVELOPE | FETCH_CONTENT_INFO | FETCH_STRUCTURE |
-	        FETCH_FLAGS | FETCH_SIZE | FETCH_FULL_HEADER | FETCH_UID |
-	        FETCH_IMPORTANCE);
-}
+	ref <IMAPStore> store = m_store.acquire();
 
+	if (!store)
+		throw exceptions::illegal_state("Store disconnected");
+	else if (!isOpen())
+		throw exceptions::illegal_state("Folder not open");
 
-ref <folder> IMAPFolder::getParent()
-{
-	if (m_path.isEmpty())
-		return NULL;
-	else
-		return vmime::create <IMAPFolder>(m_path.getParent(), m_store.acquire());
-}
+	if (msgs.isEmpty())
+		return;
 
+	// Send the request
+	const string command = IMAPUtils::buildFetchRequest(m_connection, msgs, options);
 
-ref <const store> IMAPFolder::getStore() const
-{
-	return m_store.acquire();
-}
+	m_connection->send(true, command, true);
 
+	// Get the response: messages are handed to the handler while they are
+	// parsed, so that only the current message is held in memory
+	const int total = m_status->getMessageCount();  // upper bound
 
-ref <store> IMAPFolder::getStore()
-{
-	return m_store.acquire();
-}
+	fetchResponseHandler responseHandler
+		(thisRef().dynamicCast <IMAPFolder>(), options, handler, progress, total);
 
+	if (progress)
+		progress->start(total);
 
-void IMAPFolder::registerMessage(IMAPMessage* msg)
-{
-	m_messages.push_back(msg);
-}
+	IMAPParser::response* response = NULL;
 
+	try
+	{
+		response = m_connection->readResponse(/* literalHandler */ NULL, &responseHandler);
+	}
+	catch (...)
+	{
+		if (progress)
+			progress->stop(total);
 
-void IMAPFolder::unregisterMessage(IMAPMessage* msg)
-{
-	std::vector <IMAPMessage*>::iterator it =
-		std::find(m_messages.begin(), m_messages.end(), msg);
+		// The handler has thrown in the middle of the response: read the
+		// rest of it, so that the next command does not get stale data
+		if (responseHandler.hasHandlerFailed())
+		{
+			try
+			{
+				delete m_connection->readResponse(/* literalHandler */ NULL, &responseHandler);
+			}
+			catch (...)
+			{
+				// The connection cannot be used anymore
+				m_connection->abort();
+			}
+		}
 
-	if (it != m_messages.end())
-		m_messages.erase(it);
-}
+		throw;
+	}
 
+	if (progress)
+		progress->stop(total);
 
-void IMAPFolder::onStoreDisconnected()
-{
-	m_store = NULL;
+	utility::auto_ptr <IMAPParser::response> resp(response);
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("FETCH",
+			resp->getErrorLog(), "bad response");
+	}
+
+	processStatusUpdate(resp);
+}
+
+
+ref <IMAPCache> IMAPFolder::getCache() const
+{
+	ref <const IMAPStore> store = m_store.acquire();
+
+	// UIDs are only valid with the UID validity of the folder
+	if (!store || !m_status || m_status->getUIDValidity() == 0)
+		return NULL;
+
+	return store->getCache();
+}
+
+
+const IMAPCache::mailboxKey IMAPFolder::getCacheKey() const
+{
+	ref <connectionInfos> infos = m_connection->getConnectionInfos();
+
+	std::ostringstream server;
+	server.imbue(std::locale::classic());
+
+	try
+	{
+		server << m_connection->getAuthenticator()->getUsername() << '@';
+	}
+	catch (exceptions::no_auth_information&)
+	{
+		// Anonymous
+	}
+
+	server << infos->getHost() << ':' << infos->getPort();
+
+	return IMAPCache::mailboxKey(server.str(),
+		IMAPUtils::pathToString(m_connection->hierarchySeparator(), getFullPath()),
+		m_status->getUIDValidity());
+}
+
+
+ref <IMAPMessage> IMAPFolder::createMessageFromFetchResponse
+	(const IMAPParser::message_data* msgData, const int options)
+{
+	ref <IMAPMessage> msg = vmime::create <IMAPMessage>
+		(thisRef().dynamicCast <IMAPFolder>(), static_cast <int>(msgData->number()));
+
+	msg->processFetchResponse(options, msgData);
+
+	return msg;
+}
+
+
+int IMAPFolder::getFetchCapabilities() const
+{
+	return (FETCH_ENVELOPE | FETCH_CONTENT_INFO | FETCH_STRUCTURE |
+	        FETCH_FLAGS | FETCH_SIZE | FETCH_FULL_HEADER | FETCH_UID |
+	        FETCH_IMPORTANCE);
+}
+
+
+ref <folder> IMAPFolder::getParent()
+{
+	if (m_path.isEmpty())
+		return NULL;
+	else
+		return vmime::create <IMAPFolder>(m_path.getParent(), m_store.acquire());
+}
+
+
+ref <const store> IMAPFolder::getStore() const
+{
+	return m_store.acquire();
+}
+
+
+ref <store> IMAPFolder::getStore()
+{
+	return m_store.acquire();
+}
+
+
+void IMAPFolder::registerMessage(IMAPMessage* msg)
+{
+	m_messages.push_back(msg);
+}
+
+
+void IMAPFolder::unregisterMessage(IMAPMessage* msg)
+{
+	std::vector <IMAPMessage*>::iterator it =
+		std::find(m_messages.begin(), m_messages.end(), msg);
+
+	if (it != m_messages.end())
+		m_messages.erase(it);
+}
+
+
+void IMAPFolder::onStoreDisconnected()
+{
+	m_store = NULL;
 }
 
 
@@ -995,6 +1460,9 @@ void IMAPFolder::setMessageFlags(const messageSet& msgs, const int flags, const
 void IMAPFolder::addMessage(ref <vmime::message> msg, const int flags,
                             vmime::datetime* date, utility::progressListener* progress)
 {
+	// The size of the message must be sent before its data, and some
+	// content handlers can only be read once: generate the message once,
+	// to memory, then stream it from there
 	std::ostringstream oss;
 	utility::outputStreamAdapter ossAdapter(oss);
 
@@ -1019,6 +1487,10 @@ void IMAPFolder::addMessage(utility::inputStream& is, const int size, const int
 	else if (m_mode == MODE_READ_ONLY)
 		throw exceptions::illegal_state("Folder is read-only");
 
+	// With LITERAL+, message data is sent without waiting
+	// for the server to be ready to receive it
+	const bool literalPlus = m_connection->hasCapability("LITERAL+");
+
 	// Build the request text
 	std::ostringstream command;
 	command.imbue(std::locale::classic());
@@ -1026,26 +1498,142 @@ void IMAPFolder::addMessage(utility::inputStream& is, const int size, const int
 	command << "APPEND " << IMAPUtils::quoteString(IMAPUtils::pathToString
 			(m_connection->hierarchySeparator(), getFullPath())) << ' ';
 
+	command << buildAppendArguments(flags, date, size, literalPlus);
+
+	// Send the request
+	m_connection->send(true, command.str(), true);
+
+	if (!literalPlus)
+		waitForContinuation("APPEND");
+
+	// Send message data
+	sendAppendData(is, size, progress);
+
+	m_connection->send(false, "", true);
+
+	// Get the response
+	utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("APPEND",
+			resp->getErrorLog(), "bad response");
+	}
+
+	processStatusUpdate(resp);
+}
+
+
+int IMAPFolder::addMessages(messageSource& source, const int maxMessagesPerCommand)
+{
+	ref <IMAPStore> store = m_store.acquire();
+
+	if (!store)
+		throw exceptions::illegal_state("Store disconnected");
+	else if (!isOpen())
+		throw exceptions::illegal_state("Folder not open");
+	else if (m_mode == MODE_READ_ONLY)
+		throw exceptions::illegal_state("Folder is read-only");
+
+	const bool literalPlus = m_connection->hasCapability("LITERAL+");
+	const int maxPerCommand = m_connection->hasCapability("MULTIAPPEND")
+		? std::max(1, maxMessagesPerCommand) : 1;
+
+	const string mailbox = IMAPUtils::quoteString(IMAPUtils::pathToString
+		(m_connection->hierarchySeparator(), getFullPath()));
+
+	int added = 0;
+	bool more = true;
+
+	while (more)
+	{
+		int count = 0;
+
+		for ( ; count < maxPerCommand ; ++count)
+		{
+			int size = 0;
+			int flags = message::FLAG_UNDEFINED;
+			vmime::datetime* date = NULL;
+
+			utility::inputStream* is = source.nextMessage(size, flags, date);
+
+			if (is == NULL)
+			{
+				more = false;
+				break;
+			}
+
+			// Example (MULTIAPPEND and LITERAL+):
+			//   C: A003 APPEND saved-messages (\Seen) {310+}
+			//   C: <310 octets of data> (\Seen) {328+}
+			//   C: <328 octets of data>
+			//   S: A003 OK APPEND completed
+			const string args = buildAppendArguments(flags, date, size, literalPlus);
+
+			if (count == 0)
+				m_connection->send(true, "APPEND " + mailbox + ' ' + args, true);
+			else
+				m_connection->send(false, ' ' + args, true);
+
+			if (!literalPlus)
+				waitForContinuation("APPEND");
+
+			sendAppendData(*is, size, NULL);
+		}
+
+		if (count == 0)
+			break;
+
+		m_connection->send(false, "", true);
+
+		// Get the response: messages of a command are added atomically
+		utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
+
+		if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+		{
+			throw exceptions::command_error("APPEND",
+				resp->getErrorLog(), "bad response");
+		}
+
+		processStatusUpdate(resp);
+
+		added += count;
+	}
+
+	return added;
+}
+
+
+const string IMAPFolder::buildAppendArguments
+	(const int flags, const vmime::datetime* date, const int size, const bool nonSyncLiteral) const
+{
+	std::ostringstream args;
+	args.imbue(std::locale::classic());
+
 	const string flagList = IMAPUtils::messageFlagList(flags);
 
 	if (flags != message::FLAG_UNDEFINED && !flagList.empty())
 	{
-		command << flagList;
-		command << ' ';
+		args << flagList;
+		args << ' ';
 	}
 
 	if (date != NULL)
 	{
-		command << IMAPUtils::dateTime(*date);
-		command << ' ';
+		args << IMAPUtils::dateTime(*date);
+		args << ' ';
 	}
 
-	command << '{' << size << '}';
+	args << '{' << size << (nonSyncLiteral ? "+}" : "}");
 
-	// Send the request
-	m_connection->send(true, command.str(), true);
+	return args.str();
+}
 
-	// Get the response
+
+void IMAPFolder::waitForContinuation(const string& command)
+{
 	utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
 
 	bool ok = false;
@@ -1061,11 +1649,15 @@ void IMAPFolder::addMessage(utility::inputStream& is, const int size, const int
 
 	if (!ok)
 	{
-		throw exceptions::command_error("APPEND",
+		throw exceptions::command_error(command,
 			resp->getErrorLog(), "bad response");
 	}
+}
 
-	// Send message data
+
+void IMAPFolder::sendAppendData(utility::inputStream& is, const int size,
+                                utility::progressListener* progress)
+{
 	const int total = size;
 	int current = 0;
 
@@ -1078,10 +1670,17 @@ void IMAPFolder::addMessage(utility::inputStream& is, const int size, const int
 	std::vector <char> vbuffer(blockSize);
 	char* buffer = &vbuffer.front();
 
-	while (!is.eof())
+	// Send exactly the number of bytes announced in the literal
+	while (current < total && !is.eof())
 	{
 		// Read some data from the input stream
-		const int read = is.read(buffer, sizeof(buffer));
+		const int read = static_cast <int>(is.read
+			(buffer, std::min(blockSize, static_cast <socket::size_type>(total - current))));
+
+		// No data is returned only at the end of the stream
+		if (read == 0)
+			break;
+
 		current += read;
 
 		// Put read data into socket output stream
@@ -1092,22 +1691,18 @@ void IMAPFolder::addMessage(utility::inputStream& is, const int size, const int
 			progress->progress(current, total);
 	}
 
-	m_connection->send(false, "", true);
-
-	if (progress)
-		progress->stop(total);
-
-	// Get the response
-	utility::auto_ptr <IMAPParser::response> finalResp(m_connection->readResponse());
-
-	if (finalResp->isBad() || finalResp->response_done()->response_tagged()->
-		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	// The server still expects the rest of the literal: the connection
+	// cannot be used for any other command
+	if (current != total)
 	{
-		throw exceptions::command_error("APPEND",
-			resp->getErrorLog(), "bad response");
+		m_connection->abort();
+
+		throw exceptions::command_error("APPEND", "",
+			"message data is shorter than the announced size");
 	}
 
-	processStatusUpdate(resp);
+	if (progress)
+		progress->stop(total);
 }
 
 
@@ -1224,7 +1819,11 @@ void IMAPFolder::copyMessages(const folder::path& dest, const messageSet& set)
 	std::ostringstream command;
 	command.imbue(std::locale::classic());
 
-	command << "COPY " << IMAPUtils::messageSetToSequenceSet(set) << " ";
+	if (set.isUIDSet())
+		command << "UID COPY " << IMAPUtils::messageSetToSequenceSet(set) << " ";
+	else
+		command << "COPY " << IMAPUtils::messageSetToSequenceSet(set) << " ";
+
 	command << IMAPUtils::quoteString(IMAPUtils::pathToString
 			(m_connection->hierarchySeparator(), dest));
 
@@ -1245,81 +1844,239 @@ void IMAPFolder::copyMessages(const folder::path& dest, const messageSet& set)
 }
 
 
-void IMAPFolder::status(int& count, int& unseen)
-{
-	count = 0;
-	unseen = 0;
-
-	ref <folderStatus> status = getStatus();
-
-	count = status->getMessageCount();
-	unseen = status->getUnseenCount();
-}
-
-
-ref <folderStatus> IMAPFolder::getStatus()
+folder::uidMapping IMAPFolder::moveMessages(const folder::path& dest, const messageSet& msgs)
 {
 	ref <IMAPStore> store = m_store.acquire();
 
+	if (msgs.isEmpty())
+		throw exceptions::invalid_argument();
+
 	if (!store)
 		throw exceptions::illegal_state("Store disconnected");
+	else if (!isOpen())
+		throw exceptions::illegal_state("Folder not open");
+	else if (m_mode == MODE_READ_ONLY)
+		throw exceptions::illegal_state("Folder is read-only");
 
-	// Build the request text
-	std::ostringstream command;
-	command.imbue(std::locale::classic());
+	const string prefix = (msgs.isUIDSet() ? "UID " : "");
+	const string set = IMAPUtils::messageSetToSequenceSet(msgs);
+	const string mailbox = IMAPUtils::quoteString(IMAPUtils::pathToString
+		(m_connection->hierarchySeparator(), dest));
 
-	command << "STATUS ";
-	command << IMAPUtils::quoteString(IMAPUtils::pathToString
-			(m_connection->hierarchySeparator(), getFullPath()));
-	command << " (";
+	uidMapping mapping;
 
-	command << "MESSAGES" << ' ' << "UNSEEN" << ' ' << "UIDNEXT" << ' ' << "UIDVALIDITY";
+	if (m_connection->hasCapability("MOVE"))
+	{
+		// Example:  C: a001 UID MOVE 42:69 Archive
+		//           S: * OK [COPYUID 432432 42:69 1202:1229]
+		//           S: * 22 EXPUNGE
+		//           (... more EXPUNGE responses ...)
+		//           S: a001 OK Done
+		m_connection->send(true, prefix + "MOVE " + set + " " + mailbox, true);
 
-	if (m_connection->hasCapability("CONDSTORE"))
-		command << ' ' << "HIGHESTMODSEQ";
+		utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
 
-	command << ")";
+		if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+		{
+			throw exceptions::command_error("MOVE",
+				resp->getErrorLog(), "bad response");
+		}
 
-	// Send the request
-	m_connection->send(true, command.str(), true);
+		extractCopyUIDs(resp, mapping);
 
-	// Get the response
-	utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
+		processStatusUpdate(resp);
 
-	if (resp->isBad() || resp->response_done()->response_tagged()->
-		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
-	{
-		throw exceptions::command_error("STATUS",
-			resp->getErrorLog(), "bad response");
+		return mapping;
 	}
 
-	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
-		resp->continue_req_or_response_data();
+	// Copy the messages
+	m_connection->send(true, prefix + "COPY " + set + " " + mailbox, true);
 
-	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
-	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
 	{
-		if ((*it)->response_data() != NULL)
-		{
-			const IMAPParser::response_data* responseData = (*it)->response_data();
+		utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
 
-			if (responseData->mailbox_data() &&
-				responseData->mailbox_data()->type() == IMAPParser::mailbox_data::STATUS)
-			{
-				ref <IMAPFolderStatus> status = vmime::create <IMAPFolderStatus>();
-				status->updateFromResponse(responseData->mailbox_data());
+		if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+		{
+			throw exceptions::command_error("COPY",
+				resp->getErrorLog(), "bad response");
+		}
 
-				m_status->updateFromResponse(responseData->mailbox_data());
+		extractCopyUIDs(resp, mapping);
 
-				return status;
-			}
-		}
+		processStatusUpdate(resp);
 	}
 
-	throw exceptions::command_error("STATUS",
-		resp->getErrorLog(), "invalid response");
-}
-
+	// Expunge only the moved messages. This requires UIDPLUS and their
+	// UIDs; otherwise, "EXPUNGE" would also remove other messages marked
+	// as deleted, so the messages are left for the caller to expunge.
+	string uidSet;
+
+	if (m_connection->hasCapability("UIDPLUS"))
+	{
+		if (msgs.isUIDSet())
+		{
+			uidSet = set;
+		}
+		else if (!mapping.empty())
+		{
+			std::vector <message::uid> uids;
+
+			for (uidMapping::const_iterator it = mapping.begin() ; it != mapping.end() ; ++it)
+				uids.push_back((*it).first);
+
+			uidSet = IMAPUtils::messageSetToSequenceSet(messageSet::byUID(uids));
+		}
+	}
+
+	// Mark the messages as deleted. UID EXPUNGE is pipelined with STORE:
+	// as all the messages have been copied, it cannot remove a message
+	// which has not been moved, even if STORE fails.
+	m_connection->send(true, prefix + "STORE " + set + " +FLAGS.SILENT (\\Deleted)", true);
+
+	const string storeTag = m_connection->getLastTag();
+	string expungeTag;
+
+	if (!uidSet.empty())
+	{
+		m_connection->send(true, "UID EXPUNGE " + uidSet, true);
+		expungeTag = m_connection->getLastTag();
+	}
+
+	// Read both responses before reporting an error, so that the
+	// connection is left in a consistent state
+	utility::auto_ptr <IMAPParser::response> storeResp
+		(m_connection->readResponse(storeTag));
+
+	processStatusUpdate(storeResp);
+
+	utility::auto_ptr <IMAPParser::response> expungeResp
+		(expungeTag.empty() ? NULL : m_connection->readResponse(expungeTag));
+
+	if (!expungeTag.empty())
+		processStatusUpdate(expungeResp);
+
+	if (storeResp->isBad() || storeResp->response_done()->response_tagged()->
+		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("STORE",
+			storeResp->getErrorLog(), "bad response");
+	}
+
+	if (!expungeTag.empty() && (expungeResp->isBad() || expungeResp->response_done()->
+		response_tagged()->resp_cond_state()->status() != IMAPParser::resp_cond_state::OK))
+	{
+		throw exceptions::command_error("UID EXPUNGE",
+			expungeResp->getErrorLog(), "bad response");
+	}
+
+	return mapping;
+}
+
+
+// static
+void IMAPFolder::extractCopyUIDs(const IMAPParser::response* resp, uidMapping& mapping)
+{
+	std::vector <const IMAPParser::resp_text_code*> codes;
+
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+	{
+		if ((*it)->response_data() && (*it)->response_data()->resp_cond_state())
+			codes.push_back((*it)->response_data()->resp_cond_state()->resp_text()->resp_text_code());
+	}
+
+	if (resp->response_done()->response_tagged())
+		codes.push_back(resp->response_done()->response_tagged()->resp_cond_state()->resp_text()->resp_text_code());
+
+	for (std::vector <const IMAPParser::resp_text_code*>::const_iterator
+	     it = codes.begin() ; it != codes.end() ; ++it)
+	{
+		if (*it == NULL || (*it)->type() != IMAPParser::resp_text_code::COPYUID)
+			continue;
+
+		// "COPYUID" SP uidvalidity SP source-uid-set SP dest-uid-set
+		const std::vector <message::uid> srcUIDs = IMAPUtils::uidSetToList((*it)->uid_set());
+		const std::vector <message::uid> destUIDs = IMAPUtils::uidSetToList((*it)->uid_set2());
+
+		for (unsigned int i = 0, n = std::min(srcUIDs.size(), destUIDs.size()) ; i < n ; ++i)
+			mapping.push_back(std::make_pair(srcUIDs[i], destUIDs[i]));
+	}
+}
+
+
+void IMAPFolder::status(int& count, int& unseen)
+{
+	count = 0;
+	unseen = 0;
+
+	ref <folderStatus> status = getStatus();
+
+	count = status->getMessageCount();
+	unseen = status->getUnseenCount();
+}
+
+
+ref <folderStatus> IMAPFolder::getStatus()
+{
+	ref <IMAPStore> store = m_store.acquire();
+
+	if (!store)
+		throw exceptions::illegal_state("Store disconnected");
+
+	// Build the request text
+	std::ostringstream command;
+	command.imbue(std::locale::classic());
+
+	command << "STATUS ";
+	command << IMAPUtils::quoteString(IMAPUtils::pathToString
+			(m_connection->hierarchySeparator(), getFullPath()));
+	command << ' ' << IMAPUtils::buildStatusAttributes(m_connection->hasCapability("CONDSTORE"));
+
+	// Send the request
+	m_connection->send(true, command.str(), true);
+
+	// Get the response
+	utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("STATUS",
+			resp->getErrorLog(), "bad response");
+	}
+
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+	{
+		if ((*it)->response_data() != NULL)
+		{
+			const IMAPParser::response_data* responseData = (*it)->response_data();
+
+			if (responseData->mailbox_data() &&
+				responseData->mailbox_data()->type() == IMAPParser::mailbox_data::STATUS)
+			{
+				ref <IMAPFolderStatus> status = vmime::create <IMAPFolderStatus>();
+				status->updateFromResponse(responseData->mailbox_data());
+
+				m_status->updateFromResponse(responseData->mailbox_data());
+
+				return status;
+			}
+		}
+	}
+
+	throw exceptions::command_error("STATUS",
+		resp->getErrorLog(), "invalid response");
+}
+
 
 void IMAPFolder::noop()
 {
@@ -1400,6 +2157,419 @@ std::vector <int> IMAPFolder::getMessageNumbersStartingOnUID(const message::uid&
 }
 
 
+IMAPFolder::searchResult::searchResult()
+	: options(0), min(0), max(0), count(0), all(messageSet::none()), modseq(0)
+{
+}
+
+
+IMAPFolder::messageThread::messageThread()
+	: id(0)
+{
+}
+
+
+messageSet IMAPFolder::search(const searchCriteria& criteria, const bool uid)
+{
+	// With ESEARCH, the server returns a sequence set, which is much
+	// shorter than the list of messages if most messages match
+	return extendedSearch(criteria, SEARCH_RETURN_ALL, uid).all;
+}
+
+
+IMAPFolder::searchResult IMAPFolder::extendedSearch
+	(const searchCriteria& criteria, const int returnOptions, const bool uid)
+{
+	searchResult result;
+	result.options = returnOptions;
+
+	if (m_connection->hasCapability("ESEARCH"))
+	{
+		// Example:
+		//    C: a001 UID SEARCH RETURN (MIN COUNT) UNSEEN
+		//    S: * ESEARCH (TAG "a001") UID MIN 7 COUNT 3
+		//    S: a001 OK Search completed
+		std::vector <string> options;
+
+		if (returnOptions & SEARCH_RETURN_MIN) options.push_back("MIN");
+		if (returnOptions & SEARCH_RETURN_MAX) options.push_back("MAX");
+		if (returnOptions & SEARCH_RETURN_COUNT) options.push_back("COUNT");
+		if (returnOptions & SEARCH_RETURN_ALL) options.push_back("ALL");
+
+		std::ostringstream command;
+		command.imbue(std::locale::classic());
+
+		command << (uid ? "UID SEARCH RETURN (" : "SEARCH RETURN (");
+
+		for (unsigned int i = 0 ; i < options.size() ; ++i)
+		{
+			if (i != 0)
+				command << ' ';
+
+			command << options[i];
+		}
+
+		command << ')';
+
+		utility::auto_ptr <IMAPParser::response> resp
+			(sendSearchCommand(command.str(), criteria, false));
+
+		// The server omits the ESEARCH response, or the items which do
+		// not apply, if no message matches
+		const IMAPParser::esearch_response* esearch =
+			findESearchResponse(resp, m_connection->getLastTag());
+
+		if (esearch != NULL)
+		{
+			const std::vector <IMAPParser::search_return_data*>& data =
+				esearch->search_return_data();
+
+			for (std::vector <IMAPParser::search_return_data*>::const_iterator
+			     jt = data.begin() ; jt != data.end() ; ++jt)
+			{
+				const IMAPParser::search_return_data* rd = *jt;
+
+				switch (rd->type())
+				{
+				case IMAPParser::search_return_data::MIN:
+
+					result.min = static_cast <vmime_uint32>(rd->number()->value());
+					break;
+
+				case IMAPParser::search_return_data::MAX:
+
+					result.max = static_cast <vmime_uint32>(rd->number()->value());
+					break;
+
+				case IMAPParser::search_return_data::COUNT:
+
+					result.count = static_cast <vmime_uint32>(rd->number()->value());
+					break;
+
+				case IMAPParser::search_return_data::ALL:
+
+					// Ranges are kept as they are, without being expanded
+					result.all = IMAPUtils::sequenceSetToMessageSet(rd->sequence_set(), uid);
+					break;
+
+				case IMAPParser::search_return_data::MODSEQ:
+
+					result.modseq = rd->mod_sequence_value()->value();
+					break;
+
+				case IMAPParser::search_return_data::OTHER:
+
+					// Unknown items are ignored (RFC 4731)
+					break;
+				}
+			}
+		}
+
+		processStatusUpdate(resp);
+	}
+	else
+	{
+		utility::auto_ptr <IMAPParser::response> resp
+			(sendSearchCommand(uid ? "UID SEARCH" : "SEARCH", criteria, false));
+
+		std::vector <vmime_uint32> all;
+
+		const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+			resp->continue_req_or_response_data();
+
+		for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+		     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+		{
+			if ((*it)->response_data() == NULL)
+				continue;
+
+			const IMAPParser::mailbox_data* mailboxData =
+				(*it)->response_data()->mailbox_data();
+
+			if (mailboxData == NULL ||
+			    mailboxData->type() != IMAPParser::mailbox_data::SEARCH)
+			{
+				continue;
+			}
+
+			for (std::vector <IMAPParser::nz_number*>::const_iterator
+			     jt = mailboxData->search_nz_number_list().begin() ;
+			     jt != mailboxData->search_nz_number_list().end() ; ++jt)
+			{
+				all.push_back(static_cast <vmime_uint32>((*jt)->value()));
+			}
+
+			if (mailboxData->mod_sequence_value())
+				result.modseq = mailboxData->mod_sequence_value()->value();
+		}
+
+		processStatusUpdate(resp);
+
+		std::sort(all.begin(), all.end());
+
+		if (!all.empty())
+		{
+			result.min = all.front();
+			result.max = all.back();
+		}
+
+		result.count = static_cast <vmime_uint32>(all.size());
+
+		if (returnOptions & SEARCH_RETURN_ALL)
+		{
+			if (uid)
+			{
+				std::vector <message::uid> uids;
+
+				for (std::vector <vmime_uint32>::const_iterator
+				     it = all.begin() ; it != all.end() ; ++it)
+				{
+					std::ostringstream oss;
+					oss.imbue(std::locale::classic());
+					oss << *it;
+
+					uids.push_back(message::uid(oss.str()));
+				}
+
+				result.all = messageSet::byUID(uids);
+			}
+			else
+			{
+				result.all = messageSet::byNumber
+					(std::vector <int>(all.begin(), all.end()));
+			}
+		}
+	}
+
+	return result;
+}
+
+
+std::vector <vmime_uint32> IMAPFolder::sort
+	(const std::vector <int>& keys, const searchCriteria& criteria, const bool uid)
+{
+	if (!m_connection->hasCapability("SORT"))
+		throw exceptions::operation_not_supported();
+
+	if (keys.empty())
+		throw exceptions::invalid_argument();
+
+	// sort-criteria = "(" sort-criterion *(SP sort-criterion) ")"
+	// sort-criterion = ["REVERSE" SP] sort-key
+	std::ostringstream command;
+	command.imbue(std::locale::classic());
+
+	command << (uid ? "UID SORT (" : "SORT (");
+
+	for (unsigned int i = 0 ; i < keys.size() ; ++i)
+	{
+		if (i != 0)
+			command << ' ';
+
+		if (keys[i] & SORT_REVERSE)
+			command << "REVERSE ";
+
+		switch (keys[i] & ~SORT_REVERSE)
+		{
+		case SORT_ARRIVAL: command << "ARRIVAL"; break;
+		case SORT_CC: command << "CC"; break;
+		case SORT_DATE: command << "DATE"; break;
+		case SORT_FROM: command << "FROM"; break;
+		case SORT_SIZE: command << "SIZE"; break;
+		case SORT_SUBJECT: command << "SUBJECT"; break;
+		case SORT_TO: command << "TO"; break;
+
+		default:
+
+			throw exceptions::invalid_argument();
+		}
+	}
+
+	command << ')';
+
+	utility::auto_ptr <IMAPParser::response> resp
+		(sendSearchCommand(command.str(), criteria, true));
+
+	std::vector <vmime_uint32> result;
+
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+	{
+		if ((*it)->response_data() == NULL)
+			continue;
+
+		const IMAPParser::mailbox_data* mailboxData =
+			(*it)->response_data()->mailbox_data();
+
+		if (mailboxData == NULL ||
+		    mailboxData->type() != IMAPParser::mailbox_data::SORT)
+		{
+			continue;
+		}
+
+		for (std::vector <IMAPParser::nz_number*>::const_iterator
+		     jt = mailboxData->search_nz_number_list().begin() ;
+		     jt != mailboxData->search_nz_number_list().end() ; ++jt)
+		{
+			result.push_back(static_cast <vmime_uint32>((*jt)->value()));
+		}
+	}
+
+	processStatusUpdate(resp);
+
+	return result;
+}
+
+
+std::vector <IMAPFolder::messageThread> IMAPFolder::thread
+	(const int algorithm, const searchCriteria& criteria, const bool uid)
+{
+	string name;
+
+	switch (algorithm)
+	{
+	case THREAD_ORDEREDSUBJECT: name = "ORDEREDSUBJECT"; break;
+	case THREAD_REFERENCES: name = "REFERENCES"; break;
+
+	default:
+
+		throw exceptions::invalid_argument();
+	}
+
+	if (!m_connection->hasCapability("THREAD=" + name))
+		throw exceptions::operation_not_supported();
+
+	utility::auto_ptr <IMAPParser::response> resp
+		(sendSearchCommand((uid ? "UID THREAD " : "THREAD ") + name, criteria, true));
+
+	std::vector <messageThread> threads;
+
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+	{
+		if ((*it)->response_data() == NULL)
+			continue;
+
+		const IMAPParser::mailbox_data* mailboxData =
+			(*it)->response_data()->mailbox_data();
+
+		if (mailboxData == NULL ||
+		    mailboxData->type() != IMAPParser::mailbox_data::THREAD)
+		{
+			continue;
+		}
+
+		for (std::vector <IMAPParser::thread_list*>::const_iterator
+		     jt = mailboxData->thread_list().begin() ;
+		     jt != mailboxData->thread_list().end() ; ++jt)
+		{
+			convertThreadList(*jt, threads);
+		}
+	}
+
+	processStatusUpdate(resp);
+
+	return threads;
+}
+
+
+// static
+void IMAPFolder::convertThreadList
+	(const IMAPParser::thread_list* list, std::vector <messageThread>& threads)
+{
+	const std::vector <IMAPParser::nz_number*>& members = list->members();
+	std::vector <messageThread>* dest = &threads;
+
+	if (members.empty())
+	{
+		// The root of the thread is not part of the result: use a
+		// dummy message so that the sub-threads remain grouped
+		dest->push_back(messageThread());
+		dest = &dest->back().children;
+	}
+	else
+	{
+		// Each member is the parent of the next one
+		for (std::vector <IMAPParser::nz_number*>::const_iterator
+		     it = members.begin() ; it != members.end() ; ++it)
+		{
+			messageThread t;
+			t.id = static_cast <vmime_uint32>((*it)->value());
+
+			dest->push_back(t);
+			dest = &dest->back().children;
+		}
+	}
+
+	for (std::vector <IMAPParser::thread_list*>::const_iterator
+	     it = list->nested().begin() ; it != list->nested().end() ; ++it)
+	{
+		convertThreadList(*it, *dest);
+	}
+}
+
+
+IMAPParser::response* IMAPFolder::sendSearchCommand
+	(const string& command, const searchCriteria& criteria, const bool charsetRequired)
+{
+	ref <IMAPStore> store = m_store.acquire();
+
+	if (!store)
+		throw exceptions::illegal_state("Store disconnected");
+	else if (!isOpen())
+		throw exceptions::illegal_state("Folder not open");
+
+	const bool literalPlus = m_connection->hasCapability("LITERAL+");
+
+	std::vector <string> parts;
+	const bool utf8 = IMAPUtils::buildSearchKeys(criteria, literalPlus, parts);
+
+	// Example (without LITERAL+):
+	//    C: a001 SEARCH CHARSET UTF-8 SUBJECT {6}
+	//    S: + Ready for literal data
+	//    C: ÄÖÜ FLAGGED
+	//    S: * SEARCH 4 7
+	//    S: a001 OK Search completed
+	string line = command;
+
+	if (charsetRequired)
+		line += " UTF-8";
+	else if (utf8)
+		line += " CHARSET UTF-8";
+
+	line += " " + parts[0];
+
+	m_connection->send(true, line, true);
+
+	for (unsigned int i = 1 ; i < parts.size() ; ++i)
+	{
+		if (!literalPlus)
+			waitForContinuation(command);
+
+		m_connection->send(false, parts[i], true);
+	}
+
+	IMAPParser::response* resp = m_connection->readResponse();
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		const string errorLog = resp->getErrorLog();
+		delete resp;
+
+		throw exceptions::command_error(command, errorLog, "bad response");
+	}
+
+	return resp;
+}
+
+
 void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
 {
 	std::vector <ref <events::event> > events;
@@ -1407,6 +2577,8 @@ void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
 	ref <IMAPFolderStatus> oldStatus = m_status->clone().dynamicCast <IMAPFolderStatus>();
 	int expungedMessageCount = 0;
 
+	std::vector <message::uid> expungedUIDs;
+
 	// Process tagged response
 	if (resp->response_done() && resp->response_done()->response_tagged() &&
 	    resp->response_done()->response_tagged()
@@ -1463,7 +2635,12 @@ void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
 				     m_messages.begin() ; jt != m_messages.end() ; ++jt)
 				{
 					if ((*jt)->getNumber() == msgNumber)
+					{
+						if (!(*jt)->m_uid.empty())
+							expungedUIDs.push_back((*jt)->m_uid);
+
 						(*jt)->setExpunged();
+					}
 					else if ((*jt)->getNumber() > msgNumber)
 						(*jt)->renumber((*jt)->getNumber() - 1);
 				}
@@ -1478,6 +2655,27 @@ void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
 		}
 	}
 
+	// Expunged messages will never be fetched again
+	if (!expungedUIDs.empty())
+	{
+		ref <IMAPCache> cache = getCache();
+
+		if (cache)
+		{
+			try
+			{
+				const IMAPCache::mailboxKey key = getCacheKey();
+
+				for (size_t i = 0 ; i < expungedUIDs.size() ; ++i)
+					cache->removeMessage(key, expungedUIDs[i]);
+			}
+			catch (exception&)
+			{
+				// Ignore: the cache is only an optimization
+			}
+		}
+	}
+
 	// New messages arrived
 	if (m_status->getMessageCount() > oldStatus->getMessageCount() - expungedMessageCount)
 	{
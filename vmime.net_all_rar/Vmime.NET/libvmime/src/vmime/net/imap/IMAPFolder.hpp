@@ -39,6 +39,7 @@
 #include "../vmime/net/folder.hpp"
 
 #include "../vmime/net/imap/IMAPParser.hpp"
+#include "../vmime/net/imap/IMAPCache.hpp"
 
 
 namespace vmime {
@@ -61,6 +62,7 @@ private:
 
 	friend class IMAPStore;
 	friend class IMAPMessage;
+	friend class IMAPPartDownloader;
 	friend class vmime::creator;  // vmime::create <IMAPFolder>
 
 
@@ -95,6 +97,122 @@ public:
 
 	std::vector <int> getMessageNumbersStartingOnUID(const message::uid& uid);
 
+	messageSet search(const searchCriteria& criteria, const bool uid = false);
+
+	/** Information which can be requested with extendedSearch().
+	  */
+	enum SearchReturnOptions
+	{
+		SEARCH_RETURN_MIN = (1 << 0),    /**< Lowest matching message. */
+		SEARCH_RETURN_MAX = (1 << 1),    /**< Highest matching message. */
+		SEARCH_RETURN_COUNT = (1 << 2),  /**< Number of matching messages. */
+		SEARCH_RETURN_ALL = (1 << 3)     /**< All matching messages. */
+	};
+
+	/** Result of extendedSearch().
+	  */
+	class searchResult
+	{
+	public:
+
+		searchResult();
+
+		int options;                     /**< information available (see SearchReturnOptions) */
+		vmime_uint32 min;                /**< lowest matching message, or zero if none */
+		vmime_uint32 max;                /**< highest matching message, or zero if none */
+		vmime_uint32 count;              /**< number of matching messages */
+		messageSet all;                  /**< matching messages (by UID or by number,
+		                                      as requested), or an empty set */
+		vmime_uint64 modseq;             /**< highest modification sequence of the matching
+		                                      messages if the criteria use MODSEQ, or zero */
+	};
+
+	/** Search for the messages which match the specified criteria,
+	  * and return only the requested information.
+	  *
+	  * If the server supports ESEARCH, it only sends the requested
+	  * information: for example, counting the matching messages does not
+	  * transfer the list of the messages. Otherwise, the information is
+	  * computed from the result of a SEARCH command.
+	  *
+	  * @param criteria search criteria
+	  * @param returnOptions information to return (combination of
+	  * SearchReturnOptions flags)
+	  * @param uid if true, return UIDs; otherwise, return message
+	  * sequence numbers
+	  * @return search result
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	searchResult extendedSearch(const searchCriteria& criteria, const int returnOptions, const bool uid = false);
+
+	/** Keys used to sort messages with sort().
+	  */
+	enum SortKeys
+	{
+		SORT_ARRIVAL,           /**< Internal date and time of the message. */
+		SORT_CC,                /**< First "Cc:" address. */
+		SORT_DATE,              /**< "Date:" header. */
+		SORT_FROM,              /**< First "From:" address. */
+		SORT_SIZE,              /**< Message size. */
+		SORT_SUBJECT,           /**< Base subject (without "Re:", "Fwd:", etc.). */
+		SORT_TO,                /**< First "To:" address. */
+
+		SORT_REVERSE = (1 << 8) /**< Combined with a key, sort in reverse order. */
+	};
+
+	/** Sort the messages which match the specified criteria. Sorting
+	  * is performed by the server: this requires the SORT extension.
+	  *
+	  * @param keys sort keys, by order of precedence (see SortKeys)
+	  * @param criteria search criteria
+	  * @param uid if true, return UIDs; otherwise, return message
+	  * sequence numbers
+	  * @return sorted list of the matching messages
+	  * @throw exceptions::operation_not_supported if the server does
+	  * not support sorting
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	std::vector <vmime_uint32> sort(const std::vector <int>& keys,
+		const searchCriteria& criteria, const bool uid = false);
+
+	/** Algorithms used to group messages into threads with thread().
+	  */
+	enum ThreadAlgorithms
+	{
+		THREAD_ORDEREDSUBJECT,  /**< Group messages by base subject. */
+		THREAD_REFERENCES       /**< Use "References:" and "In-Reply-To:" headers. */
+	};
+
+	/** A message in a thread, and the replies to this message.
+	  */
+	class messageThread
+	{
+	public:
+
+		messageThread();
+
+		vmime_uint32 id;                         /**< message (UID or sequence number), or zero if
+		                                              the message is not part of the result (in this
+		                                              case, the children are siblings) */
+		std::vector <messageThread> children;    /**< replies to the message */
+	};
+
+	/** Group the messages which match the specified criteria into
+	  * threads. Threading is performed by the server: this requires
+	  * the THREAD extension with the requested algorithm.
+	  *
+	  * @param algorithm threading algorithm (see ThreadAlgorithms)
+	  * @param criteria search criteria
+	  * @param uid if true, return UIDs; otherwise, return message
+	  * sequence numbers
+	  * @return list of threads
+	  * @throw exceptions::operation_not_supported if the server does
+	  * not support the algorithm
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	std::vector <messageThread> thread(const int algorithm,
+		const searchCriteria& criteria, const bool uid = false);
+
 	int getMessageCount();
 
 	ref <folder> getFolder(const folder::path::component& name);
@@ -109,8 +227,63 @@ public:
 	void addMessage(ref <vmime::message> msg, const int flags = message::FLAG_UNDEFINED, vmime::datetime* date = NULL, utility::progressListener* progress = NULL);
 	void addMessage(utility::inputStream& is, const int size, const int flags = message::FLAG_UNDEFINED, vmime::datetime* date = NULL, utility::progressListener* progress = NULL);
 
+	/** Provides the messages added with addMessages().
+	  */
+	class messageSource
+	{
+	public:
+
+		virtual ~messageSource() { }
+
+		/** Return the next message to add.
+		  *
+		  * @param size receives the size of the message data, in bytes
+		  * @param flags receives the flags of the message (combination of
+		  * message::Flags), or message::FLAG_UNDEFINED if not set
+		  * @param date receives the date of the message, or NULL if not set;
+		  * it must remain valid until the next call
+		  * @return stream from which the message data is read, or NULL if
+		  * there are no more messages; it must remain valid until the next call
+		  */
+		virtual utility::inputStream* nextMessage(int& size, int& flags, vmime::datetime*& date) = 0;
+	};
+
+	/** Add a large number of messages to this folder.
+	  *
+	  * If the server supports MULTIAPPEND, several messages are added
+	  * with a single command. If it supports LITERAL+, message data is
+	  * sent without waiting for the server to be ready to receive it.
+	  * Messages added with a single command are added atomically: if
+	  * an error occurs, none of them have been added.
+	  *
+	  * @param source provides the messages to add
+	  * @param maxMessagesPerCommand maximum number of messages added
+	  * with a single command (if MULTIAPPEND is supported)
+	  * @return number of messages added
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	int addMessages(messageSource& source, const int maxMessagesPerCommand = 100);
+
 	void copyMessages(const folder::path& dest, const messageSet& msgs);
 
+	/** Move messages from this folder to another folder.
+	  *
+	  * If the server supports MOVE, messages are moved with a single
+	  * command. Otherwise, they are copied and marked as deleted; then,
+	  * if the server supports UIDPLUS, only the moved messages are
+	  * expunged with "UID EXPUNGE". Without UIDPLUS, the messages are
+	  * only marked as deleted: call expunge() to remove them (this also
+	  * removes other messages marked as deleted).
+	  *
+	  * @param dest destination folder path
+	  * @param msgs index set of messages to move
+	  * @return UIDs of the moved messages in the destination folder, if
+	  * the server supports UIDPLUS (COPYUID response code); otherwise,
+	  * an empty list
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	uidMapping moveMessages(const folder::path& dest, const messageSet& msgs);
+
 	void status(int& count, int& unseen);
 	ref <folderStatus> getStatus();
 
@@ -127,6 +300,50 @@ public:
 	void fetchMessages(std::vector <ref <message> >& msg, const int options, utility::progressListener* progress = NULL);
 	void fetchMessage(ref <message> msg, const int options);
 
+	/** Receives the messages fetched by the streaming variant
+	  * of fetchMessages().
+	  */
+	class messageFetchHandler
+	{
+	public:
+
+		virtual ~messageFetchHandler() { }
+
+		/** Called for each message, as soon as its FETCH response has
+		  * been parsed. The folder does not keep any reference to the
+		  * message: hold it yourself if you need it after this call.
+		  *
+		  * No more data is read from the server until this function
+		  * returns, so a slow handler throttles the transfer.
+		  *
+		  * If this function throws an exception, the remaining messages
+		  * are read but not delivered, then the exception is passed to
+		  * the caller of fetchMessages().
+		  *
+		  * @param msg message filled in with the requested objects
+		  * @return true to continue, or false to ignore the remaining
+		  * messages (the server response is still read until its end)
+		  */
+		virtual bool handleMessage(ref <message> msg) = 0;
+	};
+
+	/** Fetch objects for the specified messages, without creating the
+	  * message objects beforehand and without keeping the whole server
+	  * response in memory. A single FETCH command is sent for the set,
+	  * and each message is handed to the handler as soon as it has been
+	  * received.
+	  *
+	  * FETCH responses consumed this way do not emit any
+	  * messageChangedEvent.
+	  *
+	  * @param msgs index set of messages to fetch (sequence numbers or UIDs)
+	  * @param options objects to fetch (combination of folder::FetchOptions flags)
+	  * @param handler receives each fetched message
+	  * @param progress progress listener, or NULL if not used
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	void fetchMessages(const messageSet& msgs, const int options, messageFetchHandler* handler, utility::progressListener* progress = NULL);
+
 	int getFetchCapabilities() const;
 
 	/** Returns the UID validity of the folder for the current session.
@@ -151,6 +368,8 @@ public:
 
 private:
 
+	class fetchResponseHandler;
+
 	void registerMessage(IMAPMessage* msg);
 	void unregisterMessage(IMAPMessage* msg);
 
@@ -158,11 +377,120 @@ private:
 
 	void onClose();
 
+	/** Mark the folder as closed, after its connection has been
+	  * given back to the store.
+	  */
+	void resetState();
+
 	int testExistAndGetType();
 
+	/** Creates a message object from a FETCH response which is
+	  * not bound to any message object yet.
+	  *
+	  * @param msgData pointer to message_data component of the parsed response
+	  * @param options fetch options used in the request (see folder::FetchOptions)
+	  * @return new message object
+	  */
+	ref <IMAPMessage> createMessageFromFetchResponse(const IMAPParser::message_data* msgData, const int options);
+
+	/** Send a FETCH command for the specified messages and process
+	  * the response.
+	  *
+	  * @param msgs messages to fetch
+	  * @param options objects to fetch (see folder::FetchOptions)
+	  * @param modifiers FETCH modifiers appended to the command, or
+	  * an empty string (eg. " (CHANGEDSINCE 12345)")
+	  * @param progress progress listener, or NULL if not used
+	  */
+	void fetchMessagesImpl(const std::vector <ref <IMAPMessage> >& msgs, const int options,
+		const string& modifiers, utility::progressListener* progress);
+
+	/** Fetch messages, taking from the cache the objects that were
+	  * retrieved during a previous session, and storing in the cache
+	  * the objects that were not found.
+	  *
+	  * @param cache cache
+	  * @param msgs messages to fetch
+	  * @param options objects to fetch (see folder::FetchOptions)
+	  * @param progress progress listener, or NULL if not used
+	  */
+	void fetchMessagesCached(ref <IMAPCache> cache, const std::vector <ref <IMAPMessage> >& msgs,
+		const int options, utility::progressListener* progress);
+
+	/** Return the cache to use for this folder.
+	  *
+	  * @return cache set on the store, or NULL if no cache is set or
+	  * if the folder has no UID validity
+	  */
+	ref <IMAPCache> getCache() const;
+
+	/** Return the key which identifies this folder in the cache.
+	  *
+	  * @return mailbox key
+	  */
+	const IMAPCache::mailboxKey getCacheKey() const;
+
+	/** Build the arguments of APPEND for a message (without the
+	  * mailbox name), up to and including the literal size.
+	  *
+	  * @param flags flags of the message, or message::FLAG_UNDEFINED
+	  * @param date date of the message, or NULL
+	  * @param size size of the message data
+	  * @param nonSyncLiteral use a non-synchronizing literal (LITERAL+)
+	  * @return APPEND arguments (eg. "(\Seen) {310+}")
+	  */
+	const string buildAppendArguments(const int flags, const vmime::datetime* date,
+		const int size, const bool nonSyncLiteral) const;
+
+	/** Wait for the server to be ready to receive literal data (ie. wait
+	  * for the continuation request) after a synchronizing literal.
+	  *
+	  * @param command name of the command being sent (for error reporting)
+	  * @throw exceptions::command_error if the server refuses the command
+	  */
+	void waitForContinuation(const string& command);
+
+	/** Send message data of APPEND to the server.
+	  *
+	  * @param is stream from which message data is read
+	  * @param size number of bytes to send
+	  * @param progress progress listener, or NULL if not used
+	  * @throw exceptions::invalid_argument if the stream contains less
+	  * than size bytes
+	  */
+	void sendAppendData(utility::inputStream& is, const int size, utility::progressListener* progress);
+
+	/** Send a command which takes search keys (SEARCH, SORT or THREAD)
+	  * and read the response.
+	  *
+	  * @param command command name and arguments preceding the charset
+	  * (eg. "UID SORT (DATE)")
+	  * @param criteria search criteria
+	  * @param charsetRequired if true, the charset is always specified
+	  * (SORT and THREAD); otherwise, "CHARSET" is specified only if needed
+	  * @return server response
+	  * @throw exceptions::command_error if the command failed
+	  */
+	IMAPParser::response* sendSearchCommand(const string& command,
+		const searchCriteria& criteria, const bool charsetRequired);
+
+	/** Convert a parser-style thread list into message threads.
+	  *
+	  * @param list thread list from a THREAD response
+	  * @param threads list to which threads are appended
+	  */
+	static void convertThreadList(const IMAPParser::thread_list* list, std::vector <messageThread>& threads);
+
 	void setMessageFlagsImpl(const string& set, const int flags, const int mode);
 
-	void copyMessagesImpl(const string& set, const folder::path& dest);
+	/** Extract the UIDs of copied or moved messages from the COPYUID
+	  * response code (UIDPLUS), which may be sent either in the tagged
+	  * response or in an untagged "OK" response.
+	  *
+	  * @param resp parsed IMAP response
+	  * @param mapping list to which UID correspondences are appended
+	  */
+	static void extractCopyUIDs(const IMAPParser::response* resp, uidMapping& mapping);
 
 
 	/** Process status updates ("unsolicited responses") contained in the
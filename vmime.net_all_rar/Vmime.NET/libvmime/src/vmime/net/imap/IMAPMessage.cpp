@@ -73,6 +73,7 @@ public:
 				<const IMAPParser::msg_att_item&>(comp).type();
 
 			if (type == IMAPParser::msg_att_item::BODY_SECTION ||
+			    type == IMAPParser::msg_att_item::BINARY_SECTION ||
 			    type == IMAPParser::msg_att_item::RFC822_TEXT)
 			{
 				return new targetStream(m_progress, m_os);
@@ -88,6 +89,66 @@ private:
 	utility::progressListener* m_progress;
 };
 
+
+//
+// IMAPMessage_cachingOutputStream
+//
+
+// Forwards data to another stream, and keeps a copy of it
+// (as long as it does not exceed a maximum size)
+
+class IMAPMessage_cachingOutputStream : public utility::outputStream
+{
+public:
+
+	IMAPMessage_cachingOutputStream(utility::outputStream& os, const size_t maxSize)
+		: m_os(os), m_maxSize(maxSize), m_overflow(false)
+	{
+	}
+
+	void write(const value_type* const data, const size_type count)
+	{
+		m_os.write(data, count);
+
+		if (!m_overflow)
+		{
+			if (m_data.length() + count > m_maxSize)
+			{
+				m_overflow = true;
+
+				string().swap(m_data);
+			}
+			else
+			{
+				m_data.append(data, count);
+			}
+		}
+	}
+
+	void flush()
+	{
+		m_os.flush();
+	}
+
+	bool isComplete() const
+	{
+		return !m_overflow;
+	}
+
+	const string& getData() const
+	{
+		return m_data;
+	}
+
+private:
+
+	utility::outputStream& m_os;
+	const size_t m_maxSize;
+
+	string m_data;
+	bool m_overflow;
+};
+
 #endif // VMIME_BUILDING_DOC
 
 
@@ -238,6 +299,70 @@ void IMAPMessage::fetchPartHeader(ref <messagePart> p)
 }
 
 
+int IMAPMessage::getPartDecodedSize(ref <const messagePart> p)
+{
+	ref <IMAPFolder> folder = m_folder.acquire();
+
+	if (!folder)
+		throw exceptions::folder_not_found();
+
+	if (!folder->m_connection->hasCapability("BINARY"))
+		return -1;
+
+	// Build the request text
+	std::ostringstream command;
+	command.imbue(std::locale::classic());
+
+	if (m_uid.empty())
+		command << "FETCH " << m_num;
+	else
+		command << "UID FETCH " << m_uid;
+
+	command << " BINARY.SIZE[" << buildPartSection(p) << "]";
+
+	// Send the request
+	folder->m_connection->send(true, command.str(), true);
+
+	// Get the response
+	utility::auto_ptr <IMAPParser::response> resp(folder->m_connection->readResponse());
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("FETCH",
+			resp->getErrorLog(), "bad response");
+	}
+
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+	{
+		if ((*it)->response_data() == NULL)
+			continue;
+
+		const IMAPParser::message_data* messageData =
+			(*it)->response_data()->message_data();
+
+		if (messageData == NULL || messageData->type() != IMAPParser::message_data::FETCH)
+			continue;
+
+		const std::vector <IMAPParser::msg_att_item*>& atts = messageData->msg_att()->items();
+
+		for (std::vector <IMAPParser::msg_att_item*>::const_iterator
+		     ait = atts.begin() ; ait != atts.end() ; ++ait)
+		{
+			if ((*ait)->type() == IMAPParser::msg_att_item::BINARY_SIZE)
+				return static_cast <int>((*ait)->number()->value());
+		}
+	}
+
+	throw exceptions::command_error("FETCH",
+		resp->getErrorLog(), "invalid response");
+}
+
+
 void IMAPMessage::fetchPartHeaderForStructure(ref <messageStructure> str)
 {
 	for (size_t i = 0, n = str->getPartCount() ; i < n ; ++i)
@@ -259,9 +384,74 @@ void IMAPMessage::extractImpl(ref <const messagePart> p, utility::outputStream&
 {
 	ref <const IMAPFolder> folder = m_folder.acquire();
 
-	IMAPMessage_literalHandler literalHandler(os, progress);
+	const string command = buildExtractRequest(p, start, length, extractFlags);
 
-	// Construct section identifier
+	// Look up the cache. As a cache hit would not set the "\Seen" flag
+	// on the server, only contents extracted in "peek" mode are cached.
+	ref <IMAPCache> cache = folder->getCache();
+
+	if (cache && (!(extractFlags & EXTRACT_PEEK) || m_uid.empty() || cache->getMaxBodySectionSize() == 0))
+		cache = NULL;
+
+	// Section identifier, eg. "BODY.PEEK[1.2.MIME]" or "BINARY.PEEK[2]<0.1024>"
+	const string section = command.substr(command.find_last_of(' ') + 1);
+
+	if (cache && cache->getBodySection(folder->getCacheKey(), m_uid, section, os))
+		return;
+
+	IMAPMessage_cachingOutputStream cachingStream(os, cache ? cache->getMaxBodySectionSize() : 0);
+	IMAPMessage_literalHandler literalHandler(cache ? cachingStream : os, progress);
+
+	// Send the request
+	folder.constCast <IMAPFolder>()->m_connection->send(true, command, true);
+
+	// Get the response
+	utility::auto_ptr <IMAPParser::response> resp
+		(folder.constCast <IMAPFolder>()->m_connection->readResponse(&literalHandler));
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("FETCH",
+			resp->getErrorLog(), "bad response");
+	}
+
+	if (cache && cachingStream.isComplete())
+	{
+		try
+		{
+			cache->putBodySection(folder->getCacheKey(), m_uid, section, cachingStream.getData());
+		}
+		catch (exception&)
+		{
+			// Ignore: the cache is only an optimization
+		}
+	}
+
+
+	if (extractFlags & EXTRACT_BODY)
+	{
+		// TODO: update the flags (eg. flag "\Seen" may have been set)
+	}
+}
+
+
+bool IMAPMessage::canExtractBinary(ref <const messagePart> p) const
+{
+	ref <const IMAPFolder> folder = m_folder.acquire();
+
+	// BINARY[] only applies to body parts, and some servers refuse
+	// to decode message/rfc822 and multipart parts
+	if (!folder || p == NULL || p->getStructure()->getPartCount() != 0)
+		return false;
+
+	return folder.constCast <IMAPFolder>()->m_connection->hasCapability("BINARY");
+}
+
+
+// static
+const string IMAPMessage::buildPartSection(ref <const messagePart> p)
+{
 	std::ostringstream section;
 	section.imbue(std::locale::classic());
 
@@ -288,14 +478,49 @@ void IMAPMessage::extractImpl(ref <const messagePart> p, utility::outputStream&
 		}
 	}
 
+	return section.str();
+}
+
+
+const string IMAPMessage::buildExtractRequest(ref <const messagePart> p,
+	const int start, const int length, const int extractFlags) const
+{
+	// Construct section identifier
+	const string section = buildPartSection(p);
+
 	// Build the request text
 	std::ostringstream command;
 	command.imbue(std::locale::classic());
 
 	if (m_uid.empty())
-		command << "FETCH " << m_num << " BODY";
+		command << "FETCH " << m_num;
 	else
-		command << "UID FETCH " << m_uid << " BODY";
+		command << "UID FETCH " << m_uid;
+
+	/*
+	   BINARY[1.2]          decoded body of a part (RFC-3516)
+	   BINARY.PEEK[1.2]     decoded body of a part (peek)
+	*/
+
+	if ((extractFlags & EXTRACT_BINARY) && !section.empty())
+	{
+		if (extractFlags & EXTRACT_HEADER)
+			throw exceptions::operation_not_supported();
+
+		command << " BINARY";
+
+		if (extractFlags & EXTRACT_PEEK)
+			command << ".PEEK";
+
+		command << "[" << section << "]";
+
+		if (start != 0 || length != -1)
+			command << "<" << start << "." << length << ">";
+
+		return command.str();
+	}
+
+	command << " BODY";
 
 	/*
 	   BODY[]               header + body
@@ -311,7 +536,7 @@ void IMAPMessage::extractImpl(ref <const messagePart> p, utility::outputStream&
 
 	command << "[";
 
-	if (section.str().empty())
+	if (section.empty())
 	{
 		// header + body
 		if ((extractFlags & EXTRACT_HEADER) && (extractFlags & EXTRACT_BODY))
@@ -325,7 +550,7 @@ void IMAPMessage::extractImpl(ref <const messagePart> p, utility::outputStream&
 	}
 	else
 	{
-		command << section.str();
+		command << section;
 
 		// header + body
 		if ((extractFlags & EXTRACT_HEADER) && (extractFlags & EXTRACT_BODY))
@@ -343,25 +568,7 @@ void IMAPMessage::extractImpl(ref <const messagePart> p, utility::outputStream&
 	if (start != 0 || length != -1)
 		command << "<" << start << "." << length << ">";
 
-	// Send the request
-	folder.constCast <IMAPFolder>()->m_connection->send(true, command.str(), true);
-
-	// Get the response
-	utility::auto_ptr <IMAPParser::response> resp
-		(folder.constCast <IMAPFolder>()->m_connection->readResponse(&literalHandler));
-
-	if (resp->isBad() || resp->response_done()->response_tagged()->
-		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
-	{
-		throw exceptions::command_error("FETCH",
-			resp->getErrorLog(), "bad response");
-	}
-
-
-	if (extractFlags & EXTRACT_BODY)
-	{
-		// TODO: update the flags (eg. flag "\Seen" may have been set)
-	}
+	return command.str();
 }
 
 
@@ -515,6 +722,63 @@ int IMAPMessage::processFetchResponse
 }
 
 
+void IMAPMessage::processCachedInfo(const IMAPCache::messageInfo& info)
+{
+	ref <IMAPMessageStructure> structure;
+
+	if (!info.structure.empty())
+		structure = IMAPMessageStructure::deserialize(info.structure);
+
+	if (info.options & folder::FETCH_FLAGS)
+	{
+		m_flags = info.flags;
+		m_modseq = info.modseq;
+	}
+
+	if (info.size >= 0)
+		m_size = info.size;
+
+	if (!info.header.empty())
+		getOrCreateHeader()->parse(info.header);
+
+	if (structure)
+		m_structure = structure;
+}
+
+
+void IMAPMessage::buildCachedInfo(const int options, IMAPCache::messageInfo& info) const
+{
+	info.options = options;
+	info.flags = m_flags;
+	info.size = m_size;
+	info.modseq = m_modseq;
+
+	if (m_flags == FLAG_UNDEFINED)
+		info.options &= ~folder::FETCH_FLAGS;
+
+	if (m_header)
+	{
+		std::ostringstream oss;
+		utility::outputStreamAdapter ossAdapter(oss);
+
+		m_header->generate(ossAdapter);
+
+		info.header = oss.str();
+	}
+	else
+	{
+		info.header.clear();
+	}
+
+	ref <const IMAPMessageStructure> structure = m_structure.dynamicCast <IMAPMessageStructure>();
+
+	if (structure)
+		info.structure = structure->serialize();
+	else
+		info.structure.clear();
+}
+
+
 ref <header> IMAPMessage::getOrCreateHeader()
 {
 	if (m_header != NULL)
@@ -35,6 +35,7 @@
 #include "../vmime/net/folder.hpp"
 
 #include "../vmime/net/imap/IMAPParser.hpp"
+#include "../vmime/net/imap/IMAPCache.hpp"
 
 
 namespace vmime {
@@ -54,6 +55,7 @@ private:
 
 	friend class IMAPFolder;
 	friend class IMAPMessagePartContentHandler;
+	friend class IMAPPartDownloader;
 	friend class vmime::creator;  // vmime::create <IMAPMessage>
 
 	IMAPMessage(ref <IMAPFolder> folder, const int num);
@@ -97,6 +99,17 @@ public:
 
 	void fetchPartHeader(ref <messagePart> p);
 
+	/** Returns the size of the specified part once its content transfer
+	  * encoding has been removed. The server must support the BINARY
+	  * extension (RFC-3516) for this to be available.
+	  *
+	  * @param p part for which to retrieve the decoded size
+	  * @return decoded size of the part in bytes, or -1 if the server
+	  * does not support the BINARY extension
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	int getPartDecodedSize(ref <const messagePart> p);
+
 	ref <vmime::message> getParsedMessage();
 
 private:
@@ -121,6 +134,22 @@ private:
 	  */
 	int processFetchResponse(const int options, const IMAPParser::message_data* msgData);
 
+	/** Fill in the attributes and metadata of this message with
+	  * data retrieved from the cache.
+	  *
+	  * @param info cached data
+	  * @throw exceptions::invalid_argument if cached data is not valid
+	  */
+	void processCachedInfo(const IMAPCache::messageInfo& info);
+
+	/** Build the cache entry for this message.
+	  *
+	  * @param options objects which have been fetched for this
+	  * message (see folder::FetchOptions)
+	  * @param info receives the data to store in the cache
+	  */
+	void buildCachedInfo(const int options, IMAPCache::messageInfo& info) const;
+
 	/** Recursively fetch part header for all parts in the structure.
 	  *
 	  * @param str structure for which to fetch parts headers
@@ -141,12 +170,39 @@ private:
 	{
 		EXTRACT_HEADER = 0x1,
 		EXTRACT_BODY = 0x2,
-		EXTRACT_PEEK = 0x10
+		EXTRACT_PEEK = 0x10,
+		EXTRACT_BINARY = 0x20   /**< let the server decode the part (BINARY extension) */
 	};
 
+	/** Tests whether the server can decode the specified part
+	  * itself, ie. whether EXTRACT_BINARY can be used for it.
+	  *
+	  * @param p part to extract
+	  * @return true if the part can be extracted with EXTRACT_BINARY
+	  */
+	bool canExtractBinary(ref <const messagePart> p) const;
+
 	void extractImpl(ref <const messagePart> p, utility::outputStream& os, utility::progressListener* progress,
 		const int start, const int length, const int extractFlags) const;
 
+	/** Build the FETCH command used to extract a message or a part.
+	  *
+	  * @param p part to extract, or NULL for the whole message
+	  * @param start offset of the first byte to extract
+	  * @param length number of bytes to extract, or -1 to extract until the end
+	  * @param extractFlags what to extract (see ExtractFlags)
+	  * @return FETCH command (without tag)
+	  */
+	const string buildExtractRequest(ref <const messagePart> p,
+		const int start, const int length, const int extractFlags) const;
+
+	/** Build the section identifier of a part (eg. "1.2").
+	  *
+	  * @param p part, or NULL for the whole message
+	  * @return section identifier, or an empty string for the whole message
+	  */
+	static const string buildPartSection(ref <const messagePart> p);
+
 
 	ref <header> getOrCreateHeader();
 
@@ -54,12 +54,15 @@ IMAPMessagePart::IMAPMessagePart(ref <IMAPMessagePart> parent, const int number,
 				media_text()->media_subtype()->value());
 
 		m_size = part->body_type_text()->body_fields()->body_fld_octets()->value();
+		m_encoding = vmime::encoding(part->body_type_text()->body_fields()->body_fld_enc()->value());
 	}
 	else if (part->body_type_msg())
 	{
 		m_mediaType = vmime::mediaType
 			("message", part->body_type_msg()->
 				media_message()->media_subtype()->value());
+
+		m_encoding = vmime::encoding(part->body_type_msg()->body_fields()->body_fld_enc()->value());
 	}
 	else
 	{
@@ -68,12 +71,21 @@ IMAPMessagePart::IMAPMessagePart(ref <IMAPMessagePart> parent, const int number,
 			 part->body_type_basic()->media_basic()->media_subtype()->value());
 
 		m_size = part->body_type_basic()->body_fields()->body_fld_octets()->value();
+		m_encoding = vmime::encoding(part->body_type_basic()->body_fields()->body_fld_enc()->value());
 	}
 
 	m_structure = NULL;
 }
 
 
+IMAPMessagePart::IMAPMessagePart(ref <IMAPMessagePart> parent, const int number,
+	const mediaType& type, const int size, const vmime::encoding& enc)
+	: m_structure(NULL), m_parent(parent), m_header(NULL), m_number(number), m_size(size),
+	  m_mediaType(type), m_encoding(enc)
+{
+}
+
+
 ref <const messageStructure> IMAPMessagePart::getStructure() const
 {
 	if (m_structure != NULL)
@@ -116,6 +128,12 @@ int IMAPMessagePart::getNumber() const
 }
 
 
+const vmime::encoding& IMAPMessagePart::getEncoding() const
+{
+	return m_encoding;
+}
+
+
 ref <const header> IMAPMessagePart::getHeader() const
 {
 	if (m_header == NULL)
@@ -143,6 +161,48 @@ ref <IMAPMessagePart> IMAPMessagePart::create
 }
 
 
+void IMAPMessagePart::serialize(std::ostream& os) const
+{
+	// Line format: "type subtype size encoding", followed by sub-parts
+	const string enc = m_encoding.getName();
+
+	os << m_mediaType.getType() << ' ' << m_mediaType.getSubType() << ' '
+	   << m_size << ' ' << (enc.empty() ? "-" : enc) << '\n';
+
+	if (m_structure != NULL)
+		m_structure->serialize(os);
+	else
+		os << 0 << '\n';
+}
+
+
+// static
+ref <IMAPMessagePart> IMAPMessagePart::deserialize
+	(ref <IMAPMessagePart> parent, const int number, std::istream& is)
+{
+	string type, subType, enc;
+	int size = 0;
+
+	is >> type >> subType >> size >> enc;
+
+	if (is.fail())
+		throw exceptions::invalid_argument();
+
+	if (enc == "-")
+		enc.clear();
+
+	ref <IMAPMessagePart> part = vmime::create <IMAPMessagePart>
+		(parent, number, mediaType(type, subType), size, vmime::encoding(enc));
+
+	ref <IMAPMessageStructure> structure = IMAPMessageStructure::deserialize(part, is);
+
+	if (structure->getPartCount() != 0)
+		part->m_structure = structure;
+
+	return part;
+}
+
+
 header& IMAPMessagePart::getOrCreateHeader()
 {
 	if (m_header != NULL)
@@ -32,6 +32,7 @@
 
 
 #include "../vmime/net/message.hpp"
+#include "../vmime/encoding.hpp"
 
 #include "../vmime/net/imap/IMAPParser.hpp"
 
@@ -52,6 +53,7 @@ private:
 
 	IMAPMessagePart(ref <IMAPMessagePart> parent, const int number, const IMAPParser::body_type_mpart* mpart);
 	IMAPMessagePart(ref <IMAPMessagePart> parent, const int number, const IMAPParser::body_type_1part* part);
+	IMAPMessagePart(ref <IMAPMessagePart> parent, const int number, const mediaType& type, const int size, const vmime::encoding& enc);
 
 public:
 
@@ -64,12 +66,38 @@ public:
 	int getSize() const;
 	int getNumber() const;
 
+	/** Return the transfer encoding of this part, as announced
+	  * by the server in the body structure.
+	  *
+	  * @return content transfer encoding of the part
+	  */
+	const vmime::encoding& getEncoding() const;
+
 	ref <const header> getHeader() const;
 
 
 	static ref <IMAPMessagePart> create
 		(ref <IMAPMessagePart> parent, const int number, const IMAPParser::body* body);
 
+	/** Write this part and its sub-parts in the format read
+	  * by deserialize() (see IMAPMessageStructure::serialize()).
+	  *
+	  * @param os output stream
+	  */
+	void serialize(std::ostream& os) const;
+
+	/** Construct a part (and its sub-parts) from data previously
+	  * written by serialize().
+	  *
+	  * @param parent parent part, or NULL for the root part
+	  * @param number zero-based number of the part in its parent
+	  * @param is input stream
+	  * @return new part
+	  * @throw exceptions::invalid_argument if data is not valid
+	  */
+	static ref <IMAPMessagePart> deserialize
+		(ref <IMAPMessagePart> parent, const int number, std::istream& is);
+
 
 	header& getOrCreateHeader();
 
@@ -82,6 +110,7 @@ private:
 	int m_number;
 	int m_size;
 	mediaType m_mediaType;
+	vmime::encoding m_encoding;
 };
 
 
@@ -73,20 +73,11 @@ void IMAPMessagePartContentHandler::generate
 		// buffer, and then re-encode to output stream...
 		if (m_encoding != enc)
 		{
-			// Extract part contents to temporary buffer
-			std::ostringstream oss;
-			utility::outputStreamAdapter tmp(oss);
-
-			msg->extractPart(part, tmp, NULL);
-
-			// Decode to another temporary buffer
-			utility::inputStreamStringProxyAdapter in(oss.str());
-
+			// Extract decoded part contents to temporary buffer
 			std::ostringstream oss2;
 			utility::outputStreamAdapter tmp2(oss2);
 
-			ref <utility::encoder::encoder> theDecoder = m_encoding.getEncoder();
-			theDecoder->decode(in, tmp2);
+			extract(tmp2, NULL);
 
 			// Reencode to output stream
 			string str = oss2.str();
@@ -139,6 +130,24 @@ void IMAPMessagePartContentHandler::extract
 	// Need to decode data
 	else
 	{
+		// Let the server decode data, if it supports the BINARY extension.
+		// It may still refuse to do so (eg. unknown encoding), in which
+		// case no data has been received and we decode it ourselves.
+		if (msg->canExtractBinary(part))
+		{
+			try
+			{
+				msg->extractImpl(part, os, progress, 0, -1,
+					IMAPMessage::EXTRACT_BODY | IMAPMessage::EXTRACT_BINARY);
+
+				return;
+			}
+			catch (exceptions::command_error&)
+			{
+				// Fall back to client-side decoding
+			}
+		}
+
 		// Extract part contents to temporary buffer
 		std::ostringstream oss;
 		utility::outputStreamAdapter tmp(oss);
@@ -30,6 +30,8 @@
 #include "../vmime/net/imap/IMAPMessageStructure.hpp"
 #include "../vmime/net/imap/IMAPMessagePart.hpp"
 
+#include <sstream>
+
 
 namespace vmime {
 namespace net {
@@ -85,6 +87,60 @@ ref <IMAPMessageStructure> IMAPMessageStructure::emptyStructure()
 }
 
 
+const string IMAPMessageStructure::serialize() const
+{
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+
+	serialize(oss);
+
+	return oss.str();
+}
+
+
+void IMAPMessageStructure::serialize(std::ostream& os) const
+{
+	os << m_parts.size() << '\n';
+
+	for (std::vector <ref <IMAPMessagePart> >::const_iterator
+	     it = m_parts.begin() ; it != m_parts.end() ; ++it)
+	{
+		(*it)->serialize(os);
+	}
+}
+
+
+// static
+ref <IMAPMessageStructure> IMAPMessageStructure::deserialize(const string& data)
+{
+	std::istringstream iss(data);
+	iss.imbue(std::locale::classic());
+
+	return deserialize(NULL, iss);
+}
+
+
+// static
+ref <IMAPMessageStructure> IMAPMessageStructure::deserialize(ref <IMAPMessagePart> parent, std::istream& is)
+{
+	size_t count = 0;
+	is >> count;
+
+	if (is.fail())
+		throw exceptions::invalid_argument();
+
+	ref <IMAPMessageStructure> structure = vmime::create <IMAPMessageStructure>();
+
+	for (size_t i = 0 ; i < count ; ++i)
+	{
+		structure->m_parts.push_back(IMAPMessagePart::deserialize
+			(parent, static_cast <int>(i), is));
+	}
+
+	return structure;
+}
+
+
 } // imap
 } // net
 } // vmime
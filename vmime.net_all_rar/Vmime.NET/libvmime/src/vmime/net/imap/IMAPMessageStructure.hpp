@@ -58,6 +58,37 @@ public:
 
 	static ref <IMAPMessageStructure> emptyStructure();
 
+	/** Return a compact text representation of this structure, from
+	  * which it can be constructed again with deserialize(). This is
+	  * used to store the structure in a cache (see IMAPCache).
+	  *
+	  * @return serialized structure
+	  */
+	const string serialize() const;
+
+	/** Write a compact text representation of this structure.
+	  *
+	  * @param os output stream
+	  */
+	void serialize(std::ostream& os) const;
+
+	/** Construct a structure from data returned by serialize().
+	  *
+	  * @param data serialized structure
+	  * @return new structure
+	  * @throw exceptions::invalid_argument if data is not valid
+	  */
+	static ref <IMAPMessageStructure> deserialize(const string& data);
+
+	/** Construct a structure from data written by serialize().
+	  *
+	  * @param parent part which contains this structure, or NULL
+	  * @param is input stream
+	  * @return new structure
+	  * @throw exceptions::invalid_argument if data is not valid
+	  */
+	static ref <IMAPMessageStructure> deserialize(ref <IMAPMessagePart> parent, std::istream& is);
+
 private:
 
 	std::vector <ref <IMAPMessagePart> > m_parts;
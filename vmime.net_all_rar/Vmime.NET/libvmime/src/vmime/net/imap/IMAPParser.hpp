@@ -157,7 +157,8 @@ public:
     // FIX by Elmue: Added instance counter
 	IMAPParser(weak_ref <IMAPTag> tag, weak_ref <socket> sok, weak_ref <timeoutHandler> _timeoutHandler, int _instanceID)
 		: m_tag(tag), m_socket(sok), m_progress(NULL), m_strict(false),
-		  m_literalHandler(NULL), m_timeoutHandler(_timeoutHandler), m_instanceID(_instanceID)
+		  m_literalHandler(NULL), m_responseDataHandler(NULL),
+		  m_timeoutHandler(_timeoutHandler), m_instanceID(_instanceID)
 	{
 	}
 
@@ -289,6 +290,32 @@ public:
 	};
 
 
+	//
+	// responseDataHandler : receives untagged responses while they are read
+	//
+
+	class continue_req_or_response_data;
+
+	class responseDataHandler
+	{
+	public:
+
+		virtual ~responseDataHandler() { }
+
+
+		// Called for each untagged response as soon as it has been parsed,
+		// before the next line is read from the socket
+		//    . data: the untagged response
+		//
+		// Returns :
+		//    . true if the data has been consumed (it is released immediately
+		//      and will not appear in the final response)
+		//    . false to keep it in the response
+
+		virtual bool handleResponseData(const continue_req_or_response_data& data) = 0;
+	};
+
+
 	//
 	// Base class for a terminal or a non-terminal
 	//
@@ -472,7 +499,12 @@ public:
 				}
 			}
 
-			if (tagString == string(*parser.getTag()))
+			// When commands are pipelined, the expected tag is the tag of
+			// the oldest pending command, not the last one sent
+			const string expectedTag = parser.m_expectedTag.empty()
+				? string(*parser.getTag()) : parser.m_expectedTag;
+
+			if (tagString == expectedTag)
 			{
 				*currentPos = pos;
 			}
@@ -607,7 +639,7 @@ public:
 			size_t pos = *currentPos;
 
 			m_uniqueid1 = parser.get <uniqueid>(line, &pos);
-			parser.check <one_char <','> >(line, &pos);
+			parser.check <one_char <':'> >(line, &pos);
 			m_uniqueid2 = parser.get <uniqueid>(line, &pos);
 
 			*currentPos = pos;
@@ -969,6 +1001,8 @@ public:
 	// literal         ::= "{" number "}" CRLF *CHAR8
 	//                     ;; Number represents the number of CHAR8 octets
 	// CHAR8           ::= <any 8-bit octet except NUL, 0x01 - 0xff>
+	// literal8        ::= "~{" number "}" CRLF *OCTET
+	//                     ;; BINARY extension (RFC 3516), may contain NUL
 	//
 
 	class xstring : public component
@@ -1041,8 +1075,10 @@ public:
 					DEBUG_FOUND("string[quoted]", "<length=" << m_value.length() << ", value='" << m_value << "'>");
 				}
 				// literal ::= "{" number "}" CRLF *CHAR8
+				// literal8 ::= "~{" number "}" CRLF *OCTET
 				else
 				{
+					parser.check <one_char <'~'> >(line, &pos, true);
 					parser.check <one_char <'{'> >(line, &pos);
 
 					number* num = parser.get <number>(line, &pos);
@@ -1471,7 +1507,7 @@ public:
 
 			m_first = parser.get <seq_number>(line, &pos);
 
-			parser.check <one_char <'*'> >(line, &pos);
+			parser.check <one_char <':'> >(line, &pos);
 
 			m_last = parser.get <seq_number>(line, &pos);
 
@@ -4077,6 +4113,12 @@ public:
 	// IMAP Extension for Conditional STORE (RFC-4551):
 	//
 	//   msg_att_item      /= "MODSEQ" SP "(" mod_sequence_value ")"
+	//
+	// IMAP4 Binary Content Extension (RFC-3516):
+	//
+	//   msg_att_item      /= "BINARY" section_binary ["<" number ">"] SP
+	//                        (nstring / literal8) /
+	//                        "BINARY.SIZE" section_binary SP number
 
 	class msg_att_item : public component
 	{
@@ -4211,6 +4253,34 @@ public:
 					m_body = parser.get <IMAPParser::body>(line, &pos);
 				}
 			}
+			// "BINARY" section_binary ["<" number ">"] SPACE (nstring / literal8)
+			else if (parser.checkWithArg <special_atom>(line, &pos, "binary", true))
+			{
+				m_type = BINARY_SECTION;
+
+				m_section = parser.get <IMAPParser::section>(line, &pos);
+
+				if (parser.check <one_char <'<'> >(line, &pos, true))
+				{
+					m_number = parser.get <IMAPParser::number>(line, &pos);
+					parser.check <one_char <'>'> >(line, &pos);
+				}
+
+				parser.check <SPACE>(line, &pos);
+
+				m_nstring = parser.getWithArgs <IMAPParser::nstring>
+					(line, &pos, this, BINARY_SECTION);
+			}
+			// "BINARY.SIZE" section_binary SPACE number
+			else if (parser.checkWithArg <special_atom>(line, &pos, "binary.size", true))
+			{
+				m_type = BINARY_SIZE;
+
+				m_section = parser.get <IMAPParser::section>(line, &pos);
+
+				parser.check <SPACE>(line, &pos);
+				m_number = parser.get <IMAPParser::number>(line, &pos);
+			}
 			// "MODSEQ" SP "(" mod_sequence_value ")"
 			else if (parser.checkWithArg <special_atom>(line, &pos, "modseq", true))
 			{
@@ -4251,7 +4321,9 @@ public:
 			BODY_SECTION,
 			BODY_STRUCTURE,
 			UID,
-			MODSEQ
+			MODSEQ,
+			BINARY_SECTION,
+			BINARY_SIZE
 		};
 
 	private:
@@ -4924,17 +4996,364 @@ public:
 	};
 
 
+	//
+	// tagged-ext-comp     = astring /
+	//                       tagged-ext-comp *(SP tagged-ext-comp) /
+	//                       "(" tagged-ext-comp ")"
+	//
+	// Only used to skip the value of an unknown extension item.
+	//
+
+	class tagged_ext_comp : public component
+	{
+	public:
+
+		void go(IMAPParser& parser, string& line, size_t* currentPos)
+		{
+			DEBUG_ENTER_COMPONENT("tagged_ext_comp");
+
+			size_t pos = *currentPos;
+
+			if (parser.check <one_char <'('> >(line, &pos, true))
+			{
+				do
+				{
+					parser.check <tagged_ext_comp>(line, &pos);
+				}
+				while (parser.check <SPACE>(line, &pos, true));
+
+				parser.check <one_char <')'> >(line, &pos);
+			}
+			else
+			{
+				parser.check <astring>(line, &pos);
+			}
+
+			*currentPos = pos;
+		}
+	};
+
+
+	//
+	// tagged-ext-val      = tagged-ext-simple /
+	//                       "(" [tagged-ext-comp] ")"
+	//
+	// tagged-ext-simple   = sequence-set / number
+	//
+	// Only used to skip the value of an unknown extension item.
+	//
+
+	class tagged_ext_val : public component
+	{
+	public:
+
+		void go(IMAPParser& parser, string& line, size_t* currentPos)
+		{
+			DEBUG_ENTER_COMPONENT("tagged_ext_val");
+
+			size_t pos = *currentPos;
+
+			if (parser.check <one_char <'('> >(line, &pos, true))
+			{
+				if (!parser.check <one_char <')'> >(line, &pos, true))
+				{
+					do
+					{
+						parser.check <tagged_ext_comp>(line, &pos);
+					}
+					while (parser.check <SPACE>(line, &pos, true));
+
+					parser.check <one_char <')'> >(line, &pos);
+				}
+			}
+			else
+			{
+				parser.check <sequence_set>(line, &pos);
+			}
+
+			*currentPos = pos;
+		}
+	};
+
+
+	//
+	// search-return-data  = "MIN" SP nz-number /
+	//                       "MAX" SP nz-number /
+	//                       "ALL" SP sequence-set /
+	//                       "COUNT" SP number /
+	//                       "MODSEQ" SP mod-sequence-value /
+	//                       search-modifier-name SP search-return-value
+	//
+	// search-modifier-name = tagged-ext-label
+	// search-return-value  = tagged-ext-val
+	//
+	// Unknown items must be ignored (RFC 4731): they are parsed as OTHER,
+	// and their value is skipped.
+	//
+
+	class search_return_data : public component
+	{
+	public:
+
+		search_return_data()
+			: m_number(NULL), m_sequence_set(NULL), m_mod_sequence_value(NULL)
+		{
+		}
+
+		~search_return_data()
+		{
+			delete m_number;
+			delete m_sequence_set;
+			delete m_mod_sequence_value;
+		}
+
+		void go(IMAPParser& parser, string& line, size_t* currentPos)
+		{
+			DEBUG_ENTER_COMPONENT("search_return_data");
+
+			size_t pos = *currentPos;
+
+			if (parser.checkWithArg <special_atom>(line, &pos, "min", true))
+			{
+				m_type = MIN;
+
+				parser.check <SPACE>(line, &pos);
+				m_number = parser.get <IMAPParser::nz_number>(line, &pos);
+			}
+			else if (parser.checkWithArg <special_atom>(line, &pos, "max", true))
+			{
+				m_type = MAX;
+
+				parser.check <SPACE>(line, &pos);
+				m_number = parser.get <IMAPParser::nz_number>(line, &pos);
+			}
+			else if (parser.checkWithArg <special_atom>(line, &pos, "all", true))
+			{
+				m_type = ALL;
+
+				parser.check <SPACE>(line, &pos);
+				m_sequence_set = parser.get <IMAPParser::sequence_set>(line, &pos);
+			}
+			else if (parser.checkWithArg <special_atom>(line, &pos, "count", true))
+			{
+				m_type = COUNT;
+
+				parser.check <SPACE>(line, &pos);
+				m_number = parser.get <IMAPParser::number>(line, &pos);
+			}
+			else if (parser.checkWithArg <special_atom>(line, &pos, "modseq", true))
+			{
+				m_type = MODSEQ;
+
+				parser.check <SPACE>(line, &pos);
+				m_mod_sequence_value = parser.get <IMAPParser::mod_sequence_value>(line, &pos);
+			}
+			else
+			{
+				m_type = OTHER;
+
+				parser.check <atom>(line, &pos);
+				parser.check <SPACE>(line, &pos);
+				parser.check <tagged_ext_val>(line, &pos);
+			}
+
+			*currentPos = pos;
+		}
+
+
+		enum Type
+		{
+			MIN,
+			MAX,
+			ALL,
+			COUNT,
+			MODSEQ,
+			OTHER    /**< unknown item, which must be ignored */
+		};
+
+	private:
+
+		Type m_type;
+
+		IMAPParser::number* m_number;
+		IMAPParser::sequence_set* m_sequence_set;
+		IMAPParser::mod_sequence_value* m_mod_sequence_value;
+
+	public:
+
+		Type type() const { return m_type; }
+
+		const IMAPParser::number* number() const { return m_number; }
+		const IMAPParser::sequence_set* sequence_set() const { return m_sequence_set; }
+		const IMAPParser::mod_sequence_value* mod_sequence_value() const { return m_mod_sequence_value; }
+	};
+
+
+	//
+	// esearch-response   = [search-correlator] [SP "UID"]
+	//                      *(SP search-return-data)
+	//                      ;; "ESEARCH" keyword is parsed by mailbox_data
+	//
+	// search-correlator  = SP "(" "TAG" SP tag-string ")"
+	//
+
+	class esearch_response : public component
+	{
+	public:
+
+		esearch_response()
+			: m_tag(NULL), m_uid(false)
+		{
+		}
+
+		~esearch_response()
+		{
+			delete m_tag;
+
+			for (std::vector <IMAPParser::search_return_data*>::iterator it = m_search_return_data.begin() ;
+			     it != m_search_return_data.end() ; ++it)
+			{
+				delete *it;
+			}
+		}
+
+		void go(IMAPParser& parser, string& line, size_t* currentPos)
+		{
+			DEBUG_ENTER_COMPONENT("esearch_response");
+
+			size_t pos = *currentPos;
+
+			while (parser.check <SPACE>(line, &pos, true))
+			{
+				if (!m_tag && !m_uid && m_search_return_data.empty() &&
+				    parser.check <one_char <'('> >(line, &pos, true))
+				{
+					parser.checkWithArg <special_atom>(line, &pos, "tag");
+					parser.check <SPACE>(line, &pos);
+
+					m_tag = parser.get <IMAPParser::xstring>(line, &pos);
+
+					parser.check <one_char <')'> >(line, &pos);
+				}
+				else if (!m_uid && m_search_return_data.empty() &&
+				         parser.checkWithArg <special_atom>(line, &pos, "uid", true))
+				{
+					m_uid = true;
+				}
+				else
+				{
+					m_search_return_data.push_back
+						(parser.get <IMAPParser::search_return_data>(line, &pos));
+				}
+			}
+
+			*currentPos = pos;
+		}
+
+	private:
+
+		IMAPParser::xstring* m_tag;
+		bool m_uid;
+		std::vector <IMAPParser::search_return_data*> m_search_return_data;
+
+	public:
+
+		const IMAPParser::xstring* tag() const { return m_tag; }
+		bool uid() const { return m_uid; }
+		const std::vector <IMAPParser::search_return_data*>& search_return_data() const { return m_search_return_data; }
+	};
+
+
+	//
+	// thread-list     = "(" (thread-members / thread-nested) ")"
+	//
+	// thread-members  = nz-number *(SP nz-number) [SP thread-nested]
+	//
+	// thread-nested   = 2*thread-list
+	//
+
+	class thread_list : public component
+	{
+	public:
+
+		~thread_list()
+		{
+			for (std::vector <IMAPParser::nz_number*>::iterator it = m_members.begin() ;
+			     it != m_members.end() ; ++it)
+			{
+				delete *it;
+			}
+
+			for (std::vector <IMAPParser::thread_list*>::iterator it = m_nested.begin() ;
+			     it != m_nested.end() ; ++it)
+			{
+				delete *it;
+			}
+		}
+
+		void go(IMAPParser& parser, string& line, size_t* currentPos)
+		{
+			DEBUG_ENTER_COMPONENT("thread_list");
+
+			size_t pos = *currentPos;
+
+			parser.check <one_char <'('> >(line, &pos);
+
+			IMAPParser::nz_number* member;
+
+			while ((member = parser.get <IMAPParser::nz_number>(line, &pos, true)) != NULL)
+			{
+				m_members.push_back(member);
+
+				if (!parser.check <SPACE>(line, &pos, true))
+					break;
+			}
+
+			IMAPParser::thread_list* nested;
+
+			while ((nested = parser.get <IMAPParser::thread_list>(line, &pos, true)) != NULL)
+			{
+				m_nested.push_back(nested);
+
+				parser.check <SPACE>(line, &pos, true);  // not allowed, but sent by some servers
+			}
+
+			parser.check <one_char <')'> >(line, &pos);
+
+			*currentPos = pos;
+		}
+
+	private:
+
+		std::vector <IMAPParser::nz_number*> m_members;
+		std::vector <IMAPParser::thread_list*> m_nested;
+
+	public:
+
+		/** Messages of the thread: each one is the parent of the next one. */
+		const std::vector <IMAPParser::nz_number*>& members() const { return m_members; }
+
+		/** Sub-threads, whose parent is the last member (if any). */
+		const std::vector <IMAPParser::thread_list*>& nested() const { return m_nested; }
+	};
+
+
 	//
 	// mailbox_data ::= "FLAGS" SPACE mailbox_flag_list /
 	//                  "LIST" SPACE mailbox_list /
 	//                  "LSUB" SPACE mailbox_list /
 	//                  "MAILBOX" SPACE text /
-	//                  "SEARCH" [SPACE 1#nz_number] /
+	//                  "SEARCH" [SPACE 1#nz_number] [SPACE search-sort-mod-seq] /
+	//                  "SORT" [SPACE 1#nz_number] [SPACE search-sort-mod-seq] /
+	//                  "ESEARCH" esearch-response /
+	//                  "THREAD" [SPACE 1*thread-list] /
 	//                  "STATUS" SPACE mailbox SPACE
 	//                    "(" [status-att-list] ")" /
 	//                  number SPACE "EXISTS" /
 	//                  number SPACE "RECENT"
 	//
+	// search-sort-mod-seq ::= "(" "MODSEQ" SP mod-sequence-value ")"
+	//
 
 	class mailbox_data : public component
 	{
@@ -4942,7 +5361,8 @@ public:
 
 		mailbox_data()
 			: m_number(NULL), m_mailbox_flag_list(NULL), m_mailbox_list(NULL),
-			  m_mailbox(NULL), m_text(NULL), m_status_att_list(NULL)
+			  m_mailbox(NULL), m_text(NULL), m_status_att_list(NULL),
+			  m_mod_sequence_value(NULL), m_esearch_response(NULL)
 		{
 		}
 
@@ -4961,6 +5381,14 @@ public:
 			}
 
 			delete m_status_att_list;
+			delete m_mod_sequence_value;
+			delete m_esearch_response;
+
+			for (std::vector <IMAPParser::thread_list*>::iterator it = m_thread_list.begin() ;
+			     it != m_thread_list.end() ; ++it)
+			{
+				delete (*it);
+			}
 		}
 
 		void go(IMAPParser& parser, string& line, size_t* currentPos)
@@ -5024,22 +5452,43 @@ public:
 
 					m_type = MAILBOX;
 				}
-				// "SEARCH" [SPACE 1#nz_number]
+				// "SEARCH" [SPACE 1#nz_number] [SPACE search-sort-mod-seq]
 				else if (parser.checkWithArg <special_atom>(line, &pos, "search", true))
+				{
+					parseNumberList(parser, line, &pos);
+
+					m_type = SEARCH;
+				}
+				// "SORT" [SPACE 1#nz_number] [SPACE search-sort-mod-seq]
+				else if (parser.checkWithArg <special_atom>(line, &pos, "sort", true))
+				{
+					parseNumberList(parser, line, &pos);
+
+					m_type = SORT;
+				}
+				// "ESEARCH" esearch-response
+				else if (parser.checkWithArg <special_atom>(line, &pos, "esearch", true))
+				{
+					m_esearch_response = parser.get <IMAPParser::esearch_response>(line, &pos);
+
+					m_type = ESEARCH;
+				}
+				// "THREAD" [SPACE 1*thread-list]
+				else if (parser.checkWithArg <special_atom>(line, &pos, "thread", true))
 				{
 					if (parser.check <SPACE>(line, &pos, true))
 					{
-						m_search_nz_number_list.push_back
-							(parser.get <nz_number>(line, &pos));
+						IMAPParser::thread_list* thread;
 
-						while (parser.check <SPACE>(line, &pos, true))
+						while ((thread = parser.get <IMAPParser::thread_list>(line, &pos, true)) != NULL)
 						{
-							m_search_nz_number_list.push_back
-								(parser.get <nz_number>(line, &pos));
+							m_thread_list.push_back(thread);
+
+							parser.check <SPACE>(line, &pos, true);  // not allowed, but sent by some servers
 						}
 					}
 
-					m_type = SEARCH;
+					m_type = THREAD;
 				}
 				// "STATUS" SPACE mailbox SPACE
 				// "(" [status_att_list] ")"
@@ -5075,11 +5524,40 @@ public:
 			SEARCH,
 			STATUS,
 			EXISTS,
-			RECENT
+			RECENT,
+			SORT,
+			ESEARCH,
+			THREAD
 		};
 
 	private:
 
+		void parseNumberList(IMAPParser& parser, string& line, size_t* currentPos)
+		{
+			size_t pos = *currentPos;
+
+			while (parser.check <SPACE>(line, &pos, true))
+			{
+				if (parser.check <one_char <'('> >(line, &pos, true))
+				{
+					parser.checkWithArg <special_atom>(line, &pos, "modseq");
+					parser.check <SPACE>(line, &pos);
+
+					m_mod_sequence_value = parser.get <IMAPParser::mod_sequence_value>(line, &pos);
+
+					parser.check <one_char <')'> >(line, &pos);
+
+					break;
+				}
+
+				m_search_nz_number_list.push_back
+					(parser.get <nz_number>(line, &pos));
+			}
+
+			*currentPos = pos;
+		}
+
+
 		Type m_type;
 
 		IMAPParser::number* m_number;
@@ -5089,6 +5567,9 @@ public:
 		IMAPParser::text* m_text;
 		std::vector <nz_number*> m_search_nz_number_list;
 		IMAPParser::status_att_list* m_status_att_list;
+		IMAPParser::mod_sequence_value* m_mod_sequence_value;
+		IMAPParser::esearch_response* m_esearch_response;
+		std::vector <IMAPParser::thread_list*> m_thread_list;
 
 	public:
 
@@ -5101,6 +5582,9 @@ public:
 		const IMAPParser::text* text() const { return (m_text); }
 		const std::vector <nz_number*>& search_nz_number_list() const { return (m_search_nz_number_list); }
 		const IMAPParser::status_att_list* status_att_list() const { return m_status_att_list; }
+		const IMAPParser::mod_sequence_value* mod_sequence_value() const { return m_mod_sequence_value; }
+		const IMAPParser::esearch_response* esearch_response() const { return m_esearch_response; }
+		const std::vector <IMAPParser::thread_list*>& thread_list() const { return m_thread_list; }
 	};
 
 
@@ -5403,6 +5887,14 @@ public:
 					break;
 				}
 
+				// Streamed response: release data as soon as it has been consumed
+				if (parser.m_responseDataHandler != NULL &&
+				    parser.m_responseDataHandler->handleResponseData(*resp))
+				{
+					m_continue_req_or_response_data.pop_back();
+					delete (resp);
+				}
+
 				// We have read a CRLF, read another line
 				curLine = parser.readLine();
 				pos = 0;
@@ -5521,14 +6013,16 @@ public:
 	// The main functions used to parse a response
 	//
 
-	response* readResponse(literalHandler* lh = NULL)
+	response* readResponse(literalHandler* lh = NULL, responseDataHandler* rh = NULL)
 	{
 		size_t pos = 0;
 		string line = readLine();
 
 		m_literalHandler = lh;
+		m_responseDataHandler = rh;
 		response* resp = get <response>(line, &pos);
 		m_literalHandler = NULL;
+		m_responseDataHandler = NULL;
 
 		resp->setErrorLog(lastLine());
 
@@ -5536,6 +6030,25 @@ public:
 	}
 
 
+	response* readTaggedResponse(const string& tag, literalHandler* lh = NULL, responseDataHandler* rh = NULL)
+	{
+		m_expectedTag = tag;
+
+		try
+		{
+			response* resp = readResponse(lh, rh);
+			m_expectedTag.clear();
+
+			return (resp);
+		}
+		catch (...)
+		{
+			m_expectedTag.clear();
+			throw;
+		}
+	}
+
+
 	greeting* readGreeting()
 	{
 		size_t pos = 0;
@@ -5695,6 +6208,9 @@ private:
 	bool m_strict;
 
 	literalHandler* m_literalHandler;
+	responseDataHandler* m_responseDataHandler;
+
+	string m_expectedTag;
 
 	weak_ref <timeoutHandler> m_timeoutHandler;
 
@@ -5774,7 +6290,8 @@ public:
 
 			if (receiveBuffer.empty())   // buffer is empty
 			{
-				platform::getHandler()->wait();
+				// Block until data arrives or the time-out delay is elapsed
+				sok->waitForReadable(toh ? toh->getRemainingTime() : 1000);
 				continue;
 			}
 
@@ -5833,7 +6350,8 @@ public:
 
 			if (receiveBuffer.empty())   // buffer is empty
 			{
-				platform::getHandler()->wait();
+				// Block until data arrives or the time-out delay is elapsed
+				sok->waitForReadable(toh ? toh->getRemainingTime() : 1000);
 				continue;
 			}
 
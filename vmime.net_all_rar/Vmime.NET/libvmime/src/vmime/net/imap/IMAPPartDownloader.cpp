@@ -0,0 +1,313 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+
+#include "../vmime/net/imap/IMAPPartDownloader.hpp"
+#include "../vmime/net/imap/IMAPMessage.hpp"
+#include "../vmime/net/imap/IMAPMessagePart.hpp"
+#include "../vmime/net/imap/IMAPFolder.hpp"
+#include "../vmime/net/imap/IMAPConnection.hpp"
+
+#include "../vmime/exception.hpp"
+
+#include <algorithm>
+#include <typeinfo>
+
+
+namespace vmime {
+namespace net {
+namespace imap {
+
+
+#ifndef VMIME_BUILDING_DOC
+
+//
+// IMAPPartDownloader_literalHandler
+//
+
+class IMAPPartDownloader_literalHandler : public IMAPParser::literalHandler
+{
+public:
+
+	// Target: redirect to an output stream, and count bytes written.
+	// The download offset is advanced as soon as data is written, so
+	// that it is right even if the connection drops in a literal.
+	class targetCountingStream : public targetStream
+	{
+	public:
+
+		targetCountingStream(utility::outputStream& stream, int& count, int& offset)
+			: targetStream(NULL, stream), m_count(count), m_offset(offset) { }
+
+		void putData(const string& chunk)
+		{
+			targetStream::putData(chunk);
+
+			const int n = static_cast <int>(chunk.length());
+
+			m_count += n;
+			m_offset += n;
+		}
+
+	private:
+
+		int& m_count;
+		int& m_offset;
+	};
+
+
+	IMAPPartDownloader_literalHandler(utility::outputStream& os, int& offset)
+		: m_os(os), m_count(0), m_offset(offset), m_discard(false)
+	{
+	}
+
+	target* targetFor(const IMAPParser::component& comp, const int /* data */)
+	{
+		if (!m_discard && typeid(comp) == typeid(IMAPParser::msg_att_item))
+		{
+			const int type = static_cast
+				<const IMAPParser::msg_att_item&>(comp).type();
+
+			if (type == IMAPParser::msg_att_item::BODY_SECTION)
+				return new targetCountingStream(m_os, m_count, m_offset);
+		}
+
+		return (NULL);
+	}
+
+	void reset()
+	{
+		m_count = 0;
+	}
+
+	int count() const
+	{
+		return m_count;
+	}
+
+	// Do not write data to the stream anymore
+	void discard()
+	{
+		m_discard = true;
+	}
+
+private:
+
+	utility::outputStream& m_os;
+	int m_count;
+	int& m_offset;
+	bool m_discard;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
+
+//
+// IMAPPartDownloader
+//
+
+
+IMAPPartDownloader::IMAPPartDownloader(ref <IMAPMessage> msg, ref <const messagePart> part)
+	: m_message(msg), m_part(part), m_chunkSize(256 * 1024), m_pipelineDepth(4),
+	  m_offset(0), m_complete(false)
+{
+}
+
+
+void IMAPPartDownloader::setChunkSize(const int size)
+{
+	if (size <= 0)
+		throw exceptions::invalid_argument();
+
+	m_chunkSize = size;
+}
+
+
+int IMAPPartDownloader::getChunkSize() const
+{
+	return m_chunkSize;
+}
+
+
+void IMAPPartDownloader::setPipelineDepth(const int depth)
+{
+	if (depth <= 0)
+		throw exceptions::invalid_argument();
+
+	m_pipelineDepth = depth;
+}
+
+
+int IMAPPartDownloader::getPipelineDepth() const
+{
+	return m_pipelineDepth;
+}
+
+
+void IMAPPartDownloader::setOffset(const int offset)
+{
+	if (offset < 0)
+		throw exceptions::invalid_argument();
+
+	m_offset = offset;
+	m_complete = (getSize() > 0 && m_offset >= getSize());
+}
+
+
+int IMAPPartDownloader::getOffset() const
+{
+	return m_offset;
+}
+
+
+int IMAPPartDownloader::getSize() const
+{
+	return m_part->getSize();
+}
+
+
+bool IMAPPartDownloader::isComplete() const
+{
+	return m_complete;
+}
+
+
+void IMAPPartDownloader::download(utility::outputStream& os, utility::progressListener* progress)
+{
+	ref <IMAPFolder> folder = m_message->m_folder.acquire();
+
+	if (!folder)
+		throw exceptions::folder_not_found();
+
+	ref <IMAPConnection> connection = folder->m_connection;
+
+	const int total = getSize();  // zero if unknown
+
+	if (progress)
+		progress->start(total);
+
+	// Only the bytes which are actually written are accounted for,
+	// so that the download can be resumed after an error
+	IMAPPartDownloader_literalHandler literalHandler(os, m_offset);
+
+	while (!m_complete)
+	{
+		// Send a window of range requests, without waiting for the responses
+		//
+		// Example:  C: a012 UID FETCH 1042 BODY.PEEK[2]<0.262144>
+		//           C: a013 UID FETCH 1042 BODY.PEEK[2]<262144.262144>
+		//           S: * 7 FETCH (UID 1042 BODY[2]<0> {262144} ...)
+		//           S: a012 OK FETCH completed
+		//           S: * 7 FETCH (UID 1042 BODY[2]<262144> {262144} ...)
+		//           S: a013 OK FETCH completed
+		std::vector <string> tags;
+
+		for (int i = 0 ; i < m_pipelineDepth ; ++i)
+		{
+			const int start = m_offset + i * m_chunkSize;
+
+			if (total > 0 && start >= total)
+				break;
+
+			connection->send(true, m_message->buildExtractRequest
+				(m_part, start, m_chunkSize, IMAPMessage::EXTRACT_BODY | IMAPMessage::EXTRACT_PEEK), true);
+
+			tags.push_back(connection->getLastTag());
+		}
+
+		// Read the responses in order, and append data to the output
+		string errorLog;
+
+		for (std::vector <string>::const_iterator it = tags.begin() ; it != tags.end() ; ++it)
+		{
+			literalHandler.reset();
+
+			utility::auto_ptr <IMAPParser::response> resp
+				(connection->readResponse(*it, &literalHandler));
+
+			if (resp->isBad() || resp->response_done()->response_tagged()->
+				resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+			{
+				// Data following a failed range must not be written: still
+				// read the responses to the pending requests, but drop them
+				if (errorLog.empty())
+					errorLog = resp->getErrorLog();
+
+				literalHandler.discard();
+			}
+			// A short (or empty) range means we reached the end of the part
+			else if (errorLog.empty() && literalHandler.count() < m_chunkSize)
+			{
+				m_complete = true;
+			}
+
+			if (progress)
+				progress->progress(m_offset, std::max(total, m_offset));
+		}
+
+		if (!errorLog.empty())
+		{
+			m_complete = false;
+
+			if (progress)
+				progress->stop(std::max(total, m_offset));
+
+			throw exceptions::command_error("FETCH", errorLog, "bad response");
+		}
+
+		if (total > 0 && m_offset >= total)
+			m_complete = true;
+	}
+
+	if (progress)
+		progress->stop(std::max(total, m_offset));
+}
+
+
+void IMAPPartDownloader::decode(utility::inputStream& is, utility::outputStream& os,
+                                utility::progressListener* progress) const
+{
+	ref <const IMAPMessagePart> part = m_part.dynamicCast <const IMAPMessagePart>();
+
+	// The encoding is only known for parts of the IMAP message structure
+	if (!part)
+		throw exceptions::operation_not_supported();
+
+	ref <utility::encoder::encoder> theDecoder = part->getEncoding().getEncoder();
+	theDecoder->decode(is, os, progress);
+}
+
+
+} // imap
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
@@ -0,0 +1,174 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#ifndef VMIME_NET_IMAP_IMAPPARTDOWNLOADER_HPP_INCLUDED
+#define VMIME_NET_IMAP_IMAPPARTDOWNLOADER_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+
+#include "../vmime/types.hpp"
+
+#include "../vmime/net/message.hpp"
+
+#include "../vmime/utility/inputStream.hpp"
+#include "../vmime/utility/outputStream.hpp"
+#include "../vmime/utility/progressListener.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace imap {
+
+
+class IMAPMessage;
+
+
+/** Downloads a (large) message part in byte ranges, using partial
+  * fetches (BODY.PEEK[section]<start.length>).
+  *
+  * Several range requests are sent at once on the folder connection
+  * (pipelining), so that the transfer does not stall for a round trip
+  * between two ranges.
+  *
+  * The downloader remembers how many bytes have been written to the
+  * output. If the transfer fails (eg. time-out or disconnection), open
+  * the folder again, get a new downloader for the part, set the offset
+  * with setOffset() to the size of the data already saved, and call
+  * download() again with an output stream that appends to this data:
+  * the transfer continues where it stopped.
+  *
+  * Data is downloaded as stored on the server (ie. encoded). Once the
+  * download is complete, call decode() to get the decoded contents.
+  */
+
+class VMIME_EXPORT IMAPPartDownloader : public object
+{
+public:
+
+	/** Construct a new downloader for the specified part.
+	  *
+	  * @param msg message containing the part
+	  * @param part part to download (from the message structure)
+	  */
+	IMAPPartDownloader(ref <IMAPMessage> msg, ref <const messagePart> part);
+
+	/** Set the size of the byte ranges requested from the server.
+	  * Default is 256 KB.
+	  *
+	  * @param size range size, in bytes
+	  */
+	void setChunkSize(const int size);
+
+	/** Return the size of the byte ranges requested from the server.
+	  *
+	  * @return range size, in bytes
+	  */
+	int getChunkSize() const;
+
+	/** Set the maximum number of range requests sent before reading
+	  * the responses. Default is 4. Set to 1 to disable pipelining.
+	  *
+	  * @param depth maximum number of requests in flight
+	  */
+	void setPipelineDepth(const int depth);
+
+	/** Return the maximum number of range requests sent before
+	  * reading the responses.
+	  *
+	  * @return maximum number of requests in flight
+	  */
+	int getPipelineDepth() const;
+
+	/** Set the offset from which the download will start. Use this
+	  * to resume an interrupted download.
+	  *
+	  * @param offset number of bytes already downloaded
+	  */
+	void setOffset(const int offset);
+
+	/** Return the number of bytes downloaded so far (including the
+	  * offset set with setOffset()).
+	  *
+	  * @return number of bytes downloaded
+	  */
+	int getOffset() const;
+
+	/** Return the size of the part, as announced by the server.
+	  *
+	  * @return encoded size of the part, or zero if not known
+	  */
+	int getSize() const;
+
+	/** Test whether the whole part has been downloaded.
+	  *
+	  * @return true if the download is complete, false otherwise
+	  */
+	bool isComplete() const;
+
+	/** Download the part, starting at the current offset.
+	  *
+	  * @param os output stream to which encoded data is appended
+	  * @param progress progress listener, or NULL if not used
+	  * @throw exceptions::net_exception if an error occurs; the data
+	  * received until the error has been written to the stream
+	  */
+	void download(utility::outputStream& os, utility::progressListener* progress = NULL);
+
+	/** Decode data downloaded from the server, according to the
+	  * transfer encoding of the part.
+	  *
+	  * @param is downloaded (encoded) data
+	  * @param os output stream for decoded data
+	  * @param progress progress listener, or NULL if not used
+	  * @throw exceptions::operation_not_supported if the part does not
+	  * come from the structure of an IMAP message
+	  */
+	void decode(utility::inputStream& is, utility::outputStream& os, utility::progressListener* progress = NULL) const;
+
+private:
+
+	ref <IMAPMessage> m_message;
+	ref <const messagePart> m_part;
+
+	int m_chunkSize;
+	int m_pipelineDepth;
+
+	int m_offset;
+	bool m_complete;
+};
+
+
+} // imap
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+#endif // VMIME_NET_IMAP_IMAPPARTDOWNLOADER_HPP_INCLUDED
@@ -31,10 +31,14 @@
 #include "../vmime/net/imap/IMAPFolder.hpp"
 #include "../vmime/net/imap/IMAPConnection.hpp"
 #include "../vmime/net/imap/IMAPFolderStatus.hpp"
+#include "../vmime/net/imap/IMAPCache.hpp"
+#include "../vmime/net/imap/IMAPUtils.hpp"
 
 #include "../vmime/exception.hpp"
 #include "../vmime/platform.hpp"
 
+#include "../vmime/utility/sync/autoLock.hpp"
+
 #include <map>
 
 
@@ -44,8 +48,10 @@ namespace imap {
 
 
 IMAPStore::IMAPStore(ref <session> sess, ref <security::authenticator> auth, const bool secured)
-	: store(sess, getInfosInstance(), auth), m_connection(NULL), m_isIMAPS(secured)
+	: store(sess, getInfosInstance(), auth), m_connection(NULL),
+	  m_connectionPoolSize(4), m_isIMAPS(secured)
 {
+	m_connectionPoolMutex = platform::getHandler()->createCriticalSection();
 }
 
 
@@ -109,9 +115,6 @@ void IMAPStore::connect()
 	if (isConnected())
 		throw exceptions::already_connected();
 
-    // Reset Cancel flag
-    platform::handler::setCancelFlag(false);
-
 	m_connection = vmime::create <IMAPConnection>
 		(thisRef().dynamicCast <IMAPStore>(), getAuthenticator());
 
@@ -163,6 +166,18 @@ ref <IMAPConnection> IMAPStore::getConnection()
 }
 
 
+void IMAPStore::setCache(ref <IMAPCache> cache)
+{
+	m_cache = cache;
+}
+
+
+ref <IMAPCache> IMAPStore::getCache() const
+{
+	return m_cache;
+}
+
+
 void IMAPStore::disconnect()
 {
     // FIX by Elmue: removed exception here
@@ -177,6 +192,7 @@ void IMAPStore::disconnect()
 
 	m_folders.clear();
 
+	clearConnectionPool();
 
 	m_connection->disconnect();
 
@@ -209,12 +225,357 @@ void IMAPStore::noop()
 }
 
 
+std::vector <IMAPStore::folderStatusEntry> IMAPStore::getFolderTreeWithStatus(const folder::path& path)
+{
+	if (!isConnected())
+		throw exceptions::not_connected();
+
+	// Maximum number of STATUS commands sent without waiting for responses
+	static const unsigned int STATUS_PIPELINE_DEPTH = 32;
+
+	ref <IMAPStore> thisStore = thisRef().dynamicCast <IMAPStore>();
+
+	const string statusAttributes =
+		IMAPUtils::buildStatusAttributes(m_connection->hasCapability("CONDSTORE"));
+	const bool listStatus = m_connection->hasCapability("LIST-STATUS");
+
+	// Eg. List folders in '/foo' with their status
+	//
+	//     C: a005 LIST "foo" * RETURN (STATUS (MESSAGES UNSEEN))
+	//     S: * LIST (\HasNoChildren) "/" foo/bar
+	//     S: * STATUS foo/bar (MESSAGES 17 UNSEEN 16)
+	//     S: * LIST (\NoSelect) "/" foo/zap
+	//     S: a005 OK LIST completed
+	std::ostringstream command;
+	command << "LIST ";
+	command << IMAPUtils::quoteString(IMAPUtils::pathToString
+		(m_connection->hierarchySeparator(), path));
+	command << " *";
+
+	if (listStatus)
+		command << " RETURN (STATUS " << statusAttributes << ")";
+
+	m_connection->send(true, command.str(), true);
+
+	utility::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("LIST", resp->getErrorLog(), "bad response");
+	}
+
+	std::vector <folderStatusEntry> entries;
+	std::vector <string> names;  // mailbox names, as sent by the server
+	std::map <string, ref <IMAPFolderStatus> > statusByName;
+
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+	{
+		if ((*it)->response_data() == NULL)
+		{
+			throw exceptions::command_error("LIST",
+				resp->getErrorLog(), "invalid response");
+		}
+
+		const IMAPParser::mailbox_data* mailboxData =
+			(*it)->response_data()->mailbox_data();
+
+		if (mailboxData == NULL)
+			continue;
+
+		if (mailboxData->type() == IMAPParser::mailbox_data::LIST)
+		{
+			const class IMAPParser::mailbox* mailbox =
+				mailboxData->mailbox_list()->mailbox();
+			const class IMAPParser::mailbox_flag_list* mailbox_flag_list =
+				mailboxData->mailbox_list()->mailbox_flag_list();
+
+			folderStatusEntry entry;
+			entry.imapFolder = vmime::create <IMAPFolder>(IMAPUtils::stringToPath
+					(mailboxData->mailbox_list()->quoted_char(), mailbox->name()), thisStore,
+				IMAPUtils::folderTypeFromFlags(mailbox_flag_list),
+				IMAPUtils::folderFlagsFromFlags(mailbox_flag_list));
+
+			entries.push_back(entry);
+			names.push_back(mailbox->name());
+		}
+		else if (mailboxData->type() == IMAPParser::mailbox_data::STATUS)
+		{
+			ref <IMAPFolderStatus> status = vmime::create <IMAPFolderStatus>();
+			status->updateFromResponse(mailboxData);
+
+			statusByName[mailboxData->mailbox()->name()] = status;
+		}
+	}
+
+	if (listStatus)
+	{
+		for (unsigned int i = 0 ; i < entries.size() ; ++i)
+		{
+			std::map <string, ref <IMAPFolderStatus> >::const_iterator
+				it = statusByName.find(names[i]);
+
+			if (it != statusByName.end())
+				entries[i].status = (*it).second;
+		}
+
+		return entries;
+	}
+
+	// Server does not support LIST-STATUS: pipeline the STATUS commands
+	std::vector <unsigned int> selectable;
+
+	for (unsigned int i = 0 ; i < entries.size() ; ++i)
+	{
+		if (entries[i].imapFolder->getType() & folder::TYPE_CONTAINS_MESSAGES)
+			selectable.push_back(i);
+	}
+
+	for (unsigned int start = 0 ; start < selectable.size() ; start += STATUS_PIPELINE_DEPTH)
+	{
+		const unsigned int end = std::min
+			(start + STATUS_PIPELINE_DEPTH, static_cast <unsigned int>(selectable.size()));
+
+		std::vector <string> tags;
+
+		for (unsigned int i = start ; i < end ; ++i)
+		{
+			m_connection->send(true, "STATUS " + IMAPUtils::quoteString(names[selectable[i]])
+				+ " " + statusAttributes, true);
+
+			tags.push_back(m_connection->getLastTag());
+		}
+
+		// Read all the responses before reporting an error, so that the
+		// connection is left in a consistent state
+		string errorLog;
+
+		for (unsigned int i = start ; i < end ; ++i)
+		{
+			utility::auto_ptr <IMAPParser::response> statusResp
+				(m_connection->readResponse(tags[i - start]));
+
+			if (statusResp->isBad())
+			{
+				if (errorLog.empty())
+					errorLog = statusResp->getErrorLog();
+
+				continue;
+			}
+
+			// The folder may have been deleted in the meantime
+			if (statusResp->response_done()->response_tagged()->
+				resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+			{
+				continue;
+			}
+
+			const std::vector <IMAPParser::continue_req_or_response_data*>& statusDataList =
+				statusResp->continue_req_or_response_data();
+
+			for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+			     it = statusDataList.begin() ; it != statusDataList.end() ; ++it)
+			{
+				const IMAPParser::response_data* responseData = (*it)->response_data();
+
+				if (responseData != NULL && responseData->mailbox_data() &&
+				    responseData->mailbox_data()->type() == IMAPParser::mailbox_data::STATUS)
+				{
+					ref <IMAPFolderStatus> status = vmime::create <IMAPFolderStatus>();
+					status->updateFromResponse(responseData->mailbox_data());
+
+					entries[selectable[i]].status = status;
+				}
+			}
+		}
+
+		if (!errorLog.empty())
+			throw exceptions::command_error("STATUS", errorLog, "bad response");
+	}
+
+	return entries;
+}
+
+
 ref <IMAPConnection> IMAPStore::connection()
 {
 	return (m_connection);
 }
 
 
+IMAPStore::pooledConnection::pooledConnection()
+	: mode(-1)
+{
+}
+
+
+void IMAPStore::setConnectionPoolSize(const int size)
+{
+	std::vector <ref <IMAPConnection> > evicted;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_connectionPoolMutex);
+
+		m_connectionPoolSize = std::max(0, size);
+
+		while (static_cast <int>(m_connectionPool.size()) > m_connectionPoolSize)
+		{
+			evicted.push_back(m_connectionPool.back().connection);
+			m_connectionPool.pop_back();
+		}
+	}
+
+	// Disconnect outside of the lock, as this involves network I/O
+	for (std::vector <ref <IMAPConnection> >::iterator it = evicted.begin() ;
+	     it != evicted.end() ; ++it)
+	{
+		try
+		{
+			if ((*it)->isConnected())
+				(*it)->disconnect();
+		}
+		catch (vmime::exception&)
+		{
+			// Ignore
+		}
+	}
+}
+
+
+int IMAPStore::getConnectionPoolSize() const
+{
+	return m_connectionPoolSize;
+}
+
+
+ref <IMAPConnection> IMAPStore::acquireConnection
+	(const folder::path& path, const int mode, ref <IMAPFolderStatus>& status, bool& reused)
+{
+	status = NULL;
+	reused = false;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_connectionPoolMutex);
+
+		std::list <pooledConnection>::iterator found = m_connectionPool.end();
+
+		for (std::list <pooledConnection>::iterator it = m_connectionPool.begin() ;
+		     it != m_connectionPool.end() ; )
+		{
+			// Connection may have been closed by the server while idle
+			if (!(*it).connection->isConnected())
+			{
+				it = m_connectionPool.erase(it);
+				continue;
+			}
+
+			if (found == m_connectionPool.end())
+				found = it;  // most recently used
+
+			if ((*it).mode == mode && (*it).path == path)
+			{
+				found = it;
+				break;
+			}
+
+			++it;
+		}
+
+		if (found != m_connectionPool.end())
+		{
+			ref <IMAPConnection> connection = (*found).connection;
+
+			if ((*found).mode == mode && (*found).path == path)
+				status = (*found).status;
+
+			m_connectionPool.erase(found);
+
+			reused = true;
+			return connection;
+		}
+	}
+
+	// No idle connection: open a new one
+	ref <IMAPConnection> connection = vmime::create <IMAPConnection>
+		(thisRef().dynamicCast <IMAPStore>(), getAuthenticator());
+
+	connection->connect();
+
+	return connection;
+}
+
+
+void IMAPStore::releaseConnection(ref <IMAPConnection> connection,
+	const folder::path& path, const int mode, ref <IMAPFolderStatus> status)
+{
+	ref <IMAPConnection> evicted = connection;
+
+	if (isConnected() && connection->isConnected())
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_connectionPoolMutex);
+
+		if (m_connectionPoolSize > 0)
+		{
+			pooledConnection entry;
+			entry.connection = connection;
+			entry.path = path;
+			entry.mode = (status ? mode : -1);
+			entry.status = status;
+
+			m_connectionPool.push_front(entry);
+
+			if (static_cast <int>(m_connectionPool.size()) > m_connectionPoolSize)
+			{
+				evicted = m_connectionPool.back().connection;
+				m_connectionPool.pop_back();
+			}
+			else
+			{
+				evicted = NULL;
+			}
+		}
+	}
+
+	try
+	{
+		if (evicted && evicted->isConnected())
+			evicted->disconnect();
+	}
+	catch (vmime::exception&)
+	{
+		// Ignore
+	}
+}
+
+
+void IMAPStore::clearConnectionPool()
+{
+	std::list <pooledConnection> pool;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_connectionPoolMutex);
+		pool.swap(m_connectionPool);
+	}
+
+	for (std::list <pooledConnection>::iterator it = pool.begin() ; it != pool.end() ; ++it)
+	{
+		try
+		{
+			if ((*it).connection->isConnected())
+				(*it).connection->disconnect();
+		}
+		catch (vmime::exception&)
+		{
+			// Ignore
+		}
+	}
+}
+
+
 void IMAPStore::registerFolder(IMAPFolder* folder)
 {
 	m_folders.push_back(folder);
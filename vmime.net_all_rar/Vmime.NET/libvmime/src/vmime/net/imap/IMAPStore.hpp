@@ -38,6 +38,10 @@
 #include "../vmime/net/imap/IMAPServiceInfos.hpp"
 #include "../vmime/net/imap/IMAPConnection.hpp"
 
+#include "../vmime/utility/sync/criticalSection.hpp"
+
+#include <list>
+
 
 namespace vmime {
 namespace net {
@@ -47,6 +51,8 @@ namespace imap {
 class IMAPParser;
 class IMAPTag;
 class IMAPFolder;
+class IMAPFolderStatus;
+class IMAPCache;
 
 
 /** IMAP store service.
@@ -88,8 +94,122 @@ public:
 	ref <connectionInfos> getConnectionInfos() const;
 	ref <IMAPConnection> getConnection();
 
+	/** Set the cache used to avoid fetching again message data
+	  * retrieved during previous sessions.
+	  *
+	  * @param cache cache object, or NULL to disable caching
+	  */
+	void setCache(ref <IMAPCache> cache);
+
+	/** Return the cache set with setCache().
+	  *
+	  * @return cache object, or NULL if caching is disabled
+	  */
+	ref <IMAPCache> getCache() const;
+
+	/** Set the maximum number of idle connections kept by this store.
+	  *
+	  * Each open folder uses its own connection. When a folder is closed,
+	  * its connection is kept in a pool, with the folder still selected,
+	  * instead of being disconnected: opening a folder again reuses the
+	  * connection without connecting and authenticating again and, if it
+	  * is the same folder in the same mode, without selecting it again.
+	  * When the pool is full, the connection which has been idle for
+	  * the longest time is disconnected.
+	  *
+	  * @param size maximum number of idle connections, or zero to
+	  * disconnect folder connections as soon as folders are closed
+	  */
+	void setConnectionPoolSize(const int size);
+
+	/** Return the maximum number of idle connections kept by this
+	  * store (see setConnectionPoolSize()).
+	  *
+	  * @return maximum number of idle connections
+	  */
+	int getConnectionPoolSize() const;
+
+	/** A folder listed by getFolderTreeWithStatus(), with its status.
+	  */
+	class folderStatusEntry
+	{
+	public:
+
+		ref <IMAPFolder> imapFolder;    /**< listed folder (not open) */
+		ref <IMAPFolderStatus> status;  /**< status of the folder, or NULL if
+		                                     it cannot be selected */
+	};
+
+	/** List a folder and all its sub-folders, along with their status,
+	  * in a single round trip if possible.
+	  *
+	  * If the server supports the LIST-STATUS extension (RFC 5819), the
+	  * status of the folders is returned with the LIST response.
+	  * Otherwise, the STATUS commands for all folders are pipelined
+	  * after the LIST command, instead of calling folder::getStatus()
+	  * on each folder, which waits for each response in turn.
+	  *
+	  * @param path path of the folder to list (root folder by default)
+	  * @return list of the folders and their status
+	  * @throw exceptions::net_exception if an error occurs
+	  */
+	std::vector <folderStatusEntry> getFolderTreeWithStatus(const folder::path& path = folder::path());
+
 protected:
 
+	/** An idle connection in the pool.
+	  */
+	class pooledConnection
+	{
+	public:
+
+		pooledConnection();
+
+		ref <IMAPConnection> connection;  /**< idle connection */
+		folder::path path;                /**< folder selected on the connection */
+		int mode;                         /**< mode of the selected folder, or -1 if none */
+		ref <IMAPFolderStatus> status;    /**< status of the selected folder, or NULL if none */
+	};
+
+	/** Lease a connection for a folder. An idle connection which has
+	  * the folder selected in the specified mode is preferred, then any
+	  * idle connection. If there is no idle connection, a new connection
+	  * is established.
+	  *
+	  * This function can be called from several threads.
+	  *
+	  * @param path path of the folder to open
+	  * @param mode mode in which the folder will be opened
+	  * @param status receives the status of the folder if the connection
+	  * already has it selected in this mode, or NULL otherwise
+	  * @param reused receives true if the connection was idle in the
+	  * pool (it may have been closed by the server in the meantime), or
+	  * false if it has just been established
+	  * @return connected and authenticated connection
+	  */
+	ref <IMAPConnection> acquireConnection(const folder::path& path,
+		const int mode, ref <IMAPFolderStatus>& status, bool& reused);
+
+	/** Give back a connection leased with acquireConnection(). The
+	  * connection is kept in the pool if it is still connected and if
+	  * the store is connected; otherwise, it is disconnected.
+	  *
+	  * This function can be called from several threads.
+	  *
+	  * @param connection connection to give back
+	  * @param path path of the folder selected on the connection
+	  * @param mode mode of the selected folder, or -1 if no folder
+	  * is selected
+	  * @param status status of the selected folder, or NULL if no
+	  * folder is selected
+	  */
+	void releaseConnection(ref <IMAPConnection> connection,
+		const folder::path& path, const int mode, ref <IMAPFolderStatus> status);
+
+	/** Disconnect all the idle connections of the pool.
+	  */
+	void clearConnectionPool();
+
 	// Connection
 	ref <IMAPConnection> m_connection;
 
@@ -103,6 +223,12 @@ protected:
 
 	std::list <IMAPFolder*> m_folders;
 
+	ref <IMAPCache> m_cache;
+
+	std::list <pooledConnection> m_connectionPool;  // most recently used first
+	int m_connectionPoolSize;
+	ref <utility::sync::criticalSection> m_connectionPoolMutex;
+
 	const bool m_isIMAPS;  // Use IMAPS
 
 
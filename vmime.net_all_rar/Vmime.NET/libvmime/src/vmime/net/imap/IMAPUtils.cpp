@@ -33,6 +33,8 @@
 #include "../vmime/net/message.hpp"
 #include "../vmime/net/folder.hpp"
 
+#include "../vmime/utility/stringUtils.hpp"
+
 #include <sstream>
 #include <iterator>
 #include <algorithm>
@@ -667,6 +669,8 @@ public:
 
 		if (range.getFirst() == range.getLast())
 			m_oss << range.getFirst();
+		else if (range.getLast() == -1)
+			m_oss << range.getFirst() << ":*";
 		else
 			m_oss << range.getFirst() << ":" << range.getLast();
 
@@ -745,6 +749,335 @@ const std::vector <int> IMAPUtils::messageSetToNumberList(const messageSet& msgs
 }
 
 
+// static
+messageSet IMAPUtils::sequenceSetToMessageSet(const IMAPParser::sequence_set* set, const bool uid)
+{
+	messageSet msgs = messageSet::none();
+
+	for ( ; set != NULL ; set = set->next_sequence_set())
+	{
+		unsigned long first, last;
+
+		if (set->seq_range())
+		{
+			first = set->seq_range()->first()->number()->value();
+			last = set->seq_range()->last()->number()->value();
+
+			if (first > last)
+				std::swap(first, last);
+		}
+		else
+		{
+			first = last = set->seq_number()->number()->value();
+		}
+
+		// Ranges are merged by the message set, without being expanded
+		if (uid)
+		{
+			std::ostringstream ossFirst, ossLast;
+			ossFirst.imbue(std::locale::classic());
+			ossLast.imbue(std::locale::classic());
+
+			ossFirst << first;
+			ossLast << last;
+
+			msgs.addRange(UIDMessageRange(ossFirst.str(), ossLast.str()));
+		}
+		else
+		{
+			msgs.addRange(numberMessageRange(static_cast <int>(first), static_cast <int>(last)));
+		}
+	}
+
+	return msgs;
+}
+
+
+// static
+const std::vector <message::uid> IMAPUtils::uidSetToList(const IMAPParser::uid_set* set)
+{
+	std::vector <message::uid> uids;
+
+	for ( ; set != NULL ; set = set->next_uid_set())
+	{
+		unsigned long first, last;
+
+		if (set->uid_range())
+		{
+			first = set->uid_range()->uniqueid1()->value();
+			last = set->uid_range()->uniqueid2()->value();
+
+			if (first > last)
+				std::swap(first, last);
+		}
+		else
+		{
+			first = last = set->uniqueid()->value();
+		}
+
+		for (unsigned long n = first ; n <= last ; ++n)
+			uids.push_back(message::uid(n));
+	}
+
+	return uids;
+}
+
+
+// static
+const string IMAPUtils::buildStatusAttributes(const bool highestModSeq)
+{
+	if (highestModSeq)
+		return "(MESSAGES UNSEEN UIDNEXT UIDVALIDITY HIGHESTMODSEQ)";
+	else
+		return "(MESSAGES UNSEEN UIDNEXT UIDVALIDITY)";
+}
+
+
+// static
+bool IMAPUtils::buildSearchKeys(const searchCriteria& criteria,
+	const bool literalPlus, std::vector <string>& parts)
+{
+	bool utf8 = false;
+
+	parts.clear();
+	parts.push_back("");
+
+	buildSearchKeysImpl(criteria, literalPlus, parts, utf8);
+
+	return utf8;
+}
+
+
+// static
+void IMAPUtils::buildSearchKeysImpl(const searchCriteria& criteria,
+	const bool literalPlus, std::vector <string>& parts, bool& utf8)
+{
+	const std::vector <searchCriteria>& children = criteria.getChildren();
+
+	switch (criteria.getType())
+	{
+	case searchCriteria::TYPE_ALL:
+
+		parts.back() += "ALL";
+		break;
+
+	case searchCriteria::TYPE_AND:
+
+		// Keys in a list are implicitely ANDed
+		parts.back() += "(";
+
+		for (unsigned int i = 0 ; i < children.size() ; ++i)
+		{
+			if (i != 0)
+				parts.back() += " ";
+
+			buildSearchKeysImpl(children[i], literalPlus, parts, utf8);
+		}
+
+		parts.back() += ")";
+		break;
+
+	case searchCriteria::TYPE_OR:
+
+		// "OR" takes exactly two keys: a OR (b OR c)
+		for (unsigned int i = 0 ; i < children.size() ; ++i)
+		{
+			if (i + 1 < children.size())
+				parts.back() += "OR ";
+
+			buildSearchKeysImpl(children[i], literalPlus, parts, utf8);
+
+			if (i + 1 < children.size())
+				parts.back() += " ";
+		}
+
+		break;
+
+	case searchCriteria::TYPE_NOT:
+
+		parts.back() += "NOT ";
+		buildSearchKeysImpl(children.front(), literalPlus, parts, utf8);
+
+		break;
+
+	case searchCriteria::TYPE_FLAG_SET:
+	case searchCriteria::TYPE_FLAG_UNSET:
+	{
+		const bool set = (criteria.getType() == searchCriteria::TYPE_FLAG_SET);
+		const int flags = criteria.getFlag();
+
+		std::vector <string> keys;
+
+		if (flags & message::FLAG_SEEN) keys.push_back(set ? "SEEN" : "UNSEEN");
+		if (flags & message::FLAG_RECENT) keys.push_back(set ? "RECENT" : "OLD");
+		if (flags & message::FLAG_DELETED) keys.push_back(set ? "DELETED" : "UNDELETED");
+		if (flags & message::FLAG_REPLIED) keys.push_back(set ? "ANSWERED" : "UNANSWERED");
+		if (flags & message::FLAG_MARKED) keys.push_back(set ? "FLAGGED" : "UNFLAGGED");
+		if (flags & message::FLAG_PASSED) keys.push_back(set ? "KEYWORD $Forwarded" : "UNKEYWORD $Forwarded");
+		if (flags & message::FLAG_DRAFT) keys.push_back(set ? "DRAFT" : "UNDRAFT");
+
+		if (keys.empty())
+		{
+			// No flag: nothing is set, everything is unset
+			parts.back() += (set ? "NOT ALL" : "ALL");
+			break;
+		}
+
+		// Any of the flags is set / none of the flags is set
+		if (!set)
+			parts.back() += "(";
+
+		for (unsigned int i = 0 ; i < keys.size() ; ++i)
+		{
+			if (set && i + 1 < keys.size())
+				parts.back() += "OR ";
+
+			parts.back() += keys[i];
+
+			if (i + 1 < keys.size())
+				parts.back() += " ";
+		}
+
+		if (!set)
+			parts.back() += ")";
+
+		break;
+	}
+	case searchCriteria::TYPE_SENT_BEFORE:
+
+		parts.back() += "SENTBEFORE " + searchDate(criteria.getDate());
+		break;
+
+	case searchCriteria::TYPE_SENT_SINCE:
+
+		parts.back() += "SENTSINCE " + searchDate(criteria.getDate());
+		break;
+
+	case searchCriteria::TYPE_RECEIVED_BEFORE:
+
+		parts.back() += "BEFORE " + searchDate(criteria.getDate());
+		break;
+
+	case searchCriteria::TYPE_RECEIVED_SINCE:
+
+		parts.back() += "SINCE " + searchDate(criteria.getDate());
+		break;
+
+	case searchCriteria::TYPE_HEADER:
+	{
+		const string field = utility::stringUtils::toLower(criteria.getField());
+
+		if (field == "from" || field == "to" || field == "cc" ||
+		    field == "bcc" || field == "subject")
+		{
+			parts.back() += utility::stringUtils::toUpper(field) + " ";
+		}
+		else
+		{
+			parts.back() += "HEADER ";
+			appendSearchString(criteria.getField(), literalPlus, parts, utf8);
+			parts.back() += " ";
+		}
+
+		appendSearchString(criteria.getText(), literalPlus, parts, utf8);
+		break;
+	}
+	case searchCriteria::TYPE_BODY:
+
+		parts.back() += "BODY ";
+		appendSearchString(criteria.getText(), literalPlus, parts, utf8);
+		break;
+
+	case searchCriteria::TYPE_TEXT:
+
+		parts.back() += "TEXT ";
+		appendSearchString(criteria.getText(), literalPlus, parts, utf8);
+		break;
+
+	case searchCriteria::TYPE_LARGER:
+	case searchCriteria::TYPE_SMALLER:
+	{
+		std::ostringstream oss;
+		oss.imbue(std::locale::classic());
+
+		oss << (criteria.getType() == searchCriteria::TYPE_LARGER ? "LARGER " : "SMALLER ")
+		    << std::max(0, criteria.getSize());
+
+		parts.back() += oss.str();
+		break;
+	}
+	case searchCriteria::TYPE_MODSEQ:
+	{
+		std::ostringstream oss;
+		oss.imbue(std::locale::classic());
+
+		oss << "MODSEQ " << criteria.getModSequence();
+
+		parts.back() += oss.str();
+		break;
+	}
+
+	}
+}
+
+
+// static
+void IMAPUtils::appendSearchString(const string& text,
+	const bool literalPlus, std::vector <string>& parts, bool& utf8)
+{
+	bool needLiteral = false;
+
+	for (string::const_iterator it = text.begin() ; !needLiteral && it != text.end() ; ++it)
+	{
+		const unsigned char c = *it;
+
+		if (c >= 0x80 || c == '\r' || c == '\n' || c == '\0')
+			needLiteral = true;
+	}
+
+	if (!needLiteral)
+	{
+		parts.back() += quoteString(text);
+		return;
+	}
+
+	// Literal: "{" number ["+"] "}" CRLF *CHAR8
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+
+	oss << "{" << text.length() << (literalPlus ? "+" : "") << "}";
+
+	parts.back() += oss.str();
+	parts.push_back(text);
+
+	for (string::const_iterator it = text.begin() ; !utf8 && it != text.end() ; ++it)
+	{
+		if (static_cast <unsigned char>(*it) >= 0x80)
+			utf8 = true;
+	}
+}
+
+
+// static
+const string IMAPUtils::searchDate(const vmime::datetime& date)
+{
+	// date        ::= date_text / <"> date_text <">
+	// date_text   ::= date_day "-" date_month "-" date_year
+	std::ostringstream res;
+	res.imbue(std::locale::classic());
+
+	static const char* monthNames[12] =
+		{ "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+		  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+	res << date.getDay() << '-'
+	    << monthNames[std::min(std::max(date.getMonth() - 1, 0), 11)] << '-'
+	    << date.getYear();
+
+	return res.str();
+}
+
+
 } // imap
 } // net
 } // vmime
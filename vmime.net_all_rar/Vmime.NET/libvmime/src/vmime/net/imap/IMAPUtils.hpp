@@ -36,6 +36,7 @@
 
 #include "../vmime/net/folder.hpp"
 #include "../vmime/net/message.hpp"
+#include "../vmime/net/searchCriteria.hpp"
 #include "../vmime/net/imap/IMAPParser.hpp"
 #include "../vmime/net/imap/IMAPConnection.hpp"
 
@@ -112,8 +113,68 @@ public:
 	  */
 	static const std::vector <int> messageSetToNumberList(const messageSet& msgs);
 
+	/** Returns a message set given an IMAP sequence set, as returned
+	  * by the server (eg. in an ESEARCH response).
+	  *
+	  * @param set IMAP sequence set (must not contain "*")
+	  * @param uid if true, the set contains UIDs; otherwise, it
+	  * contains message sequence numbers
+	  * @return message set
+	  */
+	static messageSet sequenceSetToMessageSet(const IMAPParser::sequence_set* set, const bool uid);
+
+	/** Returns the list of UIDs contained in an IMAP UID set, as
+	  * returned by the server (eg. in a COPYUID response code).
+	  *
+	  * @param set IMAP UID set
+	  * @return list of UIDs, in the order of the set (ranges are
+	  * expanded in ascending order)
+	  */
+	static const std::vector <message::uid> uidSetToList(const IMAPParser::uid_set* set);
+
+	/** Build the list of status data items requested by the STATUS
+	  * command and the STATUS return option of LIST (RFC 5819).
+	  *
+	  * @param highestModSeq if true, also request the highest
+	  * modification sequence (CONDSTORE)
+	  * @return parenthesized list of status data items
+	  * (eg. "(MESSAGES UNSEEN UIDNEXT UIDVALIDITY)")
+	  */
+	static const string buildStatusAttributes(const bool highestModSeq);
+
+	/** Build the search keys of a SEARCH, SORT or THREAD command.
+	  *
+	  * Text which cannot be sent as a quoted string (eg. non-ASCII
+	  * characters) is sent as a literal. As the command must be sent
+	  * in several parts in this case, the keys are split after each
+	  * literal size: every part except the last one ends with a literal
+	  * size (eg. "{12}"), and the following part starts with the literal
+	  * data. Each part must be followed by CRLF.
+	  *
+	  * @param criteria search criteria
+	  * @param literalPlus use non-synchronizing literals (LITERAL+)
+	  * @param parts receives the search keys
+	  * @return true if the keys contain non-ASCII text, which is encoded
+	  * in UTF-8 (ie. "CHARSET UTF-8" must be specified)
+	  */
+	static bool buildSearchKeys(const searchCriteria& criteria,
+		const bool literalPlus, std::vector <string>& parts);
+
 private:
 
+	static void buildSearchKeysImpl(const searchCriteria& criteria,
+		const bool literalPlus, std::vector <string>& parts, bool& utf8);
+
+	static void appendSearchString(const string& text,
+		const bool literalPlus, std::vector <string>& parts, bool& utf8);
+
+	/** Format a date to IMAP search date format (eg. "1-Feb-2013").
+	  *
+	  * @param date date to format (time is ignored)
+	  * @return IMAP-formatted date
+	  */
+	static const string searchDate(const vmime::datetime& date);
+
 	static const string buildFetchRequestImpl
 		(ref <IMAPConnection> cnt, const string& mode, const string& set, const int options);
 };
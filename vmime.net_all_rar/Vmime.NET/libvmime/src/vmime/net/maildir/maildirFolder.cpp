@@ -977,6 +977,121 @@ void maildirFolder::copyMessages(const folder::path& dest, const messageSet& msg
 }
 
 
+folder::uidMapping maildirFolder::moveMessages(const folder::path& dest, const messageSet& msgs)
+{
+	ref <maildirStore> store = m_store.acquire();
+
+	if (!store)
+		throw exceptions::illegal_state("Store disconnected");
+	else if (!isOpen())
+		throw exceptions::illegal_state("Folder not open");
+	else if (m_mode == MODE_READ_ONLY)
+		throw exceptions::illegal_state("Folder is read-only");
+
+	if (!msgs.isNumberSet())
+		throw exceptions::operation_not_supported();
+
+	ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+
+	utility::file::path curDirPath = store->getFormat()->folderPathToFileSystemPath
+		(m_path, maildirFormat::CUR_DIRECTORY);
+
+	utility::file::path destCurDirPath = store->getFormat()->
+		folderPathToFileSystemPath(dest, maildirFormat::CUR_DIRECTORY);
+	utility::file::path destTmpDirPath = store->getFormat()->
+		folderPathToFileSystemPath(dest, maildirFormat::TMP_DIRECTORY);
+
+	// Create destination directories
+	try
+	{
+		ref <utility::file> destTmpDir = fsf->create(destTmpDirPath);
+		destTmpDir->createDirectory(true);
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		// Don't throw now, it will fail later...
+	}
+
+	try
+	{
+		ref <utility::file> destCurDir = fsf->create(destCurDirPath);
+		destCurDir->createDirectory(true);
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		// Don't throw now, it will fail later...
+	}
+
+	// Move messages
+	std::vector <int> nums = maildirUtils::messageSetToNumberList(msgs);
+	std::sort(nums.begin(), nums.end());
+	nums.erase(std::unique(nums.begin(), nums.end()), nums.end());
+
+	std::vector <int> movedNums;
+	uidMapping mapping;
+
+	try
+	{
+		for (std::vector <int>::const_iterator it =
+		     nums.begin() ; it != nums.end() ; ++it)
+		{
+			const int num = *it;
+
+			if (num < 1 || num > m_messageCount)
+				throw exceptions::message_not_found();
+
+			const messageInfos& msg = m_messageInfos[num - 1];
+			const message::uid oldUID = maildirUtils::extractId(msg.path).getBuffer();
+
+			ref <utility::file> file = fsf->create(curDirPath / msg.path);
+
+			try
+			{
+				// Both folders are normally on the same file system: the
+				// message file is simply moved and keeps its name (and UID)
+				file->rename(destCurDirPath / msg.path);
+
+				mapping.push_back(std::make_pair(oldUID, oldUID));
+			}
+			catch (exceptions::filesystem_exception&)
+			{
+				// Fall back to copy + delete
+				const utility::file::path::component filename =
+					maildirUtils::buildFilename(maildirUtils::generateId(),
+						maildirUtils::extractFlags(msg.path));
+
+				{
+					ref <utility::fileReader> fr = file->getFileReader();
+					ref <utility::inputStream> is = fr->getInputStream();
+
+					copyMessageImpl(destTmpDirPath, destCurDirPath,
+						filename, *is, file->getLength(), NULL);
+				}
+
+				file->remove();
+
+				mapping.push_back(std::make_pair
+					(oldUID, message::uid(maildirUtils::extractId(filename).getBuffer())));
+			}
+
+			movedNums.push_back(num);
+		}
+	}
+	catch (exception& e)
+	{
+		removeMessagesImpl(movedNums);
+		notifyMessagesCopied(dest);
+
+		throw exceptions::command_error("MOVE", "", "", e);
+	}
+
+	removeMessagesImpl(movedNums);
+	notifyMessagesCopied(dest);
+
+	return mapping;
+}
+
+
 void maildirFolder::notifyMessagesCopied(const folder::path& dest)
 {
 	ref <maildirStore> store = m_store.acquire();
@@ -1081,7 +1196,6 @@ void maildirFolder::expunge()
 		folderPathToFileSystemPath(m_path, maildirFormat::CUR_DIRECTORY);
 
 	std::vector <int> nums;
-	int unreadCount = 0;
 
 	for (int num = 1 ; num <= m_messageCount ; ++num)
 	{
@@ -1091,18 +1205,6 @@ void maildirFolder::expunge()
 		{
 			nums.push_back(num);
 
-			for (std::vector <maildirMessage*>::iterator it =
-			     m_messages.begin() ; it != m_messages.end() ; ++it)
-			{
-				if ((*it)->m_num == num)
-					(*it)->m_expunged = true;
-				else if ((*it)->m_num > num)
-					(*it)->m_num--;
-			}
-
-			if (maildirUtils::extractFlags(infos.path) & message::FLAG_SEEN)
-				++unreadCount;
-
 			// Delete file from file system
 			try
 			{
@@ -1116,13 +1218,41 @@ void maildirFolder::expunge()
 		}
 	}
 
-	if (!nums.empty())
+	removeMessagesImpl(nums);
+}
+
+
+void maildirFolder::removeMessagesImpl(const std::vector <int>& nums)
+{
+	ref <maildirStore> store = m_store.acquire();
+
+	if (nums.empty())
+		return;
+
+	int unreadCount = 0;
+
+	// Process messages from the last one, so that the numbers of the
+	// messages which remain to be processed are not changed
+	for (std::vector <int>::size_type i = nums.size() ; i != 0 ; --i)
 	{
-		for (std::vector <int>::size_type i = nums.size() ; i != 0 ; --i)
-			m_messageInfos.erase(m_messageInfos.begin() + (i - 1));
+		const int num = nums[i - 1];
+
+		for (std::vector <maildirMessage*>::iterator it =
+		     m_messages.begin() ; it != m_messages.end() ; ++it)
+		{
+			if ((*it)->m_num == num)
+				(*it)->m_expunged = true;
+			else if ((*it)->m_num > num)
+				(*it)->m_num--;
+		}
+
+		if (!(maildirUtils::extractFlags(m_messageInfos[num - 1].path) & message::FLAG_SEEN))
+			++unreadCount;
+
+		m_messageInfos.erase(m_messageInfos.begin() + (num - 1));
 	}
 
-	m_messageCount -= nums.size();
+	m_messageCount -= static_cast <int>(nums.size());
 	m_unreadMessageCount -= unreadCount;
 
 	// Notify message expunged
@@ -107,6 +107,8 @@ public:
 
 	void copyMessages(const folder::path& dest, const messageSet& msgs);
 
+	uidMapping moveMessages(const folder::path& dest, const messageSet& msgs);
+
 	void status(int& count, int& unseen);
 	ref <folderStatus> getStatus();
 
@@ -148,6 +150,8 @@ private:
 
 	void notifyMessagesCopied(const folder::path& dest);
 
+	void removeMessagesImpl(const std::vector <int>& nums);
+
 
 	weak_ref <maildirStore> m_store;
 
@@ -141,25 +141,65 @@ messageRange* UIDMessageRange::clone() const
 // messageSet
 
 
+#ifndef VMIME_BUILDING_DOC
+
+// Value used to represent the last message in the folder (-1 or '*')
+static const vmime_uint32 LAST_MESSAGE = static_cast <vmime_uint32>(-1);
+
+
+// Returns whether an interval ends before the specified value, and
+// cannot be merged with an interval starting at this value
+static inline bool intervalEndsBefore(const std::pair <vmime_uint32, vmime_uint32>& i,
+                                      const vmime_uint32 value)
+{
+	return i.second < value && value - i.second > 1;
+}
+
+
+// Returns whether an interval ends before the specified value
+static inline bool intervalEndsBeforeValue(const std::pair <vmime_uint32, vmime_uint32>& i,
+                                           const vmime_uint32 value)
+{
+	return i.second < value;
+}
+
+
+// Appends an interval to a sorted list of intervals, merging it with
+// the last interval of the list if they overlap or touch
+static void appendInterval(std::vector <std::pair <vmime_uint32, vmime_uint32> >& list,
+                           const std::pair <vmime_uint32, vmime_uint32>& i)
+{
+	if (!list.empty() && !intervalEndsBefore(list.back(), i.first))
+		list.back().second = std::max(list.back().second, i.second);
+	else
+		list.push_back(i);
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
 messageSet::messageSet()
+	: m_type(TYPE_EMPTY)
 {
 }
 
 
 messageSet::messageSet(const messageSet& other)
-	: object()
+	: object(), m_type(other.m_type), m_intervals(other.m_intervals),
+	  m_uidRanges(other.m_uidRanges)
 {
-	m_ranges.resize(other.m_ranges.size());
-
-	for (unsigned int i = 0, n = other.m_ranges.size() ; i < n ; ++i)
-		m_ranges[i] = other.m_ranges[i]->clone();
 }
 
 
 messageSet::~messageSet()
 {
-	for (unsigned int i = 0, n = m_ranges.size() ; i < n ; ++i)
-		delete m_ranges[i];
+}
+
+
+// static
+messageSet messageSet::none()
+{
+	return messageSet();
 }
 
 
@@ -167,7 +207,7 @@ messageSet::~messageSet()
 messageSet messageSet::byNumber(const int number)
 {
 	messageSet set;
-	set.m_ranges.push_back(new numberMessageRange(number));
+	set.addRange(numberMessageRange(number));
 
 	return set;
 }
@@ -177,7 +217,7 @@ messageSet messageSet::byNumber(const int number)
 messageSet messageSet::byNumber(const int first, const int last)
 {
 	messageSet set;
-	set.m_ranges.push_back(new numberMessageRange(first, last));
+	set.addRange(numberMessageRange(first, last));
 
 	return set;
 }
@@ -186,49 +226,19 @@ messageSet messageSet::byNumber(const int first, const int last)
 // static
 messageSet messageSet::byNumber(const std::vector <int>& numbers)
 {
-	// Sort a copy of the list
-	std::vector <int> sortedNumbers;
-
-	sortedNumbers.resize(numbers.size());
-
-	std::copy(numbers.begin(), numbers.end(), sortedNumbers.begin());
+	// Sort a copy of the list, so that each number is appended at
+	// the end of the set, or merged with the last interval
+	std::vector <int> sortedNumbers(numbers);
 	std::sort(sortedNumbers.begin(), sortedNumbers.end());
 
-	// Build the set by detecting ranges of continuous numbers
-	int previous = -1, rangeStart = -1;
 	messageSet set;
 
 	for (std::vector <int>::const_iterator it = sortedNumbers.begin() ;
 	     it != sortedNumbers.end() ; ++it)
 	{
-		const int current = *it;
-
-		if (current == previous)
-			continue;  // skip duplicates
-
-		if (previous == -1)
-		{
-			previous = current;
-			rangeStart = current;
-		}
-		else
-		{
-			if (current == previous + 1)
-			{
-				previous = current;
-			}
-			else
-			{
-				set.m_ranges.push_back(new numberMessageRange(rangeStart, previous));
-
-				previous = current;
-				rangeStart = current;
-			}
-		}
+		set.addRange(numberMessageRange(*it));
 	}
 
-	set.m_ranges.push_back(new numberMessageRange(rangeStart, previous));
-
 	return set;
 }
 
@@ -237,7 +247,7 @@ messageSet messageSet::byNumber(const std::vector <int>& numbers)
 messageSet messageSet::byUID(const message::uid& uid)
 {
 	messageSet set;
-	set.m_ranges.push_back(new UIDMessageRange(uid));
+	set.addRange(UIDMessageRange(uid));
 
 	return set;
 }
@@ -246,7 +256,7 @@ messageSet messageSet::byUID(const message::uid& uid)
 messageSet messageSet::byUID(const message::uid& first, const message::uid& last)
 {
 	messageSet set;
-	set.m_ranges.push_back(new UIDMessageRange(first, last));
+	set.addRange(UIDMessageRange(first, last));
 
 	return set;
 }
@@ -255,24 +265,19 @@ messageSet messageSet::byUID(const message::uid& first, const message::uid& last
 messageSet messageSet::byUID(const std::vector <message::uid>& uids)
 {
 	std::vector <vmime_uint32> numericUIDs;
+	numericUIDs.reserve(uids.size());
+
+	messageSet set;
 
 	for (unsigned int i = 0, n = uids.size() ; i < n ; ++i)
 	{
-		const string uid = uids[i];
-		int numericUID = 0;
+		vmime_uint32 numericUID = 0;
 
-		const string::value_type* p = uid.c_str();
-
-		for ( ; *p >= '0' && *p <= '9' ; ++p)
-			 numericUID = (numericUID * 10) + (*p - '0');
-
-		if (*p != '\0')
+		if (!parseUID(uids[i], numericUID))
 		{
-			messageSet set;
-
 			// Non-numeric UID, fall back to plain UID list (single-UID ranges)
-			for (unsigned int i = 0, n = uids.size() ; i < n ; ++i)
-				set.m_ranges.push_back(new UIDMessageRange(uids[i]));
+			for (unsigned int j = 0, count = uids.size() ; j < count ; ++j)
+				set.addRange(UIDMessageRange(uids[j]));
 
 			return set;
 		}
@@ -280,88 +285,358 @@ messageSet messageSet::byUID(const std::vector <message::uid>& uids)
 		numericUIDs.push_back(numericUID);
 	}
 
-	// Sort a copy of the list
-	std::vector <vmime_uint32> sortedUIDs;
+	std::sort(numericUIDs.begin(), numericUIDs.end());
 
-	sortedUIDs.resize(numericUIDs.size());
+	if (!numericUIDs.empty())
+		set.m_type = TYPE_UID;
 
-	std::copy(numericUIDs.begin(), numericUIDs.end(), sortedUIDs.begin());
-	std::sort(sortedUIDs.begin(), sortedUIDs.end());
+	for (std::vector <vmime_uint32>::const_iterator it = numericUIDs.begin() ;
+	     it != numericUIDs.end() ; ++it)
+	{
+		appendInterval(set.m_intervals, interval(*it, *it));
+	}
 
-	// Build the set by detecting ranges of continuous numbers
-	vmime_uint32 previous = (vmime_uint32)-1, rangeStart = (vmime_uint32)-1;
-	messageSet set;
+	return set;
+}
+
+
+void messageSet::addRange(const messageRange& range)
+{
+	const numberMessageRange* numberRange = dynamic_cast <const numberMessageRange*>(&range);
+	const UIDMessageRange* uidRange = dynamic_cast <const UIDMessageRange*>(&range);
+
+	if (numberRange)
+	{
+		if (m_type == TYPE_UID)
+			throw std::invalid_argument("range");
+
+		m_type = TYPE_NUMBER;
+
+		insertInterval(static_cast <vmime_uint32>(numberRange->getFirst()),
+			numberRange->getLast() == -1 ? LAST_MESSAGE
+				: static_cast <vmime_uint32>(numberRange->getLast()));
+	}
+	else if (uidRange)
+	{
+		if (m_type == TYPE_NUMBER)
+			throw std::invalid_argument("range");
+
+		m_type = TYPE_UID;
+
+		vmime_uint32 first = 0, last = 0;
+
+		if (m_uidRanges.empty() &&
+		    parseUID(uidRange->getFirst(), first) && parseUID(uidRange->getLast(), last))
+		{
+			// IMAP allows ranges to be specified in any order (eg. "42:12")
+			if (first > last)
+				std::swap(first, last);
+
+			insertInterval(first, last);
+		}
+		else
+		{
+			convertToUIDList();
 
-	for (std::vector <vmime_uint32>::const_iterator it = sortedUIDs.begin() ;
-	     it != sortedUIDs.end() ; ++it)
+			m_uidRanges.push_back(std::make_pair(uidRange->getFirst(), uidRange->getLast()));
+		}
+	}
+	else
 	{
-		const vmime_uint32 current = *it;
+		throw std::invalid_argument("range");
+	}
+}
+
+
+void messageSet::insertInterval(const vmime_uint32 first, const vmime_uint32 last)
+{
+	// Find the first interval which can be merged with the new one
+	std::vector <interval>::iterator begin =
+		std::lower_bound(m_intervals.begin(), m_intervals.end(), first, intervalEndsBefore);
+
+	// Find the end of the intervals which can be merged with the new one
+	std::vector <interval>::iterator end = begin;
+
+	while (end != m_intervals.end() && (last == LAST_MESSAGE || (*end).first <= last + 1))
+		++end;
+
+	if (begin == end)
+	{
+		m_intervals.insert(begin, interval(first, last));
+	}
+	else
+	{
+		(*begin).first = std::min((*begin).first, first);
+		(*begin).second = std::max((*(end - 1)).second, last);
+
+		m_intervals.erase(begin + 1, end);
+	}
+}
+
+
+void messageSet::convertToUIDList()
+{
+	for (std::vector <interval>::const_iterator it = m_intervals.begin() ;
+	     it != m_intervals.end() ; ++it)
+	{
+		m_uidRanges.push_back(std::make_pair(formatUID((*it).first), formatUID((*it).second)));
+	}
+
+	m_intervals.clear();
+}
+
+
+void messageSet::checkCompatible(const messageSet& other) const
+{
+	if (!m_uidRanges.empty() || !other.m_uidRanges.empty())
+		throw std::invalid_argument("other");
+
+	if (m_type != TYPE_EMPTY && other.m_type != TYPE_EMPTY && m_type != other.m_type)
+		throw std::invalid_argument("other");
+}
+
+
+messageSet messageSet::getUnion(const messageSet& other) const
+{
+	checkCompatible(other);
 
-		if (current == previous)
-			continue;  // skip duplicates
+	messageSet set;
+	set.m_type = (m_type != TYPE_EMPTY ? m_type : other.m_type);
+	set.m_intervals.reserve(m_intervals.size() + other.m_intervals.size());
+
+	std::vector <interval>::const_iterator it = m_intervals.begin();
+	std::vector <interval>::const_iterator jt = other.m_intervals.begin();
 
-		if (previous == (vmime_uint32)-1)
+	while (it != m_intervals.end() || jt != other.m_intervals.end())
+	{
+		if (jt == other.m_intervals.end() ||
+		    (it != m_intervals.end() && (*it).first < (*jt).first))
 		{
-			previous = current;
-			rangeStart = current;
+			appendInterval(set.m_intervals, *it++);
 		}
 		else
 		{
-			if (current == previous + 1)
-			{
-				previous = current;
-			}
+			appendInterval(set.m_intervals, *jt++);
+		}
+	}
+
+	return set;
+}
+
+
+messageSet messageSet::getIntersection(const messageSet& other) const
+{
+	checkCompatible(other);
+
+	messageSet set;
+
+	std::vector <interval>::const_iterator it = m_intervals.begin();
+	std::vector <interval>::const_iterator jt = other.m_intervals.begin();
+
+	while (it != m_intervals.end() && jt != other.m_intervals.end())
+	{
+		const vmime_uint32 first = std::max((*it).first, (*jt).first);
+		const vmime_uint32 last = std::min((*it).second, (*jt).second);
+
+		if (first <= last)
+			set.m_intervals.push_back(interval(first, last));
+
+		// Advance the interval which ends first
+		if ((*it).second < (*jt).second)
+			++it;
+		else
+			++jt;
+	}
+
+	if (!set.m_intervals.empty())
+		set.m_type = m_type;
+
+	return set;
+}
+
+
+messageSet messageSet::getDifference(const messageSet& other) const
+{
+	checkCompatible(other);
+
+	messageSet set;
+
+	std::vector <interval>::const_iterator jt = other.m_intervals.begin();
+
+	for (std::vector <interval>::const_iterator it = m_intervals.begin() ;
+	     it != m_intervals.end() ; ++it)
+	{
+		vmime_uint32 first = (*it).first;
+		const vmime_uint32 last = (*it).second;
+		bool remaining = true;
+
+		// Skip the intervals which end before this one
+		while (jt != other.m_intervals.end() && (*jt).second < first)
+			++jt;
+
+		// Remove the intervals which overlap this one
+		for ( ; remaining && jt != other.m_intervals.end() && (*jt).first <= last ; ++jt)
+		{
+			if ((*jt).first > first)
+				set.m_intervals.push_back(interval(first, (*jt).first - 1));
+
+			if ((*jt).second >= last)
+				remaining = false;
 			else
-			{
-				set.m_ranges.push_back(new UIDMessageRange
-					(static_cast <std::ostringstream*>(&(std::ostringstream() << rangeStart))->str(),
-					 static_cast <std::ostringstream*>(&(std::ostringstream() << previous))->str()));
-
-				previous = current;
-				rangeStart = current;
-			}
+				first = (*jt).second + 1;
 		}
+
+		if (remaining)
+			set.m_intervals.push_back(interval(first, last));
+
+		// The last removed interval may also overlap the next one
+		if (!remaining && jt != other.m_intervals.begin())
+			--jt;
 	}
 
-	set.m_ranges.push_back(new UIDMessageRange
-		(static_cast <std::ostringstream*>(&(std::ostringstream() << rangeStart))->str(),
-		 static_cast <std::ostringstream*>(&(std::ostringstream() << previous))->str()));
+	if (!set.m_intervals.empty())
+		set.m_type = m_type;
 
 	return set;
 }
 
 
-void messageSet::addRange(const messageRange& range)
+bool messageSet::containsValue(const vmime_uint32 value) const
 {
-	if (!m_ranges.empty() && typeid(*m_ranges[0]) != typeid(range))
-		throw std::invalid_argument("range");
+	std::vector <interval>::const_iterator it =
+		std::lower_bound(m_intervals.begin(), m_intervals.end(), value, intervalEndsBeforeValue);
+
+	return it != m_intervals.end() && (*it).first <= value && value <= (*it).second;
+}
+
+
+bool messageSet::contains(const int number) const
+{
+	return m_type == TYPE_NUMBER && number >= 1 &&
+		containsValue(static_cast <vmime_uint32>(number));
+}
+
 
-	m_ranges.push_back(range.clone());
+bool messageSet::contains(const message::uid& uid) const
+{
+	if (m_type != TYPE_UID)
+		return false;
+
+	if (m_uidRanges.empty())
+	{
+		vmime_uint32 value = 0;
+		return parseUID(uid, value) && containsValue(value);
+	}
+
+	// Non-numeric UIDs: only single UIDs can be matched
+	for (std::vector <std::pair <message::uid, message::uid> >::const_iterator
+	     it = m_uidRanges.begin() ; it != m_uidRanges.end() ; ++it)
+	{
+		if ((*it).first == uid && (*it).second == uid)
+			return true;
+	}
+
+	return false;
+}
+
+
+int messageSet::getRangeCount() const
+{
+	return static_cast <int>(m_intervals.size() + m_uidRanges.size());
 }
 
 
 void messageSet::enumerate(messageSetEnumerator& en) const
 {
-	for (unsigned int i = 0, n = m_ranges.size() ; i < n ; ++i)
-		m_ranges[i]->enumerate(en);
+	if (m_type == TYPE_NUMBER)
+	{
+		for (std::vector <interval>::const_iterator it = m_intervals.begin() ;
+		     it != m_intervals.end() ; ++it)
+		{
+			en.enumerateNumberMessageRange(numberMessageRange(static_cast <int>((*it).first),
+				(*it).second == LAST_MESSAGE ? -1 : static_cast <int>((*it).second)));
+		}
+	}
+	else if (m_type == TYPE_UID)
+	{
+		for (std::vector <interval>::const_iterator it = m_intervals.begin() ;
+		     it != m_intervals.end() ; ++it)
+		{
+			en.enumerateUIDMessageRange(UIDMessageRange
+				(formatUID((*it).first), formatUID((*it).second)));
+		}
+
+		for (std::vector <std::pair <message::uid, message::uid> >::const_iterator
+		     it = m_uidRanges.begin() ; it != m_uidRanges.end() ; ++it)
+		{
+			en.enumerateUIDMessageRange(UIDMessageRange((*it).first, (*it).second));
+		}
+	}
 }
 
 
 bool messageSet::isEmpty() const
 {
-	return m_ranges.empty();
+	return m_intervals.empty() && m_uidRanges.empty();
 }
 
 
 bool messageSet::isNumberSet() const
 {
-	return !isEmpty() && dynamic_cast <numberMessageRange*>(m_ranges[0]) != NULL;
+	return !isEmpty() && m_type == TYPE_NUMBER;
 }
 
 
 bool messageSet::isUIDSet() const
 {
-	return !isEmpty() && dynamic_cast <UIDMessageRange*>(m_ranges[0]) != NULL;
+	return !isEmpty() && m_type == TYPE_UID;
+}
+
+
+// static
+bool messageSet::parseUID(const message::uid& uid, vmime_uint32& value)
+{
+	const string str = uid;
+
+	if (str == "*")
+	{
+		value = LAST_MESSAGE;
+		return true;
+	}
+
+	if (str.empty() || str.length() > 10)
+		return false;
+
+	vmime_uint64 v = 0;
+
+	for (string::const_iterator it = str.begin() ; it != str.end() ; ++it)
+	{
+		if (*it < '0' || *it > '9')
+			return false;
+
+		v = (v * 10) + (*it - '0');
+	}
+
+	if (v >= LAST_MESSAGE)
+		return false;
+
+	value = static_cast <vmime_uint32>(v);
+
+	return true;
+}
+
+
+// static
+const message::uid messageSet::formatUID(const vmime_uint32 value)
+{
+	if (value == LAST_MESSAGE)
+		return message::uid("*");
+
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+	oss << value;
+
+	return message::uid(oss.str());
 }
 
 
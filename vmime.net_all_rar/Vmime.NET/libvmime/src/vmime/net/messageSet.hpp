@@ -182,6 +182,12 @@ private:
 /** Represents a set of messages, designated either by their sequence
   * number, or by their UID (but not both).
   *
+  * Message numbers and numeric UIDs (this is the case for IMAP) are
+  * stored as a sorted list of disjoint intervals: ranges are merged as
+  * they are added, so that the set is always as compact as possible,
+  * whatever the order in which messages are added. Non-numeric UIDs
+  * are kept in the order in which they are added.
+  *
   * Following is example code to designate messages by their number:
   * \code{.cpp}
   *    // Designate a single message with sequence number 42
@@ -214,6 +220,12 @@ public:
 
 	messageSet(const messageSet& other);
 
+	/** Constructs a new, empty message set.
+	  *
+	  * @return new message set
+	  */
+	static messageSet none();
+
 	/** Constructs a new message set and initializes it with a single
 	  * message represented by its sequence number.
 	  *
@@ -244,7 +256,7 @@ public:
 	  * result in the following ranges: "1:5,7:8,13,15:17".
 	  *
 	  * @param numbers a vector containing numbers of the messages
-	  * @return new message set
+	  * @return new message set (empty if the list is empty)
 	  */
 	static messageSet byNumber(const std::vector <int>& numbers);
 
@@ -277,7 +289,7 @@ public:
 	  * result in the following ranges: "1:5,7:8,13,15:17".
 	  *
 	  * @param uids a vector containing UIDs of the messages
-	  * @return new message set
+	  * @return new message set (empty if the list is empty)
 	  */
 	static messageSet byUID(const std::vector <message::uid>& uids);
 
@@ -286,12 +298,70 @@ public:
 	  * contained in this set (ie. it's not possible to have a message
 	  * set which contains both number ranges and UID ranges).
 	  *
+	  * The range is merged with the ranges it overlaps or touches.
+	  *
 	  * @param range range to add
 	  * @throw std::invalid_argument exception if the range type does
 	  * not match the type of the ranges in this set
 	  */
 	void addRange(const messageRange& range);
 
+	/** Returns the set of messages contained in this set or in the
+	  * specified set.
+	  *
+	  * The last message in the folder (-1 or '*') is considered as
+	  * being greater than any message number or UID.
+	  *
+	  * @param other other set
+	  * @return union of the two sets
+	  * @throw std::invalid_argument exception if the sets are not of the
+	  * same type, or if they contain non-numeric UIDs
+	  */
+	messageSet getUnion(const messageSet& other) const;
+
+	/** Returns the set of messages contained both in this set and in
+	  * the specified set.
+	  *
+	  * @param other other set
+	  * @return intersection of the two sets
+	  * @throw std::invalid_argument exception if the sets are not of the
+	  * same type, or if they contain non-numeric UIDs
+	  */
+	messageSet getIntersection(const messageSet& other) const;
+
+	/** Returns the set of messages contained in this set but not in
+	  * the specified set.
+	  *
+	  * @param other other set
+	  * @return difference of the two sets
+	  * @throw std::invalid_argument exception if the sets are not of the
+	  * same type, or if they contain non-numeric UIDs
+	  */
+	messageSet getDifference(const messageSet& other) const;
+
+	/** Returns whether this set contains the specified message.
+	  *
+	  * @param number message number
+	  * @return true if this set is a number set containing the
+	  * message, or false otherwise
+	  */
+	bool contains(const int number) const;
+
+	/** Returns whether this set contains the specified message.
+	  *
+	  * @param uid message UID
+	  * @return true if this set is a UID set containing the message,
+	  * or false otherwise
+	  */
+	bool contains(const message::uid& uid) const;
+
+	/** Returns the number of ranges in this set, after ranges which
+	  * overlap or touch have been merged.
+	  *
+	  * @return number of ranges
+	  */
+	int getRangeCount() const;
+
 	/** Enumerates this set with the specified enumerator.
 	  *
 	  * @param en enumerator that will receive the method calls while
@@ -322,9 +392,32 @@ public:
 
 private:
 
+	enum Type
+	{
+		TYPE_EMPTY,
+		TYPE_NUMBER,
+		TYPE_UID
+	};
+
+	/** Interval of message numbers or numeric UIDs (bounds included). */
+	typedef std::pair <vmime_uint32, vmime_uint32> interval;
+
 	messageSet();
 
-	std::vector <messageRange*> m_ranges;
+	void insertInterval(const vmime_uint32 first, const vmime_uint32 last);
+	void checkCompatible(const messageSet& other) const;
+	bool containsValue(const vmime_uint32 value) const;
+
+	void convertToUIDList();
+
+	static bool parseUID(const message::uid& uid, vmime_uint32& value);
+	static const message::uid formatUID(const vmime_uint32 value);
+
+
+	Type m_type;
+
+	std::vector <interval> m_intervals;  // sorted, disjoint and non-adjacent
+	std::vector <std::pair <message::uid, message::uid> > m_uidRanges;  // if non-numeric UIDs
 };
 
 
@@ -33,6 +33,8 @@
 #include "../vmime/exception.hpp"
 #include "../vmime/platform.hpp"
 
+#include "../vmime/utility/stringUtils.hpp"
+
 #include "../vmime/security/digest/messageDigestFactory.hpp"
 
 #include "../vmime/net/defaultConnectionInfos.hpp"
@@ -102,6 +104,7 @@ void POP3Connection::connect()
 
 	// Create and connect the socket
 	m_socket = store->getSocketFactory()->create(m_timeoutHandler);
+	m_socket->setCancellationToken(store->getCancellationToken());
 
 #if VMIME_HAVE_TLS_SUPPORT
 	if (store->isPOP3S())  // dedicated port/POP3S
@@ -226,6 +229,8 @@ void POP3Connection::internalDisconnect()
 	m_socket = NULL;
 	m_timeoutHandler = NULL;
 
+	m_receivedData.clear();
+
 	m_authenticated = false;
 	m_secured = false;
 
@@ -635,6 +640,7 @@ void POP3Connection::startTLS()
 		ref <tls::TLSSocket> tlsSocket =
 			tlsSession->getSocket(m_socket);
 
+		tlsSocket->setServerName(m_cntInfos->getHost());
 		tlsSocket->handshake(m_timeoutHandler);
 
 		// FIX by Elmue: Added Trace output
@@ -680,6 +686,55 @@ const std::vector <string> POP3Connection::getCapabilities()
 }
 
 
+bool POP3Connection::hasCapability(const string& capa)
+{
+	const std::vector <string> capabilities = getCapabilities();
+
+	for (unsigned int i = 0 ; i < capabilities.size() ; ++i)
+	{
+		// Ignore capability parameters (eg. "SASL PLAIN LOGIN")
+		const string::size_type end = capabilities[i].find_first_of(" \t");
+		const string name = capabilities[i].substr(0, end);
+
+		if (utility::stringUtils::isStringEqualNoCase(name, capa))
+			return true;
+	}
+
+	return false;
+}
+
+
+int POP3Connection::getPipelineDepth()
+{
+	// Maximum number of commands in flight: this is limited so that the
+	// server does not block writing responses while we are still sending
+	// commands (neither side reads while writing)
+	static const int PIPELINE_DEPTH = 32;
+
+	return hasCapability("PIPELINING") ? PIPELINE_DEPTH : 1;
+}
+
+
+void POP3Connection::receive(string& buffer)
+{
+	if (!m_receivedData.empty())
+	{
+		buffer.clear();
+		buffer.swap(m_receivedData);
+	}
+	else
+	{
+		getSocket()->receive(buffer);
+	}
+}
+
+
+void POP3Connection::pushBack(const string& data)
+{
+	m_receivedData.insert(0, data);
+}
+
+
 void POP3Connection::invalidateCapabilities()
 {
 	m_capabilities.clear();
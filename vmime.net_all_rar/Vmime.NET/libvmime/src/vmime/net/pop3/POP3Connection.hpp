@@ -83,6 +83,38 @@ public:
 	virtual ref <security::authenticator> getAuthenticator();
 	virtual ref <session> getSession();
 
+	/** Receive data from the server. Data which has been received
+	  * previously but has not been consumed yet (see pushBack()) is
+	  * returned first.
+	  *
+	  * @param buffer receives the data (empty if no data is available)
+	  */
+	void receive(string& buffer);
+
+	/** Give back data which has been received from the server but which
+	  * belongs to the following responses. This happens when commands are
+	  * pipelined: the data will be returned by the next call to receive().
+	  *
+	  * @param data data to give back
+	  */
+	void pushBack(const string& data);
+
+	/** Returns whether the server advertised the specified capability
+	  * in response to the CAPA command (RFC 2449).
+	  *
+	  * @param capa capability name (eg. "PIPELINING"), case-insensitive
+	  * @return true if the capability is supported, false otherwise
+	  */
+	bool hasCapability(const string& capa);
+
+	/** Returns the maximum number of commands which may be sent without
+	  * waiting for their responses.
+	  *
+	  * @return a number greater than one if the server supports command
+	  * pipelining (PIPELINING capability), or 1 otherwise
+	  */
+	int getPipelineDepth();
+
 private:
 
 	void authenticate(const messageId& randomMID);
@@ -114,6 +146,8 @@ private:
 
 	std::vector <string> m_capabilities;
 	bool m_capabilitiesFetched;
+
+	string m_receivedData;  // received but not consumed yet
 };
 
 
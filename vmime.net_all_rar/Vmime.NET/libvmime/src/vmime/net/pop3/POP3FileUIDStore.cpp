@@ -0,0 +1,336 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_POP3 && VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include "../vmime/net/pop3/POP3FileUIDStore.hpp"
+
+#include "../vmime/utility/fileUtils.hpp"
+#include "../vmime/utility/outputStreamAdapter.hpp"
+#include "../vmime/utility/streamUtils.hpp"
+#include "../vmime/utility/sync/autoLock.hpp"
+
+#include "../vmime/exception.hpp"
+#include "../vmime/platform.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+
+namespace vmime {
+namespace net {
+namespace pop3 {
+
+
+#ifndef VMIME_BUILDING_DOC
+
+// Version of the format of the account files
+static const int POP3FileUIDStore_fileVersion = 1;
+
+
+// Order entries by hash only
+struct POP3FileUIDStore_hashLess
+{
+	bool operator()(const std::pair <vmime_uint64, vmime_uint32>& a, const vmime_uint64 b) const
+	{
+		return a.first < b;
+	}
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
+
+POP3FileUIDStore::accountState::accountState()
+	: generation(0), modified(false), syncing(false)
+{
+}
+
+
+
+POP3FileUIDStore::POP3FileUIDStore(const utility::file::path& rootDir)
+	: m_rootDir(rootDir), m_generationCount(3)
+{
+	m_mutex = platform::getHandler()->createCriticalSection();
+}
+
+
+void POP3FileUIDStore::setGenerationCount(const unsigned int count)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	m_generationCount = std::max(1u, count);
+}
+
+
+unsigned int POP3FileUIDStore::getGenerationCount() const
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	return m_generationCount;
+}
+
+
+void POP3FileUIDStore::beginSync(const string& account)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	// The generation is only advanced when a complete
+	// synchronization ends (see endSync())
+	getAccountState(account).syncing = true;
+}
+
+
+bool POP3FileUIDStore::isKnown(const string& account, const string& uid)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	accountState& state = getAccountState(account);
+	const vmime_uint64 hash = hashUID(uid);
+
+	std::vector <entry>::iterator it = std::lower_bound
+		(state.entries.begin(), state.entries.end(), hash, POP3FileUIDStore_hashLess());
+
+	if (it == state.entries.end() || (*it).first != hash)
+		return false;
+
+	(*it).second = state.generation + 1;
+
+	return true;
+}
+
+
+void POP3FileUIDStore::addUID(const string& account, const string& uid)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	const bool loaded = (m_accounts.find(account) != m_accounts.end());
+
+	accountState& state = getAccountState(account);
+	const vmime_uint64 hash = hashUID(uid);
+
+	std::vector <entry>::iterator it = std::lower_bound
+		(state.entries.begin(), state.entries.end(), hash, POP3FileUIDStore_hashLess());
+
+	// UIDs recorded now are as recent as the ones listed
+	// during the next complete synchronization
+	if (it != state.entries.end() && (*it).first == hash)
+	{
+		(*it).second = state.generation + 1;
+	}
+	else
+	{
+		state.entries.insert(it, entry(hash, state.generation + 1));
+		state.modified = true;
+	}
+
+	// Outside of a synchronization, save the state immediately
+	if (!loaded && !state.syncing)
+	{
+		if (state.modified)
+			writeState(account, state);
+
+		m_accounts.erase(account);
+	}
+}
+
+
+void POP3FileUIDStore::endSync(const string& account, const bool complete)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	std::map <string, accountState>::iterator it = m_accounts.find(account);
+
+	if (it == m_accounts.end())
+		return;
+
+	accountState& state = (*it).second;
+
+	if (complete)
+	{
+		++state.generation;
+
+		// Forget the UIDs which have not been listed by the server
+		// during the last complete synchronizations; if some UIDs were
+		// not listed during this synchronization, the file must be
+		// updated anyway, so that they will be forgotten later
+		std::vector <entry>::iterator out = state.entries.begin();
+
+		for (std::vector <entry>::const_iterator in = state.entries.begin() ;
+		     in != state.entries.end() ; ++in)
+		{
+			if ((*in).second != state.generation)
+			{
+				state.modified = true;
+
+				if (state.generation - (*in).second >= m_generationCount)
+					continue;
+			}
+
+			*out++ = *in;
+		}
+
+		state.entries.erase(out, state.entries.end());
+	}
+
+	try
+	{
+		if (state.modified)
+			writeState(account, state);
+	}
+	catch (...)
+	{
+		m_accounts.erase(it);
+		throw;
+	}
+
+	m_accounts.erase(it);
+}
+
+
+POP3FileUIDStore::accountState& POP3FileUIDStore::getAccountState(const string& account)
+{
+	std::map <string, accountState>::iterator it = m_accounts.find(account);
+
+	if (it != m_accounts.end())
+		return (*it).second;
+
+	accountState& state = m_accounts[account];
+	readState(account, state);
+
+	return state;
+}
+
+
+// static
+vmime_uint64 POP3FileUIDStore::hashUID(const string& uid)
+{
+	// 64-bit FNV-1a
+	const vmime_uint64 prime = (static_cast <vmime_uint64>(1) << 40) | 0x1b3;
+	vmime_uint64 hash = (static_cast <vmime_uint64>(0xcbf29ce4) << 32) | 0x84222325;
+
+	for (string::const_iterator it = uid.begin() ; it != uid.end() ; ++it)
+	{
+		hash ^= static_cast <unsigned char>(*it);
+		hash *= prime;
+	}
+
+	return hash;
+}
+
+
+void POP3FileUIDStore::readState(const string& account, accountState& state)
+{
+	ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+
+	std::ostringstream oss;
+	utility::outputStreamAdapter ossAdapter(oss);
+
+	try
+	{
+		ref <utility::file> file = fsf->create(m_rootDir / utility::fileUtils::escapeName(account));
+
+		if (!file->exists() || !file->isFile())
+			return;
+
+		ref <utility::fileReader> reader = file->getFileReader();
+		ref <utility::inputStream> is = reader->getInputStream();
+
+		utility::bufferedStreamCopy(*is, ossAdapter);
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		return;
+	}
+
+	// File format:
+	//
+	//    <version> <generation> <entry count>
+	//    <hash in hexadecimal> <generation>
+	//    ...
+	std::istringstream iss(oss.str());
+	iss.imbue(std::locale::classic());
+
+	int version = 0;
+	vmime_uint32 generation = 0;
+	size_t count = 0;
+
+	iss >> version >> generation >> count;
+
+	if (iss.fail() || version != POP3FileUIDStore_fileVersion)
+		return;
+
+	std::vector <entry> entries;
+	entries.reserve(count);
+
+	for (size_t i = 0 ; i < count ; ++i)
+	{
+		vmime_uint64 hash = 0;
+		vmime_uint32 gen = 0;
+
+		iss >> std::hex >> hash >> std::dec >> gen;
+
+		if (iss.fail())  // truncated file
+			return;
+
+		entries.push_back(entry(hash, gen));
+	}
+
+	state.generation = generation;
+	state.entries.swap(entries);
+}
+
+
+void POP3FileUIDStore::writeState(const string& account, const accountState& state)
+{
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+
+	oss << POP3FileUIDStore_fileVersion << ' ' << state.generation << ' ' << state.entries.size() << '\n';
+
+	for (std::vector <entry>::const_iterator it = state.entries.begin() ; it != state.entries.end() ; ++it)
+	{
+		oss << std::hex << std::setw(16) << std::setfill('0') << (*it).first
+		    << std::dec << ' ' << (*it).second << '\n';
+	}
+
+	// The state of the account must never be lost if the file is not
+	// completely written. Unlike for a cache, errors are reported: if
+	// the state cannot be saved, the same messages would be retrieved
+	// again.
+	utility::fileUtils::writeFileAtomically
+		(m_rootDir / utility::fileUtils::escapeName(account), oss.str());
+}
+
+
+} // pop3
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_POP3 && VMIME_HAVE_FILESYSTEM_FEATURES
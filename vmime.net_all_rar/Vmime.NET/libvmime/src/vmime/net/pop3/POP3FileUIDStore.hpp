@@ -0,0 +1,142 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_POP3_POP3FILEUIDSTORE_HPP_INCLUDED
+#define VMIME_NET_POP3_POP3FILEUIDSTORE_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_POP3 && VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include <map>
+#include <vector>
+
+#include "../vmime/net/pop3/POP3UIDStore.hpp"
+
+#include "../vmime/utility/file.hpp"
+#include "../vmime/utility/sync/criticalSection.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace pop3 {
+
+
+/** POP3 UID store which keeps one file per account, in a local directory.
+  *
+  * UIDs are stored as 64-bit hashes, sorted so that they can be looked
+  * up by binary search. Each UID is stored with the number of the
+  * complete synchronization during which it was last listed by the
+  * server: UIDs which have not been listed during the last complete
+  * synchronizations are removed. Only complete synchronizations are
+  * counted, so that recording UIDs outside of a listing never makes
+  * other UIDs older.
+  *
+  * The state of an account is only kept in memory during a
+  * synchronization, and the file is only rewritten when UIDs were
+  * added or are no longer listed by the server. The store can be
+  * used from several threads.
+  */
+
+class VMIME_EXPORT POP3FileUIDStore : public POP3UIDStore
+{
+public:
+
+	/** Construct a new store which keeps its data in the
+	  * specified directory. The directory is created if needed.
+	  *
+	  * @param rootDir full path of the store directory
+	  */
+	POP3FileUIDStore(const utility::file::path& rootDir);
+
+	/** Set the number of synchronizations after which a UID which is
+	  * not listed by the server anymore is forgotten. The default is 3.
+	  *
+	  * @param count number of synchronizations (at least 1)
+	  */
+	void setGenerationCount(const unsigned int count);
+
+	unsigned int getGenerationCount() const;
+
+	void beginSync(const string& account);
+	bool isKnown(const string& account, const string& uid);
+	void addUID(const string& account, const string& uid);
+	void endSync(const string& account, const bool complete);
+
+private:
+
+	/** UID hash, and number of the complete synchronization during
+	  * which the UID was last listed or added.
+	  */
+	typedef std::pair <vmime_uint64, vmime_uint32> entry;
+
+	class accountState
+	{
+	public:
+
+		accountState();
+
+		vmime_uint32 generation;      /**< number of complete synchronizations */
+		std::vector <entry> entries;  /**< entries, sorted by hash */
+		bool modified;                /**< entries have been added */
+		bool syncing;                 /**< a synchronization is in progress */
+	};
+
+	/** Return the state of an account, and load it from
+	  * its file if it is not already in memory.
+	  *
+	  * @param account account identity
+	  * @return account state
+	  */
+	accountState& getAccountState(const string& account);
+
+	/** Compute the hash under which a UID is stored.
+	  *
+	  * @param uid UID of the message
+	  * @return 64-bit FNV-1a hash of the UID
+	  */
+	static vmime_uint64 hashUID(const string& uid);
+
+	void readState(const string& account, accountState& state);
+	void writeState(const string& account, const accountState& state);
+
+
+	utility::file::path m_rootDir;
+	unsigned int m_generationCount;
+
+	std::map <string, accountState> m_accounts;
+	ref <utility::sync::criticalSection> m_mutex;
+};
+
+
+} // pop3
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_POP3 && VMIME_HAVE_FILESYSTEM_FEATURES
+
+#endif // VMIME_NET_POP3_POP3FILEUIDSTORE_HPP_INCLUDED
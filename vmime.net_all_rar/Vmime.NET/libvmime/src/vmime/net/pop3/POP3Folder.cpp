@@ -34,10 +34,16 @@
 #include "../vmime/net/pop3/POP3Command.hpp"
 #include "../vmime/net/pop3/POP3Response.hpp"
 #include "../vmime/net/pop3/POP3FolderStatus.hpp"
+#include "../vmime/net/pop3/POP3UIDStore.hpp"
 
 #include "../vmime/net/pop3/POP3Utils.hpp"
 
 #include "../vmime/exception.hpp"
+#include "../vmime/header.hpp"
+
+#include "../vmime/utility/outputStreamStringAdapter.hpp"
+
+#include <algorithm>
 
 
 namespace vmime {
@@ -45,10 +51,73 @@ namespace net {
 namespace pop3 {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+// Parses the data of a "UIDL" response as it is received, and keeps
+// the messages whose UID is not known by the UID store
+class POP3UIDLCheckStream : public utility::outputStream
+{
+public:
+
+	POP3UIDLCheckStream(ref <POP3UIDStore> uidStore, const string& account,
+	                    std::vector <std::pair <int, string> >& newMessages)
+		: m_uidStore(uidStore), m_account(account), m_newMessages(newMessages)
+	{
+	}
+
+	void write(const value_type* const data, const size_type count)
+	{
+		const value_type* pos = data;
+		const value_type* const end = data + count;
+
+		for (const value_type* eol ; (eol = std::find(pos, end, '\n')) != end ; pos = eol + 1)
+		{
+			m_line.append(pos, eol);
+			processLine();
+		}
+
+		m_line.append(pos, end);
+	}
+
+	void flush()
+	{
+		if (!m_line.empty())
+			processLine();
+	}
+
+private:
+
+	void processLine()
+	{
+		int number = 0;
+		string uid;
+
+		if (POP3Utils::parseListOrUidlLine(m_line, number, uid) &&
+		    !m_uidStore->isKnown(m_account, uid))
+		{
+			m_newMessages.push_back(std::pair <int, string>(number, uid));
+		}
+
+		m_line.clear();
+	}
+
+
+	ref <POP3UIDStore> m_uidStore;
+	const string m_account;
+
+	std::vector <std::pair <int, string> >& m_newMessages;
+
+	string m_line;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
+
 POP3Folder::POP3Folder(const folder::path& path, ref <POP3Store> store)
 	: m_store(store), m_path(path),
 	  m_name(path.isEmpty() ? folder::path::component("") : path.getLastComponent()),
-	  m_mode(-1), m_open(false)
+	  m_mode(-1), m_open(false), m_uidSyncComplete(false)
 {
 	store->registerFolder(this);
 }
@@ -56,6 +125,15 @@ POP3Folder::POP3Folder(const folder::path& path, ref <POP3Store> store)
 
 POP3Folder::~POP3Folder()
 {
+	try
+	{
+		endUIDSync();
+	}
+	catch (vmime::exception&)
+	{
+		// Ignore
+	}
+
 	ref <POP3Store> store = m_store.acquire();
 
 	if (store)
@@ -179,6 +257,8 @@ void POP3Folder::close(const bool expunge)
 
 void POP3Folder::onClose()
 {
+	endUIDSync();
+
 	for (MessageMap::iterator it = m_messages.begin() ; it != m_messages.end() ; ++it)
 		(*it).first->onFolderClosed();
 
@@ -318,20 +398,102 @@ void POP3Folder::fetchMessages(std::vector <ref <message> >& msg, const int opti
 	else if (!isOpen())
 		throw exceptions::illegal_state("Folder not open");
 
+	// FETCH_STRUCTURE and FETCH_FLAGS are not supported by POP3.
+	if (options & (FETCH_STRUCTURE | FETCH_FLAGS))
+		throw exceptions::operation_not_supported();
+
 	const int total = msg.size();
 	int current = 0;
 
 	if (progress)
 		progress->start(total);
 
-	for (std::vector <ref <message> >::iterator it = msg.begin() ;
-	     it != msg.end() ; ++it)
+	// POP3 only permits to retrieve the whole header, with the "TOP"
+	// command: there is no need to differenciate between FETCH_ENVELOPE,
+	// FETCH_CONTENT_INFO...
+	static const int optionsRequiringHeader =
+		FETCH_ENVELOPE | FETCH_CONTENT_INFO |
+		FETCH_FULL_HEADER | FETCH_IMPORTANCE;
+
+	if (options & optionsRequiringHeader)
 	{
-		(*it).dynamicCast <POP3Message>()->fetch
-			(thisRef().dynamicCast <POP3Folder>(), options);
+		// Check all the messages before sending any command: once a
+		// window is sent, all its responses must be read
+		for (std::vector <ref <message> >::const_iterator it = msg.begin() ; it != msg.end() ; ++it)
+		{
+			ref <POP3Message> m = (*it).dynamicCast <POP3Message>();
+
+			if (!m || m->m_folder.acquire() != thisRef().dynamicCast <POP3Folder>())
+				throw exceptions::folder_not_found();
+		}
+
+		ref <POP3Connection> conn = store->getConnection();
+		const int depth = conn->getPipelineDepth();
+
+		for (std::vector <ref <message> >::iterator start = msg.begin() ; start != msg.end() ; )
+		{
+			// Send a window of "TOP" commands, without waiting for the
+			// responses if the server supports pipelining
+			//
+			// Example:  C: TOP 1 0
+			//           C: TOP 2 0
+			//           S: +OK
+			//           S: (header of message 1)
+			//           S: .
+			//           S: +OK
+			//           S: (header of message 2)
+			//           S: .
+			std::vector <ref <POP3Message> > window;
+
+			for ( ; start != msg.end() && static_cast <int>(window.size()) < depth ; ++start)
+			{
+				ref <POP3Message> m = (*start).dynamicCast <POP3Message>();
+
+				POP3Command::TOP(m->m_num, 0)->send(conn);
+				window.push_back(m);
+			}
+
+			// Read the responses in order: all responses must be read before
+			// reporting an error, so that the connection stays usable
+			string errorResponse;
+			bool error = false;
+
+			for (std::vector <ref <POP3Message> >::iterator it = window.begin() ;
+			     it != window.end() ; ++it)
+			{
+				try
+				{
+					string buffer;
+					utility::outputStreamStringAdapter bufferStream(buffer);
+
+					POP3Response::readLargeResponse(conn,
+						bufferStream, /* progress */ NULL, /* predictedSize */ 0);
+
+					ref <header> hdr = vmime::create <header>();
+					hdr->parse(buffer);
+
+					(*it)->m_header = hdr;
+				}
+				catch (exceptions::command_error& e)
+				{
+					if (!error)
+						errorResponse = e.response();
+
+					error = true;
+				}
+
+				if (progress)
+					progress->progress(++current, total);
+			}
 
-		if (progress)
-			progress->progress(++current, total);
+			if (error)
+				throw exceptions::command_error("TOP", errorResponse);
+		}
+	}
+	else if (progress)
+	{
+		current = total;
+		progress->progress(current, total);
 	}
 
 	if (options & FETCH_SIZE)
@@ -531,6 +693,15 @@ void POP3Folder::unregisterMessage(POP3Message* msg)
 void POP3Folder::onStoreDisconnected()
 {
 	m_store = NULL;
+
+	try
+	{
+		endUIDSync();
+	}
+	catch (vmime::exception&)
+	{
+		// Ignore
+	}
 }
 
 
@@ -548,24 +719,38 @@ void POP3Folder::deleteMessages(const messageSet& msgs)
 	else if (!isOpen())
 		throw exceptions::illegal_state("Folder not open");
 
-	for (std::vector <int>::const_iterator
-	     it = nums.begin() ; it != nums.end() ; ++it)
+	ref <POP3Connection> conn = store->getConnection();
+	const int depth = conn->getPipelineDepth();
+
+	std::vector <int> list;  // deleted messages
+	string errorResponse;
+
+	for (std::vector <int>::const_iterator start = nums.begin() ;
+	     start != nums.end() && errorResponse.empty() ; )
 	{
-		POP3Command::DELE(*it)->send(store->getConnection());
+		// Send a window of "DELE" commands, without waiting for the
+		// responses if the server supports pipelining
+		std::vector <int> window;
 
-		ref <POP3Response> response =
-			POP3Response::readResponse(store->getConnection());
+		for ( ; start != nums.end() && static_cast <int>(window.size()) < depth ; ++start)
+		{
+			POP3Command::DELE(*start)->send(conn);
+			window.push_back(*start);
+		}
 
-		if (!response->isSuccess())
-			throw exceptions::command_error("DELE", response->getFirstLine());
+		// Read the responses in order
+		for (std::vector <int>::const_iterator it = window.begin() ; it != window.end() ; ++it)
+		{
+			ref <POP3Response> response = POP3Response::readResponse(conn);
+
+			if (response->isSuccess())
+				list.push_back(*it);
+			else if (errorResponse.empty())
+				errorResponse = response->getFirstLine();
+		}
 	}
 
 	// Sort message list
-	std::vector <int> list;
-
-	list.resize(nums.size());
-	std::copy(nums.begin(), nums.end(), list.begin());
-
 	std::sort(list.begin(), list.end());
 
 	// Update local flags
@@ -585,6 +770,9 @@ void POP3Folder::deleteMessages(const messageSet& msgs)
 			 events::messageChangedEvent::TYPE_FLAGS, list);
 
 	notifyMessageChanged(event);
+
+	if (!errorResponse.empty())
+		throw exceptions::command_error("DELE", errorResponse);
 }
 
 
@@ -718,6 +906,164 @@ std::vector <int> POP3Folder::getMessageNumbersStartingOnUID(const message::uid&
 }
 
 
+std::vector <ref <message> > POP3Folder::getNewMessages(const int options,
+	utility::progressListener* progress)
+{
+	ref <POP3Store> store = m_store.acquire();
+
+	if (!store)
+		throw exceptions::illegal_state("Store disconnected");
+	else if (!isOpen())
+		throw exceptions::illegal_state("Folder not open");
+
+	ref <POP3UIDStore> uidStore = store->getUIDStore();
+
+	if (!uidStore)
+		throw exceptions::illegal_state("No UID store");
+
+	// Start a new synchronization
+	endUIDSync();
+
+	m_uidSyncAccount = getUIDStoreAccount(store);
+	m_uidSyncComplete = false;
+
+	uidStore->beginSync(m_uidSyncAccount);
+
+	m_uidSyncStore = uidStore;
+
+	// C: UIDL
+	// S: +OK
+	// S: 1 whqtswO00WBw418f9t5JxYwZ
+	// S: 2 QhdPYR:00WBw1Ph7x7
+	// S: .
+	POP3Command::UIDL()->send(store->getConnection());
+
+	std::vector <std::pair <int, string> > newMessages;
+	POP3UIDLCheckStream checkStream(uidStore, m_uidSyncAccount, newMessages);
+
+	try
+	{
+		POP3Response::readLargeResponse(store->getConnection(),
+			checkStream, /* progress */ NULL, /* predictedSize */ 0);
+	}
+	catch (exceptions::command_error& e)
+	{
+		throw exceptions::command_error("UIDL", e.response());
+	}
+
+	checkStream.flush();
+
+	m_uidSyncComplete = true;
+
+	std::vector <ref <message> > messages;
+	messages.reserve(newMessages.size());
+
+	ref <POP3Folder> thisFolder = thisRef().dynamicCast <POP3Folder>();
+
+	for (std::vector <std::pair <int, string> >::const_iterator it = newMessages.begin() ;
+	     it != newMessages.end() ; ++it)
+	{
+		if ((*it).first < 1 || (*it).first > m_messageCount)
+			continue;  // invalid message number
+
+		ref <POP3Message> msg = vmime::create <POP3Message>(thisFolder, (*it).first);
+		msg->m_uid = (*it).second;
+
+		messages.push_back(msg);
+	}
+
+	// UIDs are already known
+	const int fetchOptions = options & ~FETCH_UID;
+
+	if (fetchOptions != 0 && !messages.empty())
+		fetchMessages(messages, fetchOptions, progress);
+
+	return messages;
+}
+
+
+void POP3Folder::markMessagesKnown(const std::vector <ref <message> >& msgs)
+{
+	ref <POP3Store> store = m_store.acquire();
+
+	if (!store)
+		throw exceptions::illegal_state("Store disconnected");
+	else if (!isOpen())
+		throw exceptions::illegal_state("Folder not open");
+
+	ref <POP3UIDStore> uidStore = store->getUIDStore();
+
+	if (!uidStore)
+		throw exceptions::illegal_state("No UID store");
+
+	// Retrieve the UIDs which are not known yet
+	std::vector <ref <message> > noUID;
+
+	for (std::vector <ref <message> >::const_iterator it = msgs.begin() ; it != msgs.end() ; ++it)
+	{
+		if (static_cast <string>((*it)->getUID()).empty())
+			noUID.push_back(*it);
+	}
+
+	if (!noUID.empty())
+		fetchMessages(noUID, FETCH_UID);
+
+	// Outside of a synchronization, record all the UIDs at once
+	const bool syncing = (m_uidSyncStore == uidStore);
+	const string account = (syncing ? m_uidSyncAccount : getUIDStoreAccount(store));
+
+	if (!syncing)
+		uidStore->beginSync(account);
+
+	for (std::vector <ref <message> >::const_iterator it = msgs.begin() ; it != msgs.end() ; ++it)
+	{
+		const string uid = (*it)->getUID();
+
+		if (!uid.empty())
+			uidStore->addUID(account, uid);
+	}
+
+	if (!syncing)
+		uidStore->endSync(account, /* complete */ false);
+}
+
+
+// static
+const string POP3Folder::getUIDStoreAccount(ref <POP3Store> store)
+{
+	ref <POP3Connection> conn = store->getConnection();
+	ref <connectionInfos> infos = conn->getConnectionInfos();
+
+	std::ostringstream account;
+	account.imbue(std::locale::classic());
+
+	try
+	{
+		account << conn->getAuthenticator()->getUsername() << '@';
+	}
+	catch (exceptions::no_auth_information&)
+	{
+		// Anonymous
+	}
+
+	account << infos->getHost() << ':' << infos->getPort();
+
+	return account.str();
+}
+
+
+void POP3Folder::endUIDSync()
+{
+	if (!m_uidSyncStore)
+		return;
+
+	ref <POP3UIDStore> uidStore = m_uidSyncStore;
+	m_uidSyncStore = NULL;
+
+	uidStore->endSync(m_uidSyncAccount, m_uidSyncComplete);
+}
+
+
 } // pop3
 } // net
 } // vmime
@@ -46,6 +46,7 @@ namespace pop3 {
 
 class POP3Store;
 class POP3Message;
+class POP3UIDStore;
 
 
 /** POP3 folder implementation.
@@ -122,6 +123,36 @@ public:
 
 	std::vector <int> getMessageNumbersStartingOnUID(const message::uid& uid);
 
+	/** Return the messages which have not been retrieved yet, for
+	  * accounts whose messages are left on the server. The UIDs are
+	  * checked against the UID store of the POP3 store (see
+	  * POP3Store::setUIDStore()) as the response to the "UIDL" command
+	  * is received, without building the complete list in memory.
+	  *
+	  * The new messages are not recorded in the UID store: call
+	  * markMessagesKnown() once they have been processed. The
+	  * synchronization with the UID store ends when the folder is
+	  * closed, or when this function is called again.
+	  *
+	  * @param options objects to fetch for the new messages (see
+	  * fetchMessages()): eg. FETCH_FULL_HEADER only retrieves their
+	  * header, with the "TOP" command
+	  * @param progress progress listener for fetching the new
+	  * messages, or NULL if not used
+	  * @return new messages, with their UID set
+	  * @throw exceptions::illegal_state if no UID store is set
+	  */
+	std::vector <ref <message> > getNewMessages(const int options = 0,
+		utility::progressListener* progress = NULL);
+
+	/** Record messages in the UID store of the POP3 store, so that
+	  * they are not returned anymore by getNewMessages().
+	  *
+	  * @param msgs messages to record
+	  * @throw exceptions::illegal_state if no UID store is set
+	  */
+	void markMessagesKnown(const std::vector <ref <message> >& msgs);
+
 private:
 
 	void registerMessage(POP3Message* msg);
@@ -131,6 +162,17 @@ private:
 
 	void onClose();
 
+	/** Return the identity of the account in the UID store.
+	  *
+	  * @param store POP3 store
+	  * @return account identity (eg. "user@pop3.example.com:995")
+	  */
+	static const string getUIDStoreAccount(ref <POP3Store> store);
+
+	/** End the current synchronization with the UID store, if any.
+	  */
+	void endUIDSync();
+
 
 	weak_ref <POP3Store> m_store;
 
@@ -142,6 +184,10 @@ private:
 
 	int m_messageCount;
 
+	ref <POP3UIDStore> m_uidSyncStore;  // set during a synchronization
+	string m_uidSyncAccount;
+	bool m_uidSyncComplete;
+
 	typedef std::map <POP3Message*, int> MessageMap;
 	MessageMap m_messages;
 };
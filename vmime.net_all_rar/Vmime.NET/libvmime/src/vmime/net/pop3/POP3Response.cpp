@@ -33,9 +33,7 @@
 #include "../vmime/platform.hpp"
 
 #include "../vmime/utility/stringUtils.hpp"
-#include "../vmime/utility/filteredStream.hpp"
-#include "../vmime/utility/stringUtils.hpp"
-#include "../vmime/utility/inputStreamSocketAdapter.hpp"
+#include "../vmime/utility/outputStreamStringAdapter.hpp"
 
 #include "../vmime/net/socket.hpp"
 #include "../vmime/net/timeoutHandler.hpp"
@@ -46,8 +44,8 @@ namespace net {
 namespace pop3 {
 
 
-POP3Response::POP3Response(ref <socket> sok, ref <timeoutHandler> toh)
-	: m_socket(sok), m_timeoutHandler(toh)
+POP3Response::POP3Response(ref <POP3Connection> conn)
+	: m_connection(conn), m_timeoutHandler(conn->getTimeoutHandler())
 {
 }
 
@@ -55,11 +53,10 @@ POP3Response::POP3Response(ref <socket> sok, ref <timeoutHandler> toh)
 // static
 ref <POP3Response> POP3Response::readResponse(ref <POP3Connection> conn)
 {
-	ref <POP3Response> resp = vmime::create <POP3Response>
-		(conn->getSocket(), conn->getTimeoutHandler());
+	ref <POP3Response> resp = vmime::create <POP3Response>(conn);
 
 	string buffer;
-	resp->readResponseImpl(buffer, /* multiLine */ false);
+	resp->readFirstLineImpl(buffer);
 
     // FIX by Elmue: Added Trace
     #if VMIME_TRACE
@@ -77,26 +74,37 @@ ref <POP3Response> POP3Response::readResponse(ref <POP3Connection> conn)
 // static
 ref <POP3Response> POP3Response::readMultilineResponse(ref <POP3Connection> conn)
 {
-	ref <POP3Response> resp = vmime::create <POP3Response>
-		(conn->getSocket(), conn->getTimeoutHandler());
+	ref <POP3Response> resp = vmime::create <POP3Response>(conn);
 
-	string buffer;
-	resp->readResponseImpl(buffer, /* multiLine */ true);
+	string firstLine;
+	resp->readFirstLineImpl(firstLine);
 
-	string firstLine, nextLines;
-	stripFirstLine(buffer, nextLines, &firstLine);
+	firstLine = utility::stringUtils::trim(firstLine);
 
 	resp->m_firstLine = firstLine;
 	resp->m_code = getResponseCode(firstLine);
 	stripResponseCode(firstLine, resp->m_text);
 
-	std::istringstream iss(nextLines);
-	string line;
+	// If there is an error (-ERR) when executing a command that
+	// requires a multi-line response, the error response will
+	// include only one line
+	if (resp->m_code == CODE_ERR)
+		return resp;
 
-	while (std::getline(iss, line, '\n'))
+	string nextLines;
+	utility::outputStreamStringAdapter nextLinesStream(nextLines);
+
+	resp->readDataImpl(nextLinesStream, /* progress */ NULL, /* predictedSize */ 0);
+
+	for (string::size_type pos = 0, end = 0 ; pos < nextLines.length() ; pos = end + 1)
     {
+		end = nextLines.find('\n', pos);
+
+		if (end == string::npos)
+			end = nextLines.length();
+
         // FIX by Elmue: Added  Trace
-        line = utility::stringUtils::trim(line);
+        const string line = utility::stringUtils::trim(nextLines.substr(pos, end - pos));
 
         #if VMIME_TRACE
             TRACE("POP3 read < \"%s\"", line.c_str());
@@ -114,11 +122,12 @@ ref <POP3Response> POP3Response::readLargeResponse
 	(ref <POP3Connection> conn, utility::outputStream& os,
 	 utility::progressListener* progress, const long predictedSize)
 {
-	ref <POP3Response> resp = vmime::create <POP3Response>
-		(conn->getSocket(), conn->getTimeoutHandler());
+	ref <POP3Response> resp = vmime::create <POP3Response>(conn);
 
 	string firstLine;
-	resp->readResponseImpl(firstLine, os, progress, predictedSize);
+	resp->readFirstLineImpl(firstLine);
+
+	firstLine = utility::stringUtils::trim(firstLine);
 
     // FIX by Elmue: Added Trace
     #if VMIME_TRACE
@@ -129,6 +138,12 @@ ref <POP3Response> POP3Response::readLargeResponse
 	resp->m_code = getResponseCode(firstLine);
 	stripResponseCode(firstLine, resp->m_text);
 
+	// Response data follows the first line, unless it is an error
+	if (resp->m_code != CODE_OK)
+		throw exceptions::command_error("?", firstLine);
+
+	resp->readDataImpl(os, progress, predictedSize);
+
 	return resp;
 }
 
@@ -169,18 +184,14 @@ size_t POP3Response::getLineCount() const
 }
 
 
-void POP3Response::readResponseImpl(string& buffer, const bool multiLine)
+void POP3Response::readFirstLineImpl(string& line)
 {
-	bool foundTerminator = false;
-
 	if (m_timeoutHandler)
 		m_timeoutHandler->resetTimeOut();
 
-	buffer.clear();
+	line.clear();
 
-	string::value_type last1 = '\0', last2 = '\0';
-
-	for ( ; !foundTerminator ; )
+	for ( ; ; )
 	{
 		// Check whether the time-out delay is elapsed
 		if (m_timeoutHandler && m_timeoutHandler->isTimeOut())
@@ -193,11 +204,14 @@ void POP3Response::readResponseImpl(string& buffer, const bool multiLine)
 
 		// Receive data from the socket
 		string receiveBuffer;
-		m_socket->receive(receiveBuffer);
+		m_connection->receive(receiveBuffer);
 
 		if (receiveBuffer.empty())   // buffer is empty
 		{
-			platform::getHandler()->wait();
+			// Block until data arrives or the time-out delay is elapsed
+			m_connection->getSocket()->waitForReadable
+				(m_timeoutHandler ? m_timeoutHandler->getRemainingTime() : 1000);
+
 			continue;
 		}
 
@@ -205,76 +219,52 @@ void POP3Response::readResponseImpl(string& buffer, const bool multiLine)
 		if (m_timeoutHandler)
 			m_timeoutHandler->resetTimeOut();
 
-		// Check for transparent characters: '\n..' becomes '\n.'
-		const string::value_type first = receiveBuffer[0];
+		const string::size_type end = receiveBuffer.find('\n');
 
-		if (first == '.' && last2 == '\n' && last1 == '.')
-		{
-			receiveBuffer.erase(receiveBuffer.begin());
-		}
-		else if (receiveBuffer.length() >= 2 && first == '.' &&
-		         receiveBuffer[1] == '.' && last1 == '\n')
+		if (end == string::npos)
 		{
-			receiveBuffer.erase(receiveBuffer.begin());
-		}
-
-		for (string::size_type trans ;
-		     string::npos != (trans = receiveBuffer.find("\n..")) ; )
-		{
-			receiveBuffer.replace(trans, 3, "\n.");
+			line += receiveBuffer;
+			continue;
 		}
 
-		last1 = receiveBuffer[receiveBuffer.length() - 1];
-		last2 = static_cast <char>((receiveBuffer.length() >= 2) ? receiveBuffer[receiveBuffer.length() - 2] : 0);
-
-		// Append the data to the response buffer
-		buffer += receiveBuffer;
+		line.append(receiveBuffer, 0, end);
 
-		// Check for terminator string (and strip it if present)
-		foundTerminator = checkTerminator(buffer, multiLine);
+		// Data which follows belongs to the response data, or to the
+		// next responses if commands are pipelined
+		if (end + 1 < receiveBuffer.length())
+			m_connection->pushBack(receiveBuffer.substr(end + 1));
 
-		// If there is an error (-ERR) when executing a command that
-		// requires a multi-line response, the error response will
-		// include only one line, so we stop waiting for a multi-line
-		// terminator and check for a "normal" one.
-		if (multiLine && !foundTerminator && buffer.length() >= 4 && buffer[0] == '-')
-		{
-			foundTerminator = checkTerminator(buffer, false);
-		}
+		break;
 	}
+
+	if (!line.empty() && line[line.length() - 1] == '\r')
+		line.erase(line.length() - 1);
 }
 
 
-void POP3Response::readResponseImpl
-	(string& firstLine, utility::outputStream& os,
-	 utility::progressListener* progress, const long predictedSize)
+void POP3Response::readDataImpl(utility::outputStream& os,
+	utility::progressListener* progress, const long predictedSize)
 {
 	long current = 0, total = predictedSize;
 
-	string temp;
-	bool codeDone = false;
-
 	if (progress)
 		progress->start(total);
 
 	if (m_timeoutHandler)
 		m_timeoutHandler->resetTimeOut();
 
-	utility::inputStreamSocketAdapter sis(*m_socket);
-	utility::stopSequenceFilteredInputStream <5> sfis1(sis, "\r\n.\r\n");
-	utility::stopSequenceFilteredInputStream <3> sfis2(sfis1, "\n.\n");
-	utility::dotFilteredInputStream dfis(sfis2);   // "\n.." --> "\n."
-
-	utility::inputStream& is = dfis;
-
-	while (!is.eof())
+	// Data is processed in a single forward pass over each received block:
+	// lines are moved in place to remove transparent dots, and written
+	// directly to the output stream. Only a few bytes are kept between
+	// blocks: the beginning of a line which may be the terminator (".",
+	// ".\r"), and the last two bytes of data, which are not written until
+	// we know whether they end the line preceding the terminator.
+	string carry, tail;
+	bool atLineStart = true;
+	bool done = false;
+
+	while (!done)
 	{
-#if 0 // not supported
-		// Check for possible cancellation
-		if (progress && progress->cancel())
-			throw exceptions::operation_cancelled();
-#endif
-
 		// Check whether the time-out delay is elapsed
 		if (m_timeoutHandler && m_timeoutHandler->isTimeOut())
 		{
@@ -283,12 +273,15 @@ void POP3Response::readResponseImpl
 		}
 
 		// Receive data from the socket
-		utility::stream::value_type buffer[65536];
-		const utility::stream::size_type read = is.read(buffer, sizeof(buffer));
+		string block;
+		m_connection->receive(block);
 
-		if (read == 0)   // buffer is empty
+		if (block.empty())   // buffer is empty
 		{
-			platform::getHandler()->wait();
+			// Block until data arrives or the time-out delay is elapsed
+			m_connection->getSocket()->waitForReadable
+				(m_timeoutHandler ? m_timeoutHandler->getRemainingTime() : 1000);
+
 			continue;
 		}
 
@@ -296,65 +289,104 @@ void POP3Response::readResponseImpl
 		if (m_timeoutHandler)
 			m_timeoutHandler->resetTimeOut();
 
-		// Notify progress
-		current += read;
+		// Bytes kept from the previous block have already been counted
+		const string::size_type carried = carry.length();
 
-		if (progress)
+		if (!carry.empty())
 		{
-			total = std::max(total, current);
-			progress->progress(current, total);
+			block.insert(0, carry);
+			carry.clear();
 		}
 
-		// If we don't have extracted the response code yet
-		if (!codeDone)
+		const string::size_type n = block.length();
+		string::size_type r = 0;  // read position
+		string::size_type w = 0;  // write position (always <= r)
+
+		while (r < n)
 		{
-			temp.append(buffer, read);
+			if (atLineStart && block[r] == '.')
+			{
+				// Wait for more data to decide
+				if (r + 1 >= n || (block[r + 1] == '\r' && r + 2 >= n))
+				{
+					carry.assign(block, r, n - r);
+					break;
+				}
+
+				// Terminator line
+				if (block[r + 1] == '\n')
+				{
+					r += 2;
+					done = true;
+					break;
+				}
+				else if (block[r + 1] == '\r' && block[r + 2] == '\n')
+				{
+					r += 3;
+					done = true;
+					break;
+				}
+
+				++r;  // transparent character: '..' becomes '.'
+			}
 
-			string responseData;
+			const string::size_type lineEnd = block.find('\n', r);
+			const string::size_type end = (lineEnd == string::npos ? n : lineEnd + 1);
 
-			if (stripFirstLine(temp, responseData, &firstLine) == true)
-			{
-				if (getResponseCode(firstLine) != CODE_OK)
-					throw exceptions::command_error("?", firstLine);
+			if (w != r)
+				std::copy(block.begin() + r, block.begin() + end, block.begin() + w);
 
-				codeDone = true;
+			w += end - r;
+			r = end;
 
-				os.write(responseData.data(), responseData.length());
-				temp.clear();
+			atLineStart = (lineEnd != string::npos);
+		}
 
-				continue;
-			}
+		// Data following the terminator belongs to the next responses
+		if (done && r < n)
+			m_connection->pushBack(block.substr(r));
+
+		current += static_cast <long>((done ? r : n) - carried);
+
+		// Inject the data into the output stream, except the last two bytes
+		if (w >= 2)
+		{
+			if (!tail.empty())
+				os.write(tail.data(), tail.length());
+
+			os.write(block.data(), w - 2);
+			tail.assign(block, w - 2, 2);
 		}
 		else
 		{
-			// Inject the data into the output stream
-			os.write(buffer, read);
+			tail.append(block, 0, w);
+
+			if (tail.length() > 2)
+			{
+				os.write(tail.data(), tail.length() - 2);
+				tail.erase(0, tail.length() - 2);
+			}
 		}
-	}
 
-	if (progress)
-		progress->stop(total);
-}
+		// Notify progress
+		if (progress)
+		{
+			total = std::max(total, current);
+			progress->progress(current, total);
+		}
+	}
 
+	// The end of the line preceding the terminator is not part of the data
+	if (tail.length() >= 2 && tail[tail.length() - 2] == '\r' && tail[tail.length() - 1] == '\n')
+		tail.erase(tail.length() - 2);
+	else if (!tail.empty() && tail[tail.length() - 1] == '\n')
+		tail.erase(tail.length() - 1);
 
-// static
-bool POP3Response::stripFirstLine
-	(const string& buffer, string& result, string* firstLine)
-{
-	const string::size_type end = buffer.find('\n');
+	if (!tail.empty())
+		os.write(tail.data(), tail.length());
 
-	if (end != string::npos)
-	{
-		if (firstLine) *firstLine = utility::stringUtils::trim(buffer.substr(0, end));
-		result = buffer.substr(end + 1);
-		return true;
-	}
-	else
-	{
-		if (firstLine) *firstLine = utility::stringUtils::trim(buffer);
-		result = "";
-		return false;
-	}
+	if (progress)
+		progress->stop(total);
 }
 
 
@@ -399,46 +431,6 @@ void POP3Response::stripResponseCode(const string& buffer, string& result)
 }
 
 
-// static
-bool POP3Response::checkTerminator(string& buffer, const bool multiLine)
-{
-	// Multi-line response
-	if (multiLine)
-	{
-		static const string term1("\r\n.\r\n");
-		static const string term2("\n.\n");
-
-		return (checkOneTerminator(buffer, term1) ||
-		        checkOneTerminator(buffer, term2));
-	}
-	// Normal response
-	else
-	{
-		static const string term1("\r\n");
-		static const string term2("\n");
-
-		return (checkOneTerminator(buffer, term1) ||
-		        checkOneTerminator(buffer, term2));
-	}
-
-	return false;
-}
-
-
-// static
-bool POP3Response::checkOneTerminator(string& buffer, const string& term)
-{
-	if (buffer.length() >= term.length() &&
-		std::equal(buffer.end() - term.length(), buffer.end(), term.begin()))
-	{
-		buffer.erase(buffer.end() - term.length(), buffer.end());
-		return true;
-	}
-
-	return false;
-}
-
-
 } // pop3
 } // net
 } // vmime
@@ -145,25 +145,19 @@ public:
 
 private:
 
-	POP3Response(ref <socket> sok, ref <timeoutHandler> toh);
-
-	void readResponseImpl(string& buffer, const bool multiLine);
-	void readResponseImpl
-		(string& firstLine, utility::outputStream& os,
-		 utility::progressListener* progress, const long predictedSize);
+	POP3Response(ref <POP3Connection> conn);
 
+	void readFirstLineImpl(string& line);
+	void readDataImpl(utility::outputStream& os,
+		utility::progressListener* progress, const long predictedSize);
 
-	static bool stripFirstLine(const string& buffer, string& result, string* firstLine);
 
 	static ResponseCode getResponseCode(const string& buffer);
 
 	static void stripResponseCode(const string& buffer, string& result);
 
-	static bool checkTerminator(string& buffer, const bool multiLine);
-	static bool checkOneTerminator(string& buffer, const string& term);
-
 
-	ref <socket> m_socket;
+	ref <POP3Connection> m_connection;
 	ref <timeoutHandler> m_timeoutHandler;
 
 	string m_firstLine;
@@ -31,6 +31,7 @@
 #include "../vmime/net/pop3/POP3Folder.hpp"
 #include "../vmime/net/pop3/POP3Command.hpp"
 #include "../vmime/net/pop3/POP3Response.hpp"
+#include "../vmime/net/pop3/POP3UIDStore.hpp"
 
 #include "../vmime/exception.hpp"
 #include "../vmime/platform.hpp"
@@ -110,9 +111,6 @@ void POP3Store::connect()
 	if (isConnected())
 		throw exceptions::already_connected();
 
-    // Reset Cancel flag
-    platform::handler::setCancelFlag(false);
-
 	m_connection = vmime::create <POP3Connection>
 		(thisRef().dynamicCast <POP3Store>(), getAuthenticator());
 
@@ -136,6 +134,18 @@ bool POP3Store::isPOP3S() const
 }
 
 
+void POP3Store::setUIDStore(ref <POP3UIDStore> uidStore)
+{
+	m_uidStore = uidStore;
+}
+
+
+ref <POP3UIDStore> POP3Store::getUIDStore() const
+{
+	return m_uidStore;
+}
+
+
 bool POP3Store::isConnected() const
 {
 	return m_connection && m_connection->isConnected();
@@ -47,6 +47,7 @@ namespace pop3 {
 class POP3Folder;
 class POP3Command;
 class POP3Response;
+class POP3UIDStore;
 
 
 /** POP3 store service.
@@ -87,10 +88,26 @@ public:
 
 	bool isPOP3S() const;
 
+	/** Set the store used to record the messages already retrieved,
+	  * for accounts whose messages are left on the server (see
+	  * POP3Folder::getNewMessages()).
+	  *
+	  * @param uidStore UID store, or NULL to disable it
+	  */
+	void setUIDStore(ref <POP3UIDStore> uidStore);
+
+	/** Return the UID store set with setUIDStore().
+	  *
+	  * @return UID store, or NULL if none is set
+	  */
+	ref <POP3UIDStore> getUIDStore() const;
+
 private:
 
 	ref <POP3Connection> m_connection;
 
+	ref <POP3UIDStore> m_uidStore;
+
 
 	void registerFolder(POP3Folder* folder);
 	void unregisterFolder(POP3Folder* folder);
@@ -0,0 +1,105 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_POP3_POP3UIDSTORE_HPP_INCLUDED
+#define VMIME_NET_POP3_POP3UIDSTORE_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_POP3
+
+
+#include "../vmime/types.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace pop3 {
+
+
+/** Persistent record of the messages already retrieved from POP3
+  * accounts whose messages are left on the server.
+  *
+  * When a UID store is set on the store (see POP3Store::setUIDStore()),
+  * POP3Folder::getNewMessages() checks the UIDs returned by the "UIDL"
+  * command against the store, and only returns the messages which are
+  * not recorded yet. The caller records the messages it has processed
+  * with POP3Folder::markMessagesKnown().
+  *
+  * The UIDs of an account are accessed within a synchronization: the
+  * UIDs listed by the server during a complete synchronization are kept,
+  * the other ones are forgotten after some synchronizations, as the
+  * corresponding messages have been deleted from the server.
+  */
+
+class VMIME_EXPORT POP3UIDStore : public object
+{
+public:
+
+	virtual ~POP3UIDStore() { }
+
+	/** Start a new synchronization of an account. A synchronization
+	  * which is not complete can also be used to record several UIDs
+	  * at once: it does not count for forgetting UIDs.
+	  *
+	  * @param account account identity (eg. "user@pop3.example.com:995")
+	  */
+	virtual void beginSync(const string& account) = 0;
+
+	/** Check whether a message has already been recorded. If it is the
+	  * case, the UID is marked as still present on the server.
+	  *
+	  * @param account account identity
+	  * @param uid UID of the message, as returned by the "UIDL" command
+	  * @return true if the message is known, false otherwise
+	  */
+	virtual bool isKnown(const string& account, const string& uid) = 0;
+
+	/** Record a message as known.
+	  *
+	  * @param account account identity
+	  * @param uid UID of the message, as returned by the "UIDL" command
+	  */
+	virtual void addUID(const string& account, const string& uid) = 0;
+
+	/** End the synchronization of an account, and save its state.
+	  *
+	  * @param account account identity
+	  * @param complete true if all the UIDs present on the server have
+	  * been checked with isKnown() during this synchronization: only in
+	  * this case the UIDs which were not listed can be forgotten
+	  */
+	virtual void endSync(const string& account, const bool complete) = 0;
+};
+
+
+} // pop3
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_POP3
+
+#endif // VMIME_NET_POP3_POP3UIDSTORE_HPP_INCLUDED
@@ -41,38 +41,53 @@ namespace pop3 {
 // static
 void POP3Utils::parseMultiListOrUidlResponse(ref <POP3Response> response, std::map <int, string>& result)
 {
-	std::map <int, string> ids;
-
 	for (size_t i = 0, n = response->getLineCount() ; i < n ; ++i)
 	{
-		string line = response->getLineAt(i);
-		string::iterator it = line.begin();
-
-		while (it != line.end() && (*it == ' ' || *it == '\t'))
-			++it;
-
-		if (it != line.end())
-		{
-			int number = 0;
-
-			while (it != line.end() && (*it >= '0' && *it <= '9'))
-			{
-				number = (number * 10) + (*it - '0');
-				++it;
-			}
-
-			while (it != line.end() && !(*it == ' ' || *it == '\t')) ++it;
-			while (it != line.end() && (*it == ' ' || *it == '\t')) ++it;
-
-			if (it != line.end())
-			{
-				result.insert(std::map <int, string>::value_type(number, string(it, line.end())));
-			}
-		}
+		int number = 0;
+		string data;
+
+		if (parseListOrUidlLine(response->getLineAt(i), number, data))
+			result.insert(std::map <int, string>::value_type(number, data));
 	}
 }
 
 
+// static
+bool POP3Utils::parseListOrUidlLine(const string& line, int& number, string& data)
+{
+	string::const_iterator it = line.begin();
+
+	while (it != line.end() && (*it == ' ' || *it == '\t'))
+		++it;
+
+	if (it == line.end())
+		return false;
+
+	number = 0;
+
+	while (it != line.end() && (*it >= '0' && *it <= '9'))
+	{
+		number = (number * 10) + (*it - '0');
+		++it;
+	}
+
+	while (it != line.end() && !(*it == ' ' || *it == '\t')) ++it;
+	while (it != line.end() && (*it == ' ' || *it == '\t')) ++it;
+
+	if (it == line.end())
+		return false;
+
+	string::const_iterator end = line.end();
+
+	while (end != it && (*(end - 1) == ' ' || *(end - 1) == '\t' || *(end - 1) == '\r'))
+		--end;
+
+	data.assign(it, end);
+
+	return true;
+}
+
+
 
 class POP3MessageSetEnumerator : public messageSetEnumerator
 {
@@ -66,6 +66,16 @@ public:
 	static void parseMultiListOrUidlResponse
 		(ref <POP3Response> response, std::map <int, string>& result);
 
+	/** Parse a single line of a LIST or UIDL response, of the
+	  * form [integer] [string].
+	  *
+	  * @param line line of the response, without the end of line
+	  * @param number receives the message number
+	  * @param data receives the data (either UID or size)
+	  * @return true if the line could be parsed, false otherwise
+	  */
+	static bool parseListOrUidlLine(const string& line, int& number, string& data);
+
 	/** Returns a list of message numbers given a message set.
 	  *
 	  * @param msgs message set
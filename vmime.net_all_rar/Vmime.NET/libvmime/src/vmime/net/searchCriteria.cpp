@@ -0,0 +1,648 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+
+#include "../vmime/net/searchCriteria.hpp"
+#include "../vmime/net/folder.hpp"
+
+#include "../vmime/header.hpp"
+#include "../vmime/text.hpp"
+#include "../vmime/message.hpp"
+#include "../vmime/charset.hpp"
+#include "../vmime/contentHandler.hpp"
+
+#include "../vmime/utility/outputStreamAdapter.hpp"
+#include "../vmime/utility/stringUtils.hpp"
+
+#include <sstream>
+
+
+namespace vmime {
+namespace net {
+
+
+searchCriteria::searchCriteria(const Types type)
+	: m_type(type), m_number(0), m_modseq(0)
+{
+}
+
+
+searchCriteria::searchCriteria(const searchCriteria& other)
+	: object(), m_type(other.m_type), m_children(other.m_children),
+	  m_number(other.m_number), m_modseq(other.m_modseq), m_date(other.m_date),
+	  m_field(other.m_field), m_text(other.m_text)
+{
+}
+
+
+searchCriteria& searchCriteria::operator=(const searchCriteria& other)
+{
+	m_type = other.m_type;
+	m_children = other.m_children;
+	m_number = other.m_number;
+	m_modseq = other.m_modseq;
+	m_date = other.m_date;
+	m_field = other.m_field;
+	m_text = other.m_text;
+
+	return *this;
+}
+
+
+searchCriteria::~searchCriteria()
+{
+}
+
+
+// static
+searchCriteria searchCriteria::all()
+{
+	return searchCriteria(TYPE_ALL);
+}
+
+
+// static
+searchCriteria searchCriteria::flag(const int flag, const bool set)
+{
+	searchCriteria c(set ? TYPE_FLAG_SET : TYPE_FLAG_UNSET);
+	c.m_number = flag;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::sentBefore(const datetime& date)
+{
+	searchCriteria c(TYPE_SENT_BEFORE);
+	c.m_date = date;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::sentSince(const datetime& date)
+{
+	searchCriteria c(TYPE_SENT_SINCE);
+	c.m_date = date;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::receivedBefore(const datetime& date)
+{
+	searchCriteria c(TYPE_RECEIVED_BEFORE);
+	c.m_date = date;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::receivedSince(const datetime& date)
+{
+	searchCriteria c(TYPE_RECEIVED_SINCE);
+	c.m_date = date;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::header(const string& field, const string& text)
+{
+	searchCriteria c(TYPE_HEADER);
+	c.m_field = field;
+	c.m_text = text;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::from(const string& text)
+{
+	return header(fields::FROM, text);
+}
+
+
+// static
+searchCriteria searchCriteria::to(const string& text)
+{
+	return header(fields::TO, text);
+}
+
+
+// static
+searchCriteria searchCriteria::cc(const string& text)
+{
+	return header(fields::CC, text);
+}
+
+
+// static
+searchCriteria searchCriteria::subject(const string& text)
+{
+	return header(fields::SUBJECT, text);
+}
+
+
+// static
+searchCriteria searchCriteria::body(const string& text)
+{
+	searchCriteria c(TYPE_BODY);
+	c.m_text = text;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::text(const string& text)
+{
+	searchCriteria c(TYPE_TEXT);
+	c.m_text = text;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::largerThan(const int size)
+{
+	searchCriteria c(TYPE_LARGER);
+	c.m_number = size;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::smallerThan(const int size)
+{
+	searchCriteria c(TYPE_SMALLER);
+	c.m_number = size;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::modSequenceSince(const vmime_uint64 modseq)
+{
+	searchCriteria c(TYPE_MODSEQ);
+	c.m_modseq = modseq;
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::both(const searchCriteria& a, const searchCriteria& b)
+{
+	searchCriteria c(TYPE_AND);
+	c.m_children.push_back(a);
+	c.m_children.push_back(b);
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::either(const searchCriteria& a, const searchCriteria& b)
+{
+	searchCriteria c(TYPE_OR);
+	c.m_children.push_back(a);
+	c.m_children.push_back(b);
+
+	return c;
+}
+
+
+// static
+searchCriteria searchCriteria::negate(const searchCriteria& c)
+{
+	searchCriteria n(TYPE_NOT);
+	n.m_children.push_back(c);
+
+	return n;
+}
+
+
+searchCriteria::Types searchCriteria::getType() const
+{
+	return m_type;
+}
+
+
+const std::vector <searchCriteria>& searchCriteria::getChildren() const
+{
+	return m_children;
+}
+
+
+int searchCriteria::getFlag() const
+{
+	return m_number;
+}
+
+
+const datetime& searchCriteria::getDate() const
+{
+	return m_date;
+}
+
+
+const string& searchCriteria::getField() const
+{
+	return m_field;
+}
+
+
+const string& searchCriteria::getText() const
+{
+	return m_text;
+}
+
+
+int searchCriteria::getSize() const
+{
+	return m_number;
+}
+
+
+vmime_uint64 searchCriteria::getModSequence() const
+{
+	return m_modseq;
+}
+
+
+int searchCriteria::getFetchOptions() const
+{
+	switch (m_type)
+	{
+	case TYPE_AND:
+	case TYPE_OR:
+	case TYPE_NOT:
+	{
+		int options = 0;
+
+		for (std::vector <searchCriteria>::const_iterator
+		     it = m_children.begin() ; it != m_children.end() ; ++it)
+		{
+			options |= (*it).getFetchOptions();
+		}
+
+		return options;
+	}
+	case TYPE_FLAG_SET:
+	case TYPE_FLAG_UNSET:
+
+		return folder::FETCH_FLAGS;
+
+	case TYPE_SENT_BEFORE:
+	case TYPE_SENT_SINCE:
+	case TYPE_RECEIVED_BEFORE:
+	case TYPE_RECEIVED_SINCE:
+	case TYPE_HEADER:
+
+		return folder::FETCH_FULL_HEADER;
+
+	case TYPE_LARGER:
+	case TYPE_SMALLER:
+
+		return folder::FETCH_SIZE;
+
+	case TYPE_ALL:
+	case TYPE_BODY:
+	case TYPE_TEXT:
+	case TYPE_MODSEQ:
+
+		break;
+	}
+
+	return 0;
+}
+
+
+bool searchCriteria::needsContents() const
+{
+	if (m_type == TYPE_BODY || m_type == TYPE_TEXT)
+		return true;
+
+	for (std::vector <searchCriteria>::const_iterator
+	     it = m_children.begin() ; it != m_children.end() ; ++it)
+	{
+		if ((*it).needsContents())
+			return true;
+	}
+
+	return false;
+}
+
+
+#ifndef VMIME_BUILDING_DOC
+
+// Returns the decoded value of a header field, in UTF-8
+static const string searchCriteria_getFieldText(ref <const headerField> field)
+{
+	std::ostringstream oss;
+	utility::outputStreamAdapter ossAdapter(oss);
+
+	field->getValue()->generate(ossAdapter);
+
+	return text::decodeAndUnfold(oss.str())->getConvertedText(charsets::UTF_8);
+}
+
+
+// Tests whether a header field contains the (lower-case) text
+static bool searchCriteria_fieldContains(ref <const headerField> field, const string& lowerText)
+{
+	return utility::stringUtils::toLower(searchCriteria_getFieldText(field)).find(lowerText) != string::npos;
+}
+
+
+// Appends the decoded header fields to 'out', in UTF-8
+static void searchCriteria_appendHeaderText(ref <const header> hdr, string& out)
+{
+	const std::vector <ref <const headerField> > fields = hdr->getFieldList();
+
+	for (std::vector <ref <const headerField> >::const_iterator
+	     it = fields.begin() ; it != fields.end() ; ++it)
+	{
+		out += (*it)->getName();
+		out += ": ";
+		out += searchCriteria_getFieldText(*it);
+		out += "\n";
+	}
+}
+
+
+// Appends the decoded text parts of a body to 'out', in UTF-8.
+// Other parts (eg. attachments) are not searched.
+static void searchCriteria_appendBodyText(ref <const body> bdy, string& out)
+{
+	if (bdy->getPartCount() != 0)
+	{
+		for (size_t i = 0 ; i < bdy->getPartCount() ; ++i)
+			searchCriteria_appendBodyText(bdy->getPartAt(i)->getBody(), out);
+
+		return;
+	}
+
+	if (bdy->getContentType().getType() != mediaTypes::TEXT)
+		return;
+
+	std::ostringstream oss;
+	utility::outputStreamAdapter ossAdapter(oss);
+
+	// Removes the transfer encoding
+	bdy->getContents()->extract(ossAdapter);
+
+	try
+	{
+		string converted;
+		charset::convert(oss.str(), converted, bdy->getCharset(), charset(charsets::UTF_8));
+
+		out += converted;
+	}
+	catch (exceptions::charset_conv_error&)
+	{
+		// Unknown charset: search the text as it is
+		out += oss.str();
+	}
+
+	out += "\n";
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
+bool searchCriteria::matches(ref <message> msg) const
+{
+	string headerText, bodyText;
+
+	if (needsContents())
+	{
+		std::ostringstream oss;
+		utility::outputStreamAdapter ossAdapter(oss);
+
+		msg->extract(ossAdapter, NULL, 0, -1, /* peek */ true);
+
+		// Text is searched after decoding, like an IMAP server does
+		ref <vmime::message> parsedMsg = vmime::create <vmime::message>();
+		parsedMsg->parse(oss.str());
+
+		searchCriteria_appendHeaderText(parsedMsg->getHeader(), headerText);
+		searchCriteria_appendBodyText(parsedMsg->getBody(), bodyText);
+
+		headerText = utility::stringUtils::toLower(headerText);
+		bodyText = utility::stringUtils::toLower(bodyText);
+	}
+
+	return matchesImpl(msg, headerText, bodyText) != MATCH_NO;
+}
+
+
+#ifndef VMIME_BUILDING_DOC
+
+
+// Compares two dates, ignoring the time
+static int searchCriteria_compareDates(const datetime& a, const datetime& b)
+{
+	if (a.getYear() != b.getYear())
+		return a.getYear() < b.getYear() ? -1 : 1;
+	else if (a.getMonth() != b.getMonth())
+		return a.getMonth() < b.getMonth() ? -1 : 1;
+	else if (a.getDay() != b.getDay())
+		return a.getDay() < b.getDay() ? -1 : 1;
+
+	return 0;
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
+searchCriteria::MatchResult searchCriteria::matchesImpl
+	(ref <message> msg, const string& headerText, const string& bodyText) const
+{
+	switch (m_type)
+	{
+	case TYPE_AND:
+	{
+		// False if one is false, otherwise unknown if one is unknown
+		MatchResult result = MATCH_YES;
+
+		for (std::vector <searchCriteria>::const_iterator
+		     it = m_children.begin() ; it != m_children.end() ; ++it)
+		{
+			const MatchResult r = (*it).matchesImpl(msg, headerText, bodyText);
+
+			if (r == MATCH_NO)
+				return MATCH_NO;
+			else if (r == MATCH_UNKNOWN)
+				result = MATCH_UNKNOWN;
+		}
+
+		return result;
+	}
+	case TYPE_OR:
+	{
+		// True if one is true, otherwise unknown if one is unknown
+		MatchResult result = MATCH_NO;
+
+		for (std::vector <searchCriteria>::const_iterator
+		     it = m_children.begin() ; it != m_children.end() ; ++it)
+		{
+			const MatchResult r = (*it).matchesImpl(msg, headerText, bodyText);
+
+			if (r == MATCH_YES)
+				return MATCH_YES;
+			else if (r == MATCH_UNKNOWN)
+				result = MATCH_UNKNOWN;
+		}
+
+		return result;
+	}
+	case TYPE_NOT:
+
+		switch (m_children.front().matchesImpl(msg, headerText, bodyText))
+		{
+		case MATCH_NO: return MATCH_YES;
+		case MATCH_YES: return MATCH_NO;
+		case MATCH_UNKNOWN: break;
+		}
+
+		return MATCH_UNKNOWN;
+
+	case TYPE_MODSEQ:
+
+		// Not available with protocols other than IMAP
+		return MATCH_UNKNOWN;
+
+	default:
+
+		return matchesLeaf(msg, headerText, bodyText) ? MATCH_YES : MATCH_NO;
+	}
+}
+
+
+bool searchCriteria::matchesLeaf
+	(ref <message> msg, const string& headerText, const string& bodyText) const
+{
+	switch (m_type)
+	{
+	case TYPE_ALL:
+
+		return true;
+
+	case TYPE_AND:
+	case TYPE_OR:
+	case TYPE_NOT:
+	case TYPE_MODSEQ:
+
+		// Handled by matchesImpl()
+		break;
+
+	case TYPE_FLAG_SET:
+
+		return (msg->getFlags() & m_number) != 0;
+
+	case TYPE_FLAG_UNSET:
+
+		return (msg->getFlags() & m_number) == 0;
+
+	case TYPE_SENT_BEFORE:
+	case TYPE_SENT_SINCE:
+	case TYPE_RECEIVED_BEFORE:
+	case TYPE_RECEIVED_SINCE:
+	{
+		ref <const vmime::header> hdr = msg->getHeader();
+
+		if (!hdr->hasField(fields::DATE))
+			return false;
+
+		const int cmp = searchCriteria_compareDates
+			(*hdr->Date()->getValue().dynamicCast <const datetime>(), m_date);
+
+		if (m_type == TYPE_SENT_BEFORE || m_type == TYPE_RECEIVED_BEFORE)
+			return cmp < 0;
+		else
+			return cmp >= 0;
+	}
+	case TYPE_HEADER:
+	{
+		const string lowerText = utility::stringUtils::toLower(m_text);
+		const std::vector <ref <const headerField> > fields = msg->getHeader()->getFieldList();
+
+		for (std::vector <ref <const headerField> >::const_iterator
+		     it = fields.begin() ; it != fields.end() ; ++it)
+		{
+			if (utility::stringUtils::isStringEqualNoCase((*it)->getName(), m_field) &&
+			    searchCriteria_fieldContains(*it, lowerText))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+	case TYPE_BODY:
+
+		return bodyText.find(utility::stringUtils::toLower(m_text)) != string::npos;
+
+	case TYPE_TEXT:
+	{
+		const string lowerText = utility::stringUtils::toLower(m_text);
+
+		return headerText.find(lowerText) != string::npos ||
+		       bodyText.find(lowerText) != string::npos;
+	}
+
+	case TYPE_LARGER:
+
+		return msg->getSize() > m_number;
+
+	case TYPE_SMALLER:
+
+		return msg->getSize() < m_number;
+	}
+
+	return false;
+}
+
+
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
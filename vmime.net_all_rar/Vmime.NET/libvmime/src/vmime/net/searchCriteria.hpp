@@ -0,0 +1,269 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#ifndef VMIME_NET_SEARCHCRITERIA_HPP_INCLUDED
+#define VMIME_NET_SEARCHCRITERIA_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+
+#include <vector>
+
+#include "../vmime/types.hpp"
+#include "../vmime/dateTime.hpp"
+
+#include "../vmime/net/message.hpp"
+
+
+namespace vmime {
+namespace net {
+
+
+/** Criteria used to search for messages in a folder (see folder::search()).
+  *
+  * Criteria are built with the static functions of this class, and
+  * can be combined with both(), either() and negate(). For example, to
+  * search for unread messages from "bob" received in 2013:
+  * \code{.cpp}
+  *    using vmime::net::searchCriteria;
+  *
+  *    searchCriteria c = searchCriteria::both
+  *       (searchCriteria::flag(vmime::net::message::FLAG_SEEN, false),
+  *        searchCriteria::both
+  *           (searchCriteria::from("bob"),
+  *            searchCriteria::both
+  *               (searchCriteria::receivedSince(vmime::datetime(2013, 1, 1)),
+  *                searchCriteria::receivedBefore(vmime::datetime(2014, 1, 1)))));
+  * \endcode
+  *
+  * Text is matched as a case-insensitive substring, and is expressed
+  * in UTF-8.
+  */
+
+class VMIME_EXPORT searchCriteria : public object
+{
+public:
+
+	/** Type of criterion.
+	  */
+	enum Types
+	{
+		TYPE_ALL,              /**< All messages. */
+		TYPE_AND,              /**< All sub-criteria match. */
+		TYPE_OR,               /**< At least one sub-criterion matches. */
+		TYPE_NOT,              /**< The sub-criterion does not match. */
+		TYPE_FLAG_SET,         /**< The flag is set. */
+		TYPE_FLAG_UNSET,       /**< The flag is not set. */
+		TYPE_SENT_BEFORE,      /**< "Date:" header is before the date. */
+		TYPE_SENT_SINCE,       /**< "Date:" header is on or after the date. */
+		TYPE_RECEIVED_BEFORE,  /**< Message was received before the date. */
+		TYPE_RECEIVED_SINCE,   /**< Message was received on or after the date. */
+		TYPE_HEADER,           /**< Header field contains the text. */
+		TYPE_BODY,             /**< Body contains the text. */
+		TYPE_TEXT,             /**< Header or body contains the text. */
+		TYPE_LARGER,           /**< Message is larger than the size. */
+		TYPE_SMALLER,          /**< Message is smaller than the size. */
+		TYPE_MODSEQ            /**< Modification sequence is greater or equal to the value. */
+	};
+
+
+	searchCriteria(const searchCriteria& other);
+	searchCriteria& operator=(const searchCriteria& other);
+
+	~searchCriteria();
+
+
+	/** Match all messages. */
+	static searchCriteria all();
+
+	/** Match messages which have (or have not) the specified flag.
+	  *
+	  * @param flag one of message::Flags
+	  * @param set true to match messages with the flag set, or
+	  * false to match messages with the flag not set
+	  */
+	static searchCriteria flag(const int flag, const bool set = true);
+
+	/** Match messages whose "Date:" header is before the specified
+	  * date (the time is ignored). */
+	static searchCriteria sentBefore(const datetime& date);
+
+	/** Match messages whose "Date:" header is on or after the
+	  * specified date (the time is ignored). */
+	static searchCriteria sentSince(const datetime& date);
+
+	/** Match messages received before the specified date (the time is
+	  * ignored). If the underlying protocol does not know when a message
+	  * has been received, the "Date:" header is used. */
+	static searchCriteria receivedBefore(const datetime& date);
+
+	/** Match messages received on or after the specified date (the time
+	  * is ignored). If the underlying protocol does not know when a message
+	  * has been received, the "Date:" header is used. */
+	static searchCriteria receivedSince(const datetime& date);
+
+	/** Match messages which have a header field with the specified
+	  * name which contains the specified text. */
+	static searchCriteria header(const string& field, const string& text);
+
+	/** Match messages whose "From:" field contains the text. */
+	static searchCriteria from(const string& text);
+
+	/** Match messages whose "To:" field contains the text. */
+	static searchCriteria to(const string& text);
+
+	/** Match messages whose "Cc:" field contains the text. */
+	static searchCriteria cc(const string& text);
+
+	/** Match messages whose "Subject:" field contains the text. */
+	static searchCriteria subject(const string& text);
+
+	/** Match messages whose body contains the text. */
+	static searchCriteria body(const string& text);
+
+	/** Match messages whose header or body contains the text. */
+	static searchCriteria text(const string& text);
+
+	/** Match messages larger than the specified size (in bytes). */
+	static searchCriteria largerThan(const int size);
+
+	/** Match messages smaller than the specified size (in bytes). */
+	static searchCriteria smallerThan(const int size);
+
+	/** Match messages whose modification sequence is greater or equal
+	  * to the specified value. This requires the IMAP CONDSTORE extension:
+	  * other protocols cannot evaluate it, and return the messages which
+	  * may match (see matches()). */
+	static searchCriteria modSequenceSince(const vmime_uint64 modseq);
+
+	/** Match messages which match both criteria. */
+	static searchCriteria both(const searchCriteria& a, const searchCriteria& b);
+
+	/** Match messages which match at least one of the criteria. */
+	static searchCriteria either(const searchCriteria& a, const searchCriteria& b);
+
+	/** Match messages which do not match the criterion. */
+	static searchCriteria negate(const searchCriteria& c);
+
+
+	/** Return the type of this criterion.
+	  *
+	  * @return criterion type (see searchCriteria::Types)
+	  */
+	Types getType() const;
+
+	/** Return the sub-criteria of this criterion (for TYPE_AND,
+	  * TYPE_OR and TYPE_NOT).
+	  *
+	  * @return sub-criteria
+	  */
+	const std::vector <searchCriteria>& getChildren() const;
+
+	/** Return the flag (for TYPE_FLAG_SET and TYPE_FLAG_UNSET). */
+	int getFlag() const;
+
+	/** Return the date (for TYPE_SENT_* and TYPE_RECEIVED_*). */
+	const datetime& getDate() const;
+
+	/** Return the header field name (for TYPE_HEADER). */
+	const string& getField() const;
+
+	/** Return the text (for TYPE_HEADER, TYPE_BODY and TYPE_TEXT). */
+	const string& getText() const;
+
+	/** Return the size (for TYPE_LARGER and TYPE_SMALLER). */
+	int getSize() const;
+
+	/** Return the modification sequence (for TYPE_MODSEQ). */
+	vmime_uint64 getModSequence() const;
+
+
+	/** Return the objects which must be fetched to evaluate this
+	  * criterion locally with matches().
+	  *
+	  * @return combination of folder::FetchOptions flags
+	  */
+	int getFetchOptions() const;
+
+	/** Return whether this criterion needs the contents of the
+	  * messages to be evaluated locally (TYPE_BODY or TYPE_TEXT).
+	  *
+	  * @return true if message contents are needed
+	  */
+	bool needsContents() const;
+
+	/** Evaluate this criterion on a message. The objects returned by
+	  * getFetchOptions() must have been fetched for the message.
+	  *
+	  * BODY and TEXT criteria are matched against the decoded text of
+	  * the message, not against its encoded contents. A MODSEQ criterion
+	  * cannot be evaluated locally: its result is unknown, also when it
+	  * is negated, and a message is returned if it matches for some
+	  * value of the unknown criteria.
+	  *
+	  * @param msg message to test
+	  * @return true if the message matches or may match, false otherwise
+	  */
+	bool matches(ref <message> msg) const;
+
+private:
+
+	/** Result of the local evaluation of a criterion.
+	  */
+	enum MatchResult
+	{
+		MATCH_NO,
+		MATCH_YES,
+		MATCH_UNKNOWN    /**< Cannot be evaluated locally (TYPE_MODSEQ). */
+	};
+
+	searchCriteria(const Types type);
+
+	MatchResult matchesImpl(ref <message> msg, const string& headerText, const string& bodyText) const;
+	bool matchesLeaf(ref <message> msg, const string& headerText, const string& bodyText) const;
+
+
+	Types m_type;
+
+	std::vector <searchCriteria> m_children;
+
+	int m_number;
+	vmime_uint64 m_modseq;
+	datetime m_date;
+	string m_field;
+	string m_text;
+};
+
+
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+
+#endif // VMIME_NET_SEARCHCRITERIA_HPP_INCLUDED
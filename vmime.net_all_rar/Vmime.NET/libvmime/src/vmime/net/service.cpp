@@ -66,6 +66,7 @@ service::service(ref <session> sess, const serviceInfos& /* infos */,
 #endif // VMIME_HAVE_TLS_SUPPORT
 
 	m_socketFactory = platform::getHandler()->getSocketFactory();
+	m_cancelToken = platform::getHandler()->createCancellationToken();
 }
 
 
@@ -144,6 +145,18 @@ ref <timeoutHandlerFactory> service::getTimeoutHandlerFactory()
 }
 
 
+void service::setCancellationToken(ref <utility::cancellationToken> token)
+{
+	m_cancelToken = token;
+}
+
+
+ref <utility::cancellationToken> service::getCancellationToken()
+{
+	return m_cancelToken;
+}
+
+
 } // net
 } // vmime
 
@@ -46,6 +46,7 @@
 #endif // VMIME_HAVE_TLS_SUPPORT
 
 #include "../vmime/utility/progressListener.hpp"
+#include "../vmime/utility/cancellationToken.hpp"
 
 
 namespace vmime {
@@ -183,6 +184,24 @@ public:
 	  */
 	ref <timeoutHandlerFactory> getTimeoutHandlerFactory();
 
+	/** Set the token used to cancel the operations of this service.
+	  * By default, each service has its own token. The same token
+	  * can be set on several services to cancel them all at once.
+	  *
+	  * The token is used by the connections created after this call.
+	  *
+	  * @param token cancellation token
+	  */
+	void setCancellationToken(ref <utility::cancellationToken> token);
+
+	/** Return the token used to cancel the operations of this service.
+	  * Call cancel() on it, from any thread, to abort the operation in
+	  * progress, and reset() before using the service again.
+	  *
+	  * @return cancellation token
+	  */
+	ref <utility::cancellationToken> getCancellationToken();
+
 	/** Set a property for this service (service prefix is added automatically).
 	  *
 	  * WARNING: this sets the property on the session object, so all service
@@ -221,6 +240,7 @@ private:
 	ref <socketFactory> m_socketFactory;
 
 	ref <timeoutHandlerFactory> m_toHandlerFactory;
+	ref <utility::cancellationToken> m_cancelToken;
 };
 
 
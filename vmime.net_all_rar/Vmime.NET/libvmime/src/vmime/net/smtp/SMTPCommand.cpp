@@ -95,6 +95,14 @@ ref <SMTPCommand> SMTPCommand::MAIL(const mailbox& mbox, const bool utf8)
 
 // static
 ref <SMTPCommand> SMTPCommand::MAIL(const mailbox& mbox, const bool utf8, const unsigned long size)
+{
+	return MAIL(mbox, utf8, size, "");
+}
+
+
+// static
+ref <SMTPCommand> SMTPCommand::MAIL
+	(const mailbox& mbox, const bool utf8, const unsigned long size, const string& bodyType)
 {
 	std::ostringstream cmd;
 	cmd.imbue(std::locale::classic());
@@ -118,6 +126,10 @@ ref <SMTPCommand> SMTPCommand::MAIL(const mailbox& mbox, const bool utf8, const
 	if (size != 0)
 		cmd << " SIZE=" << size;
 
+	// "8BITMIME" (RFC-6152) or "BINARYMIME" (RFC-3030)
+	if (!bodyType.empty())
+		cmd << " BODY=" << bodyType;
+
 	return createCommand(cmd.str());
 }
 
@@ -65,6 +65,7 @@ public:
 	static ref <SMTPCommand> STARTTLS();
 	static ref <SMTPCommand> MAIL(const mailbox& mbox, const bool utf8);
 	static ref <SMTPCommand> MAIL(const mailbox& mbox, const bool utf8, const unsigned long size);
+	static ref <SMTPCommand> MAIL(const mailbox& mbox, const bool utf8, const unsigned long size, const string& bodyType);
 	static ref <SMTPCommand> RCPT(const mailbox& mbox, const bool utf8);
 	static ref <SMTPCommand> RSET();
 	static ref <SMTPCommand> DATA();
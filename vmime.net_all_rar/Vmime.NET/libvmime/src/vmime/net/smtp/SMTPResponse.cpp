@@ -30,12 +30,12 @@
 #include "../vmime/net/smtp/SMTPResponse.hpp"
 
 #include "../vmime/platform.hpp"
-#include "../vmime/utility/stringUtils.hpp"
+#include "../vmime/parserHelpers.hpp"
 
 #include "../vmime/net/socket.hpp"
 #include "../vmime/net/timeoutHandler.hpp"
 
-#include <cctype>
+#include <cstring>
 
 
 namespace vmime {
@@ -45,8 +45,10 @@ namespace smtp {
 
 SMTPResponse::SMTPResponse(ref <socket> sok, ref <timeoutHandler> toh, const state& st)
 	: m_socket(sok), m_timeoutHandler(toh),
-	  m_responseBuffer(st.responseBuffer), m_responseContinues(false)
+	  m_buffer(st.buffer), m_responseContinues(false)
 {
+	if (!m_buffer)
+		m_buffer = vmime::create <responseBuffer>();
 }
 
 
@@ -118,33 +120,36 @@ void SMTPResponse::readResponse()
 }
 
 
-const string SMTPResponse::readResponseLine()
+const char* SMTPResponse::readResponseLine(size_t& length)
 {
-	string currentBuffer = m_responseBuffer;
+	responseBuffer& buf = *m_buffer;
 
 	if (m_timeoutHandler)
 		m_timeoutHandler->resetTimeOut();
 
+	size_t searchPos = buf.begin;  // data before this position contains no LF
+
 	while (true)
 	{
 		// Get a line from the response buffer
-		const string::size_type lineEnd = currentBuffer.find_first_of('\n');
+		const char* const lineEnd = (buf.end == searchPos) ? NULL : static_cast <const char*>
+			(std::memchr(&buf.data[searchPos], '\n', buf.end - searchPos));
 
-		if (lineEnd != string::npos)
+		if (lineEnd != NULL)
 		{
-			string::size_type actualLineEnd = lineEnd;
-
-			if (actualLineEnd != 0 && currentBuffer[actualLineEnd - 1] == '\r')  // CRLF case
-				actualLineEnd--;
+			const char* const line = &buf.data[buf.begin];
+			length = lineEnd - line;
 
-			const string line(currentBuffer.begin(), currentBuffer.begin() + actualLineEnd);
+			if (length != 0 && line[length - 1] == '\r')  // CRLF case
+				--length;
 
-			currentBuffer.erase(currentBuffer.begin(), currentBuffer.begin() + lineEnd + 1);
-			m_responseBuffer = currentBuffer;
+			buf.begin = (lineEnd - &buf.data[0]) + 1;
 
 			return line;
 		}
 
+		searchPos = buf.end;
+
 		// Check whether the time-out delay is elapsed
 		if (m_timeoutHandler && m_timeoutHandler->isTimeOut())
 		{
@@ -154,50 +159,85 @@ const string SMTPResponse::readResponseLine()
 			m_timeoutHandler->resetTimeOut();
 		}
 
-		// Receive data from the socket
-		string receiveBuffer;
-		m_socket->receive(receiveBuffer);
+		// Make room for more data: move the partial line to the beginning
+		// of the buffer, or make the buffer larger if it is full
+		if (buf.begin == buf.end)
+		{
+			buf.begin = buf.end = searchPos = 0;
+		}
+		else if (buf.end == buf.data.size())
+		{
+			if (buf.begin != 0)
+			{
+				std::memmove(&buf.data[0], &buf.data[buf.begin], buf.end - buf.begin);
+
+				searchPos -= buf.begin;
+				buf.end -= buf.begin;
+				buf.begin = 0;
+			}
+			else
+			{
+				buf.data.resize(buf.data.size() * 2);
+			}
+		}
+
+		// Receive data from the socket, directly into the buffer
+		const socket::size_type received =
+			m_socket->receiveRaw(&buf.data[buf.end], buf.data.size() - buf.end);
 
-		if (receiveBuffer.empty())   // buffer is empty
+		if (received == 0)   // buffer is empty
 		{
-			platform::getHandler()->wait();
+			// Block until data arrives or the time-out delay is elapsed
+			m_socket->waitForReadable
+				(m_timeoutHandler ? m_timeoutHandler->getRemainingTime() : 1000);
+
 			continue;
 		}
 
-		currentBuffer += receiveBuffer;
+		buf.end += received;
 	}
 }
 
 
 const SMTPResponse::responseLine SMTPResponse::getNextResponse()
 {
-	string line = readResponseLine();
+	size_t length = 0;
+	const char* const line = readResponseLine(length);
 
     // FIX by Elmue: Added Console independent Trace
     #if VMIME_TRACE
-        TRACE("SMTP read < \"%s\"", line.c_str());
+        TRACE("SMTP read < \"%s\"", string(line, length).c_str());
     #endif
 
-	const int code = extractResponseCode(line);
+	const int code = extractResponseCode(line, length);
 	string text;
 
-	m_responseContinues = (line.length() >= 4 && line[3] == '-');
+	m_responseContinues = (length >= 4 && line[3] == '-');
+
+	if (length > 4)
+	{
+		// Trim the text directly from the buffer
+		size_t textBegin = 4, textEnd = length;
+
+		while (textBegin < textEnd && parserHelpers::isSpace(line[textBegin]))
+			++textBegin;
+
+		while (textEnd > textBegin && parserHelpers::isSpace(line[textEnd - 1]))
+			--textEnd;
 
-	if (line.length() > 4)
-		text = utility::stringUtils::trim(line.substr(4));
-	else
-		text = "";
+		text.assign(line + textBegin, textEnd - textBegin);
+	}
 
 	return responseLine(code, text, extractEnhancedCode(text));
 }
 
 
 // static
-int SMTPResponse::extractResponseCode(const string& response)
+int SMTPResponse::extractResponseCode(const char* response, const size_t length)
 {
 	int code = 0;
 
-	if (response.length() >= 3)
+	if (length >= 3)
 	{
 		code = (response[0] - '0') * 100
 		     + (response[1] - '0') * 10
@@ -213,25 +253,32 @@ const SMTPResponse::enhancedStatusCode SMTPResponse::extractEnhancedCode(const s
 {
 	enhancedStatusCode enhCode;
 
-	std::istringstream iss(responseText);
+	// "class.subject.detail", parsed without creating a stream for each line
+	unsigned short* const values[] = { &enhCode.klass, &enhCode.subject, &enhCode.detail };
+	string::size_type pos = 0;
 
-	if (std::isdigit(iss.peek()))
+	for (int i = 0 ; i < 3 ; ++i)
 	{
-		iss >> enhCode.klass;
-
-		if (iss.get() == '.' && std::isdigit(iss.peek()))
+		if (i != 0)
 		{
-			iss >> enhCode.subject;
+			if (pos >= responseText.length() || responseText[pos] != '.')
+				return enhancedStatusCode();   // no enhanced code found
 
-			if (iss.get() == '.' && std::isdigit(iss.peek()))
-			{
-				iss >> enhCode.detail;
-				return enhCode;
-			}
+			++pos;
 		}
+
+		if (pos >= responseText.length() || !parserHelpers::isDigit(responseText[pos]))
+			return enhancedStatusCode();   // no enhanced code found
+
+		unsigned short value = 0;
+
+		for ( ; pos < responseText.length() && parserHelpers::isDigit(responseText[pos]) ; ++pos)
+			value = static_cast <unsigned short>(value * 10 + (responseText[pos] - '0'));
+
+		*values[i] = value;
 	}
 
-	return enhancedStatusCode();   // no enhanced code found
+	return enhCode;
 }
 
 
@@ -256,13 +303,22 @@ const SMTPResponse::responseLine SMTPResponse::getLastLine() const
 const SMTPResponse::state SMTPResponse::getCurrentState() const
 {
 	state st;
-	st.responseBuffer = m_responseBuffer;
+	st.buffer = m_buffer;
 
 	return st;
 }
 
 
 
+// SMTPResponse::responseBuffer
+
+SMTPResponse::responseBuffer::responseBuffer()
+	: data(4096), begin(0), end(0)
+{
+}
+
+
+
 // SMTPResponse::responseLine
 
 SMTPResponse::responseLine::responseLine(const int code, const string& text, const enhancedStatusCode& enhCode)
@@ -58,10 +58,26 @@ class VMIME_EXPORT SMTPResponse : public object
 
 public:
 
+	/** Data received from the socket, which has not been parsed yet.
+	  * The same buffer is used for all the responses read on a
+	  * connection: lines are parsed in place, and the space used by
+	  * parsed lines is reused when more data is received.
+	  */
+	class responseBuffer : public object
+	{
+	public:
+
+		responseBuffer();
+
+		std::vector <char> data;
+		size_t begin;   /**< start of data not parsed yet */
+		size_t end;     /**< end of data received */
+	};
+
 	/** Current state of response parser. */
 	struct state
 	{
-		string responseBuffer;
+		ref <responseBuffer> buffer;   /**< buffer of the connection (created on first use) */
 	};
 
 	/** Enhanced status code (as per RFC-3463). */
@@ -161,10 +177,17 @@ private:
 
 	void readResponse();
 
-	const string readResponseLine();
+	/** Read the next line from the buffer, receiving data from the
+	  * socket if needed. The line remains valid in the buffer until
+	  * the next call.
+	  *
+	  * @param length will receive the length of the line, without CRLF
+	  * @return pointer to the beginning of the line
+	  */
+	const char* readResponseLine(size_t& length);
 	const responseLine getNextResponse();
 
-	static int extractResponseCode(const string& response);
+	static int extractResponseCode(const char* response, const size_t length);
 	static const enhancedStatusCode extractEnhancedCode(const string& responseText);
 
 
@@ -173,7 +196,7 @@ private:
 	ref <socket> m_socket;
 	ref <timeoutHandler> m_timeoutHandler;
 
-	string m_responseBuffer;
+	ref <responseBuffer> m_buffer;
 	bool m_responseContinues;
 };
 
@@ -0,0 +1,391 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP
+
+
+#include "../vmime/net/smtp/SMTPSender.hpp"
+#include "../vmime/net/smtp/SMTPExceptions.hpp"
+
+#include "../vmime/exception.hpp"
+#include "../vmime/platform.hpp"
+
+#include "../vmime/utility/sync/autoLock.hpp"
+
+#include <algorithm>
+
+
+namespace vmime {
+namespace net {
+namespace smtp {
+
+
+SMTPSender::pooledConnection::pooledConnection()
+	: messageCount(0)
+{
+}
+
+
+
+SMTPSender::SMTPSender(ref <session> sess, const utility::url& url,
+	ref <security::authenticator> auth)
+	: m_session(sess), m_url(url), m_auth(auth),
+	  m_maxConnections(4), m_maxMessagesPerConnection(100),
+	  m_listener(NULL), m_openConnections(0)
+{
+	m_mutex = platform::getHandler()->createCriticalSection();
+	m_connectionReleased = platform::getHandler()->createCondition();
+}
+
+
+SMTPSender::~SMTPSender()
+{
+	closeIdleConnections();
+}
+
+
+void SMTPSender::setMaxConnections(const int count)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_maxConnections = std::max(1, count);
+
+	m_connectionReleased->notifyAll();
+}
+
+
+int SMTPSender::getMaxConnections() const
+{
+	return m_maxConnections;
+}
+
+
+void SMTPSender::setMaxMessagesPerConnection(const int count)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_maxMessagesPerConnection = std::max(0, count);
+}
+
+
+int SMTPSender::getMaxMessagesPerConnection() const
+{
+	return m_maxMessagesPerConnection;
+}
+
+
+void SMTPSender::setListener(listener* l)
+{
+	m_listener = l;
+}
+
+
+void SMTPSender::setSocketFactory(ref <socketFactory> sf)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_socketFactory = sf;
+}
+
+
+void SMTPSender::setTimeoutHandlerFactory(ref <timeoutHandlerFactory> thf)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_timeoutHandlerFactory = thf;
+}
+
+
+void SMTPSender::send(ref <vmime::message> msg, const mailbox& expeditor,
+	const mailboxList& recipients, const mailbox& sender)
+{
+	sendImpl(msg, NULL, 0, expeditor, recipients, sender);
+}
+
+
+void SMTPSender::send(const mailbox& expeditor, const mailboxList& recipients,
+	utility::inputStream& is, const utility::stream::size_type size,
+	const mailbox& sender)
+{
+	sendImpl(NULL, &is, size, expeditor, recipients, sender);
+}
+
+
+void SMTPSender::sendImpl(ref <vmime::message> msg, utility::inputStream* is,
+	const utility::stream::size_type size, const mailbox& expeditor,
+	const mailboxList& recipients, const mailbox& sender)
+{
+	for (int attempt = 0 ; ; ++attempt)
+	{
+		bool reused = false;
+		pooledConnection conn = acquireConnection(reused);
+
+		try
+		{
+			if (msg)
+			{
+				conn.transport->send(msg, expeditor, recipients, /* progress */ NULL, sender);
+			}
+			else
+			{
+				if (attempt != 0)
+					is->reset();
+
+				conn.transport->send(expeditor, recipients, *is, size, /* progress */ NULL, sender);
+			}
+		}
+		catch (SMTPCommandError& e)
+		{
+			closeConnection(conn.transport);
+			releaseConnection(conn);
+
+			// 421: service not available, the server closes the connection
+			if (e.statusCode() == 421 && attempt == 0)
+				continue;
+
+			throw;
+		}
+		catch (exceptions::socket_exception&)
+		{
+			const bool endOfDataSent = conn.transport->isEndOfDataSent();
+
+			closeConnection(conn.transport);
+			releaseConnection(conn);
+
+			// An idle connection may have been closed by the server; if
+			// the end of the data has been sent, the server may have
+			// accepted the message, which must not be delivered twice
+			if (reused && attempt == 0 && !endOfDataSent)
+				continue;
+
+			throw;
+		}
+		catch (...)
+		{
+			closeConnection(conn.transport);
+			releaseConnection(conn);
+
+			throw;
+		}
+
+		++conn.messageCount;
+		releaseConnection(conn);
+
+		return;
+	}
+}
+
+
+void SMTPSender::enqueue(ref <vmime::message> msg, const mailbox& expeditor,
+	const mailboxList& recipients, const mailbox& sender)
+{
+	job j;
+	j.msg = msg;
+	j.expeditor = expeditor;
+	j.recipients = recipients;
+	j.sender = sender;
+
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_queue.push_back(j);
+}
+
+
+void SMTPSender::run()
+{
+	for ( ; ; )
+	{
+		std::list <job> current;
+
+		{
+			utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+			if (m_queue.empty())
+				return;
+
+			current.splice(current.begin(), m_queue, m_queue.begin());
+		}
+
+		const job& j = current.front();
+
+		try
+		{
+			send(j.msg, j.expeditor, j.recipients, j.sender);
+		}
+		catch (vmime::exception& e)
+		{
+			if (m_listener)
+				m_listener->messageFailed(j.msg, e);
+
+			continue;
+		}
+
+		if (m_listener)
+			m_listener->messageSent(j.msg);
+	}
+}
+
+
+int SMTPSender::getQueuedMessageCount() const
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	return static_cast <int>(m_queue.size());
+}
+
+
+void SMTPSender::closeIdleConnections()
+{
+	std::list <pooledConnection> idle;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		idle.swap(m_idleConnections);
+		m_openConnections -= static_cast <int>(idle.size());
+
+		m_connectionReleased->notifyAll();
+	}
+
+	// Disconnect outside of the lock, as this involves network I/O
+	for (std::list <pooledConnection>::iterator it = idle.begin() ; it != idle.end() ; ++it)
+		closeConnection((*it).transport);
+}
+
+
+SMTPSender::pooledConnection SMTPSender::acquireConnection(bool& reused)
+{
+	ref <socketFactory> sf;
+	ref <timeoutHandlerFactory> thf;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		for ( ; ; )
+		{
+			// Most recently used connections are at the front
+			while (!m_idleConnections.empty())
+			{
+				pooledConnection conn = m_idleConnections.front();
+				m_idleConnections.pop_front();
+
+				if (conn.transport->isConnected())
+				{
+					reused = true;
+					return conn;
+				}
+
+				--m_openConnections;
+			}
+
+			if (m_openConnections < m_maxConnections)
+			{
+				++m_openConnections;
+				break;
+			}
+
+			// Wait for another thread to release a connection
+			m_connectionReleased->wait(m_mutex);
+		}
+
+		sf = m_socketFactory;
+		thf = m_timeoutHandlerFactory;
+	}
+
+	// Open a new connection
+	pooledConnection conn;
+
+	try
+	{
+		conn.transport = m_session->getTransport(m_url, m_auth).dynamicCast <SMTPTransport>();
+
+		if (!conn.transport)
+			throw exceptions::no_service_available(m_url.getProtocol());
+
+		if (sf)
+			conn.transport->setSocketFactory(sf);
+		if (thf)
+			conn.transport->setTimeoutHandlerFactory(thf);
+
+		conn.transport->connect();
+	}
+	catch (...)
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+		--m_openConnections;
+
+		m_connectionReleased->notifyOne();
+
+		throw;
+	}
+
+	reused = false;
+
+	return conn;
+}
+
+
+void SMTPSender::releaseConnection(pooledConnection& conn)
+{
+	bool close = true;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		if (conn.transport->isConnected() &&
+		    (m_maxMessagesPerConnection == 0 || conn.messageCount < m_maxMessagesPerConnection))
+		{
+			m_idleConnections.push_front(conn);
+			close = false;
+		}
+		else
+		{
+			--m_openConnections;
+		}
+
+		m_connectionReleased->notifyOne();
+	}
+
+	if (close)
+		closeConnection(conn.transport);
+}
+
+
+// static
+void SMTPSender::closeConnection(ref <SMTPTransport> transport)
+{
+	try
+	{
+		if (transport->isConnected())
+			transport->disconnect();
+	}
+	catch (vmime::exception&)
+	{
+		// Ignore
+	}
+}
+
+
+} // smtp
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP
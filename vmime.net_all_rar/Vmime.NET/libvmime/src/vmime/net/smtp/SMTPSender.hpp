@@ -0,0 +1,285 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_SMTP_SMTPSENDER_HPP_INCLUDED
+#define VMIME_NET_SMTP_SMTPSENDER_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP
+
+
+#include <list>
+
+#include "../vmime/mailbox.hpp"
+#include "../vmime/mailboxList.hpp"
+#include "../vmime/message.hpp"
+
+#include "../vmime/net/session.hpp"
+#include "../vmime/net/socket.hpp"
+#include "../vmime/net/timeoutHandler.hpp"
+#include "../vmime/net/smtp/SMTPTransport.hpp"
+
+#include "../vmime/security/authenticator.hpp"
+
+#include "../vmime/utility/inputStream.hpp"
+#include "../vmime/utility/url.hpp"
+#include "../vmime/utility/sync/condition.hpp"
+#include "../vmime/utility/sync/criticalSection.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace smtp {
+
+
+/** Sends messages to a SMTP server through a pool of connections.
+  *
+  * A sender can be used from several threads at the same time: each
+  * message is sent on an idle connection of the pool, or on a new
+  * connection if less than getMaxConnections() are open; otherwise,
+  * the thread waits for a connection to be released. Connections are
+  * kept open between messages, so that the greeting, EHLO, STARTTLS
+  * and authentication exchanges are only made once per connection.
+  *
+  * Messages can be sent one by one with send(), or queued with
+  * enqueue() and sent by one or more threads calling run(), in which
+  * case the result of each message is reported to the listener.
+  */
+
+class VMIME_EXPORT SMTPSender : public object
+{
+public:
+
+	/** Receives the result of the messages sent by run().
+	  * Notifications are made from the thread which sent the message.
+	  */
+	class VMIME_EXPORT listener
+	{
+	public:
+
+		virtual ~listener() { }
+
+		/** Called when a message has been accepted by the server.
+		  *
+		  * @param msg message sent
+		  */
+		virtual void messageSent(ref <vmime::message> msg) = 0;
+
+		/** Called when a message could not be sent.
+		  *
+		  * @param msg message which was not sent
+		  * @param e error which occurred
+		  */
+		virtual void messageFailed(ref <vmime::message> msg, const exception& e) = 0;
+	};
+
+
+	/** Construct a new sender.
+	  *
+	  * @param sess session whose properties are used by the
+	  * connections (TLS, authentication, SMTP options...)
+	  * @param url URL of the SMTP server (eg: "smtp://relay.example.com/")
+	  * @param auth authenticator object to use, or NULL to use the
+	  * default one
+	  */
+	SMTPSender(ref <session> sess, const utility::url& url,
+		ref <security::authenticator> auth = NULL);
+
+	~SMTPSender();
+
+	/** Set the maximum number of connections opened at the same time.
+	  * The default is 4.
+	  *
+	  * @param count maximum number of connections (at least 1)
+	  */
+	void setMaxConnections(const int count);
+
+	int getMaxConnections() const;
+
+	/** Set the maximum number of messages sent on a connection before
+	  * it is closed and a new one is opened. The default is 100.
+	  *
+	  * @param count maximum number of messages, or zero for no limit
+	  */
+	void setMaxMessagesPerConnection(const int count);
+
+	int getMaxMessagesPerConnection() const;
+
+	/** Set the listener which receives the results of run().
+	  *
+	  * @param l listener, or NULL
+	  */
+	void setListener(listener* l);
+
+	/** Set the factory used to create the sockets of the connections
+	  * opened from now on.
+	  *
+	  * @param sf socket factory, or NULL to use the default one
+	  */
+	void setSocketFactory(ref <socketFactory> sf);
+
+	/** Set the factory used to create the time-out handlers of the
+	  * connections opened from now on.
+	  *
+	  * @param thf time-out handler factory, or NULL to use the default one
+	  */
+	void setTimeoutHandlerFactory(ref <timeoutHandlerFactory> thf);
+
+	/** Send a message on a connection of the pool. If the server closes
+	  * the connection with a 421 reply, or if an idle connection taken
+	  * from the pool has been closed before the end of the message data
+	  * was sent, the message is sent again on a new connection. Once the
+	  * end of the data has been sent, the message is never sent again,
+	  * as the server may have accepted it.
+	  *
+	  * @param msg message to send
+	  * @param expeditor expeditor mailbox
+	  * @param recipients list of recipient mailboxes
+	  * @param sender envelope sender (if empty, expeditor will be used)
+	  * @throw exceptions::net_exception if the message could not be sent
+	  */
+	void send(ref <vmime::message> msg, const mailbox& expeditor,
+		const mailboxList& recipients, const mailbox& sender = mailbox());
+
+	/** Send an already generated message on a connection of the pool.
+	  * Same as above, except that the stream is reset and read again
+	  * if the message is sent again on a new connection.
+	  *
+	  * @param expeditor expeditor mailbox
+	  * @param recipients list of recipient mailboxes
+	  * @param is input stream providing message data (headers + body)
+	  * @param size size of the message data
+	  * @param sender envelope sender (if empty, expeditor will be used)
+	  * @throw exceptions::net_exception if the message could not be sent
+	  */
+	void send(const mailbox& expeditor, const mailboxList& recipients,
+		utility::inputStream& is, const utility::stream::size_type size,
+		const mailbox& sender = mailbox());
+
+	/** Add a message to the queue of messages sent by run().
+	  *
+	  * @param msg message to send
+	  * @param expeditor expeditor mailbox
+	  * @param recipients list of recipient mailboxes
+	  * @param sender envelope sender (if empty, expeditor will be used)
+	  */
+	void enqueue(ref <vmime::message> msg, const mailbox& expeditor,
+		const mailboxList& recipients, const mailbox& sender = mailbox());
+
+	/** Send the queued messages, until the queue is empty. The result
+	  * of each message is reported to the listener. This function can
+	  * be called from several threads at the same time, to send the
+	  * messages on several connections in parallel.
+	  */
+	void run();
+
+	/** Return the number of messages waiting in the queue.
+	  *
+	  * @return number of queued messages
+	  */
+	int getQueuedMessageCount() const;
+
+	/** Close all the idle connections of the pool.
+	  */
+	void closeIdleConnections();
+
+private:
+
+	class job
+	{
+	public:
+
+		ref <vmime::message> msg;
+		mailbox expeditor;
+		mailboxList recipients;
+		mailbox sender;
+	};
+
+	class pooledConnection
+	{
+	public:
+
+		pooledConnection();
+
+		ref <SMTPTransport> transport;
+		int messageCount;  /**< number of messages sent on this connection */
+	};
+
+	/** Send a message object, or message data if msg is NULL.
+	  * See send() for the parameters.
+	  */
+	void sendImpl(ref <vmime::message> msg, utility::inputStream* is,
+		const utility::stream::size_type size, const mailbox& expeditor,
+		const mailboxList& recipients, const mailbox& sender);
+
+	/** Take an idle connection from the pool, or open a new one.
+	  * Waits if the maximum number of connections is reached.
+	  *
+	  * @param reused set to true if the connection was idle in the pool
+	  * @return connection
+	  */
+	pooledConnection acquireConnection(bool& reused);
+
+	/** Put back a connection in the pool, or close it if it cannot be
+	  * reused.
+	  *
+	  * @param conn connection
+	  */
+	void releaseConnection(pooledConnection& conn);
+
+	static void closeConnection(ref <SMTPTransport> transport);
+
+
+	ref <session> m_session;
+	utility::url m_url;
+	ref <security::authenticator> m_auth;
+
+	int m_maxConnections;
+	int m_maxMessagesPerConnection;
+
+	listener* m_listener;
+
+	ref <socketFactory> m_socketFactory;
+	ref <timeoutHandlerFactory> m_timeoutHandlerFactory;
+
+	ref <utility::sync::criticalSection> m_mutex;
+	ref <utility::sync::condition> m_connectionReleased;  // a connection was released, or may be opened
+
+	std::list <pooledConnection> m_idleConnections;
+	int m_openConnections;  // idle and in use
+
+	std::list <job> m_queue;
+};
+
+
+} // smtp
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP
+
+#endif // VMIME_NET_SMTP_SMTPSENDER_HPP_INCLUDED
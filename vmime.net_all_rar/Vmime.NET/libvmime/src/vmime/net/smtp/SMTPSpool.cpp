@@ -0,0 +1,657 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP && VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include "../vmime/net/smtp/SMTPSpool.hpp"
+#include "../vmime/net/smtp/SMTPExceptions.hpp"
+
+#include "../vmime/utility/fileUtils.hpp"
+#include "../vmime/utility/outputStreamAdapter.hpp"
+#include "../vmime/utility/random.hpp"
+#include "../vmime/utility/streamUtils.hpp"
+#include "../vmime/utility/sync/autoLock.hpp"
+
+#include "../vmime/exception.hpp"
+#include "../vmime/platform.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <vector>
+
+
+namespace vmime {
+namespace net {
+namespace smtp {
+
+
+#ifndef VMIME_BUILDING_DOC
+
+static const int SMTPSpool_fileVersion = 1;
+
+static const char* const SMTPSpool_dataExt = ".eml";
+static const char* const SMTPSpool_envelopeExt = ".env";
+
+
+static bool SMTPSpool_endsWith(const string& str, const string& suffix)
+{
+	return str.length() > suffix.length() &&
+	       str.compare(str.length() - suffix.length(), suffix.length(), suffix) == 0;
+}
+
+
+static void SMTPSpool_checkLine(const string& str)
+{
+	// Each field of the envelope is stored on its own line
+	if (str.find_first_of("\r\n") != string::npos)
+		throw exceptions::invalid_argument();
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
+SMTPSpool::entry::entry()
+	: attempts(0), nextAttempt(0), inProgress(false)
+{
+}
+
+
+SMTPSpool::destination::destination()
+	: inProgress(0)
+{
+}
+
+
+
+SMTPSpool::SMTPSpool(const utility::file::path& dir)
+	: m_dir(dir), m_initialDelay(60), m_maxDelay(4 * 60 * 60),
+	  m_maxAttempts(10), m_listener(NULL)
+{
+	m_mutex = platform::getHandler()->createCriticalSection();
+
+	recover();
+}
+
+
+SMTPSpool::~SMTPSpool()
+{
+}
+
+
+void SMTPSpool::setDestination(const string& destination, ref <SMTPSender> sender)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	// The destination is kept, as messages may be being sent
+	m_destinations[destination].sender = sender;
+}
+
+
+void SMTPSpool::setRetryDelays(const unsigned long initialDelay, const unsigned long maxDelay)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	m_initialDelay = std::max(1UL, initialDelay);
+	m_maxDelay = std::max(m_initialDelay, maxDelay);
+}
+
+
+void SMTPSpool::setMaxAttempts(const int count)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_maxAttempts = std::max(1, count);
+}
+
+
+int SMTPSpool::getMaxAttempts() const
+{
+	return m_maxAttempts;
+}
+
+
+void SMTPSpool::setListener(listener* l)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_listener = l;
+}
+
+
+const string SMTPSpool::enqueue(ref <vmime::message> msg, const mailbox& expeditor,
+	const mailboxList& recipients, const mailbox& sender, const string& destination)
+{
+	if (recipients.isEmpty())
+		throw exceptions::no_recipient();
+	else if (expeditor.isEmpty())
+		throw exceptions::no_expeditor();
+
+	SMTPSpool_checkLine(destination);
+	SMTPSpool_checkLine(expeditor.getEmail().generate());
+
+	if (!sender.isEmpty())
+		SMTPSpool_checkLine(sender.getEmail().generate());
+
+	for (size_t i = 0 ; i < recipients.getMailboxCount() ; ++i)
+		SMTPSpool_checkLine(recipients.getMailboxAt(i)->getEmail().generate());
+
+	entry e;
+	e.id = generateId();
+	e.destination = destination;
+	e.expeditor = expeditor;
+	e.recipients = recipients;
+	e.sender = sender;
+
+	ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+
+	try
+	{
+		ref <utility::file> file = fsf->create(getDataPath(e.id));
+
+		if (!file->exists())
+			file->createFile();
+
+		// Generate the message once: each attempt streams it from the disk
+		{
+			ref <utility::fileWriter> writer = file->getFileWriter();
+			ref <utility::fileOutputStream> os = writer->getOutputStream();
+
+			msg->generate(*os);
+			os->sync();
+		}
+
+		// The message is in the spool once its envelope is written
+		writeEnvelope(e);
+	}
+	catch (...)
+	{
+		removeFiles(e.id);
+		throw;
+	}
+
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_entries[e.id] = e;
+
+	return e.id;
+}
+
+
+int SMTPSpool::run()
+{
+	int count = 0;
+
+	for ( ; ; )
+	{
+		entry e;
+		ref <SMTPSender> sender;
+
+		{
+			utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+			const unsigned long now = platform::getHandler()->getUnixTime();
+
+			// Take the oldest message which is due, and whose destination
+			// has a connection available
+			std::map <string, entry>::iterator it = m_entries.begin();
+
+			for ( ; it != m_entries.end() ; ++it)
+			{
+				entry& cur = (*it).second;
+
+				if (cur.inProgress || cur.nextAttempt > now)
+					continue;
+
+				std::map <string, destination>::iterator dit = m_destinations.find(cur.destination);
+
+				if (dit == m_destinations.end() || !(*dit).second.sender ||
+				    (*dit).second.inProgress >= (*dit).second.sender->getMaxConnections())
+				{
+					continue;
+				}
+
+				cur.inProgress = true;
+				++(*dit).second.inProgress;
+
+				e = cur;
+				sender = (*dit).second.sender;
+
+				break;
+			}
+
+			if (it == m_entries.end())
+				return count;
+		}
+
+		process(e, sender);
+
+		++count;
+	}
+}
+
+
+int SMTPSpool::getMessageCount() const
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	return static_cast <int>(m_entries.size());
+}
+
+
+unsigned long SMTPSpool::getNextAttemptTime() const
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	unsigned long next = 0;
+
+	for (std::map <string, entry>::const_iterator it = m_entries.begin() ; it != m_entries.end() ; ++it)
+	{
+		const entry& cur = (*it).second;
+
+		if (!cur.inProgress && (next == 0 || cur.nextAttempt < next))
+			next = std::max(1UL, cur.nextAttempt);
+	}
+
+	return next;
+}
+
+
+void SMTPSpool::process(const entry& e, ref <SMTPSender> sender)
+{
+	try
+	{
+		ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+		ref <utility::file> file = fsf->create(getDataPath(e.id));
+
+		const utility::stream::size_type size =
+			static_cast <utility::stream::size_type>(file->getLength());
+
+		ref <utility::fileReader> reader = file->getFileReader();
+		ref <utility::inputStream> is = reader->getInputStream();
+
+		sender->send(e.expeditor, e.recipients, *is, size, e.sender);
+	}
+	catch (SMTPCommandError& err)
+	{
+		// 4xx replies are transient, 5xx replies are permanent
+		complete(e, &err, err.statusCode() >= 500);
+		return;
+	}
+	catch (SMTPMessageSizeExceedsMaxLimitsException& err)
+	{
+		complete(e, &err, /* permanent */ true);
+		return;
+	}
+	catch (exceptions::net_exception& err)
+	{
+		// Connection and network errors
+		complete(e, &err, /* permanent */ false);
+		return;
+	}
+	catch (vmime::exception& err)
+	{
+		// Unreadable message data, invalid addresses...
+		complete(e, &err, /* permanent */ true);
+		return;
+	}
+	catch (...)
+	{
+		// Make the message available again
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		m_entries[e.id].inProgress = false;
+		--m_destinations[e.destination].inProgress;
+
+		throw;
+	}
+
+	complete(e, NULL, false);
+}
+
+
+void SMTPSpool::complete(const entry& e, const exception* err, const bool permanent)
+{
+	unsigned long initialDelay = 0, maxDelay = 0;
+	int maxAttempts = 0;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		initialDelay = m_initialDelay;
+		maxDelay = m_maxDelay;
+		maxAttempts = m_maxAttempts;
+	}
+
+	const bool remove = (err == NULL || permanent || e.attempts + 1 >= maxAttempts);
+
+	entry updated = e;
+	updated.inProgress = false;
+
+	if (remove)
+	{
+		removeFiles(e.id);
+	}
+	else
+	{
+		// Exponential backoff: the delay is doubled after each attempt
+		unsigned long delay = initialDelay;
+
+		for (int i = 0 ; i < e.attempts && delay < maxDelay ; ++i)
+			delay *= 2;
+
+		updated.attempts = e.attempts + 1;
+		updated.nextAttempt = platform::getHandler()->getUnixTime() + std::min(delay, maxDelay);
+
+		try
+		{
+			writeEnvelope(updated);
+		}
+		catch (exceptions::filesystem_exception&)
+		{
+			// The new schedule is kept in memory; if the spool is
+			// reloaded, the previous one will be used
+		}
+	}
+
+	listener* l = NULL;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		--m_destinations[e.destination].inProgress;
+
+		if (remove)
+			m_entries.erase(e.id);
+		else
+			m_entries[e.id] = updated;
+
+		l = m_listener;
+	}
+
+	if (l)
+	{
+		if (err == NULL)
+			l->messageSent(e.id);
+		else if (remove)
+			l->messageFailed(e.id, *err);
+		else
+			l->messageDeferred(e.id, *err, updated.nextAttempt);
+	}
+}
+
+
+void SMTPSpool::recover()
+{
+	ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+	ref <utility::file> dir = fsf->create(m_dir);
+
+	if (!dir->exists())
+	{
+		dir->createDirectory(true);
+		return;
+	}
+
+	std::set <string> names;
+
+	for (ref <utility::fileIterator> files = dir->getFiles() ; files->hasMoreElements() ; )
+	{
+		ref <utility::file> file = files->nextElement();
+
+		if (file->isFile())
+			names.insert(file->getFullPath().getLastComponent().getBuffer());
+	}
+
+	// Extension of the temporary files of the envelopes (".env.tmp")
+	const string envTmpExt = utility::fileUtils::getTemporaryPath
+		(getEnvelopePath("")).getLastComponent().getBuffer();
+
+	// An envelope is only replaced after its temporary file has been
+	// completely written: if the envelope is missing, the temporary file
+	// is the most recent state of the message (if it is complete)
+	for (std::set <string>::const_iterator it = names.begin() ; it != names.end() ; ++it)
+	{
+		if (!SMTPSpool_endsWith(*it, envTmpExt))
+			continue;
+
+		const string id = (*it).substr(0, (*it).length() - envTmpExt.length());
+
+		try
+		{
+			ref <utility::file> tmpFile = fsf->create(getPath(*it));
+			entry e;
+
+			if (names.count(id + SMTPSpool_envelopeExt) == 0 && readEnvelope(tmpFile, e))
+				tmpFile->rename(getEnvelopePath(id));
+			else
+				tmpFile->remove();
+		}
+		catch (exceptions::filesystem_exception&)
+		{
+			// Ignore
+		}
+	}
+
+	// Load the envelopes; data without an envelope was being added
+	// when the spool was interrupted
+	names.clear();
+
+	for (ref <utility::fileIterator> files = dir->getFiles() ; files->hasMoreElements() ; )
+	{
+		ref <utility::file> file = files->nextElement();
+
+		if (file->isFile())
+			names.insert(file->getFullPath().getLastComponent().getBuffer());
+	}
+
+	for (std::set <string>::const_iterator it = names.begin() ; it != names.end() ; ++it)
+	{
+		string id;
+
+		if (SMTPSpool_endsWith(*it, SMTPSpool_envelopeExt))
+			id = (*it).substr(0, (*it).length() - ::strlen(SMTPSpool_envelopeExt));
+		else if (SMTPSpool_endsWith(*it, SMTPSpool_dataExt))
+			id = (*it).substr(0, (*it).length() - ::strlen(SMTPSpool_dataExt));
+		else
+			continue;
+
+		if (m_entries.find(id) != m_entries.end())
+			continue;
+
+		entry e;
+
+		if (names.count(id + SMTPSpool_envelopeExt) != 0 &&
+		    names.count(id + SMTPSpool_dataExt) != 0 &&
+		    readEnvelope(fsf->create(getEnvelopePath(id)), e))
+		{
+			e.id = id;
+			m_entries[id] = e;
+		}
+		else
+		{
+			removeFiles(id);
+		}
+	}
+}
+
+
+void SMTPSpool::writeEnvelope(const entry& e)
+{
+	// File format:
+	//
+	//    <version>
+	//    <attempts> <next attempt>
+	//    <destination>
+	//    <expeditor>
+	//    <sender, or empty line>
+	//    <recipient count>
+	//    <recipient>
+	//    ...
+	//    .
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+
+	oss << SMTPSpool_fileVersion << '\n';
+	oss << e.attempts << ' ' << e.nextAttempt << '\n';
+	oss << e.destination << '\n';
+	oss << e.expeditor.getEmail().generate() << '\n';
+	oss << (e.sender.isEmpty() ? "" : e.sender.getEmail().generate()) << '\n';
+	oss << e.recipients.getMailboxCount() << '\n';
+
+	for (size_t i = 0 ; i < e.recipients.getMailboxCount() ; ++i)
+		oss << e.recipients.getMailboxAt(i)->getEmail().generate() << '\n';
+
+	oss << ".\n";
+
+	// The envelope is replaced in one step, so that a valid
+	// envelope is always found on the disk
+	utility::fileUtils::writeFileAtomically(getEnvelopePath(e.id), oss.str(), /* sync */ true);
+}
+
+
+bool SMTPSpool::readEnvelope(ref <utility::file> file, entry& e)
+{
+	std::ostringstream oss;
+	utility::outputStreamAdapter ossAdapter(oss);
+
+	try
+	{
+		ref <utility::fileReader> reader = file->getFileReader();
+		ref <utility::inputStream> is = reader->getInputStream();
+
+		utility::bufferedStreamCopy(*is, ossAdapter);
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		return false;
+	}
+
+	std::istringstream iss(oss.str());
+	iss.imbue(std::locale::classic());
+
+	int version = 0;
+	size_t count = 0;
+	string line;
+
+	iss >> version >> e.attempts >> e.nextAttempt;
+
+	if (iss.fail() || version != SMTPSpool_fileVersion)
+		return false;
+
+	std::getline(iss, line);  // end of line
+	std::getline(iss, e.destination);
+
+	std::getline(iss, line);
+	e.expeditor = mailbox(emailAddress(line));
+
+	std::getline(iss, line);
+	e.sender = line.empty() ? mailbox() : mailbox(emailAddress(line));
+
+	iss >> count;
+	std::getline(iss, line);
+
+	e.recipients.removeAllMailboxes();
+
+	for (size_t i = 0 ; i < count && std::getline(iss, line) ; ++i)
+		e.recipients.appendMailbox(vmime::create <mailbox>(emailAddress(line)));
+
+	// The last line is only present if the file is complete
+	if (!std::getline(iss, line) || line != ".")
+		return false;
+
+	return !e.expeditor.isEmpty() && !e.recipients.isEmpty();
+}
+
+
+void SMTPSpool::removeFiles(const string& id)
+{
+	ref <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+
+	// Remove the envelope first: data without an envelope is
+	// ignored if the spool is interrupted
+	const utility::file::path paths[] =
+	{
+		getEnvelopePath(id),
+		getDataPath(id)
+	};
+
+	for (size_t i = 0 ; i < sizeof(paths) / sizeof(paths[0]) ; ++i)
+	{
+		try
+		{
+			ref <utility::file> file = fsf->create(paths[i]);
+
+			if (file->exists())
+				file->remove();
+		}
+		catch (exceptions::filesystem_exception&)
+		{
+			// Ignore
+		}
+	}
+}
+
+
+const utility::file::path SMTPSpool::getDataPath(const string& id) const
+{
+	return getPath(id + SMTPSpool_dataExt);
+}
+
+
+const utility::file::path SMTPSpool::getEnvelopePath(const string& id) const
+{
+	return getPath(id + SMTPSpool_envelopeExt);
+}
+
+
+const utility::file::path SMTPSpool::getPath(const string& name) const
+{
+	return m_dir / utility::file::path::component(name, vmime::charset(vmime::charsets::US_ASCII));
+}
+
+
+// static
+const string SMTPSpool::generateId()
+{
+	// Identifiers begin with the time, so that they are sorted by age
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+
+	oss << std::hex << std::setfill('0')
+	    << std::setw(8) << platform::getHandler()->getUnixTime() << '-'
+	    << std::setw(4) << (utility::random::getProcess() & 0xffff) << '-'
+	    << std::setw(8) << utility::random::getNext()
+	    << std::setw(8) << utility::random::getNext();
+
+	return oss.str();
+}
+
+
+} // smtp
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP && VMIME_HAVE_FILESYSTEM_FEATURES
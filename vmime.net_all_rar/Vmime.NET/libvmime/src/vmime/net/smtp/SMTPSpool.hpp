@@ -0,0 +1,279 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_SMTP_SMTPSPOOL_HPP_INCLUDED
+#define VMIME_NET_SMTP_SMTPSPOOL_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP && VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include <map>
+
+#include "../vmime/mailbox.hpp"
+#include "../vmime/mailboxList.hpp"
+#include "../vmime/message.hpp"
+
+#include "../vmime/net/smtp/SMTPSender.hpp"
+
+#include "../vmime/utility/file.hpp"
+#include "../vmime/utility/path.hpp"
+#include "../vmime/utility/sync/criticalSection.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace smtp {
+
+
+/** Outbound message spool, stored on the disk.
+  *
+  * Messages are generated once when they are added to the spool, and
+  * written to the spool directory with their envelope. Each delivery
+  * attempt streams the message from the disk through the SMTPSender
+  * of its destination. If the server answers with a transient error
+  * (4xx reply, network error), the message is kept and tried again
+  * later, with an exponentially increasing delay. Permanent errors
+  * (5xx reply) and messages which reach the maximum number of attempts
+  * are removed from the spool and reported to the listener.
+  *
+  * Files are written to the disk before a message is considered to be
+  * in the spool, so that messages survive a crash of the application:
+  * messages found in the directory are loaded when the spool is created.
+  *
+  * Messages are sent by the threads which call run(). It can be called
+  * from several threads at the same time; for each destination, no more
+  * messages are sent in parallel than the number of connections of its
+  * sender (see SMTPSender::setMaxConnections()).
+  */
+
+class VMIME_EXPORT SMTPSpool : public object
+{
+public:
+
+	/** Receives the result of the delivery attempts made by run().
+	  * Notifications are made from the thread which sent the message.
+	  */
+	class VMIME_EXPORT listener
+	{
+	public:
+
+		virtual ~listener() { }
+
+		/** Called when a message has been accepted by the server,
+		  * and removed from the spool.
+		  *
+		  * @param id identifier of the message in the spool
+		  */
+		virtual void messageSent(const string& id) = 0;
+
+		/** Called when a message failed temporarily, and will be
+		  * tried again later.
+		  *
+		  * @param id identifier of the message in the spool
+		  * @param e error which occurred
+		  * @param nextAttempt time of the next attempt (seconds since the epoch)
+		  */
+		virtual void messageDeferred(const string& id, const exception& e, const unsigned long nextAttempt) = 0;
+
+		/** Called when a message failed permanently, or reached the
+		  * maximum number of attempts, and has been removed from the spool.
+		  *
+		  * @param id identifier of the message in the spool
+		  * @param e error which occurred
+		  */
+		virtual void messageFailed(const string& id, const exception& e) = 0;
+	};
+
+
+	/** Open a spool, and load the messages it contains.
+	  *
+	  * @param dir directory where the messages are stored (it
+	  * is created if it does not exist)
+	  * @throw exceptions::filesystem_exception if the directory
+	  * cannot be read
+	  */
+	SMTPSpool(const utility::file::path& dir);
+
+	~SMTPSpool();
+
+	/** Set the sender used to deliver the messages to a destination.
+	  * Messages whose destination has no sender are kept in the spool.
+	  *
+	  * @param destination name of the destination (the default
+	  * destination is the empty string)
+	  * @param sender sender, or NULL to remove the destination
+	  */
+	void setDestination(const string& destination, ref <SMTPSender> sender);
+
+	/** Set the delays between attempts. The delay is doubled after
+	  * each failed attempt, up to the maximum delay. The defaults are
+	  * 60 seconds and 4 hours.
+	  *
+	  * @param initialDelay delay after the first attempt, in seconds
+	  * @param maxDelay maximum delay, in seconds
+	  */
+	void setRetryDelays(const unsigned long initialDelay, const unsigned long maxDelay);
+
+	/** Set the maximum number of delivery attempts for a message.
+	  * The default is 10.
+	  *
+	  * @param count maximum number of attempts (at least 1)
+	  */
+	void setMaxAttempts(const int count);
+
+	int getMaxAttempts() const;
+
+	/** Set the listener which receives the results of run().
+	  *
+	  * @param l listener, or NULL
+	  */
+	void setListener(listener* l);
+
+	/** Add a message to the spool. The message is generated and written
+	  * to the disk before this function returns; it can be modified or
+	  * released afterwards.
+	  *
+	  * @param msg message to send
+	  * @param expeditor expeditor mailbox
+	  * @param recipients list of recipient mailboxes
+	  * @param sender envelope sender (if empty, expeditor will be used)
+	  * @param destination name of the destination
+	  * @return identifier of the message in the spool
+	  * @throw exceptions::invalid_argument if an address or the name of
+	  * the destination contains a line break
+	  * @throw exceptions::filesystem_exception if the message cannot be
+	  * written to the disk
+	  */
+	const string enqueue(ref <vmime::message> msg, const mailbox& expeditor,
+		const mailboxList& recipients, const mailbox& sender = mailbox(),
+		const string& destination = "");
+
+	/** Send the messages which are due, until there is none left which
+	  * can be sent now. Results are reported to the listener.
+	  *
+	  * @return number of delivery attempts made
+	  */
+	int run();
+
+	/** Return the number of messages in the spool.
+	  *
+	  * @return number of messages
+	  */
+	int getMessageCount() const;
+
+	/** Return the time at which the next message will be due, so that
+	  * the caller can wait until then before calling run() again.
+	  *
+	  * @return time of the next attempt (seconds since the epoch),
+	  * or zero if there is no message waiting
+	  */
+	unsigned long getNextAttemptTime() const;
+
+private:
+
+	class entry
+	{
+	public:
+
+		entry();
+
+		string id;
+		string destination;
+		mailbox expeditor;
+		mailboxList recipients;
+		mailbox sender;
+
+		int attempts;               /**< number of failed attempts */
+		unsigned long nextAttempt;  /**< time of the next attempt */
+		bool inProgress;            /**< being sent by a thread */
+	};
+
+	class destination
+	{
+	public:
+
+		destination();
+
+		ref <SMTPSender> sender;
+		int inProgress;  /**< number of messages being sent */
+	};
+
+	/** Load the messages of the spool directory, and remove the
+	  * files left by an interrupted operation.
+	  */
+	void recover();
+
+	/** Send a message, and update the spool with the result.
+	  *
+	  * @param e message
+	  * @param sender sender of the destination
+	  */
+	void process(const entry& e, ref <SMTPSender> sender);
+
+	/** Remove a message from the spool after it has been sent, or
+	  * failed permanently, or reschedule it.
+	  *
+	  * @param e message
+	  * @param err error, or NULL if the message has been sent
+	  * @param permanent true if the error is permanent
+	  */
+	void complete(const entry& e, const exception* err, const bool permanent);
+
+	void writeEnvelope(const entry& e);
+	bool readEnvelope(ref <utility::file> file, entry& e);
+	void removeFiles(const string& id);
+
+	const utility::file::path getDataPath(const string& id) const;
+	const utility::file::path getEnvelopePath(const string& id) const;
+	const utility::file::path getPath(const string& name) const;
+
+	static const string generateId();
+
+
+	utility::file::path m_dir;
+
+	unsigned long m_initialDelay;
+	unsigned long m_maxDelay;
+	int m_maxAttempts;
+
+	listener* m_listener;
+
+	ref <utility::sync::criticalSection> m_mutex;
+
+	std::map <string, entry> m_entries;            // by identifier, oldest first
+	std::map <string, destination> m_destinations;
+};
+
+
+} // smtp
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP && VMIME_HAVE_FILESYSTEM_FEATURES
+
+#endif // VMIME_NET_SMTP_SMTPSPOOL_HPP_INCLUDED
@@ -45,6 +45,7 @@
 #include "../vmime/utility/streamUtils.hpp"
 #include "../vmime/utility/outputStreamAdapter.hpp"
 #include "../vmime/utility/inputStreamStringAdapter.hpp"
+#include "../vmime/utility/outputStreamStringAdapter.hpp"
 
 
 namespace vmime {
@@ -53,7 +54,7 @@ namespace smtp {
 
 
 SMTPTransport::SMTPTransport(ref <session> sess, ref <security::authenticator> auth, const bool secured)
-	: transport(sess, getInfosInstance(), auth), m_isSMTPS(secured), m_needReset(false)
+	: transport(sess, getInfosInstance(), auth), m_isSMTPS(secured), m_needReset(false), m_endOfDataSent(false)
 {
 }
 
@@ -89,9 +90,6 @@ void SMTPTransport::connect()
 	if (isConnected())
 		throw exceptions::already_connected();
 
-    // Reset Cancel flag
-    platform::handler::setCancelFlag(false);
-
 	m_connection = vmime::create <SMTPConnection>
 		(thisRef().dynamicCast <SMTPTransport>(), getAuthenticator());
 
@@ -115,6 +113,12 @@ bool SMTPTransport::isConnected() const
 }
 
 
+bool SMTPTransport::isEndOfDataSent() const
+{
+	return m_endOfDataSent;
+}
+
+
 bool SMTPTransport::isSecuredConnection() const
 {
 	if (m_connection == NULL)
@@ -170,7 +174,7 @@ void SMTPTransport::noop()
 void SMTPTransport::sendEnvelope
 	(const mailbox& expeditor, const mailboxList& recipients,
 	 const mailbox& sender, bool sendDATACommand,
-	 const utility::stream::size_type size)
+	 const utility::stream::size_type size, const string& bodyType)
 {
 	// If no recipient/expeditor was found, throw an exception
 	if (recipients.isEmpty())
@@ -180,9 +184,7 @@ void SMTPTransport::sendEnvelope
 
 
 	const bool needReset = m_needReset;
-	const bool hasPipelining = m_connection->hasExtension("PIPELINING") &&
-		getInfos().getPropertyValue <bool>(getSession(),
-			dynamic_cast <const SMTPServiceInfos&>(getInfos()).getProperties().PROPERTY_OPTIONS_PIPELINING);
+	const bool hasPipelining = isPipeliningEnabled();
 
 	ref <SMTPResponse> resp;
 	ref <SMTPCommandSet> commands = SMTPCommandSet::create(hasPipelining);
@@ -196,9 +198,9 @@ void SMTPTransport::sendEnvelope
 	const bool hasSize = m_connection->hasExtension("SIZE");
 
 	if (!sender.isEmpty())
-		commands->addCommand(SMTPCommand::MAIL(sender, hasSMTPUTF8, hasSize ? size : 0));
+		commands->addCommand(SMTPCommand::MAIL(sender, hasSMTPUTF8, hasSize ? size : 0, bodyType));
 	else
-		commands->addCommand(SMTPCommand::MAIL(expeditor, hasSMTPUTF8, hasSize ? size : 0));
+		commands->addCommand(SMTPCommand::MAIL(expeditor, hasSMTPUTF8, hasSize ? size : 0, bodyType));
 
 	// Now, we will need to reset next time
 	m_needReset = true;
@@ -328,8 +330,20 @@ void SMTPTransport::send
 	if (!isConnected())
 		throw exceptions::not_connected();
 
+	m_endOfDataSent = false;
+
+	sendStream(expeditor, recipients, is, size, progress, sender, /* bodyType */ "");
+}
+
+
+void SMTPTransport::sendStream
+	(const mailbox& expeditor, const mailboxList& recipients,
+	 utility::inputStream& is, const utility::stream::size_type size,
+	 utility::progressListener* progress, const mailbox& sender,
+	 const string& bodyType)
+{
 	// Send message envelope
-	sendEnvelope(expeditor, recipients, sender, /* sendDATACommand */ true, size);
+	sendEnvelope(expeditor, recipients, sender, /* sendDATACommand */ true, size, bodyType);
 
     // FIX by Elmue: Added Console independent Trace
     #if VMIME_TRACE
@@ -346,6 +360,7 @@ void SMTPTransport::send
 	fos.flush();
 
 	// Send end-of-data delimiter
+	m_endOfDataSent = true;
 	m_connection->getSocket()->sendRaw("\r\n.\r\n", 5);
 
 	ref <SMTPResponse> resp;
@@ -367,17 +382,36 @@ void SMTPTransport::send
 	if (!isConnected())
 		throw exceptions::not_connected();
 
+	m_endOfDataSent = false;
+
 	// Generate the message with Internationalized Email support,
 	// if this is supported by the SMTP server
 	generationContext ctx(generationContext::getDefaultContext());
 	ctx.setInternationalizedEmailSupport(m_connection->hasExtension("SMTPUTF8"));
 
-	// If CHUNKING is not supported, generate the message to a temporary
-	// buffer then use the send() method which takes an inputStream
-	if (!m_connection->hasExtension("CHUNKING") ||
-	    !getInfos().getPropertyValue <bool>(getSession(),
-			dynamic_cast <const SMTPServiceInfos&>(getInfos()).getProperties().PROPERTY_OPTIONS_CHUNKING))
+	const bool chunking = m_connection->hasExtension("CHUNKING") &&
+		getInfos().getPropertyValue <bool>(getSession(),
+			dynamic_cast <const SMTPServiceInfos&>(getInfos()).getProperties().PROPERTY_OPTIONS_CHUNKING);
+
+	// If the server accepts binary data (RFC-3030, only with BDAT) or 8-bit
+	// data (RFC-6152), parts are not encoded more than needed for transport.
+	// The message itself is not modified.
+	string bodyType;
 
+	if (chunking && m_connection->hasExtension("BINARYMIME"))
+	{
+		ctx.setTransferEncodingSupport(generationContext::TRANSFER_BINARY);
+		bodyType = "BINARYMIME";
+	}
+	else if (m_connection->hasExtension("8BITMIME"))
+	{
+		ctx.setTransferEncodingSupport(generationContext::TRANSFER_8BIT);
+		bodyType = "8BITMIME";
+	}
+
+	// If CHUNKING is not supported, generate the message to a temporary
+	// buffer then send it with the DATA command
+	if (!chunking)
 	{
 		std::ostringstream oss;
 		utility::outputStreamAdapter ossAdapter(oss);
@@ -388,14 +422,14 @@ void SMTPTransport::send
 
 		utility::inputStreamStringAdapter isAdapter(str);
 
-		send(expeditor, recipients, isAdapter, str.length(), progress, sender);
+		sendStream(expeditor, recipients, isAdapter, str.length(), progress, sender, bodyType);
 		return;
 	}
 
     utility::stream::size_type size = msg->getGeneratedSize(ctx);
 
 	// Send message envelope
-	sendEnvelope(expeditor, recipients, sender, /* sendDATACommand */ false, size);
+	sendEnvelope(expeditor, recipients, sender, /* sendDATACommand */ false, size, bodyType);
 
     // FIX by Elmue: Added Console independent Trace
     #if VMIME_TRACE
@@ -407,11 +441,335 @@ void SMTPTransport::send
 
 	msg->generate(ctx, chunkStream);
 
+	// The last chunk is sent by flush()
+	m_endOfDataSent = true;
 	chunkStream.flush();
 }
 
 
 
+SMTPTransport::replyStatus::replyStatus()
+	: code(0)
+{
+}
+
+
+bool SMTPTransport::replyStatus::isSuccess() const
+{
+	return code >= 200 && code < 400;
+}
+
+
+SMTPTransport::messageResult::messageResult()
+	: sent(false)
+{
+}
+
+
+#ifndef VMIME_BUILDING_DOC
+
+static void SMTPTransport_setReplyStatus(SMTPTransport::replyStatus& status, ref <SMTPResponse> resp)
+{
+	status.code = resp->getCode();
+	status.enhancedCode = resp->getEnhancedCode();
+	status.text = resp->getText();
+}
+
+#endif // VMIME_BUILDING_DOC
+
+
+std::vector <SMTPTransport::messageResult> SMTPTransport::sendMessages
+	(const std::vector <messageJob>& jobs, utility::progressListener* progress)
+{
+	if (!isConnected())
+		throw exceptions::not_connected();
+
+	std::vector <messageResult> results(jobs.size());
+
+	const bool pipelining = isPipeliningEnabled();
+	const bool hasSMTPUTF8 = m_connection->hasExtension("SMTPUTF8");
+	const bool hasSize = m_connection->hasExtension("SIZE");
+	const bool has8BitMIME = m_connection->hasExtension("8BITMIME");
+
+	generationContext ctx(generationContext::getDefaultContext());
+	ctx.setInternationalizedEmailSupport(hasSMTPUTF8);
+
+	// Messages are sent with DATA: 8-bit data can be used, but not binary data
+	if (has8BitMIME)
+		ctx.setTransferEncodingSupport(generationContext::TRANSFER_8BIT);
+
+	ref <socket> sok = m_connection->getSocket();
+
+	const size_t noMessage = jobs.size();
+	size_t pending = noMessage;  // message whose end-of-data reply has not been read yet
+	string buffer;               // data waiting to be sent with the next commands
+
+	size_t current = 0;
+
+	if (progress)
+		progress->start(jobs.size());
+
+	try
+	{
+		for ( ; current < jobs.size() ; ++current)
+		{
+			const messageJob& job = jobs[current];
+			messageResult& result = results[current];
+
+			result.recipients.resize(job.recipients.getMailboxCount());
+
+			if (job.recipients.isEmpty() || job.expeditor.isEmpty())
+			{
+				result.status.text = job.recipients.isEmpty()
+					? exceptions::no_recipient().what() : exceptions::no_expeditor().what();
+
+				if (progress)
+					progress->progress(current + 1, jobs.size());
+
+				continue;
+			}
+
+			// Generate the message first, as its size is sent with MAIL
+			string data;
+			utility::outputStreamStringAdapter dataStream(data);
+
+			job.msg->generate(ctx, dataStream);
+
+			// Commands of the transaction: [RSET] MAIL RCPT... DATA
+			std::vector <ref <SMTPCommand> > commands;
+
+			if (m_needReset)
+				commands.push_back(SMTPCommand::RSET());
+
+			const size_t mailIndex = commands.size();
+
+			commands.push_back(SMTPCommand::MAIL(job.sender.isEmpty() ? job.expeditor : job.sender,
+				hasSMTPUTF8, hasSize ? data.length() : 0, has8BitMIME ? "8BITMIME" : ""));
+
+			for (size_t i = 0 ; i < job.recipients.getMailboxCount() ; ++i)
+				commands.push_back(SMTPCommand::RCPT(*job.recipients.getMailboxAt(i), hasSMTPUTF8));
+
+			commands.push_back(SMTPCommand::DATA());
+
+			// With pipelining, send all the commands in a single write, after
+			// the end of the data of the previous message
+			if (pipelining)
+			{
+				for (std::vector <ref <SMTPCommand> >::const_iterator it = commands.begin() ;
+				     it != commands.end() ; ++it)
+				{
+				    #if VMIME_TRACE
+				        TRACE("SMTP send > \"%s\"", (*it)->getText().c_str());
+				    #endif
+
+					buffer += (*it)->getText();
+					buffer += "\r\n";
+				}
+
+				sok->send(buffer);
+				buffer.clear();
+
+				if (pending != noMessage)
+				{
+					ref <SMTPResponse> resp = m_connection->readResponse();
+
+					SMTPTransport_setReplyStatus(results[pending].status, resp);
+					results[pending].sent = (resp->getCode() == 250);
+
+					pending = noMessage;
+
+					if (resp->getCode() == 421)
+						throw SMTPCommandError("DATA", resp->getText(), resp->getCode(), resp->getEnhancedCode());
+				}
+			}
+
+			// Read the replies; without pipelining, each command is sent
+			// after the reply to the previous one has been read
+			size_t accepted = 0;
+			bool aborted = false;
+			bool dataAccepted = false;
+
+			for (size_t i = 0 ; i < commands.size() ; ++i)
+			{
+				const bool isRCPT = (i > mailIndex && i + 1 < commands.size());
+
+				if (!pipelining)
+				{
+					if (aborted || (i + 1 == commands.size() && accepted == 0))
+						break;
+
+					commands[i]->writeToSocket(sok);
+				}
+
+				ref <SMTPResponse> resp = m_connection->readResponse();
+
+				if (resp->getCode() == 421)
+				{
+					SMTPTransport_setReplyStatus(result.status, resp);
+					throw SMTPCommandError(commands[i]->getText(), resp->getText(), resp->getCode(), resp->getEnhancedCode());
+				}
+
+				if (i < mailIndex)  // RSET
+				{
+					if (resp->getCode() != 250)
+						throw SMTPCommandError(commands[i]->getText(), resp->getText(), resp->getCode(), resp->getEnhancedCode());
+
+					m_needReset = false;
+				}
+				else if (i == mailIndex)  // MAIL
+				{
+					SMTPTransport_setReplyStatus(result.status, resp);
+
+					m_needReset = true;
+
+					if (resp->getCode() != 250)
+						aborted = true;
+				}
+				else if (isRCPT)
+				{
+					replyStatus& rcptStatus = result.recipients[i - mailIndex - 1];
+					SMTPTransport_setReplyStatus(rcptStatus, resp);
+
+					if (resp->getCode() == 250 || resp->getCode() == 251)
+						++accepted;
+					else if (accepted == 0 && !aborted)
+						result.status = rcptStatus;
+				}
+				else  // DATA
+				{
+					if (resp->getCode() == 354)
+					{
+						dataAccepted = true;
+					}
+					else if (!aborted && accepted != 0)
+					{
+						SMTPTransport_setReplyStatus(result.status, resp);
+						aborted = true;
+					}
+				}
+			}
+
+			if (accepted == 0)
+				aborted = true;
+
+			if (dataAccepted && aborted)
+			{
+				// The server accepted DATA although the transaction failed:
+				// send an empty message, which will be rejected
+				sok->sendRaw(".\r\n", 3);
+
+				ref <SMTPResponse> resp = m_connection->readResponse();
+
+				if (resp->getCode() == 421)
+				{
+					SMTPTransport_setReplyStatus(result.status, resp);
+					throw SMTPCommandError("DATA", resp->getText(), resp->getCode(), resp->getEnhancedCode());
+				}
+
+				// Keep the reason of the failure, if it is known
+				if (result.status.code == 0 || result.status.isSuccess())
+					SMTPTransport_setReplyStatus(result.status, resp);
+			}
+			else if (dataAccepted)
+			{
+			    #if VMIME_TRACE
+			        TRACE("SMTP send > {Message Data} (%d Bytes)", data.length());
+			    #endif
+
+				// Send the message data, with "\n." to "\n.." transformation
+				utility::outputStreamSocketAdapter sos(*sok);
+				utility::dotFilteredOutputStream fos(sos);
+
+				fos.write(data.data(), data.length());
+				fos.flush();
+
+				// The end-of-data delimiter is sent with the next commands
+				buffer = "\r\n.\r\n";
+
+				if (pipelining && current + 1 < jobs.size())
+				{
+					pending = current;
+				}
+				else
+				{
+					sok->send(buffer);
+					buffer.clear();
+
+					ref <SMTPResponse> resp = m_connection->readResponse();
+
+					SMTPTransport_setReplyStatus(result.status, resp);
+					result.sent = (resp->getCode() == 250);
+
+					if (resp->getCode() == 421)
+						throw SMTPCommandError("DATA", resp->getText(), resp->getCode(), resp->getEnhancedCode());
+				}
+
+				// The transaction is complete: no need to reset
+				m_needReset = false;
+			}
+
+			if (progress)
+				progress->progress(current + 1, jobs.size());
+		}
+
+		// The last messages were not valid: send the end of the data
+		if (pending != noMessage)
+		{
+			sok->send(buffer);
+			buffer.clear();
+
+			ref <SMTPResponse> resp = m_connection->readResponse();
+
+			SMTPTransport_setReplyStatus(results[pending].status, resp);
+			results[pending].sent = (resp->getCode() == 250);
+
+			pending = noMessage;
+		}
+	}
+	catch (vmime::exception& e)
+	{
+		// The connection cannot be used anymore: report the error for the
+		// messages whose result is not known
+		try
+		{
+			disconnect();
+		}
+		catch (vmime::exception&)
+		{
+			// Ignore
+		}
+
+		if (pending != noMessage)
+		{
+			results[pending].status = replyStatus();
+			results[pending].status.text = e.what();
+		}
+
+		for (size_t i = current ; i < jobs.size() ; ++i)
+		{
+			if (!results[i].sent && (results[i].status.code == 0 || results[i].status.isSuccess()))
+			{
+				results[i].status = replyStatus();
+				results[i].status.text = e.what();
+			}
+		}
+	}
+
+	if (progress)
+		progress->stop(jobs.size());
+
+	return results;
+}
+
+
+bool SMTPTransport::isPipeliningEnabled()
+{
+	return m_connection->hasExtension("PIPELINING") &&
+		getInfos().getPropertyValue <bool>(getSession(),
+			dynamic_cast <const SMTPServiceInfos&>(getInfos()).getProperties().PROPERTY_OPTIONS_PIPELINING);
+}
+
+
 // Service infos
 
 SMTPServiceInfos SMTPTransport::sm_infos(false);
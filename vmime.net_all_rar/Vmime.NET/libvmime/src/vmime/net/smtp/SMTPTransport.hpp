@@ -37,6 +37,13 @@
 
 #include "../vmime/net/smtp/SMTPServiceInfos.hpp"
 #include "../vmime/net/smtp/SMTPConnection.hpp"
+#include "../vmime/net/smtp/SMTPResponse.hpp"
+
+#include "../vmime/mailbox.hpp"
+#include "../vmime/mailboxList.hpp"
+#include "../vmime/message.hpp"
+
+#include <vector>
 
 
 namespace vmime {
@@ -83,6 +90,81 @@ public:
 		 utility::progressListener* progress = NULL,
 		 const mailbox& sender = mailbox());
 
+	/** A message to send with sendMessages().
+	  */
+	class messageJob
+	{
+	public:
+
+		ref <vmime::message> msg;   /**< message to send */
+		mailbox expeditor;          /**< expeditor mailbox */
+		mailboxList recipients;     /**< recipient mailboxes */
+		mailbox sender;             /**< envelope sender (if empty, expeditor will be used) */
+	};
+
+	/** Reply of the server to a command.
+	  */
+	class replyStatus
+	{
+	public:
+
+		replyStatus();
+
+		/** Tests whether the reply is a positive one (2xx or 3xx).
+		  *
+		  * @return true if the command succeeded, false otherwise
+		  */
+		bool isSuccess() const;
+
+		int code;                                     /**< reply code, or zero if no reply was received */
+		SMTPResponse::enhancedStatusCode enhancedCode; /**< enhanced status code (RFC-3463), if any */
+		string text;                                  /**< reply text, or error message */
+	};
+
+	/** Result of sendMessages() for a message.
+	  */
+	class messageResult
+	{
+	public:
+
+		messageResult();
+
+		bool sent;                              /**< true if the message was accepted by the server */
+		replyStatus status;                     /**< reply which ended the transaction */
+		std::vector <replyStatus> recipients;   /**< reply to "RCPT" for each recipient */
+	};
+
+	/** Send several messages on this connection. When the server supports
+	  * pipelining, the commands of a transaction are sent in a single write
+	  * together with the end of the data of the previous message, without
+	  * waiting for the replies.
+	  *
+	  * Unlike send(), an error does not end the connection: a message is
+	  * sent to the recipients which have been accepted even if some others
+	  * were rejected, and a rejected message does not prevent the next ones
+	  * from being sent. The connection is only closed if it cannot be used
+	  * anymore (eg. network error or 421 reply); in this case, the messages
+	  * which could not be sent have a status code of zero.
+	  *
+	  * @param jobs messages to send
+	  * @param progress progress listener, notified after each message,
+	  * or NULL if not used
+	  * @return result of each message, in the same order as the jobs
+	  * @throw exceptions::not_connected if the transport is not connected
+	  */
+	std::vector <messageResult> sendMessages(const std::vector <messageJob>& jobs,
+		utility::progressListener* progress = NULL);
+
+	/** Tests whether the end of the data of the last message passed
+	  * to send() has been sent to the server (end-of-data marker, or
+	  * last BDAT chunk). If send() fails after this point, the server
+	  * may have accepted the message without the reply being received,
+	  * so the message must not be sent again.
+	  *
+	  * @return true if the end of the message data has been sent
+	  */
+	bool isEndOfDataSent() const;
+
 	bool isSecuredConnection() const;
 	ref <connectionInfos> getConnectionInfos() const;
 	ref <SMTPConnection> getConnection();
@@ -100,13 +182,38 @@ private:
 	  * @param sender envelope sender (if empty, expeditor will be used)
 	  * @param sendDATACommand if true, the DATA command will be sent
 	  * @param size message size, in bytes (or 0, if not known)
+	  * @param bodyType value of the BODY parameter of the MAIL command
+	  * ("8BITMIME" or "BINARYMIME"), or empty if not needed
 	  */
 	void sendEnvelope
 		(const mailbox& expeditor,
 		 const mailboxList& recipients,
 		 const mailbox& sender,
 		 bool sendDATACommand,
-		 const utility::stream::size_type size);
+		 const utility::stream::size_type size,
+		 const string& bodyType = "");
+
+	/** Send a message over the connection, using the DATA command.
+	  * See send() for the parameters.
+	  *
+	  * @param bodyType value of the BODY parameter of the MAIL command
+	  * ("8BITMIME"), or empty if not needed
+	  */
+	void sendStream
+		(const mailbox& expeditor,
+		 const mailboxList& recipients,
+		 utility::inputStream& is,
+		 const utility::stream::size_type size,
+		 utility::progressListener* progress,
+		 const mailbox& sender,
+		 const string& bodyType);
+
+	/** Tests whether commands can be pipelined: the server supports it,
+	  * and it is enabled in the session properties.
+	  *
+	  * @return true if pipelining can be used, false otherwise
+	  */
+	bool isPipeliningEnabled();
 
 
 	ref <SMTPConnection> m_connection;
@@ -115,6 +222,7 @@ private:
 	const bool m_isSMTPS;
 
 	bool m_needReset;
+	bool m_endOfDataSent;
 
 	// Service infos
 	static SMTPServiceInfos sm_infos;
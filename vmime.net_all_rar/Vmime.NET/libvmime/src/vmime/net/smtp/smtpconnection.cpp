@@ -103,6 +103,7 @@ void SMTPConnection::connect()
 
 	// Create and connect the socket
 	m_socket = transport->getSocketFactory()->create(m_timeoutHandler);
+	m_socket->setCancellationToken(transport->getCancellationToken());
 
 #if VMIME_HAVE_TLS_SUPPORT
 	if (transport->isSMTPS())  // dedicated port/SMTPS
@@ -525,6 +526,7 @@ void SMTPConnection::startTLS()
 		ref <tls::TLSSocket> tlsSocket =
 			tlsSession->getSocket(m_socket);
 
+		tlsSocket->setServerName(m_cntInfos->getHost());
 		tlsSocket->handshake(m_timeoutHandler);
 
 		// FIX by Elmue: Added Trace output
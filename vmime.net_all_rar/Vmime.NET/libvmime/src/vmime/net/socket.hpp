@@ -35,6 +35,8 @@
 
 #include "../vmime/net/timeoutHandler.hpp"
 
+#include "../vmime/utility/cancellationToken.hpp"
+
 
 namespace vmime {
 namespace net {
@@ -92,6 +94,18 @@ public:
 	  */
 	virtual size_type receiveRaw(char* buffer, const size_type count) = 0;
 
+	/** Wait until data can be read from the socket, or the specified
+	  * delay is elapsed. This returns as soon as data arrives, so that
+	  * protocol readers block on it instead of sleeping between calls
+	  * to receive().
+	  *
+	  * @param msecs maximum time to wait, in milliseconds
+	  * @return true if data can be read, or false if the delay is elapsed
+	  * @throw exceptions::operation_cancelled if the cancellation token
+	  * of this socket is cancelled while waiting
+	  */
+	virtual bool waitForReadable(const unsigned int msecs) = 0;
+
 	/** Send (text) data to the socket.
 	  *
 	  * @param buffer data to send
@@ -139,6 +153,43 @@ public:
 	  */
 	virtual const string getPeerAddress() const = 0;
 
+	/** Return the port of peer this socket is connected to.
+	  *
+	  * @return port of the peer, or 0 if not connected
+	  */
+	virtual port_t getPeerPort() const = 0;
+
+	/** Set the token which cancels the operations on this socket. When
+	  * cancellation is requested, waits for network data are interrupted
+	  * and exceptions::operation_cancelled is thrown.
+	  *
+	  * @param token cancellation token, or NULL
+	  */
+	virtual void setCancellationToken(ref <utility::cancellationToken> token) = 0;
+
+	/** Return the token which cancels the operations on this socket.
+	  *
+	  * @return cancellation token, or NULL if none is set
+	  */
+	virtual ref <utility::cancellationToken> getCancellationToken() const = 0;
+
+	/** Test whether data has already been received from the network
+	  * and can be read without waiting (for example, decrypted TLS
+	  * records). Such data is not reported by the operating system
+	  * when it is asked whether the connection is readable.
+	  *
+	  * @return true if receiveRaw() will return data immediately
+	  */
+	virtual bool hasBufferedData() const = 0;
+
+	/** Return the socket this socket is layered on (for example,
+	  * a TLS socket is layered on a TCP socket).
+	  *
+	  * @return underlying socket, or NULL if this socket directly
+	  * talks to the network
+	  */
+	virtual ref <socket> getUnderlyingSocket() const = 0;
+
 protected:
 
 	socket() { }
@@ -0,0 +1,116 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_SOCKETPOLLER_HPP_INCLUDED
+#define VMIME_NET_SOCKETPOLLER_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+
+#include "../vmime/base.hpp"
+
+#include "../vmime/net/socket.hpp"
+
+#include "../vmime/utility/cancellationToken.hpp"
+
+#include <vector>
+
+
+namespace vmime {
+namespace net {
+
+
+/** Waits for data on many sockets at once, so that a single thread can
+  * watch a large number of connections and only serve those which have
+  * received data from the server.
+  */
+
+class VMIME_EXPORT socketPoller : public object
+{
+public:
+
+	virtual ~socketPoller() { }
+
+	/** Add a socket to the set of watched sockets. Sockets layered on
+	  * other sockets (TLS, SASL) are accepted. Sockets which were not
+	  * created by the socket factory of this platform are only reported
+	  * when socket::hasBufferedData() returns true.
+	  *
+	  * @param sok socket to watch
+	  */
+	virtual void addSocket(ref <socket> sok) = 0;
+
+	/** Remove a socket from the set of watched sockets.
+	  *
+	  * @param sok socket to remove
+	  */
+	virtual void removeSocket(ref <socket> sok) = 0;
+
+	/** Return the number of watched sockets.
+	  *
+	  * @return number of sockets
+	  */
+	virtual size_t getSocketCount() const = 0;
+
+	/** Wait until at least one of the watched sockets has data to read,
+	  * or the specified delay is elapsed.
+	  *
+	  * @param msecs maximum time to wait, in milliseconds
+	  * @param readySockets receives the sockets which have data to read
+	  * @return number of sockets which have data to read
+	  * @throw exceptions::operation_cancelled if the cancellation token
+	  * of this poller is cancelled while waiting
+	  */
+	virtual size_t waitForReadable
+		(const unsigned int msecs, std::vector <ref <socket> >& readySockets) = 0;
+
+	/** Set the token which interrupts waits on this poller. Cancelling
+	  * it from another thread wakes up the polling thread immediately.
+	  *
+	  * @param token cancellation token, or NULL
+	  */
+	virtual void setCancellationToken(ref <utility::cancellationToken> token) = 0;
+
+	/** Return the token which interrupts waits on this poller.
+	  *
+	  * @return cancellation token, or NULL if none is set
+	  */
+	virtual ref <utility::cancellationToken> getCancellationToken() const = 0;
+
+protected:
+
+	socketPoller() { }
+};
+
+
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+
+#endif // VMIME_NET_SOCKETPOLLER_HPP_INCLUDED
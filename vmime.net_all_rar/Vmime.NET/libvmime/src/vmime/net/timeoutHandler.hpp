@@ -65,6 +65,18 @@ public:
 	  */
 	virtual bool handleTimeOut() = 0;
 
+	/** Return the time left until the time-out delay is elapsed, so
+	  * that callers can block on the network until this deadline. The
+	  * default implementation makes callers wake up every second to
+	  * call isTimeOut().
+	  *
+	  * @return remaining time, in milliseconds
+	  */
+	virtual unsigned int getRemainingTime()
+	{
+		return isTimeOut() ? 0 : 1000;
+	}
+
     // FIX by Elmue: Added the possibility to modify the timeout interval.
     // This may be used to reduce the timeout for example for the SMTP command QUIT 
     // that is not responded by the Microsoft Exchange Server after a 554 error (Transaction failed).
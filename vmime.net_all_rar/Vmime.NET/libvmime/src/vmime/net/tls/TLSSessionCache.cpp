@@ -0,0 +1,260 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
+
+
+#include "../vmime/net/tls/TLSSessionCache.hpp"
+
+#include "../vmime/utility/smartPtrInt.hpp"
+#include "../vmime/utility/stringUtils.hpp"
+#include "../vmime/utility/sync/autoLock.hpp"
+
+#include "../vmime/platform.hpp"
+
+#include <sstream>
+
+
+namespace vmime {
+namespace net {
+namespace tls {
+
+
+#ifndef VMIME_BUILDING_DOC
+
+// The cache is created on first use, as it needs the platform handler,
+// which is not set yet when the library is loaded
+static utility::refCounter TLSSessionCache_creating(0);
+static utility::refCounter TLSSessionCache_created(0);
+
+static ref <TLSSessionCache> TLSSessionCache_instance;
+
+#endif // VMIME_BUILDING_DOC
+
+
+// static
+ref <TLSSessionCache> TLSSessionCache::getInstance()
+{
+	if (TLSSessionCache_created == 0)
+	{
+		// The first thread creates the cache, the others wait for it
+		if (TLSSessionCache_creating.increment() == 1)
+		{
+			TLSSessionCache_instance = vmime::create <TLSSessionCache>();
+			TLSSessionCache_created.increment();
+		}
+		else
+		{
+			while (TLSSessionCache_created == 0)
+				platform::getHandler()->wait();
+		}
+	}
+
+	return TLSSessionCache_instance;
+}
+
+
+TLSSessionCache::TLSSessionCache()
+	: m_capacity(256), m_lifetime(300), m_hits(0), m_misses(0)
+{
+	m_mutex = platform::getHandler()->createCriticalSection();
+}
+
+
+void TLSSessionCache::setCapacity(const size_t count)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	m_capacity = count;
+	trim();
+}
+
+
+size_t TLSSessionCache::getCapacity() const
+{
+	return m_capacity;
+}
+
+
+void TLSSessionCache::setLifetime(const unsigned long seconds)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	m_lifetime = seconds;
+}
+
+
+unsigned long TLSSessionCache::getLifetime() const
+{
+	return m_lifetime;
+}
+
+
+unsigned long TLSSessionCache::getHitCount() const
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	return m_hits;
+}
+
+
+unsigned long TLSSessionCache::getMissCount() const
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	return m_misses;
+}
+
+
+size_t TLSSessionCache::getSize() const
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+	return m_entries.size();
+}
+
+
+void TLSSessionCache::clear()
+{
+	entryList entries;
+
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		entries.swap(m_entries);
+		m_index.clear();
+	}
+
+	// Sessions are released outside of the lock
+}
+
+
+ref <TLSSessionCache::session> TLSSessionCache::find(const string& key)
+{
+	ref <session> expired;  // released outside of the lock
+
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	std::map <string, entryList::iterator>::iterator it = m_index.find(key);
+
+	if (it == m_index.end())
+	{
+		++m_misses;
+		return NULL;
+	}
+
+	entryList::iterator eit = (*it).second;
+
+	if ((*eit).expires <= platform::getHandler()->getUnixTime())
+	{
+		expired = (*eit).sess;
+
+		m_entries.erase(eit);
+		m_index.erase(it);
+
+		++m_misses;
+		return NULL;
+	}
+
+	// Move the entry to the front
+	m_entries.splice(m_entries.begin(), m_entries, eit);
+
+	++m_hits;
+
+	return (*eit).sess;
+}
+
+
+void TLSSessionCache::store(const string& key, ref <session> sess)
+{
+	entryList removed;  // released outside of the lock
+
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	if (m_capacity == 0)
+		return;
+
+	std::map <string, entryList::iterator>::iterator it = m_index.find(key);
+
+	if (it != m_index.end())
+	{
+		removed.splice(removed.begin(), m_entries, (*it).second);
+		m_index.erase(it);
+	}
+
+	entry e;
+	e.key = key;
+	e.sess = sess;
+	e.expires = platform::getHandler()->getUnixTime() + m_lifetime;
+
+	m_entries.push_front(e);
+	m_index[key] = m_entries.begin();
+
+	trim();
+}
+
+
+void TLSSessionCache::remove(const string& key)
+{
+	entryList removed;  // released outside of the lock
+
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	std::map <string, entryList::iterator>::iterator it = m_index.find(key);
+
+	if (it != m_index.end())
+	{
+		removed.splice(removed.begin(), m_entries, (*it).second);
+		m_index.erase(it);
+	}
+}
+
+
+void TLSSessionCache::trim()
+{
+	// Drop the least recently used sessions
+	while (m_entries.size() > m_capacity)
+	{
+		m_index.erase(m_entries.back().key);
+		m_entries.pop_back();
+	}
+}
+
+
+// static
+const string TLSSessionCache::makeKey(const string& host, const port_t port)
+{
+	std::ostringstream oss;
+	oss.imbue(std::locale::classic());
+
+	oss << utility::stringUtils::toLower(host) << ':' << port;
+
+	return oss.str();
+}
+
+
+} // tls
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
@@ -0,0 +1,190 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_TLS_TLSSESSIONCACHE_HPP_INCLUDED
+#define VMIME_NET_TLS_TLSSESSIONCACHE_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
+
+
+#include <list>
+#include <map>
+
+#include "../vmime/types.hpp"
+
+#include "../vmime/utility/sync/criticalSection.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace tls {
+
+
+/** Process-wide cache of TLS sessions, used to resume a session
+  * (with its session ID or session ticket) when connecting again
+  * to the same server, instead of making a full handshake.
+  *
+  * The cache is used automatically by TLS sockets: sessions are
+  * stored after a successful handshake, and looked up by server
+  * name and port before the next one. It can be used from several
+  * threads at the same time.
+  */
+class VMIME_EXPORT TLSSessionCache : public object
+{
+	friend class vmime::creator;
+
+public:
+
+	/** Session data stored in the cache. The contents are specific
+	  * to the TLS library.
+	  */
+	class VMIME_EXPORT session : public object
+	{
+	public:
+
+		virtual ~session() { }
+	};
+
+
+	/** Return the cache shared by all TLS connections. It is
+	  * created on the first call.
+	  *
+	  * @return TLS session cache
+	  */
+	static ref <TLSSessionCache> getInstance();
+
+	/** Set the maximum number of sessions kept in the cache. When
+	  * the cache is full, the least recently used session is dropped.
+	  * The default is 256. Zero disables the cache.
+	  *
+	  * @param count maximum number of sessions
+	  */
+	void setCapacity(const size_t count);
+
+	size_t getCapacity() const;
+
+	/** Set the time after which a session is not resumed anymore.
+	  * The default is 300 seconds.
+	  *
+	  * @param seconds lifetime of a session, in seconds
+	  */
+	void setLifetime(const unsigned long seconds);
+
+	unsigned long getLifetime() const;
+
+	/** Return the number of lookups which found a session.
+	  *
+	  * @return number of cache hits
+	  */
+	unsigned long getHitCount() const;
+
+	/** Return the number of lookups which did not find a session
+	  * (or found an expired one).
+	  *
+	  * @return number of cache misses
+	  */
+	unsigned long getMissCount() const;
+
+	/** Return the number of sessions currently in the cache.
+	  *
+	  * @return number of sessions
+	  */
+	size_t getSize() const;
+
+	/** Remove all the sessions from the cache.
+	  */
+	void clear();
+
+	/** Find the session stored for a server.
+	  *
+	  * @param key server identifier
+	  * @return session, or NULL if there is no valid session
+	  */
+	ref <session> find(const string& key);
+
+	/** Store the session negotiated with a server, replacing any
+	  * previous session for this server.
+	  *
+	  * @param key server identifier
+	  * @param sess session
+	  */
+	void store(const string& key, ref <session> sess);
+
+	/** Remove the session stored for a server, for example when it
+	  * could not be resumed.
+	  *
+	  * @param key server identifier
+	  */
+	void remove(const string& key);
+
+	/** Build the key identifying a server in the cache.
+	  *
+	  * @param host name of the server (as used for Server Name Indication)
+	  * @param port port of the server
+	  * @return key
+	  */
+	static const string makeKey(const string& host, const port_t port);
+
+private:
+
+	TLSSessionCache();
+
+	class entry
+	{
+	public:
+
+		string key;
+		ref <session> sess;
+		unsigned long expires;  /**< time after which the session is not used */
+	};
+
+	typedef std::list <entry> entryList;
+
+	void trim();
+
+
+	ref <utility::sync::criticalSection> m_mutex;
+
+	entryList m_entries;  // most recently used first
+	std::map <string, entryList::iterator> m_index;
+
+	size_t m_capacity;
+	unsigned long m_lifetime;
+
+	unsigned long m_hits;
+	unsigned long m_misses;
+};
+
+
+} // tls
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
+
+#endif // VMIME_NET_TLS_TLSSESSIONCACHE_HPP_INCLUDED
@@ -69,6 +69,24 @@ public:
 	  */
 	virtual void handshake(ref <timeoutHandler> toHandler = NULL) = 0;
 
+	/** Set the name of the server, as requested by the user. It is sent
+	  * to the server (Server Name Indication), checked against the server
+	  * certificate, and identifies the server in the TLS session cache.
+	  * It is set by connect(); when the wrapped socket is already
+	  * connected (STARTTLS), it must be set before calling handshake().
+	  *
+	  * @param name server name (host name or numeric address)
+	  */
+	virtual void setServerName(const string& name) = 0;
+
+	/** Return the name of the server, as set by connect() or
+	  * setServerName().
+	  *
+	  * @return server name, or the numeric address of the peer if
+	  * no name has been set
+	  */
+	virtual const string getServerName() const = 0;
+
 	/** Return the peer's certificate (chain) as sent by the peer.
 	  *
 	  * @return server certificate chain, or NULL if the handshake
@@ -32,6 +32,7 @@
 
 #include "../vmime/net/tls/gnutls/TLSSocket_GnuTLS.hpp"
 #include "../vmime/net/tls/gnutls/TLSSession_GnuTLS.hpp"
+#include "../vmime/net/tls/TLSSessionCache.hpp"
 
 #include "../vmime/platform.hpp"
 
@@ -43,6 +44,31 @@ namespace net {
 namespace tls {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+// GnuTLS session data stored in the TLS session cache
+class TLSSocket_GnuTLS_cachedSession : public TLSSessionCache::session
+{
+public:
+
+	TLSSocket_GnuTLS_cachedSession(const gnutls_datum& data)
+		: m_data(reinterpret_cast <const char*>(data.data), data.size)
+	{
+	}
+
+	const string& getData() const
+	{
+		return m_data;
+	}
+
+private:
+
+	string m_data;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 // static
 ref <TLSSocket> TLSSocket::wrap(ref <TLSSession> session, ref <socket> sok)
 {
@@ -83,6 +109,8 @@ TLSSocket_GnuTLS::~TLSSocket_GnuTLS()
 
 void TLSSocket_GnuTLS::connect(const string& address, const port_t port)
 {
+	m_serverName = address;
+
 	m_wrapped->connect(address, port);
 
 	handshake(NULL);
@@ -116,6 +144,21 @@ TLSSocket::size_type TLSSocket_GnuTLS::getBlockSize() const
 }
 
 
+void TLSSocket_GnuTLS::setServerName(const string& name)
+{
+	m_serverName = name;
+}
+
+
+const string TLSSocket_GnuTLS::getServerName() const
+{
+	if (m_serverName.empty())
+		return m_wrapped->getPeerAddress();
+
+	return m_serverName;
+}
+
+
 const string TLSSocket_GnuTLS::getPeerName() const
 {
 	return m_wrapped->getPeerName();
@@ -128,10 +171,41 @@ const string TLSSocket_GnuTLS::getPeerAddress() const
 }
 
 
+port_t TLSSocket_GnuTLS::getPeerPort() const
+{
+	return m_wrapped->getPeerPort();
+}
+
+
+void TLSSocket_GnuTLS::setCancellationToken(ref <utility::cancellationToken> token)
+{
+	m_wrapped->setCancellationToken(token);
+}
+
+
+ref <utility::cancellationToken> TLSSocket_GnuTLS::getCancellationToken() const
+{
+	return m_wrapped->getCancellationToken();
+}
+
+
+bool TLSSocket_GnuTLS::hasBufferedData() const
+{
+	return gnutls_record_check_pending(*m_session->m_gnutlsSession) > 0 ||
+	       m_wrapped->hasBufferedData();
+}
+
+
+ref <socket> TLSSocket_GnuTLS::getUnderlyingSocket() const
+{
+	return m_wrapped;
+}
+
+
 void TLSSocket_GnuTLS::receive(string& buffer)
 {
 	const int size = receiveRaw(m_buffer, sizeof(m_buffer));
-	buffer = vmime::string(m_buffer, size);
+	buffer.assign(m_buffer, size);
 }
 
 
@@ -167,6 +241,16 @@ TLSSocket::size_type TLSSocket_GnuTLS::receiveRaw(char* buffer, const size_type
 }
 
 
+bool TLSSocket_GnuTLS::waitForReadable(const unsigned int msecs)
+{
+	// Data may already be available without reading from the network
+	if (hasBufferedData())
+		return true;
+
+	return m_wrapped->waitForReadable(msecs);
+}
+
+
 void TLSSocket_GnuTLS::sendRaw(const char* buffer, const size_type count)
 {
 	m_status &= ~STATUS_WOULDBLOCK;
@@ -234,6 +318,20 @@ void TLSSocket_GnuTLS::handshake(ref <timeoutHandler> toHandler)
 	if (toHandler)
 		toHandler->resetTimeOut();
 
+	// Resume the last session negotiated with this server, if any:
+	// this saves the key exchange and a round trip
+	ref <TLSSessionCache> cache = TLSSessionCache::getInstance();
+	const string cacheKey = TLSSessionCache::makeKey(getServerName(), getPeerPort());
+
+	ref <TLSSocket_GnuTLS_cachedSession> cachedSession =
+		cache->find(cacheKey).dynamicCast <TLSSocket_GnuTLS_cachedSession>();
+
+	if (cachedSession)
+	{
+		gnutls_session_set_data(*m_session->m_gnutlsSession,
+			cachedSession->getData().data(), cachedSession->getData().length());
+	}
+
 	// Start handshaking process
 	m_handshaking = true;
 	m_toHandler = toHandler;
@@ -269,6 +367,10 @@ void TLSSocket_GnuTLS::handshake(ref <timeoutHandler> toHandler)
 	}
 	catch (...)
 	{
+		// Do not try to resume the session again
+		if (cachedSession)
+			cache->remove(cacheKey);
+
 		m_handshaking = false;
 		m_toHandler = NULL;
 
@@ -278,13 +380,33 @@ void TLSSocket_GnuTLS::handshake(ref <timeoutHandler> toHandler)
 	m_handshaking = false;
 	m_toHandler = NULL;
 
-	// Verify server's certificate(s)
-	ref <security::cert::certificateChain> certs = getPeerCertificates();
+	// Verify server's certificate(s), also when the session is resumed
+	try
+	{
+		ref <security::cert::certificateChain> certs = getPeerCertificates();
+
+		if (certs == NULL)
+			throw exceptions::tls_exception("No peer certificate.");
+
+		m_session->getCertificateVerifier()->verify(certs, getServerName());
+	}
+	catch (...)
+	{
+		cache->remove(cacheKey);
+		throw;
+	}
 
-	if (certs == NULL)
-		throw exceptions::tls_exception("No peer certificate.");
+	// Keep the new session for the next connection to this server
+	if (!gnutls_session_is_resumed(*m_session->m_gnutlsSession))
+	{
+		gnutls_datum data;
 
-	m_session->getCertificateVerifier()->verify(certs, getPeerName());
+		if (gnutls_session_get_data2(*m_session->m_gnutlsSession, &data) == GNUTLS_E_SUCCESS)
+		{
+			cache->store(cacheKey, vmime::create <TLSSocket_GnuTLS_cachedSession>(data));
+			gnutls_free(data.data);
+		}
+	}
 
 	m_connected = true;
 }
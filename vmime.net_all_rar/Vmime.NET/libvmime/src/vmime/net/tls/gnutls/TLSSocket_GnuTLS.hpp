@@ -58,6 +58,9 @@ public:
 
 	void handshake(ref <timeoutHandler> toHandler = NULL);
 
+	void setServerName(const string& name);
+	const string getServerName() const;
+
 	ref <security::cert::certificateChain> getPeerCertificates() const;
 
 	// Implementation of 'socket'
@@ -68,6 +71,8 @@ public:
 	void receive(string& buffer);
 	size_type receiveRaw(char* buffer, const size_type count);
 
+	bool waitForReadable(const unsigned int msecs);
+
 	void send(const string& buffer);
 	void sendRaw(const char* buffer, const size_type count);
 	size_type sendRawNonBlocking(const char* buffer, const size_type count);
@@ -78,6 +83,13 @@ public:
 
 	const string getPeerName() const;
 	const string getPeerAddress() const;
+	port_t getPeerPort() const;
+
+	void setCancellationToken(ref <utility::cancellationToken> token);
+	ref <utility::cancellationToken> getCancellationToken() const;
+
+	bool hasBufferedData() const;
+	ref <socket> getUnderlyingSocket() const;
 
 private:
 
@@ -95,6 +107,8 @@ private:
 	ref <TLSSession_GnuTLS> m_session;
 	ref <socket> m_wrapped;
 
+	string m_serverName;
+
 	bool m_connected;
 
 	char m_buffer[65536];
@@ -31,11 +31,16 @@
 #include "../vmime/net/tls/openssl/TLSProperties_OpenSSL.hpp"
 #include "../vmime/net/tls/openssl/OpenSSLInitializer.hpp"
 
+#include "../vmime/utility/sync/autoLock.hpp"
+
 #include "../vmime/exception.hpp"
+#include "../vmime/platform.hpp"
 
 #include "../openssl/ssl.h"
 #include "../openssl/err.h"
 
+#include <map>
+
 
 namespace vmime {
 namespace net {
@@ -45,6 +50,69 @@ namespace tls {
 static OpenSSLInitializer::autoInitializer openSSLInitializer;
 
 
+#ifndef VMIME_BUILDING_DOC
+
+static SSL_CTX* TLSSession_OpenSSL_createContext(const string& cipherSuite)
+{
+	SSL_CTX* ctx = SSL_CTX_new(SSLv23_client_method());
+	SSL_CTX_set_options(ctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
+	SSL_CTX_set_mode(ctx, SSL_MODE_AUTO_RETRY);
+	SSL_CTX_set_cipher_list(ctx, cipherSuite.c_str());
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);  // see TLSSessionCache
+
+	return ctx;
+}
+
+
+// Contexts shared by all the sessions which use the same cipher suites.
+// Shared contexts are never modified after they have been created, so
+// they can be used concurrently (OpenSSL locks their reference count).
+class TLSSession_OpenSSL_contextPool
+{
+public:
+
+	TLSSession_OpenSSL_contextPool()
+	{
+		m_mutex = platform::getHandler()->createCriticalSection();
+	}
+
+	~TLSSession_OpenSSL_contextPool()
+	{
+		for (std::map <string, SSL_CTX*>::iterator it = m_contexts.begin() ;
+		     it != m_contexts.end() ; ++it)
+		{
+			SSL_CTX_free(it->second);
+		}
+	}
+
+	/** Returns the shared context for the specified cipher suites.
+	  * The caller owns a reference and must release it with SSL_CTX_free().
+	  */
+	SSL_CTX* getContext(const string& cipherSuite)
+	{
+		utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+		SSL_CTX*& ctx = m_contexts[cipherSuite];
+
+		if (ctx == NULL)
+			ctx = TLSSession_OpenSSL_createContext(cipherSuite);
+
+		CRYPTO_add(&ctx->references, 1, CRYPTO_LOCK_SSL_CTX);
+
+		return ctx;
+	}
+
+private:
+
+	std::map <string, SSL_CTX*> m_contexts;
+	ref <utility::sync::criticalSection> m_mutex;
+};
+
+static TLSSession_OpenSSL_contextPool TLSSession_OpenSSL_contexts;
+
+#endif // VMIME_BUILDING_DOC
+
+
 // static
 ref <TLSSession> TLSSession::create(ref <security::cert::certificateVerifier> cv, ref <TLSProperties> props)
 {
@@ -53,13 +121,9 @@ ref <TLSSession> TLSSession::create(ref <security::cert::certificateVerifier> cv
 
 
 TLSSession_OpenSSL::TLSSession_OpenSSL(ref <vmime::security::cert::certificateVerifier> cv, ref <TLSProperties> props)
-	: m_sslctx(0), m_certVerifier(cv), m_props(props)
+	: m_sslctx(0), m_sharedContext(true), m_certVerifier(cv), m_props(props)
 {
-	m_sslctx = SSL_CTX_new(SSLv23_client_method());
-	SSL_CTX_set_options(m_sslctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
-	SSL_CTX_set_mode(m_sslctx, SSL_MODE_AUTO_RETRY);
-	SSL_CTX_set_cipher_list(m_sslctx, m_props->getCipherSuite().c_str());
-	SSL_CTX_set_session_cache_mode(m_sslctx, SSL_SESS_CACHE_OFF);
+	m_sslctx = TLSSession_OpenSSL_contexts.getContext(m_props->getCipherSuite());
 }
 
 
@@ -90,6 +154,8 @@ ref <security::cert::certificateVerifier> TLSSession_OpenSSL::getCertificateVeri
 
 void TLSSession_OpenSSL::usePrivateKeyFile(const vmime::string& keyfile)
 {
+	detachContext();
+
 	if (SSL_CTX_use_PrivateKey_file(m_sslctx, keyfile.c_str(), SSL_FILETYPE_PEM) != 1)
 	{
 		unsigned long errCode = ERR_get_error();
@@ -106,6 +172,8 @@ void TLSSession_OpenSSL::usePrivateKeyFile(const vmime::string& keyfile)
 
 void TLSSession_OpenSSL::useCertificateChainFile(const vmime::string& chainFile)
 {
+	detachContext();
+
 	if (SSL_CTX_use_certificate_chain_file(m_sslctx, chainFile.c_str()) != 1)
 	{
 		unsigned long errCode = ERR_get_error();
@@ -125,6 +193,20 @@ SSL_CTX* TLSSession_OpenSSL::getContext() const
 	return m_sslctx;
 }
 
+
+void TLSSession_OpenSSL::detachContext()
+{
+	if (!m_sharedContext)
+		return;
+
+	SSL_CTX* ctx = TLSSession_OpenSSL_createContext(m_props->getCipherSuite());
+
+	SSL_CTX_free(m_sslctx);
+
+	m_sslctx = ctx;
+	m_sharedContext = false;
+}
+
 // FIX by Elmue:
 // Gets the version of OpenSSL or GnuTLS including the name of the library.
 // e.g. "OpenSSL 1.0.1e" or "GnuTLS 3.2.7"
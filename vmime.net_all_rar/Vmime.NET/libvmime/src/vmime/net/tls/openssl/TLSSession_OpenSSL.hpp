@@ -79,6 +79,10 @@ public:
 	void useCertificateChainFile(const vmime::string& chainFile);
 
 	/** Get a pointer to the SSL_CTX used for this session.
+	 *
+	 * Unless a client certificate is used, this context is shared with
+	 * the other sessions which use the same cipher suites, and must not
+	 * be modified.
 	 *
 	 * @return the SSL_CTX used for all connections created with this session
 	 */
@@ -93,7 +97,13 @@ private:
 
 	TLSSession_OpenSSL(const TLSSession_OpenSSL&);
 
+	/** Replaces the shared context with a context owned by this
+	  * session, before it is configured with a client certificate.
+	  */
+	void detachContext();
+
 	SSL_CTX* m_sslctx;
+	bool m_sharedContext;
 
 	ref <security::cert::certificateVerifier> m_certVerifier;
 	ref <TLSProperties> m_props;
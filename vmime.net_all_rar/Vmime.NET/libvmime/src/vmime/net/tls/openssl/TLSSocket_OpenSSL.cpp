@@ -33,12 +33,15 @@
 #include "../vmime/net/tls/openssl/TLSSocket_OpenSSL.hpp"
 #include "../vmime/net/tls/openssl/TLSSession_OpenSSL.hpp"
 #include "../vmime/net/tls/openssl/OpenSSLInitializer.hpp"
+#include "../vmime/net/tls/TLSSessionCache.hpp"
 
 #include "../vmime/platform.hpp"
 
 #include "../vmime/security/cert/openssl/X509Certificate_OpenSSL.hpp"
 
 #include <vector>
+#include <algorithm>
+#include <cstring>
 
 
 namespace vmime {
@@ -49,6 +52,36 @@ namespace tls {
 static OpenSSLInitializer::autoInitializer openSSLInitializer;
 
 
+#ifndef VMIME_BUILDING_DOC
+
+// OpenSSL session stored in the TLS session cache
+class TLSSocket_OpenSSL_cachedSession : public TLSSessionCache::session
+{
+public:
+
+	TLSSocket_OpenSSL_cachedSession(SSL_SESSION* sess)
+		: m_sess(sess)
+	{
+	}
+
+	~TLSSocket_OpenSSL_cachedSession()
+	{
+		SSL_SESSION_free(m_sess);
+	}
+
+	SSL_SESSION* get() const
+	{
+		return m_sess;
+	}
+
+private:
+
+	SSL_SESSION* m_sess;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 // static
 BIO_METHOD TLSSocket_OpenSSL::sm_customBIOMethod =
 {
@@ -74,7 +107,8 @@ ref <TLSSocket> TLSSocket::wrap(ref <TLSSession> session, ref <socket> sok)
 
 
 TLSSocket_OpenSSL::TLSSocket_OpenSSL(ref <TLSSession_OpenSSL> session, ref <socket> sok)
-	: m_session(session), m_wrapped(sok), m_connected(false), m_ssl(0), m_status(0), m_ex(NULL)
+	: m_session(session), m_wrapped(sok), m_connected(false),
+	  m_readBuffer(65536), m_readBegin(0), m_readEnd(0), m_ssl(0), m_status(0), m_ex(NULL)
 {
 }
 
@@ -117,6 +151,13 @@ void TLSSocket_OpenSSL::createSSLHandle()
 		SSL_set_bio(m_ssl, sockBio, sockBio);
 		SSL_set_connect_state(m_ssl);
 
+		// Send the name of the server (Server Name Indication, RFC-6066),
+		// unless the connection was made to a numeric address
+		const string serverName = getServerName();
+
+		if (serverName != m_wrapped->getPeerAddress())
+			SSL_set_tlsext_host_name(m_ssl, serverName.c_str());
+
         SSL_set_mode(m_ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 	}
 	else
@@ -128,6 +169,8 @@ void TLSSocket_OpenSSL::createSSLHandle()
 
 void TLSSocket_OpenSSL::connect(const string& address, const port_t port)
 {
+	m_serverName = address;
+
 	m_wrapped->connect(address, port);
 
 	createSSLHandle();
@@ -170,6 +213,21 @@ TLSSocket::size_type TLSSocket_OpenSSL::getBlockSize() const
 }
 
 
+void TLSSocket_OpenSSL::setServerName(const string& name)
+{
+	m_serverName = name;
+}
+
+
+const string TLSSocket_OpenSSL::getServerName() const
+{
+	if (m_serverName.empty())
+		return m_wrapped->getPeerAddress();
+
+	return m_serverName;
+}
+
+
 const string TLSSocket_OpenSSL::getPeerName() const
 {
 	return m_wrapped->getPeerName();
@@ -182,14 +240,42 @@ const string TLSSocket_OpenSSL::getPeerAddress() const
 }
 
 
+port_t TLSSocket_OpenSSL::getPeerPort() const
+{
+	return m_wrapped->getPeerPort();
+}
+
+
+void TLSSocket_OpenSSL::setCancellationToken(ref <utility::cancellationToken> token)
+{
+	m_wrapped->setCancellationToken(token);
+}
+
+
+ref <utility::cancellationToken> TLSSocket_OpenSSL::getCancellationToken() const
+{
+	return m_wrapped->getCancellationToken();
+}
+
+
+bool TLSSocket_OpenSSL::hasBufferedData() const
+{
+	return SSL_pending(m_ssl) > 0 || hasBufferedRecord() ||
+	       m_wrapped->hasBufferedData();
+}
+
+
+ref <socket> TLSSocket_OpenSSL::getUnderlyingSocket() const
+{
+	return m_wrapped;
+}
+
+
 void TLSSocket_OpenSSL::receive(string& buffer)
 {
 	const size_type size = receiveRaw(m_buffer, sizeof(m_buffer));
 
-	if (size != 0)
-		buffer = vmime::string(m_buffer, size);
-	else
-		buffer.clear();
+	buffer.assign(m_buffer, size);
 }
 
 
@@ -221,7 +307,51 @@ TLSSocket::size_type TLSSocket_OpenSSL::receiveRaw(char* buffer, const size_type
 		handleError(rc);
 	}
 
-	return rc;
+	// Return more data if it can be decrypted without reading from the
+	// wrapped socket: this saves calls for each record
+	size_type total = rc;
+
+	while (rc > 0 && total < count && (SSL_pending(m_ssl) > 0 || hasBufferedRecord()))
+	{
+		rc = SSL_read(m_ssl, buffer + total, static_cast <int>(count - total));
+
+		if (m_ex.get())
+			internalThrow();
+
+		// Errors will be reported by the next call
+		if (rc > 0)
+			total += rc;
+	}
+
+	return total;
+}
+
+
+bool TLSSocket_OpenSSL::waitForReadable(const unsigned int msecs)
+{
+	// Data may already be available without reading from the network
+	if (hasBufferedData())
+		return true;
+
+	return m_wrapped->waitForReadable(msecs);
+}
+
+
+bool TLSSocket_OpenSSL::hasBufferedRecord() const
+{
+	// OpenSSL consumes whole records, so the buffered data always
+	// starts with a record header (type, version, length)
+	const size_type available = m_readEnd - m_readBegin;
+
+	if (available < 5)
+		return false;
+
+	const unsigned char* header =
+		reinterpret_cast <const unsigned char*>(&m_readBuffer[m_readBegin]);
+
+	const size_type length = (header[3] << 8) | header[4];
+
+	return available >= 5 + length;
 }
 
 
@@ -296,6 +426,17 @@ void TLSSocket_OpenSSL::handshake(ref <timeoutHandler> toHandler)
 	if (!m_ssl)
 		createSSLHandle();
 
+	// Resume the last session negotiated with this server, if any:
+	// this saves the key exchange and a round trip
+	ref <TLSSessionCache> cache = TLSSessionCache::getInstance();
+	const string cacheKey = TLSSessionCache::makeKey(getServerName(), getPeerPort());
+
+	ref <TLSSocket_OpenSSL_cachedSession> cachedSession =
+		cache->find(cacheKey).dynamicCast <TLSSocket_OpenSSL_cachedSession>();
+
+	if (cachedSession)
+		SSL_set_session(m_ssl, cachedSession->get());
+
 	try
 	{
 		int rc;
@@ -326,6 +467,10 @@ void TLSSocket_OpenSSL::handshake(ref <timeoutHandler> toHandler)
 	}
 	catch (...)
 	{
+		// Do not try to resume the session again
+		if (cachedSession)
+			cache->remove(cacheKey);
+
 		SSL_free(m_ssl);
 		m_ssl = 0;
 		m_toHandler = NULL;
@@ -334,13 +479,30 @@ void TLSSocket_OpenSSL::handshake(ref <timeoutHandler> toHandler)
 
 	m_toHandler = NULL;
 
-	// Verify server's certificate(s)
-	ref <security::cert::certificateChain> certs = getPeerCertificates();
+	// Verify server's certificate(s), also when the session is resumed
+	try
+	{
+		ref <security::cert::certificateChain> certs = getPeerCertificates();
+
+		if (certs == NULL)
+			throw exceptions::tls_exception("No peer certificate.");
+
+		m_session->getCertificateVerifier()->verify(certs, getServerName());
+	}
+	catch (...)
+	{
+		cache->remove(cacheKey);
+		throw;
+	}
 
-	if (certs == NULL)
-		throw exceptions::tls_exception("No peer certificate.");
+	// Keep the new session for the next connection to this server
+	if (!SSL_session_reused(m_ssl))
+	{
+		SSL_SESSION* sess = SSL_get1_session(m_ssl);
 
-	m_session->getCertificateVerifier()->verify(certs, getPeerName());
+		if (sess)
+			cache->store(cacheKey, vmime::create <TLSSocket_OpenSSL_cachedSession>(sess));
+	}
 
 	m_connected = true;
 }
@@ -481,13 +643,14 @@ int TLSSocket_OpenSSL::bio_write(BIO* bio, const char* buf, int len)
 	{
 		const size_t n = sok->m_wrapped->sendRawNonBlocking(buf, len);
 
-		if (n == 0 && sok->m_wrapped->getStatus() & socket::STATUS_WOULDBLOCK)
+		if (n == 0)
 		{
 			BIO_set_retry_write(bio);
 			return -1;
 		}
 
-		return static_cast <int>(len);
+		// Partial write: OpenSSL will call us again with the rest
+		return static_cast <int>(n);
 	}
     catch (vmime::exception& e)
 	{
@@ -519,14 +682,29 @@ int TLSSocket_OpenSSL::bio_read(BIO* bio, char* buf, int len)
 
 	try
 	{
-		const size_t n = sok->m_wrapped->receiveRaw(buf, len);
-
-		if (n == 0 || sok->m_wrapped->getStatus() & socket::STATUS_WOULDBLOCK)
+		// OpenSSL reads each record in two steps (header, then body): read
+		// as much as possible from the wrapped socket into our buffer, and
+		// serve the next reads from there
+		if (sok->m_readBegin == sok->m_readEnd)
 		{
-			BIO_set_retry_read(bio);
-			return -1;
+			const size_t n = sok->m_wrapped->receiveRaw
+				(&sok->m_readBuffer[0], sok->m_readBuffer.size());
+
+			if (n == 0 || sok->m_wrapped->getStatus() & socket::STATUS_WOULDBLOCK)
+			{
+				BIO_set_retry_read(bio);
+				return -1;
+			}
+
+			sok->m_readBegin = 0;
+			sok->m_readEnd = n;
 		}
 
+		const size_type n = std::min(static_cast <size_type>(len), sok->m_readEnd - sok->m_readBegin);
+
+		std::memcpy(buf, &sok->m_readBuffer[sok->m_readBegin], n);
+		sok->m_readBegin += n;
+
 		return static_cast <int>(n);
 	}
     catch (vmime::exception& e)
@@ -574,6 +752,11 @@ long TLSSocket_OpenSSL::bio_ctrl(BIO* bio, int cmd, long num, void* ptr)
 		break;
 
 	case BIO_CTRL_PENDING:
+	{
+		TLSSocket_OpenSSL *sok = reinterpret_cast <TLSSocket_OpenSSL*>(bio->ptr);
+		ret = (sok ? static_cast <long>(sok->m_readEnd - sok->m_readBegin) : 0);
+		break;
+	}
 	case BIO_CTRL_WPENDING:
 
 		ret = 0;
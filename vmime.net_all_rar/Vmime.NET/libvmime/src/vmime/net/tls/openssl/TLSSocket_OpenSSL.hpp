@@ -40,6 +40,8 @@
 
 #include "../openssl/ssl.h"
 
+#include <vector>
+
 
 namespace vmime {
 namespace net {
@@ -62,6 +64,9 @@ public:
 
 	void handshake(ref <timeoutHandler> toHandler = NULL);
 
+	void setServerName(const string& name);
+	const string getServerName() const;
+
 	ref <security::cert::certificateChain> getPeerCertificates() const;
 
 	// Implementation of 'socket'
@@ -72,6 +77,8 @@ public:
 	void receive(string& buffer);
 	size_type receiveRaw(char* buffer, const size_type count);
 
+	bool waitForReadable(const unsigned int msecs);
+
 	void send(const string& buffer);
 	void sendRaw(const char* buffer, const size_type count);
 	size_type sendRawNonBlocking(const char* buffer, const size_type count);
@@ -82,6 +89,13 @@ public:
 
 	const string getPeerName() const;
 	const string getPeerAddress() const;
+	port_t getPeerPort() const;
+
+	void setCancellationToken(ref <utility::cancellationToken> token);
+	ref <utility::cancellationToken> getCancellationToken() const;
+
+	bool hasBufferedData() const;
+	ref <socket> getUnderlyingSocket() const;
 
 private:
 
@@ -97,6 +111,13 @@ private:
 
 	void createSSLHandle();
 
+	/** Tests whether a complete TLS record has been received from the
+	  * wrapped socket, so that it can be decrypted without blocking.
+	  *
+	  * @return true if a complete record is buffered, false otherwise
+	  */
+	bool hasBufferedRecord() const;
+
 	void internalThrow();
 	void handleError(int rc);
 
@@ -105,10 +126,18 @@ private:
 
 	ref <socket> m_wrapped;
 
+	string m_serverName;
+
 	bool m_connected;
 
 	char m_buffer[65536];
 
+	// Encrypted data received from the wrapped socket, which has not
+	// been consumed by OpenSSL yet (room for several TLS records)
+	std::vector <char> m_readBuffer;
+	size_type m_readBegin;
+	size_type m_readEnd;
+
 	ref <timeoutHandler> m_toHandler;
 
 	SSL* m_ssl;
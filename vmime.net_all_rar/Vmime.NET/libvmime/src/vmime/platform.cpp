@@ -34,30 +34,11 @@ namespace vmime
 
 ref <platform::handler> platform::sm_handler = NULL;
 
-// FIX: Added by Elmue
-bool platform::handler::mb_Canceled = false;
-
 
 platform::handler::~handler()
 {
 }
 
-// FIX by Elmue: The user must be able to cancel lengthy operations!
-// Call setCancelFlag(true) from another thread to cancel any running operation.
-// Call setCancelFlag(false) always before starting a new connection (Smtp, Pop3, Imap,...)
-void platform::handler::setCancelFlag(bool b_Cancel)
-{
-    mb_Canceled = b_Cancel;
-}
-
-// FIX by Elmue: The user must be able to cancel lengthy operations!
-// Call checkCanceled() in locations were wait operations are executed.
-void platform::handler::checkCanceled()
-{
-    if (mb_Canceled)
-        throw exceptions::operation_cancelled();
-}
-
 
 // static
 ref <platform::handler> platform::getDefaultHandler()
@@ -32,6 +32,7 @@
 
 #if VMIME_HAVE_MESSAGING_FEATURES
 	#include "../vmime/net/socket.hpp"
+	#include "../vmime/net/socketPoller.hpp"
 	#include "../vmime/net/timeoutHandler.hpp"
 #endif
 
@@ -41,6 +42,8 @@
 #endif
 
 #include "../vmime/utility/sync/criticalSection.hpp"
+#include "../vmime/utility/sync/condition.hpp"
+#include "../vmime/utility/cancellationToken.hpp"
 
 namespace vmime
 {
@@ -117,6 +120,13 @@ public:
 		  * @return socket factory
 		  */
 		virtual ref <net::socketFactory> getSocketFactory() = 0;
+
+		/** Creates an object which waits for data on many sockets
+		  * at once.
+		  *
+		  * @return a new socket poller
+		  */
+		virtual ref <net::socketPoller> createSocketPoller() = 0;
 #endif
 
 #if VMIME_HAVE_FILESYSTEM_FEATURES
@@ -145,14 +155,15 @@ public:
 		  */
 		virtual ref <utility::sync::criticalSection> createCriticalSection() = 0;
 
+		/** Creates and initializes a condition variable, to be used
+		  * with a critical section created by createCriticalSection().
+		  */
+		virtual ref <utility::sync::condition> createCondition() = 0;
 
-        // FIX by Elmue: The user must be able to cancel lengthy operations!
-        static void setCancelFlag(bool b_Cancel);
-        static void checkCanceled();
-
-private:
-        // FIX by Elmue: The user must be able to cancel lengthy operations!
-        static bool mb_Canceled;
+		/** Creates a token to cancel lengthy operations. Sockets which
+		  * use this token wake up as soon as cancellation is requested.
+		  */
+		virtual ref <utility::cancellationToken> createCancellationToken() = 0;
 
 	}; // end class handler
 
@@ -0,0 +1,141 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_PLATFORM_IS_WINDOWS
+
+
+#include "../vmime/platforms/windows/windowsCancellationToken.hpp"
+
+
+namespace vmime {
+namespace platforms {
+namespace windows {
+
+
+windowsCancellationToken::windowsCancellationToken()
+	: m_cancelled(0)
+{
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+	WSAData wsaData;
+	WSAStartup(MAKEWORD(1, 1), &wsaData);
+
+	// Windows cannot select() on pipes: use a UDP socket connected to
+	// itself, on the loopback interface
+	m_wakeUpSocket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (m_wakeUpSocket != INVALID_SOCKET)
+	{
+		::sockaddr_in addr = {0};
+		int addrLen = sizeof(addr);
+
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+
+		unsigned long non_blocking = 1;
+
+		if (::bind(m_wakeUpSocket, reinterpret_cast <sockaddr*>(&addr), sizeof(addr)) != 0 ||
+		    ::getsockname(m_wakeUpSocket, reinterpret_cast <sockaddr*>(&addr), &addrLen) != 0 ||
+		    ::connect(m_wakeUpSocket, reinterpret_cast <sockaddr*>(&addr), addrLen) != 0 ||
+		    ::ioctlsocket(m_wakeUpSocket, FIONBIO, &non_blocking) != 0)
+		{
+			// Waits will not be interrupted, but cancellation is still
+			// checked regularly
+			::closesocket(m_wakeUpSocket);
+			m_wakeUpSocket = INVALID_SOCKET;
+		}
+	}
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+}
+
+
+windowsCancellationToken::~windowsCancellationToken()
+{
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+	if (m_wakeUpSocket != INVALID_SOCKET)
+		::closesocket(m_wakeUpSocket);
+
+	WSACleanup();
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+}
+
+
+void windowsCancellationToken::cancel()
+{
+	if (InterlockedExchange(&m_cancelled, 1) != 0)
+		return;  // already cancelled
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+	if (m_wakeUpSocket != INVALID_SOCKET)
+		::send(m_wakeUpSocket, "!", 1, 0);
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+}
+
+
+void windowsCancellationToken::reset()
+{
+	InterlockedExchange(&m_cancelled, 0);
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+	if (m_wakeUpSocket != INVALID_SOCKET)
+	{
+		char buffer[16];
+		while (::recv(m_wakeUpSocket, buffer, sizeof(buffer), 0) > 0) {}
+	}
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+}
+
+
+bool windowsCancellationToken::isCancelled() const
+{
+	return m_cancelled != 0;
+}
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+SOCKET windowsCancellationToken::getWakeUpSocket() const
+{
+	return m_wakeUpSocket;
+}
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+
+
+} // windows
+} // platforms
+} // vmime
+
+
+#endif // VMIME_PLATFORM_IS_WINDOWS
@@ -0,0 +1,126 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_PLATFORM_IS_WINDOWS
+
+
+#include "../vmime/platforms/windows/windowsCondition.hpp"
+
+#include "../vmime/exception.hpp"
+
+
+namespace vmime {
+namespace platforms {
+namespace windows {
+
+
+windowsCondition::windowsCondition()
+{
+	InitializeCriticalSection(&m_lock);
+}
+
+
+windowsCondition::~windowsCondition()
+{
+	for (std::vector <HANDLE>::iterator it = m_freeEvents.begin() ; it != m_freeEvents.end() ; ++it)
+		CloseHandle(*it);
+
+	for (std::vector <HANDLE>::iterator it = m_waiters.begin() ; it != m_waiters.end() ; ++it)
+		CloseHandle(*it);
+
+	DeleteCriticalSection(&m_lock);
+}
+
+
+void windowsCondition::wait(ref <utility::sync::criticalSection> cs)
+{
+	HANDLE event = NULL;
+
+	EnterCriticalSection(&m_lock);
+
+	if (!m_freeEvents.empty())
+	{
+		event = m_freeEvents.back();
+		m_freeEvents.pop_back();
+	}
+	else if ((event = CreateEvent(NULL, /* bManualReset */ FALSE, /* bInitialState */ FALSE, NULL)) == NULL)
+	{
+		LeaveCriticalSection(&m_lock);
+		throw exceptions::system_error("Cannot create event");
+	}
+
+	m_waiters.push_back(event);
+
+	LeaveCriticalSection(&m_lock);
+
+	// The thread is registered as a waiter before the critical section is
+	// left, so that a notification sent in the meantime is not lost
+	cs->unlock();
+
+	WaitForSingleObject(event, INFINITE);
+
+	cs->lock();
+
+	// The auto-reset event is not signaled anymore: it can be reused
+	EnterCriticalSection(&m_lock);
+	m_freeEvents.push_back(event);
+	LeaveCriticalSection(&m_lock);
+}
+
+
+void windowsCondition::notifyOne()
+{
+	EnterCriticalSection(&m_lock);
+
+	if (!m_waiters.empty())
+	{
+		SetEvent(m_waiters.front());
+		m_waiters.erase(m_waiters.begin());
+	}
+
+	LeaveCriticalSection(&m_lock);
+}
+
+
+void windowsCondition::notifyAll()
+{
+	EnterCriticalSection(&m_lock);
+
+	for (std::vector <HANDLE>::iterator it = m_waiters.begin() ; it != m_waiters.end() ; ++it)
+		SetEvent(*it);
+
+	m_waiters.clear();
+
+	LeaveCriticalSection(&m_lock);
+}
+
+
+} // windows
+} // platforms
+} // vmime
+
+
+#endif // VMIME_PLATFORM_IS_WINDOWS
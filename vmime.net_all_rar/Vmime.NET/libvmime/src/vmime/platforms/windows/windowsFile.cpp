@@ -337,6 +337,20 @@ void windowsFile::rename(const path& newName)
 		windowsFileSystemFactory::reportError(m_path, GetLastError());
 }
 
+void windowsFile::renameReplace(const path& newName)
+{
+    string s_Utf8 = windowsFileSystemFactory::pathToStringImpl(newName);
+    const vmime::wstring newNativeName = charset::Utf8ToWstring(s_Utf8);
+
+	if (MoveFileExW(m_nativePath.c_str(), newNativeName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		m_path = newName;
+		m_nativePath = newNativeName;
+	}
+	else
+		windowsFileSystemFactory::reportError(m_path, GetLastError());
+}
+
 void windowsFile::remove()
 {
 	// Fix by Elmue: Use Widechar API
@@ -526,7 +540,7 @@ windowsFileWriter::windowsFileWriter(const vmime::utility::file::path& path, con
 {
 }
 
-ref <vmime::utility::outputStream> windowsFileWriter::getOutputStream()
+ref <vmime::utility::fileOutputStream> windowsFileWriter::getOutputStream()
 {
     // Fix by Elmue: Use Widechar API
 	HANDLE hFile = CreateFileW(
@@ -565,6 +579,14 @@ void windowsFileWriterOutputStream::flush()
 	// TODO
 }
 
+void windowsFileWriterOutputStream::sync()
+{
+	flush();
+
+	if (!FlushFileBuffers(m_hFile))
+		windowsFileSystemFactory::reportError(m_path, GetLastError());
+}
+
 
 } // windows
 } // platforms
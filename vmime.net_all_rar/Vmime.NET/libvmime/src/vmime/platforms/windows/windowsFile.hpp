@@ -87,6 +87,7 @@ public:
 	ref <file> getParent() const;
 
 	void rename(const path& newName);
+	void renameReplace(const path& newName);
 	void remove();
 
 	ref <vmime::utility::fileWriter> getFileWriter();
@@ -185,7 +186,7 @@ public:
 
 public:
 
-	ref <vmime::utility::outputStream> getOutputStream();
+	ref <vmime::utility::fileOutputStream> getOutputStream();
 
 private:
 
@@ -195,7 +196,7 @@ private:
 };
 
 
-class windowsFileWriterOutputStream : public vmime::utility::outputStream
+class windowsFileWriterOutputStream : public vmime::utility::fileOutputStream
 {
 public:
 
@@ -206,6 +207,7 @@ public:
 
 	void write(const value_type* const data, const size_type count);
 	void flush();
+	void sync();
 
 private:
 
@@ -30,6 +30,8 @@
 #include "../vmime/platforms/windows/windowsHandler.hpp"
 
 #include "../vmime/platforms/windows/windowsCriticalSection.hpp"
+#include "../vmime/platforms/windows/windowsCondition.hpp"
+#include "../vmime/platforms/windows/windowsCancellationToken.hpp"
 
 #include "../vmime/utility/stringUtils.hpp"
 
@@ -203,6 +205,12 @@ ref <vmime::net::socketFactory> windowsHandler::getSocketFactory()
 	return m_socketFactory;
 }
 
+
+ref <vmime::net::socketPoller> windowsHandler::createSocketPoller()
+{
+	return vmime::create <windowsSocketPoller>();
+}
+
 #endif
 
 
@@ -225,8 +233,6 @@ ref <vmime::utility::childProcessFactory> windowsHandler::getChildProcessFactory
 
 void windowsHandler::wait() const
 {
-	// FIX by Elmue: The user must be able to cancel lengthy operations!
-	checkCanceled();
 	::Sleep(100);
 }
 
@@ -245,6 +251,18 @@ ref <utility::sync::criticalSection> windowsHandler::createCriticalSection()
 	return vmime::create <windowsCriticalSection>();
 }
 
+
+ref <utility::sync::condition> windowsHandler::createCondition()
+{
+	return vmime::create <windowsCondition>();
+}
+
+
+ref <utility::cancellationToken> windowsHandler::createCancellationToken()
+{
+	return vmime::create <windowsCancellationToken>();
+}
+
 } // posix
 } // platforms
 } // vmime
@@ -35,6 +35,7 @@
 
 #if VMIME_HAVE_MESSAGING_FEATURES
 	#include "../vmime/platforms/windows/windowsSocket.hpp"
+	#include "../vmime/platforms/windows/windowsSocketPoller.hpp"
 #endif
 
 #if VMIME_HAVE_FILESYSTEM_FEATURES
@@ -67,6 +68,8 @@ public:
 
 #if VMIME_HAVE_MESSAGING_FEATURES
 	ref <vmime::net::socketFactory> getSocketFactory();
+
+	ref <vmime::net::socketPoller> createSocketPoller();
 #endif
 
 #if VMIME_HAVE_FILESYSTEM_FEATURES
@@ -81,6 +84,10 @@ public:
 
 	ref <utility::sync::criticalSection> createCriticalSection();
 
+	ref <utility::sync::condition> createCondition();
+
+	ref <utility::cancellationToken> createCancellationToken();
+
 private:
 
 #if VMIME_HAVE_MESSAGING_FEATURES
@@ -30,6 +30,7 @@
 #pragma warning(disable: 4267)
 
 #include "../vmime/platforms/windows/windowsSocket.hpp"
+#include "../vmime/platforms/windows/windowsCancellationToken.hpp"
 
 #include "../vmime/exception.hpp"
 
@@ -205,6 +206,50 @@ const string windowsSocket::getPeerAddress() const
 }
 
 
+vmime::port_t windowsSocket::getPeerPort() const
+{
+	// Get port of connected peer (sockets are created for IPv4)
+	sockaddr_in peer;
+	socklen_t peerLen = sizeof(peer);
+
+	if (getpeername(m_desc, reinterpret_cast <sockaddr*>(&peer), &peerLen) != 0)
+		return 0;
+
+	return ntohs(peer.sin_port);
+}
+
+
+void windowsSocket::setCancellationToken(ref <utility::cancellationToken> token)
+{
+	m_cancelToken = token;
+}
+
+
+ref <utility::cancellationToken> windowsSocket::getCancellationToken() const
+{
+	return m_cancelToken;
+}
+
+
+bool windowsSocket::hasBufferedData() const
+{
+	// Data is not buffered in user space
+	return false;
+}
+
+
+ref <vmime::net::socket> windowsSocket::getUnderlyingSocket() const
+{
+	return NULL;
+}
+
+
+SOCKET windowsSocket::getDescriptor() const
+{
+	return m_desc;
+}
+
+
 const string windowsSocket::getPeerName() const
 {
 	// Get address of connected peer
@@ -241,7 +286,7 @@ windowsSocket::size_type windowsSocket::getBlockSize() const
 void windowsSocket::receive(vmime::string& buffer)
 {
 	const size_type size = receiveRaw(m_buffer, sizeof(m_buffer));
-	buffer = vmime::string(m_buffer, size);
+	buffer.assign(m_buffer, size);
 }
 
 
@@ -309,6 +354,15 @@ windowsSocket::size_type windowsSocket::receiveRaw(char* buffer, const size_type
 }
 
 
+bool windowsSocket::waitForReadable(const unsigned int msecs)
+{
+	bool timedout;
+	waitForData(READ, timedout, msecs);
+
+	return !timedout;
+}
+
+
 void windowsSocket::send(const vmime::string& buffer)
 {
 	sendRaw(buffer.data(), buffer.length());
@@ -360,6 +414,10 @@ windowsSocket::size_type windowsSocket::sendRawNonBlocking(const char* buffer, c
 
 		if (err == WSAEWOULDBLOCK)
 		{
+			// The caller will wait and try again
+			if (m_cancelToken)
+				m_cancelToken->check();
+
 			m_status |= STATUS_WOULDBLOCK;
 
 			// No data can be written at this time
@@ -422,36 +480,60 @@ string windowsSocket::explainWindowsError(const int err)
 }
 
 
-void windowsSocket::waitForData(const WaitOpType t, bool& timedOut)
+void windowsSocket::waitForData(const WaitOpType t, bool& timedOut, const unsigned int msecs)
 {
     // FIX by Elmue: The user must be able to abort
-    platform::handler::checkCanceled();
+	if (m_cancelToken)
+		m_cancelToken->check();
 
 	// Check whether data is available
-	fd_set fds;
-	FD_ZERO(&fds);
-	FD_SET(m_desc, &fds);
+	fd_set readFds, writeFds;
+	FD_ZERO(&readFds);
+	FD_ZERO(&writeFds);
 
-	struct timeval tv;
-	tv.tv_sec = 1;
-	tv.tv_usec = 0;
+	if (t & (READ | BOTH))
+		FD_SET(m_desc, &readFds);
+	if (t & (WRITE | BOTH))
+		FD_SET(m_desc, &writeFds);
 
-	int ret;
+	// Also watch the wake-up socket of the cancellation token, so that
+	// a cancellation request interrupts the wait immediately
+	SOCKET wakeUp = INVALID_SOCKET;
 
-	if (t & READ)
-		ret = ::select((int)m_desc + 1, &fds, NULL, NULL, &tv);
-	else if (t & WRITE)
-		ret = ::select((int)m_desc + 1, NULL, &fds, NULL, &tv);
-	else
-		ret = ::select((int)m_desc + 1, &fds, &fds, NULL, &tv);
+	if (m_cancelToken)
+	{
+		ref <windowsCancellationToken> token =
+			m_cancelToken.dynamicCast <windowsCancellationToken>();
 
-	timedOut = (ret == 0);
+		if (token)
+			wakeUp = token->getWakeUpSocket();
+
+		if (wakeUp != INVALID_SOCKET)
+			FD_SET(wakeUp, &readFds);
+	}
+
+	struct timeval tv;
+	tv.tv_sec = msecs / 1000;
+	tv.tv_usec = (msecs % 1000) * 1000;
+
+	const int ret = ::select(0 /* ignored */, &readFds, &writeFds, NULL, &tv);
 
 	if (ret == SOCKET_ERROR)
 	{
 		int err = WSAGetLastError();
 		throwSocketError(err);
 	}
+
+	if (wakeUp != INVALID_SOCKET && FD_ISSET(wakeUp, &readFds))
+	{
+		m_cancelToken->check();
+
+		// Cancellation has been reset in the meantime
+		timedOut = (ret == 1);
+		return;
+	}
+
+	timedOut = (ret == 0);
 }
 
 
@@ -60,6 +60,8 @@ public:
 	void receive(vmime::string& buffer);
 	size_type receiveRaw(char* buffer, const size_type count);
 
+	bool waitForReadable(const unsigned int msecs);
+
 	void send(const vmime::string& buffer);
 	void sendRaw(const char* buffer, const size_type count);
 	size_type sendRawNonBlocking(const char* buffer, const size_type count);
@@ -70,6 +72,19 @@ public:
 
 	const string getPeerName() const;
 	const string getPeerAddress() const;
+	vmime::port_t getPeerPort() const;
+
+	void setCancellationToken(ref <utility::cancellationToken> token);
+	ref <utility::cancellationToken> getCancellationToken() const;
+
+	bool hasBufferedData() const;
+	ref <vmime::net::socket> getUnderlyingSocket() const;
+
+	/** Return the system descriptor of this socket.
+	  *
+	  * @return socket descriptor, or INVALID_SOCKET if not connected
+	  */
+	SOCKET getDescriptor() const;
 
 protected:
 
@@ -85,11 +100,12 @@ protected:
 		BOTH  = 4
 	};
 
-	void waitForData(const WaitOpType t, bool& timedOut);
+	void waitForData(const WaitOpType t, bool& timedOut, const unsigned int msecs = 1000);
 
 private:
 
 	ref <vmime::net::timeoutHandler> m_timeoutHandler;
+	ref <utility::cancellationToken> m_cancelToken;
 
 	char m_buffer[65536];
 	SOCKET m_desc;
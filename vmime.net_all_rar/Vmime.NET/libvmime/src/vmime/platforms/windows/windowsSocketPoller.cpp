@@ -0,0 +1,200 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_PLATFORM_IS_WINDOWS && VMIME_HAVE_MESSAGING_FEATURES
+
+
+#include "../vmime/platforms/windows/windowsSocketPoller.hpp"
+#include "../vmime/platforms/windows/windowsCancellationToken.hpp"
+
+#include "../vmime/exception.hpp"
+
+#include "../vmime/utility/stringUtils.hpp"
+
+
+namespace vmime {
+namespace platforms {
+namespace windows {
+
+
+windowsSocketPoller::windowsSocketPoller()
+{
+}
+
+
+windowsSocketPoller::~windowsSocketPoller()
+{
+}
+
+
+void windowsSocketPoller::addSocket(ref <vmime::net::socket> sok)
+{
+	// Find the socket which talks to the network
+	ref <vmime::net::socket> lowest = sok;
+
+	while (lowest->getUnderlyingSocket())
+		lowest = lowest->getUnderlyingSocket();
+
+	// Sockets which do not talk to the network through this platform
+	// (eg. in-memory sockets) have no descriptor to wait on: they are
+	// only reported when they have buffered data
+	watchedSocket ws;
+	ws.sok = sok;
+	ws.winSok = lowest.dynamicCast <windowsSocket>();
+
+	m_sockets.push_back(ws);
+}
+
+
+void windowsSocketPoller::removeSocket(ref <vmime::net::socket> sok)
+{
+	for (std::vector <watchedSocket>::iterator it = m_sockets.begin() ;
+	     it != m_sockets.end() ; ++it)
+	{
+		if (it->sok == sok)
+		{
+			m_sockets.erase(it);
+			return;
+		}
+	}
+}
+
+
+size_t windowsSocketPoller::getSocketCount() const
+{
+	return m_sockets.size();
+}
+
+
+size_t windowsSocketPoller::waitForReadable
+	(const unsigned int msecs, std::vector <ref <vmime::net::socket> >& readySockets)
+{
+	readySockets.clear();
+
+	if (m_cancelToken)
+		m_cancelToken->check();
+
+	// Data already buffered in user space (eg. decrypted TLS records) is
+	// not reported by select(): do not wait if there is some
+	bool buffered = false;
+
+	for (std::vector <watchedSocket>::const_iterator it = m_sockets.begin() ;
+	     !buffered && it != m_sockets.end() ; ++it)
+	{
+		buffered = it->sok->hasBufferedData();
+	}
+
+	SOCKET wakeUp = INVALID_SOCKET;
+
+	if (m_cancelToken)
+	{
+		ref <windowsCancellationToken> token =
+			m_cancelToken.dynamicCast <windowsCancellationToken>();
+
+		if (token)
+			wakeUp = token->getWakeUpSocket();
+	}
+
+	// A Windows fd_set is a count followed by an array of sockets, and
+	// select() does not limit the count to FD_SETSIZE. The count has the
+	// size of a SOCKET (with padding), so it is stored in element 0.
+	m_readFds.resize(m_sockets.size() + 2);
+
+	fd_set* readFds = reinterpret_cast <fd_set*>(&m_readFds[0]);
+	readFds->fd_count = 0;
+
+	for (std::vector <watchedSocket>::const_iterator it = m_sockets.begin() ;
+	     it != m_sockets.end() ; ++it)
+	{
+		const SOCKET desc = it->winSok ? it->winSok->getDescriptor() : INVALID_SOCKET;
+
+		if (desc != INVALID_SOCKET)
+			readFds->fd_array[readFds->fd_count++] = desc;
+	}
+
+	if (wakeUp != INVALID_SOCKET)
+		readFds->fd_array[readFds->fd_count++] = wakeUp;
+
+	int ret = 0;
+
+	if (readFds->fd_count == 0)
+	{
+		// select() fails with an empty set
+		if (!buffered)
+			::Sleep(msecs);
+	}
+	else
+	{
+		struct timeval tv;
+		tv.tv_sec = buffered ? 0 : msecs / 1000;
+		tv.tv_usec = buffered ? 0 : (msecs % 1000) * 1000;
+
+		ret = ::select(0 /* ignored */, readFds, NULL, NULL, &tv);
+
+		if (ret == SOCKET_ERROR)
+		{
+			throw exceptions::socket_exception
+				("select() failed with error " + utility::stringUtils::toString(WSAGetLastError()));
+		}
+
+		if (wakeUp != INVALID_SOCKET && FD_ISSET(wakeUp, readFds))
+			m_cancelToken->check();
+	}
+
+	for (std::vector <watchedSocket>::const_iterator it = m_sockets.begin() ;
+	     it != m_sockets.end() ; ++it)
+	{
+		const SOCKET desc = it->winSok ? it->winSok->getDescriptor() : INVALID_SOCKET;
+
+		if ((ret > 0 && desc != INVALID_SOCKET && FD_ISSET(desc, readFds)) ||
+		    it->sok->hasBufferedData())
+		{
+			readySockets.push_back(it->sok);
+		}
+	}
+
+	return readySockets.size();
+}
+
+
+void windowsSocketPoller::setCancellationToken(ref <utility::cancellationToken> token)
+{
+	m_cancelToken = token;
+}
+
+
+ref <utility::cancellationToken> windowsSocketPoller::getCancellationToken() const
+{
+	return m_cancelToken;
+}
+
+
+} // windows
+} // platforms
+} // vmime
+
+
+#endif // VMIME_PLATFORM_IS_WINDOWS && VMIME_HAVE_MESSAGING_FEATURES
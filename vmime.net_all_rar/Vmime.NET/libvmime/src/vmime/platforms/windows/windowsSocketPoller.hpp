@@ -0,0 +1,86 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_PLATFORMS_WINDOWS_SOCKETPOLLER_HPP_INCLUDED
+#define VMIME_PLATFORMS_WINDOWS_SOCKETPOLLER_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_PLATFORM_IS_WINDOWS && VMIME_HAVE_MESSAGING_FEATURES
+
+
+#include <winsock2.h>
+#include "../vmime/net/socketPoller.hpp"
+#include "../vmime/platforms/windows/windowsSocket.hpp"
+
+
+namespace vmime {
+namespace platforms {
+namespace windows {
+
+
+class windowsSocketPoller : public vmime::net::socketPoller
+{
+public:
+
+	windowsSocketPoller();
+	~windowsSocketPoller();
+
+	void addSocket(ref <vmime::net::socket> sok);
+	void removeSocket(ref <vmime::net::socket> sok);
+
+	size_t getSocketCount() const;
+
+	size_t waitForReadable
+		(const unsigned int msecs, std::vector <ref <vmime::net::socket> >& readySockets);
+
+	void setCancellationToken(ref <utility::cancellationToken> token);
+	ref <utility::cancellationToken> getCancellationToken() const;
+
+private:
+
+	struct watchedSocket
+	{
+		ref <vmime::net::socket> sok;
+		ref <windowsSocket> winSok;  // socket which talks to the network, or NULL
+	};
+
+	std::vector <watchedSocket> m_sockets;
+
+	ref <utility::cancellationToken> m_cancelToken;
+
+	// Storage for a fd_set which can hold more than FD_SETSIZE sockets
+	std::vector <SOCKET> m_readFds;
+};
+
+
+} // windows
+} // platforms
+} // vmime
+
+
+#endif // VMIME_PLATFORM_IS_WINDOWS && VMIME_HAVE_MESSAGING_FEATURES
+
+#endif // VMIME_PLATFORMS_WINDOWS_SOCKETPOLLER_HPP_INCLUDED
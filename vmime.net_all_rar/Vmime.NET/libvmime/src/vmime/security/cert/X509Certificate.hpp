@@ -114,6 +114,29 @@ public:
 
 	virtual bool checkIssuer(ref <const X509Certificate> issuer) const = 0;
 
+	/** Returns the distinguished name of the subject of this certificate,
+	  * in the same format as getIssuer().
+	  *
+	  * @return subject name
+	  */
+	virtual const string getSubject() const = 0;
+
+	/** Returns the identifier of the public key of this certificate
+	  * (X.509v3 'subjectKeyIdentifier' extension).
+	  *
+	  * @return key identifier, or an empty array if the certificate
+	  * does not have this extension
+	  */
+	virtual const byteArray getSubjectKeyIdentifier() const = 0;
+
+	/** Returns the identifier of the public key of the issuer of this
+	  * certificate (X.509v3 'authorityKeyIdentifier' extension).
+	  *
+	  * @return key identifier, or an empty array if the certificate
+	  * does not have this extension
+	  */
+	virtual const byteArray getAuthorityKeyIdentifier() const = 0;
+
 	/** Verifies this certificate against a given trusted one.
 	  *
 	  * @param caCert a certificate that is considered to be trusted one
@@ -27,6 +27,12 @@
 
 #include "../vmime/security/cert/certificateVerifier.hpp"
 
+#include "../vmime/utility/sync/criticalSection.hpp"
+
+#include <list>
+#include <map>
+#include <set>
+
 
 namespace vmime {
 namespace security {
@@ -61,6 +67,15 @@ public:
 	  */
 	void setX509RootCAs(const std::vector <ref <X509Certificate> >& caCerts);
 
+	/** Sets the maximum number of certificate chains which are remembered
+	  * after they have been successfully verified. When the same server
+	  * presents the same chain again, only the validity dates are checked.
+	  * The default is 64. A value of 0 disables this cache.
+	  *
+	  * @param count maximum number of verified chains
+	  */
+	void setVerifiedChainCacheSize(const size_t count);
+
 
 	// Implementation of 'certificateVerifier'
 	void verify(ref <certificateChain> chain, const string& hostname);
@@ -74,9 +89,35 @@ private:
 	  */
 	void verifyX509(ref <certificateChain> chain, const string& hostname);
 
+	/** Finds the root CA which issued the specified certificate.
+	  *
+	  * @param cert X.509 certificate
+	  * @return root CA whose signature on the certificate has been
+	  * verified, or NULL if no root CA issued this certificate
+	  */
+	ref <X509Certificate> findX509RootCA(ref <const X509Certificate> cert) const;
+
+	bool isVerifiedChain(const string& key);
+	void addVerifiedChain(const string& key);
+	void clearVerifiedChains();
+
 
 	std::vector <ref <X509Certificate> > m_x509RootCAs;
 	std::vector <ref <X509Certificate> > m_x509TrustedCerts;
+
+	// Root CAs indexed by subject name and by key identifier
+	std::multimap <string, ref <X509Certificate> > m_x509RootCAsBySubject;
+	std::map <byteArray, ref <X509Certificate> > m_x509RootCAsByKeyId;
+
+	// SHA1 fingerprints of trusted certificates
+	std::set <byteArray> m_x509TrustedFingerprints;
+
+	// Verified chains (host name and fingerprints), most recent first
+	std::list <string> m_verifiedChains;
+	std::set <string> m_verifiedChainsIndex;
+	size_t m_verifiedChainCacheSize;
+
+	ref <utility::sync::criticalSection> m_mutex;
 };
 
 
@@ -29,7 +29,12 @@
 
 #include "../vmime/security/cert/X509Certificate.hpp"
 
+#include "../vmime/utility/sync/autoLock.hpp"
+
 #include "../vmime/exception.hpp"
+#include "../vmime/platform.hpp"
+
+#include <algorithm>
 
 
 namespace vmime {
@@ -38,7 +43,9 @@ namespace cert {
 
 
 defaultCertificateVerifier::defaultCertificateVerifier()
+	: m_verifiedChainCacheSize(64)
 {
+	m_mutex = platform::getHandler()->createCriticalSection();
 }
 
 
@@ -96,6 +103,8 @@ void defaultCertificateVerifier::verifyX509
 	// is valid at the current time
 	const datetime now = datetime::now();
 
+	string chainKey(hostname);
+
 	for (unsigned int i = 0 ; i < chain->getCount() ; ++i)
 	{
 		ref <X509Certificate> cert =
@@ -109,8 +118,18 @@ void defaultCertificateVerifier::verifyX509
 			throw exceptions::certificate_verification_exception
 				("Validity date check failed.");
 		}
+
+		const byteArray fp = cert->getFingerprint(X509Certificate::DIGEST_SHA1);
+
+		chainKey += '\n';
+		chainKey.append(fp.begin(), fp.end());
 	}
 
+	// The same chain has already been verified for this host name: the
+	// signatures do not need to be checked again
+	if (isVerifiedChain(chainKey))
+		return;
+
 	// Check whether the certificate can be trusted
 
 	// -- First, verify that the the last certificate in the chain was
@@ -120,19 +139,16 @@ void defaultCertificateVerifier::verifyX509
 
 	bool trusted = false;
 
-	for (unsigned int i = 0 ; !trusted && i < m_x509RootCAs.size() ; ++i)
-	{
-		ref <X509Certificate> rootCa = m_x509RootCAs[i];
+	ref <X509Certificate> rootCa = findX509RootCA(lastCert);
 
-		if (lastCert->verify(rootCa))
-        {
-			trusted = true;
+	if (rootCa)
+	{
+		trusted = true;
 
-            // FIX by Elmue: Added Trace output
-            #if VMIME_TRACE
-                TRACE("CERT Server certificate is signed with root certificate: %s", rootCa->getIssuer().c_str());
-            #endif
-        }
+        // FIX by Elmue: Added Trace output
+        #if VMIME_TRACE
+            TRACE("CERT Server certificate is signed with root certificate: %s", rootCa->getIssuer().c_str());
+        #endif
 	}
 
 	// -- Next, if the issuer certificate cannot be verified against
@@ -141,19 +157,15 @@ void defaultCertificateVerifier::verifyX509
 	ref <X509Certificate> firstCert =
 		chain->getAt(0).dynamicCast <X509Certificate>();
 
-	for (unsigned int i = 0 ; !trusted && i < m_x509TrustedCerts.size() ; ++i)
+	if (!trusted && m_x509TrustedFingerprints.count
+			(firstCert->getFingerprint(X509Certificate::DIGEST_SHA1)) != 0)
 	{
-		ref <X509Certificate> cert = m_x509TrustedCerts[i];
+		trusted = true;
 
-		if (firstCert->equals(cert))
-        {
-			trusted = true;
-
-            // FIX by Elmue: Added Trace output
-            #if VMIME_TRACE
-                TRACE("CERT Server certificate is trusted by user: %s", cert->getIssuer().c_str());
-            #endif
-        }
+        // FIX by Elmue: Added Trace output
+        #if VMIME_TRACE
+            TRACE("CERT Server certificate is trusted by user: %s", firstCert->getIssuer().c_str());
+        #endif
 	}
 
 	if (!trusted)
@@ -171,6 +183,71 @@ void defaultCertificateVerifier::verifyX509
 		throw exceptions::certificate_verification_exception
             ("Server identity ("+hostname+") does not match any of the identities in the certificate: "+s_NoMatch);
 	}
+
+	addVerifiedChain(chainKey);
+}
+
+
+ref <X509Certificate> defaultCertificateVerifier::findX509RootCA
+	(ref <const X509Certificate> cert) const
+{
+	// The authority key identifier designates the issuer directly
+	const byteArray keyId = cert->getAuthorityKeyIdentifier();
+
+	if (!keyId.empty())
+	{
+		std::map <byteArray, ref <X509Certificate> >::const_iterator
+			it = m_x509RootCAsByKeyId.find(keyId);
+
+		if (it != m_x509RootCAsByKeyId.end() && cert->verify(it->second))
+			return it->second;
+	}
+
+	// Otherwise, try the root CAs whose subject is the certificate issuer
+	typedef std::multimap <string, ref <X509Certificate> >::const_iterator iterator;
+
+	const std::pair <iterator, iterator> range =
+		m_x509RootCAsBySubject.equal_range(cert->getIssuer());
+
+	for (iterator it = range.first ; it != range.second ; ++it)
+	{
+		if (cert->verify(it->second))
+			return it->second;
+	}
+
+	return NULL;
+}
+
+
+bool defaultCertificateVerifier::isVerifiedChain(const string& key)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	if (m_verifiedChainsIndex.count(key) == 0)
+		return false;
+
+	// Move the chain to the front of the list
+	m_verifiedChains.remove(key);
+	m_verifiedChains.push_front(key);
+
+	return true;
+}
+
+
+void defaultCertificateVerifier::addVerifiedChain(const string& key)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	if (m_verifiedChainCacheSize == 0 || !m_verifiedChainsIndex.insert(key).second)
+		return;
+
+	m_verifiedChains.push_front(key);
+
+	while (m_verifiedChains.size() > m_verifiedChainCacheSize)
+	{
+		m_verifiedChainsIndex.erase(m_verifiedChains.back());
+		m_verifiedChains.pop_back();
+	}
 }
 
 
@@ -178,6 +255,23 @@ void defaultCertificateVerifier::setX509RootCAs
 	(const std::vector <ref <X509Certificate> >& caCerts)
 {
 	m_x509RootCAs = caCerts;
+
+	m_x509RootCAsBySubject.clear();
+	m_x509RootCAsByKeyId.clear();
+
+	for (unsigned int i = 0 ; i < caCerts.size() ; ++i)
+	{
+		ref <X509Certificate> caCert = caCerts[i];
+
+		m_x509RootCAsBySubject.insert(std::make_pair(caCert->getSubject(), caCert));
+
+		const byteArray keyId = caCert->getSubjectKeyIdentifier();
+
+		if (!keyId.empty())
+			m_x509RootCAsByKeyId.insert(std::make_pair(keyId, caCert));
+	}
+
+	clearVerifiedChains();
 }
 
 
@@ -185,6 +279,39 @@ void defaultCertificateVerifier::setX509TrustedCerts
 	(const std::vector <ref <X509Certificate> >& trustedCerts)
 {
 	m_x509TrustedCerts = trustedCerts;
+
+	m_x509TrustedFingerprints.clear();
+
+	for (unsigned int i = 0 ; i < trustedCerts.size() ; ++i)
+	{
+		m_x509TrustedFingerprints.insert
+			(trustedCerts[i]->getFingerprint(X509Certificate::DIGEST_SHA1));
+	}
+
+	clearVerifiedChains();
+}
+
+
+void defaultCertificateVerifier::setVerifiedChainCacheSize(const size_t count)
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	m_verifiedChainCacheSize = count;
+
+	while (m_verifiedChains.size() > m_verifiedChainCacheSize)
+	{
+		m_verifiedChainsIndex.erase(m_verifiedChains.back());
+		m_verifiedChains.pop_back();
+	}
+}
+
+
+void defaultCertificateVerifier::clearVerifiedChains()
+{
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+	m_verifiedChains.clear();
+	m_verifiedChainsIndex.clear();
 }
 
 
@@ -182,6 +182,44 @@ bool X509Certificate_GnuTLS::checkIssuer(ref <const X509Certificate> issuer_) co
 }
 
 
+const string X509Certificate_GnuTLS::getSubject() const
+{
+	char buf[4096];
+	size_t bufSize = sizeof(buf);
+
+	if (gnutls_x509_crt_get_dn(m_data->cert, buf, &bufSize) != GNUTLS_E_SUCCESS)
+		return "";
+
+	return buf;
+}
+
+
+const byteArray X509Certificate_GnuTLS::getSubjectKeyIdentifier() const
+{
+	byte_t keyId[64];
+	size_t keyIdSize = sizeof(keyId);
+	unsigned int critical = 0;
+
+	if (gnutls_x509_crt_get_subject_key_id(m_data->cert, keyId, &keyIdSize, &critical) != GNUTLS_E_SUCCESS)
+		return byteArray();
+
+	return byteArray(keyId, keyId + keyIdSize);
+}
+
+
+const byteArray X509Certificate_GnuTLS::getAuthorityKeyIdentifier() const
+{
+	byte_t keyId[64];
+	size_t keyIdSize = sizeof(keyId);
+	unsigned int critical = 0;
+
+	if (gnutls_x509_crt_get_authority_key_id(m_data->cert, keyId, &keyIdSize, &critical) != GNUTLS_E_SUCCESS)
+		return byteArray();
+
+	return byteArray(keyId, keyId + keyIdSize);
+}
+
+
 bool X509Certificate_GnuTLS::verify(ref <const X509Certificate> caCert_) const
 {
 	ref <const X509Certificate_GnuTLS> caCert =
@@ -315,6 +315,57 @@ bool X509Certificate_OpenSSL::checkIssuer(ref <const X509Certificate> cert_) con
 }
 
 
+const string X509Certificate_OpenSSL::getSubject() const
+{
+	BIO* out = BIO_new(BIO_s_mem());
+	X509_NAME_print_ex(out, X509_get_subject_name(m_data->cert), 0, XN_FLAG_RFC2253);
+
+	unsigned char* subject;
+	const int n = BIO_get_mem_data(out, &subject);
+
+	const string name(reinterpret_cast <char*>(subject), n);
+	BIO_free(out);
+
+	return name;
+}
+
+
+const byteArray X509Certificate_OpenSSL::getSubjectKeyIdentifier() const
+{
+	byteArray keyId;
+
+	ASN1_OCTET_STRING* skid = reinterpret_cast <ASN1_OCTET_STRING*>
+		(X509_get_ext_d2i(m_data->cert, NID_subject_key_identifier, NULL, NULL));
+
+	if (skid)
+	{
+		keyId.assign(skid->data, skid->data + skid->length);
+		ASN1_OCTET_STRING_free(skid);
+	}
+
+	return keyId;
+}
+
+
+const byteArray X509Certificate_OpenSSL::getAuthorityKeyIdentifier() const
+{
+	byteArray keyId;
+
+	AUTHORITY_KEYID* akid = reinterpret_cast <AUTHORITY_KEYID*>
+		(X509_get_ext_d2i(m_data->cert, NID_authority_key_identifier, NULL, NULL));
+
+	if (akid)
+	{
+		if (akid->keyid)
+			keyId.assign(akid->keyid->data, akid->keyid->data + akid->keyid->length);
+
+		AUTHORITY_KEYID_free(akid);
+	}
+
+	return keyId;
+}
+
+
 bool X509Certificate_OpenSSL::verify(ref <const X509Certificate> caCert_) const
 {
 	ref <const X509Certificate_OpenSSL> caCert =
@@ -67,6 +67,11 @@ public:
 
     bool checkIssuer(ref <const X509Certificate> issuer) const;
 
+	const string getSubject() const;
+
+	const byteArray getSubjectKeyIdentifier() const;
+	const byteArray getAuthorityKeyIdentifier() const;
+
 	bool verify(ref <const X509Certificate> caCert) const;
 
     // FIX by Elmue: return of the non-matching names
@@ -93,11 +93,41 @@ const string SASLSocket::getPeerAddress() const
 }
 
 
+port_t SASLSocket::getPeerPort() const
+{
+	return m_wrapped->getPeerPort();
+}
+
+
+void SASLSocket::setCancellationToken(ref <utility::cancellationToken> token)
+{
+	m_wrapped->setCancellationToken(token);
+}
+
+
+ref <utility::cancellationToken> SASLSocket::getCancellationToken() const
+{
+	return m_wrapped->getCancellationToken();
+}
+
+
+bool SASLSocket::hasBufferedData() const
+{
+	return m_pendingLen != 0 || m_wrapped->hasBufferedData();
+}
+
+
+ref <net::socket> SASLSocket::getUnderlyingSocket() const
+{
+	return m_wrapped;
+}
+
+
 void SASLSocket::receive(string& buffer)
 {
 	const size_type n = receiveRaw(m_recvBuffer, sizeof(m_recvBuffer));
 
-	buffer = string(m_recvBuffer, n);
+	buffer.assign(m_recvBuffer, n);
 }
 
 
@@ -159,6 +189,16 @@ SASLSocket::size_type SASLSocket::receiveRaw(char* buffer, const size_type count
 }
 
 
+bool SASLSocket::waitForReadable(const unsigned int msecs)
+{
+	// Data may already be available without reading from the network
+	if (hasBufferedData())
+		return true;
+
+	return m_wrapped->waitForReadable(msecs);
+}
+
+
 void SASLSocket::send(const string& buffer)
 {
 	sendRaw(buffer.data(), buffer.length());
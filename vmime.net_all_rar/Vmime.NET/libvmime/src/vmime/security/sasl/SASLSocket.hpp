@@ -61,6 +61,8 @@ public:
 	void receive(string& buffer);
 	size_type receiveRaw(char* buffer, const size_type count);
 
+	bool waitForReadable(const unsigned int msecs);
+
 	void send(const string& buffer);
 	void sendRaw(const char* buffer, const size_type count);
 	size_type sendRawNonBlocking(const char* buffer, const size_type count);
@@ -71,6 +73,13 @@ public:
 
 	const string getPeerName() const;
 	const string getPeerAddress() const;
+	port_t getPeerPort() const;
+
+	void setCancellationToken(ref <utility::cancellationToken> token);
+	ref <utility::cancellationToken> getCancellationToken() const;
+
+	bool hasBufferedData() const;
+	ref <net::socket> getUnderlyingSocket() const;
 
 private:
 
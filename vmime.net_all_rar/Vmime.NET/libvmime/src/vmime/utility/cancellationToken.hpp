@@ -0,0 +1,85 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_UTILITY_CANCELLATIONTOKEN_HPP_INCLUDED
+#define VMIME_UTILITY_CANCELLATIONTOKEN_HPP_INCLUDED
+
+
+#include "../vmime/base.hpp"
+
+
+namespace vmime {
+namespace utility {
+
+
+/** Allows cancelling lengthy operations from another thread.
+  *
+  * A token can be attached to a service (see net::service::setCancellationToken()),
+  * to cancel only the operations of this service, or shared by several services.
+  * Tokens are created by the platform handler.
+  */
+
+class VMIME_EXPORT cancellationToken : public object
+{
+public:
+
+	virtual ~cancellationToken();
+
+	/** Requests the cancellation of the operations which use this token.
+	  * Operations waiting for network data are woken up immediately, and
+	  * throw exceptions::operation_cancelled. The token stays cancelled
+	  * until reset() is called.
+	  *
+	  * This function can be called from any thread.
+	  */
+	virtual void cancel() = 0;
+
+	/** Clears a previous cancellation request, so that the token can be
+	  * used for new operations.
+	  */
+	virtual void reset() = 0;
+
+	/** Tests whether cancellation has been requested.
+	  *
+	  * @return true if cancel() has been called, false otherwise
+	  */
+	virtual bool isCancelled() const = 0;
+
+	/** Throws an exception if cancellation has been requested.
+	  *
+	  * @throw exceptions::operation_cancelled if cancel() has been called
+	  */
+	void check() const;
+
+protected:
+
+	cancellationToken();
+	cancellationToken(cancellationToken&);
+};
+
+
+} // utility
+} // vmime
+
+
+#endif // VMIME_UTILITY_CANCELLATIONTOKEN_HPP_INCLUDED
@@ -65,6 +65,23 @@ public:
 };
 
 
+/** Output stream to a file (see fileWriter::getOutputStream).
+  */
+
+class VMIME_EXPORT fileOutputStream : public outputStream
+{
+public:
+
+	/** Flush the stream and write the data of the file to the disk,
+	  * so that it is not lost if the system crashes. This may be slow:
+	  * flush() does not do this.
+	  *
+	  * @throw exceptions::filesystem_exception if an error occurs
+	  */
+	virtual void sync() = 0;
+};
+
+
 /** Write to a file.
   */
 
@@ -74,7 +91,7 @@ public:
 
 	virtual ~fileWriter() { }
 
-	virtual ref <utility::outputStream> getOutputStream() = 0;
+	virtual ref <utility::fileOutputStream> getOutputStream() = 0;
 };
 
 
@@ -174,6 +191,15 @@ public:
 	  */
 	virtual void rename(const path& newName) = 0;
 
+	/** Rename the file, replacing the file named newName if it exists.
+	  * The old contents of newName are replaced in one step: an
+	  * interruption never leaves newName missing.
+	  *
+	  * @param newName full path of the new file
+	  * @throw exceptions::filesystem_exception if an error occurs
+	  */
+	virtual void renameReplace(const path& newName) = 0;
+
 	/** Deletes this file/directory.
 	  * If this is a directory, it must be empty.
 	  *
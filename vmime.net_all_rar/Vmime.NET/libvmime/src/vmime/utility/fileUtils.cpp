@@ -0,0 +1,141 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include "../vmime/utility/fileUtils.hpp"
+
+#include "../vmime/exception.hpp"
+#include "../vmime/platform.hpp"
+
+
+namespace vmime {
+namespace utility {
+
+
+// static
+const file::path::component fileUtils::escapeName(const string& str)
+{
+	static const char hexChars[] = "0123456789ABCDEF";
+
+	if (str.empty())
+		throw exceptions::invalid_argument();
+
+	string escaped;
+	escaped.reserve(str.length());
+
+	for (string::const_iterator it = str.begin() ; it != str.end() ; ++it)
+	{
+		const unsigned char c = static_cast <unsigned char>(*it);
+
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		    (c >= '0' && c <= '9') || c == '-' || c == '_' ||
+		    (c == '.' && it != str.begin()))
+		{
+			escaped += static_cast <char>(c);
+		}
+		else
+		{
+			escaped += '%';
+			escaped += hexChars[c >> 4];
+			escaped += hexChars[c & 0xf];
+		}
+	}
+
+	return file::path::component(escaped, vmime::charset(vmime::charsets::US_ASCII));
+}
+
+
+// static
+const file::path fileUtils::getTemporaryPath(const file::path& path)
+{
+	file::path tmpPath = path.getParent();
+	tmpPath.appendComponent(file::path::component
+		(path.getLastComponent().getBuffer() + ".tmp", vmime::charset(vmime::charsets::US_ASCII)));
+
+	return tmpPath;
+}
+
+
+// static
+void fileUtils::writeFileAtomically(const file::path& path, const string& data,
+	const bool sync)
+{
+	ref <fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
+
+	const file::path tmpPath = getTemporaryPath(path);
+
+	try
+	{
+		ref <file> dir = fsf->create(path.getParent());
+
+		if (!dir->exists())
+			dir->createDirectory(true);
+
+		ref <file> tmpFile = fsf->create(tmpPath);
+
+		if (!tmpFile->exists())
+			tmpFile->createFile();
+
+		{
+			ref <fileWriter> writer = tmpFile->getFileWriter();
+			ref <fileOutputStream> os = writer->getOutputStream();
+
+			os->write(data.data(), data.length());
+
+			if (sync)
+				os->sync();
+			else
+				os->flush();
+		}
+
+		tmpFile->renameReplace(path);
+	}
+	catch (exceptions::filesystem_exception&)
+	{
+		try
+		{
+			ref <file> tmpFile = fsf->create(tmpPath);
+
+			if (tmpFile->exists())
+				tmpFile->remove();
+		}
+		catch (exceptions::filesystem_exception&)
+		{
+			// Ignore
+		}
+
+		throw;
+	}
+}
+
+
+} // utility
+} // vmime
+
+
+#endif // VMIME_HAVE_FILESYSTEM_FEATURES
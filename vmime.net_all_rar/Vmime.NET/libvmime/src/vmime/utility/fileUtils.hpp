@@ -0,0 +1,91 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_UTILITY_FILEUTILS_HPP_INCLUDED
+#define VMIME_UTILITY_FILEUTILS_HPP_INCLUDED
+
+
+#include "../vmime/config.hpp"
+
+
+#if VMIME_HAVE_FILESYSTEM_FEATURES
+
+
+#include "../vmime/utility/file.hpp"
+
+
+namespace vmime {
+namespace utility {
+
+
+/** Miscellaneous functions related to files.
+  */
+
+class VMIME_EXPORT fileUtils
+{
+public:
+
+	/** Escape a string so that it can be used as a single file name
+	  * component. All characters except ASCII letters, digits, '-', '_'
+	  * and '.' are written as "%XX". A leading '.' is escaped too, so
+	  * that the name is never "." or ".." and never designates a
+	  * directory other than the one it is appended to.
+	  *
+	  * @param str string to escape
+	  * @return file name component
+	  * @throw exceptions::invalid_argument if the string is empty
+	  */
+	static const file::path::component escapeName(const string& str);
+
+	/** Return the path of the temporary file used by writeFileAtomically()
+	  * for the specified file (the ".tmp" extension is appended).
+	  *
+	  * @param path full path of the file
+	  * @return full path of the temporary file
+	  */
+	static const file::path getTemporaryPath(const file::path& path);
+
+	/** Replace the contents of a file. The data is written into a
+	  * temporary file which then replaces the file in one step, so
+	  * that an interrupted write never leaves a truncated file. The
+	  * parent directory is created if needed.
+	  *
+	  * @param path full path of the file
+	  * @param data new contents of the file
+	  * @param sync if true, the data is written to the disk before the
+	  * file is replaced (see fileOutputStream::sync())
+	  * @throw exceptions::filesystem_exception if an error occurs; the
+	  * file is left unchanged in this case
+	  */
+	static void writeFileAtomically(const file::path& path, const string& data,
+		const bool sync = false);
+};
+
+
+} // utility
+} // vmime
+
+
+#endif // VMIME_HAVE_FILESYSTEM_FEATURES
+
+#endif // VMIME_UTILITY_FILEUTILS_HPP_INCLUDED
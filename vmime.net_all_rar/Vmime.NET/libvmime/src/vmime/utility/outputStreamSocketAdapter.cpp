@@ -29,27 +29,65 @@
 
 #include "../vmime/net/socket.hpp"
 
+#include <algorithm>
+
 
 namespace vmime {
 namespace utility {
 
 
 outputStreamSocketAdapter::outputStreamSocketAdapter(net::socket& sok)
-	: m_socket(sok)
+	: m_socket(sok), m_blockSize(std::max <size_type>(sok.getBlockSize(), 1))
 {
+	m_buffer.reserve(m_blockSize);
 }
 
 
 void outputStreamSocketAdapter::write
 	(const value_type* const data, const size_type count)
 {
-	m_socket.sendRaw(data, count);
+	const value_type* pos = data;
+	size_type remaining = count;
+
+	// Complete the pending block
+	if (!m_buffer.empty())
+	{
+		const size_type n = std::min(remaining, m_blockSize - m_buffer.size());
+
+		m_buffer.insert(m_buffer.end(), pos, pos + n);
+
+		pos += n;
+		remaining -= n;
+
+		if (m_buffer.size() < m_blockSize)
+			return;
+
+		m_socket.sendRaw(&m_buffer[0], m_buffer.size());
+		m_buffer.clear();
+	}
+
+	// Send whole blocks directly
+	if (remaining >= m_blockSize)
+	{
+		const size_type n = remaining - remaining % m_blockSize;
+
+		m_socket.sendRaw(pos, n);
+
+		pos += n;
+		remaining -= n;
+	}
+
+	m_buffer.insert(m_buffer.end(), pos, pos + remaining);
 }
 
 
 void outputStreamSocketAdapter::flush()
 {
-	// Do nothing
+	if (m_buffer.empty())
+		return;
+
+	m_socket.sendRaw(&m_buffer[0], m_buffer.size());
+	m_buffer.clear();
 }
 
 
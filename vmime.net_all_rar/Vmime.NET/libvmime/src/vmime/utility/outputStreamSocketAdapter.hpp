@@ -27,6 +27,8 @@
 
 #include "../vmime/utility/outputStream.hpp"
 
+#include <vector>
+
 
 #if VMIME_HAVE_MESSAGING_FEATURES
 
@@ -43,6 +45,11 @@ namespace utility {
 
 
 /** An output stream that is connected to a socket.
+  *
+  * Data is sent by blocks of the size returned by socket::getBlockSize(),
+  * so that small writes do not result in as many packets (or TLS records).
+  * Call flush() to send the data which is still buffered: it is not
+  * sent when the adapter is destroyed.
   */
 
 class VMIME_EXPORT outputStreamSocketAdapter : public outputStream
@@ -61,6 +68,9 @@ private:
 	outputStreamSocketAdapter(const outputStreamSocketAdapter&);
 
 	net::socket& m_socket;
+
+	const size_type m_blockSize;
+	std::vector <value_type> m_buffer;
 };
 
 
@@ -0,0 +1,78 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_UTILITY_SYNC_CONDITION_HPP_INCLUDED
+#define VMIME_UTILITY_SYNC_CONDITION_HPP_INCLUDED
+
+
+#include "../vmime/base.hpp"
+
+#include "../vmime/utility/sync/criticalSection.hpp"
+
+
+namespace vmime {
+namespace utility {
+namespace sync {
+
+
+/** Condition variable: lets a thread wait until another thread
+  * changes some state protected by a critical section.
+  */
+
+class VMIME_EXPORT condition : public object
+{
+public:
+
+	virtual ~condition();
+
+	/** Leaves the critical section and waits until the condition is
+	  * notified, then enters the critical section again. The critical
+	  * section must be locked by the calling thread. The thread may
+	  * also wake up without being notified, so the caller must check
+	  * the state it is waiting for again.
+	  *
+	  * @param cs critical section which protects the state
+	  */
+	virtual void wait(ref <criticalSection> cs) = 0;
+
+	/** Wakes up one of the threads waiting on this condition.
+	  */
+	virtual void notifyOne() = 0;
+
+	/** Wakes up all the threads waiting on this condition.
+	  */
+	virtual void notifyAll() = 0;
+
+protected:
+
+	condition();
+	condition(condition&);
+};
+
+
+} // sync
+} // utility
+} // vmime
+
+
+#endif // VMIME_UTILITY_SYNC_CONDITION_HPP_INCLUDED
@@ -0,0 +1,129 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/imap/IMAPFileCache.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPFileCacheTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testMessageInfo)
+		VMIME_TEST(testUIDValidityChange)
+		VMIME_TEST(testDotMailboxNames)
+	VMIME_TEST_LIST_END
+
+
+	typedef vmime::net::imap::IMAPCache::mailboxKey mailboxKey;
+	typedef vmime::net::imap::IMAPCache::messageInfo messageInfo;
+
+
+	static const messageInfo createInfo(const vmime::string& header)
+	{
+		messageInfo info;
+		info.options = vmime::net::folder::FETCH_FLAGS | vmime::net::folder::FETCH_FULL_HEADER;
+		info.flags = vmime::net::message::FLAG_SEEN;
+		info.size = 1234;
+		info.header = header;
+
+		return info;
+	}
+
+
+	void testMessageInfo()
+	{
+		testTempDirectory tempDir;
+		vmime::net::imap::IMAPFileCache cache(tempDir.getPath());
+
+		const mailboxKey inbox("user@imap.example.com:993", "INBOX", 1);
+
+		cache.putMessageInfo(inbox, "42", createInfo("Subject: Test\r\n\r\n"));
+
+		messageInfo info;
+
+		VASSERT_TRUE("found", cache.getMessageInfo(inbox, "42", info));
+		VASSERT_EQ("flags", vmime::net::message::FLAG_SEEN, info.flags);
+		VASSERT_EQ("size", 1234, info.size);
+		VASSERT_EQ("header", "Subject: Test\r\n\r\n", info.header);
+
+		VASSERT_FALSE("other UID", cache.getMessageInfo(inbox, "43", info));
+	}
+
+	void testUIDValidityChange()
+	{
+		testTempDirectory tempDir;
+		vmime::net::imap::IMAPFileCache cache(tempDir.getPath());
+
+		cache.putMessageInfo(mailboxKey("server", "INBOX", 1), "42", createInfo("A"));
+
+		// Data cached for the old UID validity is discarded
+		vmime::net::imap::IMAPFileCache cache2(tempDir.getPath());
+
+		messageInfo info;
+
+		VASSERT_FALSE("new validity", cache2.getMessageInfo(mailboxKey("server", "INBOX", 2), "42", info));
+		VASSERT_FALSE("old validity", cache2.getMessageInfo(mailboxKey("server", "INBOX", 1), "42", info));
+	}
+
+	void testDotMailboxNames()
+	{
+		testTempDirectory tempDir;
+		vmime::net::imap::IMAPFileCache cache(tempDir.getPath());
+
+		const mailboxKey inbox("server", "INBOX", 1);
+		const mailboxKey otherServer("other", "INBOX", 1);
+
+		cache.putMessageInfo(inbox, "42", createInfo("inbox"));
+		cache.putMessageInfo(otherServer, "42", createInfo("other"));
+
+		// "." and ".." must not be used as directory names: the UID
+		// validity cleanup would then delete the data of the mailboxes
+		// or servers next to them
+		const mailboxKey dot("server", ".", 7);
+		const mailboxKey dotDot("server", "..", 7);
+		const mailboxKey dotDotServer("..", "INBOX", 7);
+
+		cache.putMessageInfo(dot, "42", createInfo("dot"));
+		cache.putMessageInfo(dotDot, "42", createInfo("dotdot"));
+		cache.putMessageInfo(dotDotServer, "42", createInfo("dotdot server"));
+
+		messageInfo info;
+
+		VASSERT_TRUE("inbox", cache.getMessageInfo(inbox, "42", info));
+		VASSERT_EQ("inbox header", "inbox", info.header);
+
+		VASSERT_TRUE("other server", cache.getMessageInfo(otherServer, "42", info));
+		VASSERT_EQ("other server header", "other", info.header);
+
+		VASSERT_TRUE("dot", cache.getMessageInfo(dot, "42", info));
+		VASSERT_EQ("dot header", "dot", info.header);
+
+		VASSERT_TRUE("dotdot", cache.getMessageInfo(dotDot, "42", info));
+		VASSERT_EQ("dotdot header", "dotdot", info.header);
+
+		VASSERT_TRUE("dotdot server", cache.getMessageInfo(dotDotServer, "42", info));
+		VASSERT_EQ("dotdot server header", "dotdot server", info.header);
+	}
+
+VMIME_TEST_SUITE_END
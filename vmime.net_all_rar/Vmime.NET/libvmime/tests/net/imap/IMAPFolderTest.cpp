@@ -0,0 +1,471 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "IMAPTestUtils.hpp"
+
+
+/** IMAP test server without MOVE, which records the commands it
+  * receives. "STORE" fails if FAIL_STORE is true. A command is marked
+  * with " (pipelined)" if the response to the previous command has not
+  * been read by the client yet.
+  */
+template <bool UIDPLUS, bool FAIL_STORE>
+class moveIMAPTestSocket : public IMAPTestSocket
+{
+public:
+
+	static std::vector <vmime::string> commands;
+
+	bool processIMAPCommand(const vmime::string& tag,
+		const vmime::string& cmd, const vmime::string& args)
+	{
+		if (cmd == "COPY" || cmd == "UID COPY")
+		{
+			commands.push_back(cmd + " " + args);
+			localSend(tag + " OK COPY completed\r\n");
+
+			return true;
+		}
+		else if (cmd == "STORE" || cmd == "UID STORE")
+		{
+			commands.push_back(cmd + " " + args);
+
+			if (FAIL_STORE)
+				localSend(tag + " NO STORE failed\r\n");
+			else
+				localSend(tag + " OK STORE completed\r\n");
+
+			return true;
+		}
+		else if (cmd == "EXPUNGE" || cmd == "UID EXPUNGE")
+		{
+			commands.push_back(cmd + (args.empty() ? "" : " " + args) +
+				(hasBufferedData() ? " (pipelined)" : ""));
+			localSend(tag + " OK EXPUNGE completed\r\n");
+
+			return true;
+		}
+
+		return false;
+	}
+
+protected:
+
+	const vmime::string getCapabilities() const
+	{
+		return UIDPLUS ? " UIDPLUS" : "";
+	}
+};
+
+template <bool UIDPLUS, bool FAIL_STORE>
+std::vector <vmime::string> moveIMAPTestSocket <UIDPLUS, FAIL_STORE>::commands;
+
+
+/** IMAP test server which answers each FETCH with three messages. The
+  * UIDs tell which FETCH command a message belongs to (1x, 2x, ...).
+  */
+class fetchIMAPTestSocket : public IMAPTestSocket
+{
+public:
+
+	static int fetchCount;
+
+	bool processIMAPCommand(const vmime::string& tag,
+		const vmime::string& cmd, const vmime::string& /* args */)
+	{
+		if (cmd == "FETCH")
+		{
+			++fetchCount;
+
+			for (int i = 1 ; i <= 3 ; ++i)
+			{
+				std::ostringstream oss;
+				oss << "* " << i << " FETCH (UID " << (fetchCount * 10 + i) << ")\r\n";
+
+				localSend(oss.str());
+			}
+
+			localSend(tag + " OK FETCH completed\r\n");
+
+			return true;
+		}
+
+		return false;
+	}
+};
+
+int fetchIMAPTestSocket::fetchCount = 0;
+
+
+/** Collects the UIDs of fetched messages, and optionally throws
+  * when it receives the first message.
+  */
+class testMessageFetchHandler : public vmime::net::imap::IMAPFolder::messageFetchHandler
+{
+public:
+
+	testMessageFetchHandler(const bool fail)
+		: m_fail(fail)
+	{
+	}
+
+	bool handleMessage(vmime::ref <vmime::net::message> msg)
+	{
+		if (m_fail)
+			throw vmime::exceptions::invalid_argument();
+
+		uids.push_back(msg->getUID());
+		return true;
+	}
+
+	std::vector <vmime::string> uids;
+
+private:
+
+	const bool m_fail;
+};
+
+
+/** IMAP test server with a single message (UID 42, seen), which is
+  * removed by "EXPUNGE".
+  */
+class cachedIMAPTestSocket : public IMAPTestSocket
+{
+public:
+
+	bool processIMAPCommand(const vmime::string& tag,
+		const vmime::string& cmd, const vmime::string& /* args */)
+	{
+		if (cmd == "FETCH" || cmd == "UID FETCH")
+		{
+			localSend("* 1 FETCH (UID 42 FLAGS (\\Seen))\r\n");
+			localSend(tag + " OK FETCH completed\r\n");
+
+			return true;
+		}
+		else if (cmd == "EXPUNGE")
+		{
+			localSend("* 1 EXPUNGE\r\n");
+			localSend(tag + " OK EXPUNGE completed\r\n");
+
+			return true;
+		}
+
+		return false;
+	}
+};
+
+
+/** IMAP test server with ESEARCH. The response to a SEARCH command
+  * also contains the ESEARCH response of another command, and an item
+  * which is not known by the client.
+  */
+class esearchIMAPTestSocket : public IMAPTestSocket
+{
+public:
+
+	bool processIMAPCommand(const vmime::string& tag,
+		const vmime::string& cmd, const vmime::string& /* args */)
+	{
+		if (cmd == "SEARCH" || cmd == "UID SEARCH")
+		{
+			localSend("* ESEARCH (TAG \"x999\") ALL 1:100\r\n");
+			localSend("* ESEARCH (TAG \"" + tag + "\")" + (cmd == "UID SEARCH" ? " UID" : "") +
+			          " X-PARTIAL (1:10 (2 4)) COUNT 4 ALL 2:4,7\r\n");
+			localSend(tag + " OK SEARCH completed\r\n");
+
+			return true;
+		}
+
+		return false;
+	}
+
+protected:
+
+	const vmime::string getCapabilities() const
+	{
+		return " ESEARCH";
+	}
+};
+
+
+/** In-memory cache which counts the entries written and removed.
+  */
+class testIMAPCache : public vmime::net::imap::IMAPCache
+{
+public:
+
+	testIMAPCache()
+		: putCount(0)
+	{
+	}
+
+	bool getMessageInfo(const mailboxKey& /* mbox */, const vmime::net::message::uid& uid, messageInfo& info)
+	{
+		std::map <vmime::string, messageInfo>::const_iterator it = entries.find(uid);
+
+		if (it == entries.end())
+			return false;
+
+		info = (*it).second;
+		return true;
+	}
+
+	void putMessageInfo(const mailboxKey& /* mbox */, const vmime::net::message::uid& uid, const messageInfo& info)
+	{
+		entries[uid] = info;
+		++putCount;
+	}
+
+	bool getBodySection(const mailboxKey& /* mbox */, const vmime::net::message::uid& /* uid */,
+		const vmime::string& /* section */, vmime::utility::outputStream& /* os */)
+	{
+		return false;
+	}
+
+	void putBodySection(const mailboxKey& /* mbox */, const vmime::net::message::uid& /* uid */,
+		const vmime::string& /* section */, const vmime::string& /* data */)
+	{
+	}
+
+	size_t getMaxBodySectionSize() const
+	{
+		return 0;
+	}
+
+	void removeMessage(const mailboxKey& /* mbox */, const vmime::net::message::uid& uid)
+	{
+		entries.erase(uid);
+		removed.push_back(uid);
+	}
+
+	std::map <vmime::string, messageInfo> entries;
+	int putCount;
+	std::vector <vmime::string> removed;
+};
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPFolderTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testMoveMessages_UIDPLUS)
+		VMIME_TEST(testMoveMessages_NoUIDPLUS)
+		VMIME_TEST(testMoveMessages_StoreFailure)
+		VMIME_TEST(testFetchMessages_HandlerFailure)
+		VMIME_TEST(testFetchCached_FlagsUnchanged)
+		VMIME_TEST(testFetchCached_FlagsChanged)
+		VMIME_TEST(testFetchCached_Expunged)
+		VMIME_TEST(testExtendedSearch_ESearch)
+		VMIME_TEST(testSearch_ESearch)
+	VMIME_TEST_LIST_END
+
+
+	static vmime::ref <vmime::net::imap::IMAPFolder> openCachedInbox
+		(vmime::ref <vmime::net::store>& store, vmime::ref <testIMAPCache> cache, const int cachedFlags)
+	{
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openIMAPTestInbox <cachedIMAPTestSocket>(store);
+
+		vmime::net::imap::IMAPCache::messageInfo info;
+		info.options = vmime::net::folder::FETCH_FLAGS | vmime::net::folder::FETCH_UID;
+		info.flags = cachedFlags;
+
+		cache->entries["42"] = info;
+
+		store.dynamicCast <vmime::net::imap::IMAPStore>()->setCache(cache);
+
+		return folder;
+	}
+
+
+	void testMoveMessages_UIDPLUS()
+	{
+		typedef moveIMAPTestSocket <true, false> server;
+		server::commands.clear();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder = openIMAPTestInbox <server>(store);
+
+		folder->moveMessages(vmime::net::folder::path("Archive"), vmime::net::messageSet::byUID(42));
+
+		// Only the moved messages are expunged
+		VASSERT_EQ("Count", 3, server::commands.size());
+		VASSERT_EQ("COPY", "UID COPY 42 Archive", server::commands[0]);
+		VASSERT_EQ("STORE", "UID STORE 42 +FLAGS.SILENT (\\Deleted)", server::commands[1]);
+		VASSERT_EQ("EXPUNGE", "UID EXPUNGE 42 (pipelined)", server::commands[2]);
+	}
+
+	void testMoveMessages_NoUIDPLUS()
+	{
+		typedef moveIMAPTestSocket <false, false> server;
+		server::commands.clear();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder = openIMAPTestInbox <server>(store);
+
+		folder->moveMessages(vmime::net::folder::path("Archive"), vmime::net::messageSet::byUID(42));
+
+		// "EXPUNGE" would also remove other messages marked as deleted
+		VASSERT_EQ("Count", 2, server::commands.size());
+		VASSERT_EQ("COPY", "UID COPY 42 Archive", server::commands[0]);
+		VASSERT_EQ("STORE", "UID STORE 42 +FLAGS.SILENT (\\Deleted)", server::commands[1]);
+	}
+
+	void testMoveMessages_StoreFailure()
+	{
+		typedef moveIMAPTestSocket <true, true> server;
+		server::commands.clear();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder = openIMAPTestInbox <server>(store);
+
+		VASSERT_THROW("Move", folder->moveMessages(vmime::net::folder::path("Archive"),
+			vmime::net::messageSet::byUID(42)), vmime::exceptions::command_error);
+
+		// UID EXPUNGE is pipelined with STORE: it only removes copied messages
+		VASSERT_EQ("Count", 3, server::commands.size());
+		VASSERT_EQ("COPY", "UID COPY 42 Archive", server::commands[0]);
+		VASSERT_EQ("STORE", "UID STORE 42 +FLAGS.SILENT (\\Deleted)", server::commands[1]);
+		VASSERT_EQ("EXPUNGE", "UID EXPUNGE 42 (pipelined)", server::commands[2]);
+
+		// Both responses have been read
+		folder->noop();
+	}
+
+	void testFetchMessages_HandlerFailure()
+	{
+		fetchIMAPTestSocket::fetchCount = 0;
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openIMAPTestInbox <fetchIMAPTestSocket>(store);
+
+		testMessageFetchHandler failingHandler(true);
+
+		VASSERT_THROW("Handler", folder->fetchMessages(vmime::net::messageSet::byNumber(1, 3),
+			vmime::net::folder::FETCH_UID, &failingHandler), vmime::exceptions::invalid_argument);
+
+		// The rest of the first response must not be read by the next command
+		testMessageFetchHandler handler(false);
+
+		folder->fetchMessages(vmime::net::messageSet::byNumber(1, 3),
+			vmime::net::folder::FETCH_UID, &handler);
+
+		VASSERT_EQ("Count", 3, handler.uids.size());
+		VASSERT_EQ("UID 1", "21", handler.uids[0]);
+		VASSERT_EQ("UID 2", "22", handler.uids[1]);
+		VASSERT_EQ("UID 3", "23", handler.uids[2]);
+	}
+
+	void testFetchCached_FlagsUnchanged()
+	{
+		vmime::ref <testIMAPCache> cache = vmime::create <testIMAPCache>();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openCachedInbox(store, cache, vmime::net::message::FLAG_SEEN);
+
+		vmime::ref <vmime::net::message> msg = folder->getMessage(1);
+		folder->fetchMessage(msg, vmime::net::folder::FETCH_FLAGS);
+
+		VASSERT_EQ("Flags", vmime::net::message::FLAG_SEEN, msg->getFlags());
+
+		// The cache entry is up to date: it must not be written again
+		VASSERT_EQ("Put", 0, cache->putCount);
+	}
+
+	void testFetchCached_FlagsChanged()
+	{
+		vmime::ref <testIMAPCache> cache = vmime::create <testIMAPCache>();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder = openCachedInbox(store, cache, 0);
+
+		vmime::ref <vmime::net::message> msg = folder->getMessage(1);
+		folder->fetchMessage(msg, vmime::net::folder::FETCH_FLAGS);
+
+		VASSERT_EQ("Put", 1, cache->putCount);
+		VASSERT_EQ("Flags", vmime::net::message::FLAG_SEEN, cache->entries["42"].flags);
+	}
+
+	void testFetchCached_Expunged()
+	{
+		vmime::ref <testIMAPCache> cache = vmime::create <testIMAPCache>();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openCachedInbox(store, cache, vmime::net::message::FLAG_SEEN);
+
+		vmime::ref <vmime::net::message> msg = folder->getMessage(1);
+		folder->fetchMessage(msg, vmime::net::folder::FETCH_FLAGS);
+
+		folder->expunge();
+
+		VASSERT_EQ("Removed", 1, cache->removed.size());
+		VASSERT_EQ("UID", "42", cache->removed[0]);
+		VASSERT_EQ("Entries", 0, cache->entries.size());
+	}
+
+	void testExtendedSearch_ESearch()
+	{
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openIMAPTestInbox <esearchIMAPTestSocket>(store);
+
+		const vmime::net::imap::IMAPFolder::searchResult result = folder->extendedSearch
+			(vmime::net::searchCriteria::from("bob"),
+			 vmime::net::imap::IMAPFolder::SEARCH_RETURN_COUNT |
+			 vmime::net::imap::IMAPFolder::SEARCH_RETURN_ALL, /* uid */ true);
+
+		// The response of the other command is ignored, the unknown item is skipped
+		VASSERT_EQ("Count", 4, static_cast <int>(result.count));
+
+		// The set is not expanded
+		VASSERT_TRUE("UID set", result.all.isUIDSet());
+		VASSERT_EQ("Ranges", 2, result.all.getRangeCount());
+		VASSERT_TRUE("UID 2", result.all.contains(vmime::net::message::uid("2")));
+		VASSERT_TRUE("UID 4", result.all.contains(vmime::net::message::uid("4")));
+		VASSERT_FALSE("UID 5", result.all.contains(vmime::net::message::uid("5")));
+		VASSERT_TRUE("UID 7", result.all.contains(vmime::net::message::uid("7")));
+		VASSERT_FALSE("UID 100", result.all.contains(vmime::net::message::uid("100")));
+	}
+
+	void testSearch_ESearch()
+	{
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openIMAPTestInbox <esearchIMAPTestSocket>(store);
+
+		const vmime::net::messageSet set = folder->search(vmime::net::searchCriteria::from("bob"));
+
+		VASSERT_TRUE("Number set", set.isNumberSet());
+		VASSERT_EQ("Ranges", 2, set.getRangeCount());
+		VASSERT_TRUE("3", set.contains(3));
+		VASSERT_FALSE("5", set.contains(5));
+		VASSERT_TRUE("7", set.contains(7));
+		VASSERT_FALSE("100", set.contains(100));
+	}
+
+VMIME_TEST_SUITE_END
@@ -0,0 +1,78 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/imap/IMAPMessageStructure.hpp"
+#include "vmime/net/imap/IMAPMessagePart.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPMessageStructureTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testSerialize)
+		VMIME_TEST(testDeserializeInvalid)
+	VMIME_TEST_LIST_END
+
+
+	void testSerialize()
+	{
+		const vmime::string data =
+			"1\n"
+			"multipart mixed 0 7bit\n"
+			"2\n"
+			"text plain 12 quoted-printable\n"
+			"0\n"
+			"application pdf 1024 base64\n"
+			"0\n";
+
+		vmime::ref <vmime::net::imap::IMAPMessageStructure> str =
+			vmime::net::imap::IMAPMessageStructure::deserialize(data);
+
+		VASSERT_EQ("count", 1, static_cast <int>(str->getPartCount()));
+
+		vmime::ref <vmime::net::imap::IMAPMessagePart> root =
+			str->getPartAt(0).dynamicCast <vmime::net::imap::IMAPMessagePart>();
+
+		VASSERT_EQ("root type", "multipart/mixed", root->getType().generate());
+		VASSERT_EQ("sub count", 2, static_cast <int>(root->getStructure()->getPartCount()));
+
+		vmime::ref <vmime::net::imap::IMAPMessagePart> pdf =
+			root->getStructure()->getPartAt(1).dynamicCast <vmime::net::imap::IMAPMessagePart>();
+
+		VASSERT_EQ("pdf type", "application/pdf", pdf->getType().generate());
+		VASSERT_EQ("pdf size", 1024, pdf->getSize());
+		VASSERT_EQ("pdf number", 1, pdf->getNumber());
+		VASSERT_EQ("pdf encoding", "base64", pdf->getEncoding().getName());
+
+		VASSERT_EQ("serialize", data, str->serialize());
+	}
+
+	void testDeserializeInvalid()
+	{
+		VASSERT_THROW("invalid",
+			vmime::net::imap::IMAPMessageStructure::deserialize("1\ntext plain"),
+			vmime::exceptions::invalid_argument);
+	}
+
+VMIME_TEST_SUITE_END
@@ -25,15 +25,43 @@
 
 #include "vmime/net/imap/IMAPTag.hpp"
 #include "vmime/net/imap/IMAPParser.hpp"
+#include "vmime/net/imap/IMAPUtils.hpp"
 
 
 VMIME_TEST_SUITE_BEGIN(IMAPParserTest)
 
 	VMIME_TEST_LIST_BEGIN
 		VMIME_TEST(testExtraSpaceInCapaResponse)
+		VMIME_TEST(testResponseDataHandler)
+		VMIME_TEST(testBinaryFetchResponse)
+		VMIME_TEST(testESearchResponse)
+		VMIME_TEST(testESearchResponseUnknownItems)
+		VMIME_TEST(testThreadResponse)
 	VMIME_TEST_LIST_END
 
 
+	class testFetchResponseDataHandler : public vmime::net::imap::IMAPParser::responseDataHandler
+	{
+	public:
+
+		testFetchResponseDataHandler()
+			: m_count(0)
+		{
+		}
+
+		bool handleResponseData(const vmime::net::imap::IMAPParser::continue_req_or_response_data& data)
+		{
+			if (data.response_data() == NULL || data.response_data()->message_data() == NULL)
+				return false;
+
+			++m_count;
+			return true;
+		}
+
+		int m_count;
+	};
+
+
 	// For Apple iCloud IMAP server
 	void testExtraSpaceInCapaResponse()
 	{
@@ -63,4 +91,172 @@ VMIME_TEST_SUITE_BEGIN(IMAPParserTest)
 		VASSERT_THROW("strict mode", parser->readResponse(/* literalHandler */ NULL), vmime::exceptions::invalid_response);
 	}
 
+	void testResponseDataHandler()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <vmime::net::imap::IMAPTag> tag =
+			vmime::create <vmime::net::imap::IMAPTag>();
+
+		socket->localSend(
+			"* 1 FETCH (UID 10)\r\n"
+			"* 2 FETCH (UID 11)\r\n"
+			"* 3 EXISTS\r\n"
+			"a001 OK Fetch completed.\r\n");
+
+		vmime::ref <vmime::net::imap::IMAPParser> parser =
+			vmime::create <vmime::net::imap::IMAPParser>(tag, socket.dynamicCast <vmime::net::socket>(), toh, 0);
+
+		testFetchResponseDataHandler handler;
+
+		vmime::utility::auto_ptr <vmime::net::imap::IMAPParser::response> resp
+			(parser->readResponse(/* literalHandler */ NULL, &handler));
+
+		VASSERT_EQ("handled", 2, handler.m_count);
+		VASSERT_EQ("kept", 1, static_cast <int>(resp->continue_req_or_response_data().size()));
+		VASSERT_FALSE("bad", resp->isBad());
+	}
+
+	// BINARY extension (RFC-3516)
+	void testBinaryFetchResponse()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <vmime::net::imap::IMAPTag> tag =
+			vmime::create <vmime::net::imap::IMAPTag>();
+
+		socket->localSend(
+			"* 1 FETCH (BINARY.SIZE[2] 5 BINARY[2] ~{5}\r\nHello)\r\n"
+			"a001 OK Fetch completed.\r\n");
+
+		vmime::ref <vmime::net::imap::IMAPParser> parser =
+			vmime::create <vmime::net::imap::IMAPParser>(tag, socket.dynamicCast <vmime::net::socket>(), toh, 0);
+
+		vmime::utility::auto_ptr <vmime::net::imap::IMAPParser::response> resp
+			(parser->readResponse(/* literalHandler */ NULL));
+
+		VASSERT_EQ("count", 1, static_cast <int>(resp->continue_req_or_response_data().size()));
+
+		const std::vector <vmime::net::imap::IMAPParser::msg_att_item*>& items =
+			resp->continue_req_or_response_data()[0]->response_data()->message_data()->msg_att()->items();
+
+		VASSERT_EQ("items", 2, static_cast <int>(items.size()));
+		VASSERT_EQ("size type", vmime::net::imap::IMAPParser::msg_att_item::BINARY_SIZE, items[0]->type());
+		VASSERT_EQ("size", 5, static_cast <int>(items[0]->number()->value()));
+		VASSERT_EQ("section type", vmime::net::imap::IMAPParser::msg_att_item::BINARY_SECTION, items[1]->type());
+		VASSERT_EQ("section data", "Hello", items[1]->nstring()->value());
+	}
+
+
+	void testESearchResponse()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <vmime::net::imap::IMAPTag> tag =
+			vmime::create <vmime::net::imap::IMAPTag>();
+
+		socket->localSend(
+			"* ESEARCH (TAG \"a001\") UID COUNT 5 ALL 4:6,10,12\r\n"
+			"a001 OK Search completed.\r\n");
+
+		vmime::ref <vmime::net::imap::IMAPParser> parser =
+			vmime::create <vmime::net::imap::IMAPParser>(tag, socket.dynamicCast <vmime::net::socket>(), toh, 0);
+
+		vmime::utility::auto_ptr <vmime::net::imap::IMAPParser::response> resp
+			(parser->readResponse(/* literalHandler */ NULL));
+
+		const vmime::net::imap::IMAPParser::mailbox_data* data =
+			resp->continue_req_or_response_data()[0]->response_data()->mailbox_data();
+
+		VASSERT_EQ("type", vmime::net::imap::IMAPParser::mailbox_data::ESEARCH, data->type());
+		VASSERT_EQ("tag", "a001", data->esearch_response()->tag()->value());
+		VASSERT_TRUE("uid", data->esearch_response()->uid());
+
+		const std::vector <vmime::net::imap::IMAPParser::search_return_data*>& items =
+			data->esearch_response()->search_return_data();
+
+		VASSERT_EQ("items", 2, static_cast <int>(items.size()));
+		VASSERT_EQ("count", 5, static_cast <int>(items[0]->number()->value()));
+
+		const std::vector <int> all = vmime::net::imap::IMAPUtils::messageSetToNumberList
+			(vmime::net::imap::IMAPUtils::sequenceSetToMessageSet(items[1]->sequence_set(), false));
+
+		VASSERT_EQ("all count", 5, static_cast <int>(all.size()));
+		VASSERT_EQ("all 1", 4, all[0]);
+		VASSERT_EQ("all 3", 6, all[2]);
+		VASSERT_EQ("all 5", 12, all[4]);
+	}
+
+	void testESearchResponseUnknownItems()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <vmime::net::imap::IMAPTag> tag =
+			vmime::create <vmime::net::imap::IMAPTag>();
+
+		// Unknown items must be skipped (RFC 4731)
+		socket->localSend(
+			"* ESEARCH (TAG \"a001\") X-PARTIAL (1:10 (2 \"b c\" (d))) COUNT 5 X-EMPTY () X-NUM 7\r\n"
+			"a001 OK Search completed.\r\n");
+
+		vmime::ref <vmime::net::imap::IMAPParser> parser =
+			vmime::create <vmime::net::imap::IMAPParser>(tag, socket.dynamicCast <vmime::net::socket>(), toh, 0);
+
+		vmime::utility::auto_ptr <vmime::net::imap::IMAPParser::response> resp
+			(parser->readResponse(/* literalHandler */ NULL));
+
+		const vmime::net::imap::IMAPParser::mailbox_data* data =
+			resp->continue_req_or_response_data()[0]->response_data()->mailbox_data();
+
+		VASSERT_EQ("type", vmime::net::imap::IMAPParser::mailbox_data::ESEARCH, data->type());
+		VASSERT_FALSE("uid", data->esearch_response()->uid());
+
+		const std::vector <vmime::net::imap::IMAPParser::search_return_data*>& items =
+			data->esearch_response()->search_return_data();
+
+		VASSERT_EQ("items", 4, static_cast <int>(items.size()));
+		VASSERT_EQ("other 1", vmime::net::imap::IMAPParser::search_return_data::OTHER, items[0]->type());
+		VASSERT_EQ("count type", vmime::net::imap::IMAPParser::search_return_data::COUNT, items[1]->type());
+		VASSERT_EQ("count", 5, static_cast <int>(items[1]->number()->value()));
+		VASSERT_EQ("other 2", vmime::net::imap::IMAPParser::search_return_data::OTHER, items[2]->type());
+		VASSERT_EQ("other 3", vmime::net::imap::IMAPParser::search_return_data::OTHER, items[3]->type());
+	}
+
+	void testThreadResponse()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <vmime::net::imap::IMAPTag> tag =
+			vmime::create <vmime::net::imap::IMAPTag>();
+
+		socket->localSend(
+			"* THREAD (2)(3 6 (4 23)(44 7 96))((5)(8))\r\n"
+			"a001 OK Thread completed.\r\n");
+
+		vmime::ref <vmime::net::imap::IMAPParser> parser =
+			vmime::create <vmime::net::imap::IMAPParser>(tag, socket.dynamicCast <vmime::net::socket>(), toh, 0);
+
+		vmime::utility::auto_ptr <vmime::net::imap::IMAPParser::response> resp
+			(parser->readResponse(/* literalHandler */ NULL));
+
+		const vmime::net::imap::IMAPParser::mailbox_data* data =
+			resp->continue_req_or_response_data()[0]->response_data()->mailbox_data();
+
+		VASSERT_EQ("type", vmime::net::imap::IMAPParser::mailbox_data::THREAD, data->type());
+
+		const std::vector <vmime::net::imap::IMAPParser::thread_list*>& threads = data->thread_list();
+
+		VASSERT_EQ("threads", 3, static_cast <int>(threads.size()));
+		VASSERT_EQ("thread 2 members", 2, static_cast <int>(threads[1]->members().size()));
+		VASSERT_EQ("thread 2 nested", 2, static_cast <int>(threads[1]->nested().size()));
+		VASSERT_EQ("thread 2 last", 96, static_cast <int>(threads[1]->nested()[1]->members()[2]->value()));
+		VASSERT_EQ("thread 3 members", 0, static_cast <int>(threads[2]->members().size()));
+		VASSERT_EQ("thread 3 nested", 2, static_cast <int>(threads[2]->nested().size()));
+	}
+
 VMIME_TEST_SUITE_END
@@ -0,0 +1,217 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/imap/IMAPPartDownloader.hpp"
+#include "vmime/net/imap/IMAPMessage.hpp"
+
+#include "IMAPTestUtils.hpp"
+
+
+/** IMAP test server which serves a 20-byte message part in ranges. If
+  * INTERRUPT is true, the connection is closed in the middle of the
+  * range starting at offset 8, after 4 bytes of the literal are sent.
+  */
+template <bool INTERRUPT>
+class partDownloadIMAPTestSocket : public IMAPTestSocket
+{
+public:
+
+	static const vmime::string getData()
+	{
+		return "0123456789abcdefghij";
+	}
+
+	bool processIMAPCommand(const vmime::string& tag,
+		const vmime::string& cmd, const vmime::string& args)
+	{
+		if (cmd == "FETCH" && args.find("BODYSTRUCTURE") != vmime::string::npos)
+		{
+			localSend("* 1 FETCH (UID 42 BODYSTRUCTURE (\"TEXT\" \"PLAIN\" "
+			          "(\"CHARSET\" \"us-ascii\") NIL NIL \"7BIT\" 20 1))\r\n");
+			localSend(tag + " OK FETCH completed\r\n");
+
+			return true;
+		}
+		else if (cmd == "UID FETCH")
+		{
+			// eg. "42 BODY.PEEK[TEXT]<8.8>"
+			const vmime::string::size_type open = args.find('[');
+			const vmime::string::size_type close = args.find(']', open);
+			const vmime::string::size_type dot = args.find('.', close);
+			const vmime::string::size_type end = args.find('>', dot);
+
+			const vmime::string section = args.substr(open + 1, close - open - 1);
+			const int start = std::atoi(args.substr(close + 2, dot - close - 2).c_str());
+			const int length = std::atoi(args.substr(dot + 1, end - dot - 1).c_str());
+
+			const vmime::string data = getData();
+			const vmime::string content =
+				(start < static_cast <int>(data.length()) ? data.substr(start, length) : "");
+
+			std::ostringstream oss;
+			oss << "* 1 FETCH (UID 42 BODY[" << section << "]<" << start << "> {"
+			    << content.length() << "}\r\n";
+
+			if (INTERRUPT && start == 8)
+			{
+				oss << content.substr(0, 4);
+				localSend(oss.str());
+
+				disconnect();
+			}
+			else
+			{
+				oss << content << ")\r\n" << tag << " OK FETCH completed\r\n";
+				localSend(oss.str());
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+};
+
+
+/** Message part which does not come from an IMAP message structure.
+  */
+class foreignMessagePart : public vmime::net::messagePart
+{
+public:
+
+	vmime::ref <const vmime::net::messageStructure> getStructure() const { return NULL; }
+	vmime::ref <vmime::net::messageStructure> getStructure() { return NULL; }
+
+	vmime::ref <const vmime::header> getHeader() const { return NULL; }
+
+	const vmime::mediaType& getType() const { return m_type; }
+
+	int getSize() const { return 0; }
+	int getNumber() const { return 0; }
+
+private:
+
+	vmime::mediaType m_type;
+};
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPPartDownloaderTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testDownload)
+		VMIME_TEST(testResumeInterruptedRange)
+		VMIME_TEST(testDecodeForeignPart)
+	VMIME_TEST_LIST_END
+
+
+	static vmime::ref <vmime::net::imap::IMAPPartDownloader> createDownloader
+		(vmime::ref <vmime::net::imap::IMAPFolder> folder)
+	{
+		vmime::ref <vmime::net::message> msg = folder->getMessage(1);
+
+		folder->fetchMessage(msg, vmime::net::folder::FETCH_STRUCTURE | vmime::net::folder::FETCH_UID);
+
+		vmime::ref <vmime::net::imap::IMAPPartDownloader> dl =
+			vmime::create <vmime::net::imap::IMAPPartDownloader>
+				(msg.dynamicCast <vmime::net::imap::IMAPMessage>(),
+				 msg->getStructure()->getPartAt(0));
+
+		dl->setChunkSize(8);
+
+		return dl;
+	}
+
+	void testDownload()
+	{
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openIMAPTestInbox <partDownloadIMAPTestSocket <false> >(store);
+
+		vmime::ref <vmime::net::imap::IMAPPartDownloader> dl = createDownloader(folder);
+
+		vmime::string data;
+		vmime::utility::outputStreamStringAdapter os(data);
+
+		dl->download(os);
+
+		VASSERT_EQ("Data", "0123456789abcdefghij", data);
+		VASSERT_EQ("Offset", 20, dl->getOffset());
+		VASSERT_TRUE("Complete", dl->isComplete());
+	}
+
+	void testResumeInterruptedRange()
+	{
+		vmime::string data;
+		vmime::utility::outputStreamStringAdapter os(data);
+
+		// The connection drops in the middle of the second range: the
+		// bytes already written must be accounted for in the offset
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openIMAPTestInbox <partDownloadIMAPTestSocket <true> >(store);
+
+		vmime::ref <vmime::net::imap::IMAPPartDownloader> dl = createDownloader(folder);
+
+		VASSERT_THROW("Interrupted", dl->download(os), vmime::exception);
+
+		VASSERT_EQ("Partial data", "0123456789ab", data);
+		VASSERT_EQ("Partial offset", 12, dl->getOffset());
+		VASSERT_FALSE("Partial complete", dl->isComplete());
+
+		// Resume on a new connection
+		vmime::ref <vmime::net::store> store2;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder2 =
+			openIMAPTestInbox <partDownloadIMAPTestSocket <false> >(store2);
+
+		vmime::ref <vmime::net::imap::IMAPPartDownloader> dl2 = createDownloader(folder2);
+		dl2->setOffset(dl->getOffset());
+
+		dl2->download(os);
+
+		VASSERT_EQ("Data", "0123456789abcdefghij", data);
+		VASSERT_EQ("Offset", 20, dl2->getOffset());
+		VASSERT_TRUE("Complete", dl2->isComplete());
+	}
+
+	void testDecodeForeignPart()
+	{
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder =
+			openIMAPTestInbox <partDownloadIMAPTestSocket <false> >(store);
+
+		vmime::ref <vmime::net::imap::IMAPPartDownloader> dl =
+			vmime::create <vmime::net::imap::IMAPPartDownloader>
+				(folder->getMessage(1).dynamicCast <vmime::net::imap::IMAPMessage>(),
+				 vmime::create <foreignMessagePart>());
+
+		vmime::utility::inputStreamStringAdapter is("data");
+
+		vmime::string data;
+		vmime::utility::outputStreamStringAdapter os(data);
+
+		VASSERT_THROW("Decode", dl->decode(is, os), vmime::exceptions::operation_not_supported);
+	}
+
+VMIME_TEST_SUITE_END
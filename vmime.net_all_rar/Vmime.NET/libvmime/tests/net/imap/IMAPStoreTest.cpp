@@ -0,0 +1,132 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "IMAPTestUtils.hpp"
+
+
+/** IMAP test server which counts the connections, and which fails
+  * "NOOP" (by closing the connection) or "CLOSE" (with a "NO" response).
+  */
+template <bool FAIL_NOOP, bool FAIL_CLOSE>
+class connectionPoolIMAPTestSocket : public IMAPTestSocket
+{
+public:
+
+	static int connectionCount;
+
+	void onConnected()
+	{
+		++connectionCount;
+
+		IMAPTestSocket::onConnected();
+	}
+
+	bool processIMAPCommand(const vmime::string& tag,
+		const vmime::string& cmd, const vmime::string& /* args */)
+	{
+		if (cmd == "NOOP" && FAIL_NOOP)
+		{
+			// Connection closed by the server while idle
+			disconnect();
+			return true;
+		}
+		else if (cmd == "CLOSE" && FAIL_CLOSE)
+		{
+			localSend(tag + " NO CLOSE failed\r\n");
+			return true;
+		}
+
+		return false;
+	}
+};
+
+template <bool FAIL_NOOP, bool FAIL_CLOSE>
+int connectionPoolIMAPTestSocket <FAIL_NOOP, FAIL_CLOSE>::connectionCount = 0;
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPStoreTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testReopenOnPooledConnection)
+		VMIME_TEST(testReopenAfterPooledConnectionClosed)
+		VMIME_TEST(testCloseFailureDiscardsConnection)
+	VMIME_TEST_LIST_END
+
+
+	void testReopenOnPooledConnection()
+	{
+		typedef connectionPoolIMAPTestSocket <false, false> server;
+		server::connectionCount = 0;
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder = openIMAPTestInbox <server>(store);
+
+		// Store connection, then folder connection
+		VASSERT_EQ("Connections after open", 2, server::connectionCount);
+
+		folder->close(false);
+		folder->open(vmime::net::folder::MODE_READ_WRITE);
+
+		VASSERT_TRUE("Open", folder->isOpen());
+		VASSERT_EQ("Connections after reopen", 2, server::connectionCount);
+	}
+
+	void testReopenAfterPooledConnectionClosed()
+	{
+		typedef connectionPoolIMAPTestSocket <true, false> server;
+		server::connectionCount = 0;
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder = openIMAPTestInbox <server>(store);
+
+		folder->close(false);
+
+		// The pooled connection is dead: a new one is established
+		folder->open(vmime::net::folder::MODE_READ_WRITE);
+
+		VASSERT_TRUE("Open", folder->isOpen());
+		VASSERT_EQ("Connections after reopen", 3, server::connectionCount);
+	}
+
+	void testCloseFailureDiscardsConnection()
+	{
+		typedef connectionPoolIMAPTestSocket <false, true> server;
+		server::connectionCount = 0;
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::imap::IMAPFolder> folder = openIMAPTestInbox <server>(store);
+
+		VASSERT_THROW("Close", folder->close(true), vmime::exceptions::command_error);
+		VASSERT_FALSE("Open after close", folder->isOpen());
+
+		// The folder may still be selected on the old connection:
+		// it must not be reused
+		folder->open(vmime::net::folder::MODE_READ_WRITE);
+
+		VASSERT_TRUE("Open", folder->isOpen());
+		VASSERT_EQ("Connections after reopen", 3, server::connectionCount);
+	}
+
+VMIME_TEST_SUITE_END
@@ -0,0 +1,165 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "vmime/net/imap/IMAPStore.hpp"
+#include "vmime/net/imap/IMAPFolder.hpp"
+
+#include "vmime/utility/stringUtils.hpp"
+
+
+/** Base class for IMAP test servers.
+  *
+  * Answers the commands sent when connecting (greeting, hierarchy
+  * separator) and selecting a folder. Other commands are passed to
+  * processIMAPCommand(), and rejected if it returns false.
+  */
+class IMAPTestSocket : public lineBasedTestSocket
+{
+public:
+
+	void onConnected()
+	{
+		localSend("* PREAUTH [CAPABILITY IMAP4rev1" + getCapabilities() + "] test.vmime.org ready\r\n");
+	}
+
+	void processCommand()
+	{
+		if (!haveMoreLines())
+			return;
+
+		const vmime::string line = getNextLine();
+
+		// Commands sent after the server closed the connection are lost
+		if (!isConnected())
+			return;
+
+		// Data of a literal sent by the client
+		if (onLiteralLine(line))
+			return;
+
+		std::istringstream iss(line);
+
+		vmime::string tag, cmd;
+		iss >> tag >> cmd;
+
+		cmd = vmime::utility::stringUtils::toUpper(cmd);
+
+		if (cmd == "UID")
+		{
+			vmime::string sub;
+			iss >> sub;
+
+			cmd += " " + vmime::utility::stringUtils::toUpper(sub);
+		}
+
+		vmime::string args;
+		std::getline(iss, args);
+		args = vmime::utility::stringUtils::trim(args);
+
+		if (processIMAPCommand(tag, cmd, args))
+			return;
+
+		if (cmd == "LIST" && args == "\"\" \"\"")
+		{
+			localSend("* LIST (\\Noselect) \"/\" \"\"\r\n");
+			localSend(tag + " OK LIST completed\r\n");
+		}
+		else if (cmd == "SELECT" || cmd == "EXAMINE")
+		{
+			localSend("* 1 EXISTS\r\n");
+			localSend("* 0 RECENT\r\n");
+			localSend("* OK [UIDVALIDITY 1] UIDs valid\r\n");
+			localSend("* FLAGS (\\Answered \\Flagged \\Deleted \\Seen \\Draft)\r\n");
+			localSend(tag + " OK [READ-WRITE] " + cmd + " completed\r\n");
+		}
+		else if (cmd == "NOOP" || cmd == "CLOSE")
+		{
+			localSend(tag + " OK " + cmd + " completed\r\n");
+		}
+		else if (cmd == "LOGOUT")
+		{
+			localSend("* BYE test.vmime.org logging out\r\n");
+			localSend(tag + " OK LOGOUT completed\r\n");
+		}
+		else
+		{
+			localSend(tag + " BAD Command not implemented\r\n");
+		}
+	}
+
+protected:
+
+	/** Return the capabilities announced in the greeting, in addition
+	  * to IMAP4rev1 (with a leading space).
+	  */
+	virtual const vmime::string getCapabilities() const
+	{
+		return "";
+	}
+
+	/** Process a command sent by the client.
+	  *
+	  * @param tag command tag
+	  * @param cmd command name, in upper case ("UID " is kept as prefix)
+	  * @param args command arguments
+	  * @return true if the command has been processed, false otherwise
+	  */
+	virtual bool processIMAPCommand(const vmime::string& tag,
+		const vmime::string& cmd, const vmime::string& args) = 0;
+
+	/** Called for each line received, before it is parsed as a command.
+	  *
+	  * @param line line received
+	  * @return true if the line is literal data, false otherwise
+	  */
+	virtual bool onLiteralLine(const vmime::string& /* line */)
+	{
+		return false;
+	}
+};
+
+
+/** Connect to an IMAP test server and open its INBOX.
+  *
+  * @param T test server class
+  * @param store receives the connected store
+  * @return INBOX, opened in read-write mode
+  */
+template <typename T>
+vmime::ref <vmime::net::imap::IMAPFolder> openIMAPTestInbox(vmime::ref <vmime::net::store>& store)
+{
+	vmime::ref <vmime::net::session> session =
+		vmime::create <vmime::net::session>();
+
+	store = session->getStore(vmime::utility::url("imap://localhost"));
+
+	store->setSocketFactory(vmime::create <testSocketFactory <T> >());
+	store->setTimeoutHandlerFactory(vmime::create <testTimeoutHandlerFactory>());
+
+	store->connect();
+
+	vmime::ref <vmime::net::folder> folder = store->getFolder(vmime::net::folder::path("INBOX"));
+	folder->open(vmime::net::folder::MODE_READ_WRITE);
+
+	return folder.dynamicCast <vmime::net::imap::IMAPFolder>();
+}
@@ -0,0 +1,164 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/imap/IMAPUtils.hpp"
+
+
+using vmime::net::searchCriteria;
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPUtilsTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testBuildSearchKeysAnd)
+		VMIME_TEST(testBuildSearchKeysOr)
+		VMIME_TEST(testBuildSearchKeysNot)
+		VMIME_TEST(testBuildSearchKeysFlags)
+		VMIME_TEST(testBuildSearchKeysDateSizeModSeq)
+		VMIME_TEST(testBuildSearchKeysQuoted)
+		VMIME_TEST(testBuildSearchKeysLiteral)
+		VMIME_TEST(testBuildSearchKeysLiteralPlus)
+	VMIME_TEST_LIST_END
+
+
+	// Returns the keys, which must fit in a single part
+	const vmime::string buildKeys(const searchCriteria& criteria)
+	{
+		std::vector <vmime::string> parts;
+
+		VASSERT_FALSE("UTF-8", vmime::net::imap::IMAPUtils::buildSearchKeys(criteria, false, parts));
+		VASSERT_EQ("Parts", 1, static_cast <int>(parts.size()));
+
+		return parts[0];
+	}
+
+
+	void testBuildSearchKeysAnd()
+	{
+		VASSERT_EQ("1", "(UNSEEN FROM bob)", buildKeys(searchCriteria::both
+			(searchCriteria::flag(vmime::net::message::FLAG_SEEN, false),
+			 searchCriteria::from("bob"))));
+
+		VASSERT_EQ("2", "(ALL (TO alice CC carol))", buildKeys(searchCriteria::both
+			(searchCriteria::all(),
+			 searchCriteria::both(searchCriteria::to("alice"), searchCriteria::cc("carol")))));
+	}
+
+	void testBuildSearchKeysOr()
+	{
+		VASSERT_EQ("1", "OR SUBJECT hello BODY world", buildKeys(searchCriteria::either
+			(searchCriteria::subject("hello"), searchCriteria::body("world"))));
+
+		// "OR" takes exactly two keys
+		VASSERT_EQ("2", "OR TEXT a OR TEXT b TEXT c", buildKeys(searchCriteria::either
+			(searchCriteria::text("a"),
+			 searchCriteria::either(searchCriteria::text("b"), searchCriteria::text("c")))));
+	}
+
+	void testBuildSearchKeysNot()
+	{
+		VASSERT_EQ("1", "NOT HEADER X-Spam yes", buildKeys(searchCriteria::negate
+			(searchCriteria::header("X-Spam", "yes"))));
+
+		VASSERT_EQ("2", "NOT (SEEN SUBJECT test)", buildKeys(searchCriteria::negate
+			(searchCriteria::both(searchCriteria::flag(vmime::net::message::FLAG_SEEN),
+			                      searchCriteria::header("Subject", "test")))));
+	}
+
+	void testBuildSearchKeysFlags()
+	{
+		const int flags = vmime::net::message::FLAG_SEEN | vmime::net::message::FLAG_MARKED;
+
+		// Any of the flags is set
+		VASSERT_EQ("Set", "OR SEEN FLAGGED", buildKeys(searchCriteria::flag(flags, true)));
+
+		// None of the flags is set
+		VASSERT_EQ("Unset", "(UNSEEN UNFLAGGED)", buildKeys(searchCriteria::flag(flags, false)));
+
+		VASSERT_EQ("Forwarded", "KEYWORD $Forwarded",
+			buildKeys(searchCriteria::flag(vmime::net::message::FLAG_PASSED)));
+
+		VASSERT_EQ("No flag set", "NOT ALL", buildKeys(searchCriteria::flag(0, true)));
+		VASSERT_EQ("No flag unset", "ALL", buildKeys(searchCriteria::flag(0, false)));
+	}
+
+	void testBuildSearchKeysDateSizeModSeq()
+	{
+		VASSERT_EQ("Since", "SINCE 5-Jan-2013",
+			buildKeys(searchCriteria::receivedSince(vmime::datetime(2013, 1, 5))));
+		VASSERT_EQ("Sent before", "SENTBEFORE 31-Dec-2012",
+			buildKeys(searchCriteria::sentBefore(vmime::datetime(2012, 12, 31))));
+
+		VASSERT_EQ("Larger", "LARGER 1024", buildKeys(searchCriteria::largerThan(1024)));
+		VASSERT_EQ("Smaller", "SMALLER 0", buildKeys(searchCriteria::smallerThan(-5)));
+
+		VASSERT_EQ("Modseq", "MODSEQ 1099511627776", buildKeys
+			(searchCriteria::modSequenceSince(static_cast <vmime_uint64>(1) << 40)));
+	}
+
+	void testBuildSearchKeysQuoted()
+	{
+		VASSERT_EQ("Space", "SUBJECT \"hello world\"", buildKeys(searchCriteria::subject("hello world")));
+		VASSERT_EQ("Quotes", "BODY \"say \\\"hi\\\"\"", buildKeys(searchCriteria::body("say \"hi\"")));
+		VASSERT_EQ("Empty", "TEXT \"\"", buildKeys(searchCriteria::text("")));
+	}
+
+	void testBuildSearchKeysLiteral()
+	{
+		std::vector <vmime::string> parts;
+
+		// Non-ASCII text is sent as a literal, in UTF-8
+		VASSERT_TRUE("UTF-8", vmime::net::imap::IMAPUtils::buildSearchKeys
+			(searchCriteria::both(searchCriteria::subject("Caf\xc3\xa9"), searchCriteria::from("bob")),
+			 false, parts));
+
+		VASSERT_EQ("Parts", 2, static_cast <int>(parts.size()));
+		VASSERT_EQ("Part 1", "(SUBJECT {5}", parts[0]);
+		VASSERT_EQ("Part 2", "Caf\xc3\xa9 FROM bob)", parts[1]);
+
+		// CR and LF cannot be quoted, but are not UTF-8
+		VASSERT_FALSE("Not UTF-8", vmime::net::imap::IMAPUtils::buildSearchKeys
+			(searchCriteria::body("a\r\nb"), false, parts));
+
+		VASSERT_EQ("Parts 2", 2, static_cast <int>(parts.size()));
+		VASSERT_EQ("Part 2.1", "BODY {4}", parts[0]);
+		VASSERT_EQ("Part 2.2", "a\r\nb", parts[1]);
+	}
+
+	void testBuildSearchKeysLiteralPlus()
+	{
+		std::vector <vmime::string> parts;
+
+		VASSERT_TRUE("UTF-8", vmime::net::imap::IMAPUtils::buildSearchKeys
+			(searchCriteria::header("X-Caf\xc3\xa9", "\xc3\xa9t\xc3\xa9"), true, parts));
+
+		VASSERT_EQ("Parts", 3, static_cast <int>(parts.size()));
+		VASSERT_EQ("Part 1", "HEADER {7+}", parts[0]);
+		VASSERT_EQ("Part 2", "X-Caf\xc3\xa9 {5+}", parts[1]);
+		VASSERT_EQ("Part 3", "\xc3\xa9t\xc3\xa9", parts[2]);
+	}
+
+VMIME_TEST_SUITE_END
+
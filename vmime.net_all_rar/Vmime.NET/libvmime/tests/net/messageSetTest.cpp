@@ -40,6 +40,11 @@ VMIME_TEST_SUITE_BEGIN(messageSetTest)
 		VMIME_TEST(testUIDSet_MultipleNonNumeric)
 		VMIME_TEST(testIsNumberSet)
 		VMIME_TEST(testIsUIDSet)
+		VMIME_TEST(testAddRange_Coalescing)
+		VMIME_TEST(testUnion)
+		VMIME_TEST(testIntersection)
+		VMIME_TEST(testDifference)
+		VMIME_TEST(testContains)
 	VMIME_TEST_LIST_END
 
 
@@ -197,4 +202,82 @@ VMIME_TEST_SUITE_BEGIN(messageSetTest)
 		VASSERT_TRUE("uid2", vmime::net::messageSet::byUID("42", "*").isUIDSet());
 	}
 
+	void testAddRange_Coalescing()
+	{
+		vmime::net::messageSet set = vmime::net::messageSet::byNumber(30, 40);
+		set.addRange(vmime::net::numberMessageRange(10, 20));
+		set.addRange(vmime::net::numberMessageRange(5));
+		set.addRange(vmime::net::numberMessageRange(21, 29));  // fills the gap
+		set.addRange(vmime::net::numberMessageRange(35, 45));  // overlaps
+
+		VASSERT_EQ("str", "5,10:45", enumerateAsString(set));
+		VASSERT_EQ("count", 2, set.getRangeCount());
+
+		set.addRange(vmime::net::numberMessageRange(42, -1));
+
+		VASSERT_EQ("str-infinite", "5,10:-1", enumerateAsString(set));
+
+		vmime::net::messageSet uidSet = vmime::net::messageSet::byUID("12", "15");
+		uidSet.addRange(vmime::net::UIDMessageRange("16", "*"));
+
+		VASSERT_EQ("str-uid", "12:*", enumerateAsString(uidSet));
+	}
+
+	void testUnion()
+	{
+		vmime::net::messageSet set1 = vmime::net::messageSet::byNumber(1, 5);
+		set1.addRange(vmime::net::numberMessageRange(20, 30));
+
+		vmime::net::messageSet set2 = vmime::net::messageSet::byNumber(6, 10);
+		set2.addRange(vmime::net::numberMessageRange(25, -1));
+
+		VASSERT_EQ("str", "1:10,20:-1", enumerateAsString(set1.getUnion(set2)));
+		VASSERT_EQ("empty", "1:5,20:30", enumerateAsString
+			(set1.getUnion(vmime::net::messageSet::none())));
+
+		VASSERT_THROW("type", set1.getUnion(vmime::net::messageSet::byUID("42")), std::invalid_argument);
+	}
+
+	void testIntersection()
+	{
+		vmime::net::messageSet set1 = vmime::net::messageSet::byNumber(1, 10);
+		set1.addRange(vmime::net::numberMessageRange(20, -1));
+
+		vmime::net::messageSet set2 = vmime::net::messageSet::byNumber(5, 25);
+
+		VASSERT_EQ("str", "5:10,20:25", enumerateAsString(set1.getIntersection(set2)));
+		VASSERT_TRUE("empty", set2.getIntersection(vmime::net::messageSet::byNumber(30, 40)).isEmpty());
+	}
+
+	void testDifference()
+	{
+		vmime::net::messageSet set1 = vmime::net::messageSet::byNumber(1, 20);
+		set1.addRange(vmime::net::numberMessageRange(30, -1));
+
+		vmime::net::messageSet set2 = vmime::net::messageSet::byNumber(5);
+		set2.addRange(vmime::net::numberMessageRange(10, 35));
+
+		VASSERT_EQ("str", "1:4,6:9,36:-1", enumerateAsString(set1.getDifference(set2)));
+		VASSERT_EQ("str2", "21:29", enumerateAsString(set2.getDifference(set1)));
+		VASSERT_TRUE("empty", set2.getDifference(vmime::net::messageSet::byNumber(1, -1)).isEmpty());
+	}
+
+	void testContains()
+	{
+		vmime::net::messageSet set = vmime::net::messageSet::byNumber(10, 20);
+		set.addRange(vmime::net::numberMessageRange(42, -1));
+
+		VASSERT_TRUE("1", set.contains(10));
+		VASSERT_TRUE("2", set.contains(20));
+		VASSERT_FALSE("3", set.contains(21));
+		VASSERT_TRUE("4", set.contains(1000));
+		VASSERT_FALSE("5", set.contains(vmime::net::message::uid("15")));
+
+		vmime::net::messageSet uidSet = vmime::net::messageSet::byUID("100", "200");
+
+		VASSERT_TRUE("6", uidSet.contains(vmime::net::message::uid("150")));
+		VASSERT_FALSE("7", uidSet.contains(vmime::net::message::uid("250")));
+		VASSERT_FALSE("8", uidSet.contains(150));
+	}
+
 VMIME_TEST_SUITE_END
@@ -0,0 +1,170 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/pop3/POP3FileUIDStore.hpp"
+
+
+using namespace vmime::net::pop3;
+
+
+VMIME_TEST_SUITE_BEGIN(POP3FileUIDStoreTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testKnownUIDs)
+		VMIME_TEST(testAddOutsideSync)
+		VMIME_TEST(testForgetUnlisted)
+		VMIME_TEST(testPartialSyncDoesNotAge)
+		VMIME_TEST(testAccounts)
+	VMIME_TEST_LIST_END
+
+
+	static const vmime::string account()
+	{
+		return "user@pop3.example.com:995";
+	}
+
+
+	void testKnownUIDs()
+	{
+		testTempDirectory tempDir;
+
+		{
+			POP3FileUIDStore store(tempDir.getPath());
+
+			store.beginSync(account());
+			VASSERT_FALSE("unknown", store.isKnown(account(), "uid-1"));
+			store.addUID(account(), "uid-1");
+			VASSERT_TRUE("added", store.isKnown(account(), "uid-1"));
+			store.endSync(account(), true);
+		}
+
+		// The state is read again from the file
+		POP3FileUIDStore store(tempDir.getPath());
+
+		store.beginSync(account());
+		VASSERT_TRUE("saved", store.isKnown(account(), "uid-1"));
+		VASSERT_FALSE("other", store.isKnown(account(), "uid-2"));
+		store.endSync(account(), true);
+	}
+
+	void testAddOutsideSync()
+	{
+		testTempDirectory tempDir;
+
+		{
+			POP3FileUIDStore store(tempDir.getPath());
+			store.addUID(account(), "uid-1");
+		}
+
+		POP3FileUIDStore store(tempDir.getPath());
+
+		store.beginSync(account());
+		VASSERT_TRUE("saved", store.isKnown(account(), "uid-1"));
+		store.endSync(account(), true);
+	}
+
+	void testForgetUnlisted()
+	{
+		testTempDirectory tempDir;
+		POP3FileUIDStore store(tempDir.getPath());
+
+		store.setGenerationCount(2);
+
+		store.beginSync(account());
+		store.addUID(account(), "uid-1");
+		store.addUID(account(), "uid-2");
+		store.endSync(account(), true);
+
+		// "uid-2" is not listed anymore
+		store.beginSync(account());
+		VASSERT_TRUE("sync 1", store.isKnown(account(), "uid-1"));
+		store.endSync(account(), true);
+
+		store.beginSync(account());
+		VASSERT_TRUE("sync 2", store.isKnown(account(), "uid-1"));
+		store.endSync(account(), true);
+
+		store.beginSync(account());
+		VASSERT_TRUE("listed", store.isKnown(account(), "uid-1"));
+		VASSERT_FALSE("forgotten", store.isKnown(account(), "uid-2"));
+		store.endSync(account(), true);
+	}
+
+	void testPartialSyncDoesNotAge()
+	{
+		testTempDirectory tempDir;
+		POP3FileUIDStore store(tempDir.getPath());
+
+		store.setGenerationCount(2);
+
+		store.beginSync(account());
+		store.addUID(account(), "uid-1");
+		store.addUID(account(), "uid-2");
+		store.endSync(account(), true);
+
+		// Record messages outside of a listing, as
+		// POP3Folder::markMessagesKnown() does
+		for (int i = 0 ; i < 5 ; ++i)
+		{
+			std::ostringstream uid;
+			uid << "new-" << i;
+
+			store.beginSync(account());
+			store.addUID(account(), uid.str());
+			store.endSync(account(), false);
+		}
+
+		// "uid-2" has only missed one listing
+		store.beginSync(account());
+		VASSERT_TRUE("uid-1", store.isKnown(account(), "uid-1"));
+		store.endSync(account(), true);
+
+		store.beginSync(account());
+		VASSERT_TRUE("uid-2", store.isKnown(account(), "uid-2"));
+		VASSERT_TRUE("new-0", store.isKnown(account(), "new-0"));
+		store.endSync(account(), true);
+	}
+
+	void testAccounts()
+	{
+		testTempDirectory tempDir;
+		POP3FileUIDStore store(tempDir.getPath());
+
+		// Account names are escaped to be used as file names
+		const vmime::string other = "../other@pop3.example.com:110";
+
+		store.addUID(account(), "uid-1");
+
+		store.beginSync(other);
+		VASSERT_FALSE("other account", store.isKnown(other, "uid-1"));
+		store.endSync(other, true);
+
+		store.beginSync(account());
+		VASSERT_TRUE("account", store.isKnown(account(), "uid-1"));
+		store.endSync(account(), true);
+	}
+
+VMIME_TEST_SUITE_END
+
@@ -0,0 +1,187 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "tests/net/pop3/POP3TestUtils.hpp"
+
+
+/** POP3 test server with three messages, which records the TOP and
+  * DELE commands it receives. "DELE 2" fails.
+  */
+template <bool PIPELINING>
+class pipeliningPOP3TestSocket : public POP3TestSocket
+{
+public:
+
+	static std::vector <vmime::string> commands;
+
+protected:
+
+	const vmime::string getCapabilities() const
+	{
+		return PIPELINING ? "PIPELINING\r\n" : "";
+	}
+
+	int getMessageCount() const
+	{
+		return 3;
+	}
+
+	const vmime::string getMessage(const int num) const
+	{
+		std::ostringstream oss;
+		oss << "Subject: Message " << num << "\r\n\r\n.Body " << num << "\r\n";
+
+		return oss.str();
+	}
+
+	bool processPOP3Command(const vmime::string& cmd, const vmime::string& args)
+	{
+		if (cmd == "TOP" || cmd == "DELE")
+			commands.push_back(cmd + " " + args);
+
+		if (cmd == "DELE")
+		{
+			localSend(args == "2" ? "-ERR Cannot delete message\r\n" : "+OK\r\n");
+			return true;
+		}
+
+		return false;
+	}
+};
+
+template <bool PIPELINING>
+std::vector <vmime::string> pipeliningPOP3TestSocket <PIPELINING>::commands;
+
+
+VMIME_TEST_SUITE_BEGIN(POP3FolderTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testFetchHeaders)
+		VMIME_TEST(testFetchHeadersPipelined)
+		VMIME_TEST(testFetchHeadersForeignMessage)
+		VMIME_TEST(testDeleteMessagesPipelined)
+		VMIME_TEST(testExtractAfterPipelinedCommands)
+	VMIME_TEST_LIST_END
+
+
+	template <bool PIPELINING>
+	void fetchHeaders()
+	{
+		typedef pipeliningPOP3TestSocket <PIPELINING> server;
+		server::commands.clear();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::folder> folder = openPOP3TestInbox <server>(store);
+
+		std::vector <vmime::ref <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 3));
+
+		folder->fetchMessages(msgs, vmime::net::folder::FETCH_FULL_HEADER);
+
+		VASSERT_EQ("Commands", 3, server::commands.size());
+		VASSERT_EQ("TOP 1", "TOP 1 0", server::commands[0]);
+		VASSERT_EQ("TOP 2", "TOP 2 0", server::commands[1]);
+		VASSERT_EQ("TOP 3", "TOP 3 0", server::commands[2]);
+
+		VASSERT_EQ("Header 1", "Message 1", msgs[0]->getHeader()->Subject()->getValue()->generate());
+		VASSERT_EQ("Header 2", "Message 2", msgs[1]->getHeader()->Subject()->getValue()->generate());
+		VASSERT_EQ("Header 3", "Message 3", msgs[2]->getHeader()->Subject()->getValue()->generate());
+	}
+
+	void testFetchHeaders()
+	{
+		fetchHeaders <false>();
+	}
+
+	void testFetchHeadersPipelined()
+	{
+		fetchHeaders <true>();
+	}
+
+	void testFetchHeadersForeignMessage()
+	{
+		typedef pipeliningPOP3TestSocket <true> server;
+		server::commands.clear();
+
+		vmime::ref <vmime::net::store> store, otherStore;
+		vmime::ref <vmime::net::folder> folder = openPOP3TestInbox <server>(store);
+		vmime::ref <vmime::net::folder> otherFolder = openPOP3TestInbox <server>(otherStore);
+
+		std::vector <vmime::ref <vmime::net::message> > msgs;
+		msgs.push_back(folder->getMessage(1));
+		msgs.push_back(otherFolder->getMessage(2));
+
+		VASSERT_THROW("Fetch", folder->fetchMessages(msgs, vmime::net::folder::FETCH_FULL_HEADER),
+			vmime::exceptions::folder_not_found);
+
+		// No command must be sent if a message is invalid
+		VASSERT_EQ("Commands", 0, server::commands.size());
+	}
+
+	void testDeleteMessagesPipelined()
+	{
+		typedef pipeliningPOP3TestSocket <true> server;
+		server::commands.clear();
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::folder> folder = openPOP3TestInbox <server>(store);
+
+		std::vector <vmime::ref <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 3));
+
+		VASSERT_THROW("Delete", folder->deleteMessages(vmime::net::messageSet::byNumber(1, 3)),
+			vmime::exceptions::command_error);
+
+		// All the responses of the window are read before the error is reported
+		VASSERT_EQ("Commands", 3, server::commands.size());
+
+		VASSERT_TRUE("Deleted 1", (msgs[0]->getFlags() & vmime::net::message::FLAG_DELETED) != 0);
+		VASSERT_FALSE("Deleted 2", (msgs[1]->getFlags() & vmime::net::message::FLAG_DELETED) != 0);
+		VASSERT_TRUE("Deleted 3", (msgs[2]->getFlags() & vmime::net::message::FLAG_DELETED) != 0);
+	}
+
+	void testExtractAfterPipelinedCommands()
+	{
+		typedef pipeliningPOP3TestSocket <true> server;
+
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::folder> folder = openPOP3TestInbox <server>(store);
+
+		std::vector <vmime::ref <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 3));
+
+		folder->fetchMessages(msgs, vmime::net::folder::FETCH_FULL_HEADER);
+
+		// RETR responses are read with exact boundaries too: the connection
+		// is still in sync after the pipelined commands
+		vmime::string data;
+		vmime::utility::outputStreamStringAdapter os(data);
+
+		msgs[1]->extract(os);
+
+		VASSERT_EQ("Data", "Subject: Message 2\r\n\r\n.Body 2", data);
+	}
+
+VMIME_TEST_SUITE_END
@@ -21,6 +21,8 @@
 // the GNU General Public License cover the whole combination.
 //
 
+#include <deque>
+
 #include "tests/testUtils.hpp"
 
 #include "tests/net/pop3/POP3TestUtils.hpp"
@@ -31,6 +33,59 @@
 using namespace vmime::net::pop3;
 
 
+// Returns data to the client in the blocks given to localSendBlock(),
+// one block for each call to receive().
+class blockTestSocket : public testSocket
+{
+public:
+
+	void localSendBlock(const vmime::string& block)
+	{
+		m_blocks.push_back(block);
+	}
+
+	void receive(vmime::string& buffer)
+	{
+		buffer.clear();
+
+		if (!m_blocks.empty())
+		{
+			buffer = m_blocks.front();
+			m_blocks.pop_front();
+		}
+	}
+
+	bool waitForReadable(const unsigned int /* msecs */)
+	{
+		return !m_blocks.empty();
+	}
+
+private:
+
+	std::deque <vmime::string> m_blocks;
+};
+
+
+// Records the byte count reported when the transfer ends.
+class countingProgressListener : public vmime::utility::progressListener
+{
+public:
+
+	countingProgressListener() : m_total(-1) { }
+
+	bool cancel() const { return false; }
+	void start(const long /* predictedTotal */) { }
+	void progress(const long /* current */, const long /* currentTotal */) { }
+	void stop(const long total) { m_total = total; }
+
+	long getTotal() const { return m_total; }
+
+private:
+
+	long m_total;
+};
+
+
 VMIME_TEST_SUITE_BEGIN(POP3ResponseTest)
 
 	VMIME_TEST_LIST_BEGIN
@@ -42,6 +97,11 @@ VMIME_TEST_SUITE_BEGIN(POP3ResponseTest)
 		VMIME_TEST(testMultiLineResponse)
 		VMIME_TEST(testMultiLineResponseLF)
 		VMIME_TEST(testLargeResponse)
+		VMIME_TEST(testPipelinedResponses)
+		VMIME_TEST(testPushBack)
+		VMIME_TEST(testSplitTerminator)
+		VMIME_TEST(testSplitTerminatorCR)
+		VMIME_TEST(testSplitDotStuffing)
 	VMIME_TEST_LIST_END
 
 
@@ -226,5 +286,135 @@ VMIME_TEST_SUITE_BEGIN(POP3ResponseTest)
 		VASSERT_EQ("Data Bytes", data.str(), receivedData);
 	}
 
+	void testPipelinedResponses()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <POP3ConnectionTest> conn = vmime::create <POP3ConnectionTest>
+			(socket.dynamicCast <vmime::net::socket>(), toh);
+
+		// Responses to "TOP 1 0", "RETR 2", "DELE 3" and "DELE 4", received
+		// in a single block: each response must stop at its own end
+		socket->localSend(
+			"+OK Top follows\r\nSubject: 1\r\n\r\n.\r\n"
+			"+OK Message follows\r\nSubject: 2\r\n\r\n..Body\r\n.\r\n"
+			"+OK Deleted\r\n"
+			"-ERR No such message\r\n");
+
+		vmime::string top;
+		vmime::utility::outputStreamStringAdapter topStream(top);
+
+		vmime::ref <POP3Response> resp1 = POP3Response::readLargeResponse(conn, topStream, NULL, 0);
+
+		VASSERT_TRUE("TOP success", resp1->isSuccess());
+		VASSERT_EQ("TOP data", "Subject: 1\r\n", top);
+
+		vmime::string retr;
+		vmime::utility::outputStreamStringAdapter retrStream(retr);
+
+		vmime::ref <POP3Response> resp2 = POP3Response::readLargeResponse(conn, retrStream, NULL, 0);
+
+		VASSERT_TRUE("RETR success", resp2->isSuccess());
+		VASSERT_EQ("RETR data", "Subject: 2\r\n\r\n.Body", retr);
+
+		vmime::ref <POP3Response> resp3 = POP3Response::readResponse(conn);
+
+		VASSERT_TRUE("DELE 3 success", resp3->isSuccess());
+		VASSERT_EQ("DELE 3 text", "Deleted", resp3->getText());
+
+		vmime::ref <POP3Response> resp4 = POP3Response::readResponse(conn);
+
+		VASSERT_FALSE("DELE 4 success", resp4->isSuccess());
+		VASSERT_EQ("DELE 4 text", "No such message", resp4->getText());
+	}
+
+	void testPushBack()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <POP3ConnectionTest> conn = vmime::create <POP3ConnectionTest>
+			(socket.dynamicCast <vmime::net::socket>(), toh);
+
+		socket->localSend("socket data");
+
+		// Data given back is returned first, before reading the socket
+		conn->pushBack("second ");
+		conn->pushBack("first ");
+
+		vmime::string buffer;
+
+		conn->receive(buffer);
+		VASSERT_EQ("Pushed back", "first second ", buffer);
+
+		conn->receive(buffer);
+		VASSERT_EQ("Socket", "socket data", buffer);
+	}
+
+	// Read a large response received in the specified blocks
+	static void readBlocks(const char* const blocks[], vmime::string& data, long& total)
+	{
+		vmime::ref <blockTestSocket> socket = vmime::create <blockTestSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh = vmime::create <testTimeoutHandler>();
+
+		vmime::ref <POP3ConnectionTest> conn = vmime::create <POP3ConnectionTest>
+			(socket.dynamicCast <vmime::net::socket>(), toh);
+
+		socket->localSendBlock("+OK Response Follows\r\n");
+
+		for (int i = 0 ; blocks[i] != NULL ; ++i)
+			socket->localSendBlock(blocks[i]);
+
+		vmime::utility::outputStreamStringAdapter dataStream(data);
+		countingProgressListener progress;
+
+		vmime::ref <POP3Response> resp =
+			POP3Response::readLargeResponse(conn, dataStream, &progress, 0);
+
+		VASSERT_TRUE("Success", resp->isSuccess());
+
+		total = progress.getTotal();
+	}
+
+	void testSplitTerminator()
+	{
+		const char* const blocks[] = { "Line\r\n.", "\r\n", NULL };
+
+		vmime::string data;
+		long total = 0;
+
+		readBlocks(blocks, data, total);
+
+		VASSERT_EQ("Data", "Line", data);
+		VASSERT_EQ("Bytes", 9, total);
+	}
+
+	void testSplitTerminatorCR()
+	{
+		const char* const blocks[] = { "Line\r\n.\r", "\n", NULL };
+
+		vmime::string data;
+		long total = 0;
+
+		readBlocks(blocks, data, total);
+
+		VASSERT_EQ("Data", "Line", data);
+		VASSERT_EQ("Bytes", 9, total);
+	}
+
+	void testSplitDotStuffing()
+	{
+		const char* const blocks[] = { "..", "x\r\n.\r\n", NULL };
+
+		vmime::string data;
+		long total = 0;
+
+		readBlocks(blocks, data, total);
+
+		VASSERT_EQ("Data", ".x", data);
+		VASSERT_EQ("Bytes", 8, total);
+	}
+
 VMIME_TEST_SUITE_END
 
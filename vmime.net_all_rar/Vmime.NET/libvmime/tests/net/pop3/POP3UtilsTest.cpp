@@ -36,6 +36,7 @@ VMIME_TEST_SUITE_BEGIN(POP3UtilsTest)
 
 	VMIME_TEST_LIST_BEGIN
 		VMIME_TEST(testParseMultiListOrUidlResponse)
+		VMIME_TEST(testParseListOrUidlLine)
 	VMIME_TEST_LIST_END
 
 
@@ -69,5 +70,22 @@ VMIME_TEST_SUITE_BEGIN(POP3UtilsTest)
 		VASSERT_EQ("5 (with extra space)", "yz", result[8]);
 	}
 
+	void testParseListOrUidlLine()
+	{
+		int number = 0;
+		vmime::string data;
+
+		VASSERT_TRUE("1", POP3Utils::parseListOrUidlLine("1 abcdef", number, data));
+		VASSERT_EQ("1 number", 1, number);
+		VASSERT_EQ("1 data", "abcdef", data);
+
+		VASSERT_TRUE("2", POP3Utils::parseListOrUidlLine("  42\tQhdPYR:00WBw1Ph7x7 \r", number, data));
+		VASSERT_EQ("2 number", 42, number);
+		VASSERT_EQ("2 data", "QhdPYR:00WBw1Ph7x7", data);
+
+		VASSERT_FALSE("3 (no data)", POP3Utils::parseListOrUidlLine("3", number, data));
+		VASSERT_FALSE("4 (empty)", POP3Utils::parseListOrUidlLine("", number, data));
+	}
+
 VMIME_TEST_SUITE_END
 
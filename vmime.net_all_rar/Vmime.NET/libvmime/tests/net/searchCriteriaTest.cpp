@@ -0,0 +1,167 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "tests/net/pop3/POP3TestUtils.hpp"
+
+
+using vmime::net::searchCriteria;
+
+
+/** POP3 test server with three messages, whose text is encoded.
+  * POP3 has no SEARCH command: the criteria are evaluated locally
+  * by folder::search().
+  */
+class searchPOP3TestSocket : public POP3TestSocket
+{
+protected:
+
+	int getMessageCount() const
+	{
+		return 3;
+	}
+
+	const vmime::string getMessage(const int num) const
+	{
+		switch (num)
+		{
+		case 1:
+
+			return "Subject: Coffee\r\n"
+			       "Content-Type: text/plain; charset=utf-8\r\n"
+			       "Content-Transfer-Encoding: quoted-printable\r\n"
+			       "\r\n"
+			       "Caf=C3=A9 au lait\r\n";
+
+		case 2:
+
+			// "hello world"
+			return "Subject: =?utf-8?Q?R=C3=A9union?=\r\n"
+			       "Content-Type: text/plain; charset=us-ascii\r\n"
+			       "Content-Transfer-Encoding: base64\r\n"
+			       "\r\n"
+			       "aGVsbG8gd29ybGQ=\r\n";
+
+		default:
+
+			// Attachment: "secret"
+			return "Subject: Report\r\n"
+			       "Content-Type: multipart/mixed; boundary=\"sep\"\r\n"
+			       "\r\n"
+			       "--sep\r\n"
+			       "Content-Type: text/plain\r\n"
+			       "\r\n"
+			       "See attachment\r\n"
+			       "--sep\r\n"
+			       "Content-Type: application/octet-stream\r\n"
+			       "Content-Transfer-Encoding: base64\r\n"
+			       "\r\n"
+			       "c2VjcmV0\r\n"
+			       "--sep--\r\n";
+		}
+	}
+};
+
+
+VMIME_TEST_SUITE_BEGIN(searchCriteriaTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testBodyQuotedPrintable)
+		VMIME_TEST(testBodyBase64)
+		VMIME_TEST(testTextHeader)
+		VMIME_TEST(testAttachmentNotSearched)
+		VMIME_TEST(testModSeq)
+	VMIME_TEST_LIST_END
+
+
+	// Returns the numbers of the matching messages (eg. "1 3")
+	const vmime::string search(const searchCriteria& criteria)
+	{
+		vmime::ref <vmime::net::store> store;
+		vmime::ref <vmime::net::folder> folder = openPOP3TestInbox <searchPOP3TestSocket>(store);
+
+		const vmime::net::messageSet set = folder->search(criteria);
+
+		std::ostringstream oss;
+
+		for (int num = 1 ; num <= 3 ; ++num)
+		{
+			if (set.contains(num))
+				oss << (oss.str().empty() ? "" : " ") << num;
+		}
+
+		return oss.str();
+	}
+
+
+	void testBodyQuotedPrintable()
+	{
+		VASSERT_EQ("Decoded", "1", search(searchCriteria::body("caf\xc3\xa9")));
+		VASSERT_EQ("Case", "1", search(searchCriteria::body("CAF\xc3\xa9 AU")));
+		VASSERT_EQ("Encoded", "", search(searchCriteria::body("=C3=A9")));
+	}
+
+	void testBodyBase64()
+	{
+		VASSERT_EQ("Decoded", "2", search(searchCriteria::body("hello world")));
+		VASSERT_EQ("Encoded", "", search(searchCriteria::body("aGVsbG8")));
+	}
+
+	void testTextHeader()
+	{
+		// TEXT also searches the header, after decoding encoded words
+		VASSERT_EQ("Text", "2", search(searchCriteria::text("r\xc3\xa9union")));
+		VASSERT_EQ("Text 2", "1", search(searchCriteria::text("coffee")));
+		VASSERT_EQ("Encoded", "", search(searchCriteria::text("=?utf-8?")));
+
+		// BODY does not
+		VASSERT_EQ("Body", "", search(searchCriteria::body("r\xc3\xa9union")));
+	}
+
+	void testAttachmentNotSearched()
+	{
+		VASSERT_EQ("Text part", "3", search(searchCriteria::body("see attachment")));
+		VASSERT_EQ("Attachment", "", search(searchCriteria::body("secret")));
+		VASSERT_EQ("Encoded attachment", "", search(searchCriteria::text("c2VjcmV0")));
+	}
+
+	void testModSeq()
+	{
+		const searchCriteria modseq = searchCriteria::modSequenceSince(5);
+		const searchCriteria body = searchCriteria::body("caf\xc3\xa9");
+
+		// Unknown: every message may match, also when negated
+		VASSERT_EQ("Modseq", "1 2 3", search(modseq));
+		VASSERT_EQ("Not modseq", "1 2 3", search(searchCriteria::negate(modseq)));
+
+		VASSERT_EQ("And", "1", search(searchCriteria::both(modseq, body)));
+		VASSERT_EQ("Not and", "1 2 3", search(searchCriteria::negate(searchCriteria::both(modseq, body))));
+
+		// True for message 1, unknown for the others
+		VASSERT_EQ("Or", "1 2 3", search(searchCriteria::either(modseq, body)));
+		VASSERT_EQ("Not or", "2 3", search(searchCriteria::negate(searchCriteria::either(modseq, body))));
+	}
+
+VMIME_TEST_SUITE_END
+
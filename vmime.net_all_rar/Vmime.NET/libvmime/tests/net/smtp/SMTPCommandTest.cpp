@@ -43,6 +43,7 @@ VMIME_TEST_SUITE_BEGIN(SMTPCommandTest)
 		VMIME_TEST(testMAIL_UTF8)
 		VMIME_TEST(testMAIL_SIZE)
 		VMIME_TEST(testMAIL_SIZE_UTF8)
+		VMIME_TEST(testMAIL_BODY)
 		VMIME_TEST(testRCPT)
 		VMIME_TEST(testRCPT_Encoded)
 		VMIME_TEST(testRCPT_UTF8)
@@ -147,6 +148,15 @@ VMIME_TEST_SUITE_BEGIN(SMTPCommandTest)
 		VASSERT_EQ("Text", "MAIL FROM:<mailtest@例え.テスト> SMTPUTF8 SIZE=123456789", cmd->getText());
 	}
 
+	void testMAIL_BODY()
+	{
+		vmime::ref <SMTPCommand> cmd = SMTPCommand::MAIL
+			(vmime::mailbox("me@vmime.org"), false, 123456789, "8BITMIME");
+
+		VASSERT_NOT_NULL("Not null", cmd);
+		VASSERT_EQ("Text", "MAIL FROM:<me@vmime.org> SIZE=123456789 BODY=8BITMIME", cmd->getText());
+	}
+
 	void testRCPT()
 	{
 		vmime::ref <SMTPCommand> cmd = SMTPCommand::RCPT(vmime::mailbox("someone@vmime.org"), false);
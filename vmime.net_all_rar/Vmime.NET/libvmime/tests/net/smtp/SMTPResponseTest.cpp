@@ -38,6 +38,7 @@ VMIME_TEST_SUITE_BEGIN(SMTPResponseTest)
 		VMIME_TEST(testEnhancedStatusCode)
 		VMIME_TEST(testNoEnhancedStatusCode)
 		VMIME_TEST(testInvalidEnhancedStatusCode)
+		VMIME_TEST(testPipelinedResponses)
 	VMIME_TEST_LIST_END
 
 
@@ -237,5 +238,40 @@ VMIME_TEST_SUITE_BEGIN(SMTPResponseTest)
 		VASSERT_EQ("Enh.detail", 0, resp->getEnhancedCode().detail);
 	}
 
+	void testPipelinedResponses()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+		vmime::ref <vmime::net::timeoutHandler> toh =
+			vmime::create <testTimeoutHandler>();
+
+		// Many responses received at once, and a line larger than the buffer
+		const vmime::string longText(10000, 'x');
+
+		for (int i = 0 ; i < 1000 ; ++i)
+			socket->localSend("250 2.1.5 Ok\r\n");
+
+		socket->localSend("250 " + longText + "\r\n");
+
+		vmime::net::smtp::SMTPResponse::state responseState;
+
+		for (int i = 0 ; i < 1000 ; ++i)
+		{
+			vmime::ref <vmime::net::smtp::SMTPResponse> resp =
+				vmime::net::smtp::SMTPResponse::readResponse(socket, toh, responseState);
+
+			VASSERT_EQ("Code", 250, resp->getCode());
+			VASSERT_EQ("Text", "2.1.5 Ok", resp->getText());
+			VASSERT_EQ("Enh.detail", 5, resp->getEnhancedCode().detail);
+
+			responseState = resp->getCurrentState();
+		}
+
+		vmime::ref <vmime::net::smtp::SMTPResponse> resp =
+			vmime::net::smtp::SMTPResponse::readResponse(socket, toh, responseState);
+
+		VASSERT_EQ("Code", 250, resp->getCode());
+		VASSERT_EQ("Text", longText, resp->getText());
+	}
+
 VMIME_TEST_SUITE_END
 
@@ -0,0 +1,241 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/smtp/SMTPSender.hpp"
+
+
+/** How the test server fails the second message
+  * sent on the first connection.
+  */
+enum
+{
+	SENDER_FAIL_NONE,        /**< do not fail */
+	SENDER_FAIL_BEFORE_END,  /**< close the connection on "MAIL" */
+	SENDER_FAIL_AFTER_END    /**< receive the message, then close the connection without replying */
+};
+
+
+/** SMTP test server which counts the connections and the messages
+  * received, and fails the second message sent on the first connection
+  * as specified by FAIL.
+  */
+template <int FAIL>
+class senderSMTPTestSocket : public lineBasedTestSocket
+{
+public:
+
+	static int connectionCount;
+	static int messageCount;
+
+	senderSMTPTestSocket()
+		: m_connection(0), m_messages(0), m_inData(false)
+	{
+	}
+
+	void onConnected()
+	{
+		m_connection = ++connectionCount;
+
+		localSend("220 test.vmime.org Service ready\r\n");
+		processCommand();
+	}
+
+	void processCommand()
+	{
+		if (!haveMoreLines())
+			return;
+
+		const vmime::string line = getNextLine();
+
+		// Commands sent after the server closed the connection are lost
+		if (!isConnected())
+			return;
+
+		const bool fail = (m_connection == 1 && m_messages == 1);
+
+		if (m_inData)
+		{
+			if (line == ".")
+			{
+				m_inData = false;
+
+				++m_messages;
+				++messageCount;
+
+				if (fail && FAIL == SENDER_FAIL_AFTER_END)
+				{
+					disconnect();
+					return;
+				}
+
+				localSend("250 Message accepted for delivery\r\n");
+			}
+		}
+		else
+		{
+			std::istringstream iss(line);
+
+			vmime::string cmd;
+			iss >> cmd;
+
+			if (cmd == "MAIL" && fail && FAIL == SENDER_FAIL_BEFORE_END)
+			{
+				disconnect();
+				return;
+			}
+
+			if (cmd == "DATA")
+			{
+				localSend("354 Ready to accept data; end with <CRLF>.<CRLF>\r\n");
+				m_inData = true;
+			}
+			else if (cmd == "QUIT")
+			{
+				localSend("221 test.vmime.org Service closing transmission channel\r\n");
+			}
+			else
+			{
+				localSend("250 OK\r\n");
+			}
+		}
+
+		processCommand();
+	}
+
+private:
+
+	int m_connection;  // number of this connection
+	int m_messages;    // messages received on this connection
+	bool m_inData;
+};
+
+template <int FAIL>
+int senderSMTPTestSocket <FAIL>::connectionCount = 0;
+
+template <int FAIL>
+int senderSMTPTestSocket <FAIL>::messageCount = 0;
+
+
+VMIME_TEST_SUITE_BEGIN(SMTPSenderTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testReuseConnection)
+		VMIME_TEST(testMaxMessagesPerConnection)
+		VMIME_TEST(testRetryBeforeEndOfData)
+		VMIME_TEST(testNoRetryAfterEndOfData)
+	VMIME_TEST_LIST_END
+
+
+	template <int FAIL>
+	static vmime::ref <vmime::net::smtp::SMTPSender> createSender()
+	{
+		senderSMTPTestSocket <FAIL>::connectionCount = 0;
+		senderSMTPTestSocket <FAIL>::messageCount = 0;
+
+		vmime::ref <vmime::net::smtp::SMTPSender> sender =
+			vmime::create <vmime::net::smtp::SMTPSender>
+				(vmime::create <vmime::net::session>(), vmime::utility::url("smtp://localhost"));
+
+		sender->setSocketFactory(vmime::create <testSocketFactory <senderSMTPTestSocket <FAIL> > >());
+		sender->setTimeoutHandlerFactory(vmime::create <testTimeoutHandlerFactory>());
+
+		return sender;
+	}
+
+	static void sendMessage(vmime::ref <vmime::net::smtp::SMTPSender> sender)
+	{
+		vmime::mailbox exp("expeditor@test.vmime.org");
+
+		vmime::mailboxList recips;
+		recips.appendMailbox(vmime::create <vmime::mailbox>("recipient@test.vmime.org"));
+
+		vmime::string data("Message data");
+		vmime::utility::inputStreamStringAdapter is(data);
+
+		sender->send(exp, recips, is, data.length());
+	}
+
+
+	void testReuseConnection()
+	{
+		typedef senderSMTPTestSocket <SENDER_FAIL_NONE> server;
+
+		vmime::ref <vmime::net::smtp::SMTPSender> sender = createSender <SENDER_FAIL_NONE>();
+
+		sendMessage(sender);
+		sendMessage(sender);
+
+		VASSERT_EQ("Connections", 1, server::connectionCount);
+		VASSERT_EQ("Messages", 2, server::messageCount);
+	}
+
+	void testMaxMessagesPerConnection()
+	{
+		typedef senderSMTPTestSocket <SENDER_FAIL_NONE> server;
+
+		vmime::ref <vmime::net::smtp::SMTPSender> sender = createSender <SENDER_FAIL_NONE>();
+		sender->setMaxMessagesPerConnection(1);
+
+		sendMessage(sender);
+		sendMessage(sender);
+
+		VASSERT_EQ("Connections", 2, server::connectionCount);
+		VASSERT_EQ("Messages", 2, server::messageCount);
+	}
+
+	void testRetryBeforeEndOfData()
+	{
+		typedef senderSMTPTestSocket <SENDER_FAIL_BEFORE_END> server;
+
+		vmime::ref <vmime::net::smtp::SMTPSender> sender = createSender <SENDER_FAIL_BEFORE_END>();
+
+		sendMessage(sender);
+
+		// The pooled connection is closed before the message is
+		// sent: the message is sent again on a new connection
+		sendMessage(sender);
+
+		VASSERT_EQ("Connections", 2, server::connectionCount);
+		VASSERT_EQ("Messages", 2, server::messageCount);
+	}
+
+	void testNoRetryAfterEndOfData()
+	{
+		typedef senderSMTPTestSocket <SENDER_FAIL_AFTER_END> server;
+
+		vmime::ref <vmime::net::smtp::SMTPSender> sender = createSender <SENDER_FAIL_AFTER_END>();
+
+		sendMessage(sender);
+
+		// The connection is closed after the message has been
+		// received: it must not be delivered twice
+		VASSERT_THROW("Send", sendMessage(sender), vmime::exceptions::socket_exception);
+
+		VASSERT_EQ("Connections", 1, server::connectionCount);
+		VASSERT_EQ("Messages", 2, server::messageCount);
+	}
+
+VMIME_TEST_SUITE_END
+
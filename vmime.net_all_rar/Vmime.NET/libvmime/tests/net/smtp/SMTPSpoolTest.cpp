@@ -0,0 +1,356 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/smtp/SMTPSpool.hpp"
+
+#include "vmime/utility/fileUtils.hpp"
+#include "vmime/utility/outputStreamStringAdapter.hpp"
+#include "vmime/utility/streamUtils.hpp"
+
+
+using namespace vmime::net::smtp;
+
+
+/** SMTP test server which rejects all the messages with a transient error.
+  */
+class deferringSMTPTestSocket : public lineBasedTestSocket
+{
+public:
+
+	void onConnected()
+	{
+		localSend("220 test.vmime.org Service ready\r\n");
+		processCommand();
+	}
+
+	void processCommand()
+	{
+		if (!haveMoreLines())
+			return;
+
+		const vmime::string line = getNextLine();
+
+		// Commands sent after the server closed the connection are lost
+		if (!isConnected())
+			return;
+
+		std::istringstream iss(line);
+
+		vmime::string cmd;
+		iss >> cmd;
+
+		if (cmd == "MAIL")
+			localSend("451 Requested action aborted: local error in processing\r\n");
+		else if (cmd == "QUIT")
+			localSend("221 test.vmime.org Service closing transmission channel\r\n");
+		else
+			localSend("250 OK\r\n");
+
+		processCommand();
+	}
+};
+
+
+class testSpoolListener : public SMTPSpool::listener
+{
+public:
+
+	testSpoolListener()
+		: sent(0), deferred(0), failed(0), nextAttempt(0)
+	{
+	}
+
+	void messageSent(const vmime::string& /* id */)
+	{
+		++sent;
+	}
+
+	void messageDeferred(const vmime::string& /* id */, const vmime::exception& /* e */, const unsigned long next)
+	{
+		++deferred;
+		nextAttempt = next;
+	}
+
+	void messageFailed(const vmime::string& /* id */, const vmime::exception& /* e */)
+	{
+		++failed;
+	}
+
+	int sent;
+	int deferred;
+	int failed;
+	unsigned long nextAttempt;
+};
+
+
+VMIME_TEST_SUITE_BEGIN(SMTPSpoolTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testRecoverTemporaryEnvelopes)
+		VMIME_TEST(testMalformedEnvelopes)
+		VMIME_TEST(testBackoff)
+		VMIME_TEST(testMaxAttempts)
+		VMIME_TEST(testEnqueue)
+		VMIME_TEST(testEnqueueLineBreak)
+	VMIME_TEST_LIST_END
+
+
+	// Contents of a valid envelope, for the default destination
+	static const vmime::string createEnvelope(const int attempts)
+	{
+		std::ostringstream oss;
+
+		oss << "1\n"
+		    << attempts << " 0\n"
+		    << "\n"
+		    << "expeditor@test.vmime.org\n"
+		    << "\n"
+		    << "1\n"
+		    << "recipient@test.vmime.org\n"
+		    << ".\n";
+
+		return oss.str();
+	}
+
+	static const vmime::utility::file::path getPath(const testTempDirectory& dir, const vmime::string& name)
+	{
+		return dir.getPath() / vmime::utility::file::path::component(name);
+	}
+
+	static void writeFile(const testTempDirectory& dir, const vmime::string& name, const vmime::string& data)
+	{
+		vmime::utility::fileUtils::writeFileAtomically(getPath(dir, name), data);
+	}
+
+	static const vmime::string readFile(const testTempDirectory& dir, const vmime::string& name)
+	{
+		vmime::ref <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
+		vmime::ref <vmime::utility::fileReader> reader = fsf->create(getPath(dir, name))->getFileReader();
+		vmime::ref <vmime::utility::inputStream> is = reader->getInputStream();
+
+		vmime::string data;
+		vmime::utility::outputStreamStringAdapter os(data);
+
+		vmime::utility::bufferedStreamCopy(*is, os);
+
+		return data;
+	}
+
+	static bool fileExists(const testTempDirectory& dir, const vmime::string& name)
+	{
+		vmime::ref <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
+		return fsf->create(getPath(dir, name))->exists();
+	}
+
+	// Run a message which has already failed the specified number of
+	// times, and return the delay before the next attempt (or zero if
+	// the message is not deferred)
+	static unsigned long runDeferred(const int attempts, testSpoolListener& listener)
+	{
+		testTempDirectory dir;
+
+		writeFile(dir, "msg.eml", "Subject: Test\r\n\r\nBody\r\n");
+		writeFile(dir, "msg.env", createEnvelope(attempts));
+
+		vmime::ref <SMTPSender> sender = vmime::create <SMTPSender>
+			(vmime::create <vmime::net::session>(), vmime::utility::url("smtp://localhost"));
+
+		sender->setSocketFactory(vmime::create <testSocketFactory <deferringSMTPTestSocket> >());
+		sender->setTimeoutHandlerFactory(vmime::create <testTimeoutHandlerFactory>());
+
+		SMTPSpool spool(dir.getPath());
+
+		spool.setDestination("", sender);
+		spool.setRetryDelays(60, 200);
+		spool.setListener(&listener);
+
+		const unsigned long now = vmime::platform::getHandler()->getUnixTime();
+
+		VASSERT_EQ("Attempts", 1, spool.run());
+
+		if (listener.deferred == 0)
+			return 0;
+
+		// The message is not due yet
+		VASSERT_EQ("Not due", 0, spool.run());
+		VASSERT_EQ("Next attempt", listener.nextAttempt, spool.getNextAttemptTime());
+
+		return listener.nextAttempt - now;
+	}
+
+
+	void testRecoverTemporaryEnvelopes()
+	{
+		testTempDirectory dir;
+
+		// The envelope was being replaced: only the temporary file remains
+		writeFile(dir, "a.eml", "Subject: A\r\n\r\nA\r\n");
+		writeFile(dir, "a.env.tmp", createEnvelope(2));
+
+		// The envelope has not been replaced yet
+		writeFile(dir, "b.eml", "Subject: B\r\n\r\nB\r\n");
+		writeFile(dir, "b.env", createEnvelope(0));
+		writeFile(dir, "b.env.tmp", createEnvelope(3));
+
+		// The temporary file was being written when the spool
+		// was interrupted, while the message was being added
+		writeFile(dir, "c.eml", "Subject: C\r\n\r\nC\r\n");
+		writeFile(dir, "c.env.tmp", "1\n0 0\n\nexpeditor@test.vmime.org\n");
+
+		SMTPSpool spool(dir.getPath());
+
+		VASSERT_EQ("Count", 2, spool.getMessageCount());
+
+		VASSERT_TRUE("a.env", fileExists(dir, "a.env"));
+		VASSERT_FALSE("a.env.tmp", fileExists(dir, "a.env.tmp"));
+
+		VASSERT_TRUE("b.env", fileExists(dir, "b.env"));
+		VASSERT_FALSE("b.env.tmp", fileExists(dir, "b.env.tmp"));
+
+		VASSERT_FALSE("c.eml", fileExists(dir, "c.eml"));
+		VASSERT_FALSE("c.env.tmp", fileExists(dir, "c.env.tmp"));
+	}
+
+	void testMalformedEnvelopes()
+	{
+		testTempDirectory dir;
+
+		// Unknown version
+		writeFile(dir, "a.eml", "Subject: A\r\n\r\nA\r\n");
+		writeFile(dir, "a.env", "2\n0 0\n\nexpeditor@test.vmime.org\n\n1\nrecipient@test.vmime.org\n.\n");
+
+		// Truncated
+		writeFile(dir, "b.eml", "Subject: B\r\n\r\nB\r\n");
+		writeFile(dir, "b.env", "1\n0 0\n\nexpeditor@test.vmime.org\n\n1\n");
+
+		// No recipient
+		writeFile(dir, "c.eml", "Subject: C\r\n\r\nC\r\n");
+		writeFile(dir, "c.env", "1\n0 0\n\nexpeditor@test.vmime.org\n\n0\n.\n");
+
+		// Not a number
+		writeFile(dir, "d.eml", "Subject: D\r\n\r\nD\r\n");
+		writeFile(dir, "d.env", "1\nx y\n");
+
+		// Valid envelope, without data
+		writeFile(dir, "e.env", createEnvelope(0));
+
+		SMTPSpool spool(dir.getPath());
+
+		VASSERT_EQ("Count", 0, spool.getMessageCount());
+
+		const char* const names[] = { "a", "b", "c", "d", "e" };
+
+		for (size_t i = 0 ; i < sizeof(names) / sizeof(names[0]) ; ++i)
+		{
+			VASSERT_FALSE(vmime::string(names[i]) + ".eml", fileExists(dir, vmime::string(names[i]) + ".eml"));
+			VASSERT_FALSE(vmime::string(names[i]) + ".env", fileExists(dir, vmime::string(names[i]) + ".env"));
+		}
+	}
+
+	void testBackoff()
+	{
+		// The delay is doubled after each attempt, up to the maximum
+		const int attempts[] = { 0, 1, 2 };
+		const unsigned long delays[] = { 60, 120, 200 };
+
+		for (size_t i = 0 ; i < sizeof(attempts) / sizeof(attempts[0]) ; ++i)
+		{
+			testSpoolListener listener;
+			const unsigned long delay = runDeferred(attempts[i], listener);
+
+			VASSERT_EQ("Deferred", 1, listener.deferred);
+			VASSERT_TRUE("Min delay", delay >= delays[i]);
+			VASSERT_TRUE("Max delay", delay <= delays[i] + 5);
+		}
+	}
+
+	void testMaxAttempts()
+	{
+		// The default maximum is 10 attempts
+		testSpoolListener listener;
+
+		VASSERT_EQ("Delay", 0, runDeferred(9, listener));
+		VASSERT_EQ("Deferred", 0, listener.deferred);
+		VASSERT_EQ("Failed", 1, listener.failed);
+	}
+
+	void testEnqueue()
+	{
+		testTempDirectory dir;
+
+		vmime::ref <vmime::message> msg = vmime::create <vmime::message>();
+		msg->parse("Subject: Test\r\n\r\nBody\r\n");
+
+		vmime::mailboxList recipients;
+		recipients.appendMailbox(vmime::create <vmime::mailbox>("recipient@test.vmime.org"));
+
+		{
+			SMTPSpool spool(dir.getPath());
+
+			const vmime::string id = spool.enqueue
+				(msg, vmime::mailbox("expeditor@test.vmime.org"), recipients);
+
+			VASSERT_EQ("Count", 1, spool.getMessageCount());
+			VASSERT_EQ("Data", msg->generate(), readFile(dir, id + ".eml"));
+			VASSERT_TRUE("Envelope", fileExists(dir, id + ".env"));
+			VASSERT_FALSE("Temporary envelope", fileExists(dir, id + ".env.tmp"));
+		}
+
+		// The message is found again when the spool is reloaded
+		SMTPSpool spool(dir.getPath());
+
+		VASSERT_EQ("Reloaded", 1, spool.getMessageCount());
+	}
+
+	void testEnqueueLineBreak()
+	{
+		testTempDirectory dir;
+
+		vmime::ref <vmime::message> msg = vmime::create <vmime::message>();
+		msg->parse("Subject: Test\r\n\r\nBody\r\n");
+
+		vmime::mailboxList recipients;
+		recipients.appendMailbox(vmime::create <vmime::mailbox>("recipient@test.vmime.org"));
+
+		SMTPSpool spool(dir.getPath());
+
+		// The envelope would not be read back correctly
+		VASSERT_THROW("Destination", spool.enqueue(msg, vmime::mailbox("expeditor@test.vmime.org"),
+			recipients, vmime::mailbox(), "dest\r\n1"), vmime::exceptions::invalid_argument);
+
+		VASSERT_EQ("Count", 0, spool.getMessageCount());
+
+		vmime::ref <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
+		VASSERT_FALSE("Files", fsf->create(dir.getPath())->getFiles()->hasMoreElements());
+	}
+
+VMIME_TEST_SUITE_END
+
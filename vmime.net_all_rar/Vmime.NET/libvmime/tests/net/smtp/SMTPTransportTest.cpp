@@ -39,6 +39,8 @@ VMIME_TEST_SUITE_BEGIN(SMTPTransportTest)
 		VMIME_TEST(testChunking)
 		VMIME_TEST(testSize_Chunking)
 		VMIME_TEST(testSize_NoChunking)
+		VMIME_TEST(testSendMessages_Pipelining)
+		VMIME_TEST(testSendMessages_DataAfterReject)
 	VMIME_TEST_LIST_END
 
 
@@ -174,5 +176,88 @@ VMIME_TEST_SUITE_BEGIN(SMTPTransportTest)
 			vmime::net::smtp::SMTPMessageSizeExceedsMaxLimitsException);
 	}
 
+	void testSendMessages_Pipelining()
+	{
+		vmime::ref <vmime::net::session> session =
+			vmime::create <vmime::net::session>();
+
+		vmime::ref <vmime::net::smtp::SMTPTransport> tr = session->getTransport
+			(vmime::utility::url("smtp://localhost")).dynamicCast <vmime::net::smtp::SMTPTransport>();
+
+		tr->setSocketFactory(vmime::create <testSocketFactory <pipeliningSMTPTestSocket> >());
+		tr->setTimeoutHandlerFactory(vmime::create <testTimeoutHandlerFactory>());
+
+		tr->connect();
+
+		std::vector <vmime::net::smtp::SMTPTransport::messageJob> jobs(2);
+
+		jobs[0].msg = vmime::create <SMTPSmallTestMessage>();
+		jobs[0].expeditor = vmime::mailbox("expeditor@test.vmime.org");
+		jobs[0].recipients.appendMailbox(vmime::create <vmime::mailbox>("recipient1@test.vmime.org"));
+		jobs[0].recipients.appendMailbox(vmime::create <vmime::mailbox>("invalid@test.vmime.org"));
+		jobs[0].recipients.appendMailbox(vmime::create <vmime::mailbox>("recipient2@test.vmime.org"));
+
+		jobs[1].msg = vmime::create <SMTPSmallTestMessage>();
+		jobs[1].expeditor = vmime::mailbox("expeditor@test.vmime.org");
+		jobs[1].recipients.appendMailbox(vmime::create <vmime::mailbox>("invalid@test.vmime.org"));
+
+		const std::vector <vmime::net::smtp::SMTPTransport::messageResult> results =
+			tr->sendMessages(jobs);
+
+		VASSERT_EQ("Count", 2, results.size());
+
+		VASSERT_TRUE("1 sent", results[0].sent);
+		VASSERT_EQ("1 status", 250, results[0].status.code);
+		VASSERT_EQ("1 recipient count", 3, results[0].recipients.size());
+		VASSERT_EQ("1 recipient 1", 250, results[0].recipients[0].code);
+		VASSERT_EQ("1 recipient 2", 550, results[0].recipients[1].code);
+		VASSERT_EQ("1 recipient 2 enhanced code", 1, results[0].recipients[1].enhancedCode.detail);
+		VASSERT_EQ("1 recipient 3", 250, results[0].recipients[2].code);
+
+		VASSERT_FALSE("2 sent", results[1].sent);
+		VASSERT_EQ("2 status", 550, results[1].status.code);
+
+		VASSERT_TRUE("Connected", tr->isConnected());
+
+		tr->disconnect();
+	}
+
+	void testSendMessages_DataAfterReject()
+	{
+		vmime::ref <vmime::net::session> session =
+			vmime::create <vmime::net::session>();
+
+		vmime::ref <vmime::net::smtp::SMTPTransport> tr = session->getTransport
+			(vmime::utility::url("smtp://localhost")).dynamicCast <vmime::net::smtp::SMTPTransport>();
+
+		tr->setSocketFactory(vmime::create <testSocketFactory <dataAfterRejectSMTPTestSocket> >());
+		tr->setTimeoutHandlerFactory(vmime::create <testTimeoutHandlerFactory>());
+
+		tr->connect();
+
+		std::vector <vmime::net::smtp::SMTPTransport::messageJob> jobs(2);
+
+		for (int i = 0 ; i < 2 ; ++i)
+		{
+			jobs[i].msg = vmime::create <SMTPSmallTestMessage>();
+			jobs[i].expeditor = vmime::mailbox("expeditor@test.vmime.org");
+			jobs[i].recipients.appendMailbox(vmime::create <vmime::mailbox>("invalid@test.vmime.org"));
+		}
+
+		const std::vector <vmime::net::smtp::SMTPTransport::messageResult> results =
+			tr->sendMessages(jobs);
+
+		VASSERT_EQ("Count", 2, results.size());
+
+		// The 421 reply to the empty message closes the connection
+		VASSERT_FALSE("1 sent", results[0].sent);
+		VASSERT_EQ("1 status", 421, results[0].status.code);
+
+		VASSERT_FALSE("2 sent", results[1].sent);
+		VASSERT_EQ("2 status", 0, results[1].status.code);
+
+		VASSERT_FALSE("Connected", tr->isConnected());
+	}
+
 VMIME_TEST_SUITE_END
 
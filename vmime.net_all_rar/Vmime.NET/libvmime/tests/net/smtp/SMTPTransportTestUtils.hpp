@@ -613,3 +613,254 @@ public:
 };
 
 typedef SMTPBigTestMessage <4194304> SMTPBigTestMessage4MB;
+
+
+
+/** SMTP test server 4.
+  *
+  * Test PIPELINING extension with several messages, and rejected recipients.
+  */
+class pipeliningSMTPTestSocket : public lineBasedTestSocket
+{
+public:
+
+	pipeliningSMTPTestSocket()
+	{
+		m_state = STATE_NOT_CONNECTED;
+		m_mailCount = m_messageCount = m_recipientCount = 0;
+		m_quitSent = false;
+	}
+
+	~pipeliningSMTPTestSocket()
+	{
+		VASSERT_EQ("Two MAIL commands", 2, m_mailCount);
+		VASSERT_EQ("One message", 1, m_messageCount);
+		VASSERT("Client must send the QUIT command", m_quitSent);
+	}
+
+	void onConnected()
+	{
+		localSend("220 test.vmime.org Service ready\r\n");
+		processCommand();
+
+		m_state = STATE_COMMAND;
+	}
+
+	void processCommand()
+	{
+		if (!haveMoreLines())
+			return;
+
+		vmime::string line = getNextLine();
+		std::istringstream iss(line);
+
+		switch (m_state)
+		{
+		case STATE_NOT_CONNECTED:
+
+			localSend("451 Requested action aborted: invalid state\r\n");
+			break;
+
+		case STATE_COMMAND:
+		{
+			std::string cmd;
+			iss >> cmd;
+
+			if (cmd == "EHLO")
+			{
+				localSend("250-test.vmime.org\r\n");
+				localSend("250 PIPELINING\r\n");
+			}
+			else if (cmd == "MAIL")
+			{
+				++m_mailCount;
+				m_recipientCount = 0;
+
+				localSend("250 OK\r\n");
+			}
+			else if (cmd == "RCPT")
+			{
+				if (line.find("invalid") != vmime::string::npos)
+				{
+					localSend("550 5.1.1 Unknown user\r\n");
+				}
+				else
+				{
+					++m_recipientCount;
+					localSend("250 OK, recipient accepted\r\n");
+				}
+			}
+			else if (cmd == "DATA")
+			{
+				if (m_recipientCount == 0)
+				{
+					localSend("554 No valid recipients\r\n");
+				}
+				else
+				{
+					localSend("354 Ready to accept data; end with <CRLF>.<CRLF>\r\n");
+
+					m_state = STATE_DATA;
+					m_msgData.clear();
+				}
+			}
+			else if (cmd == "RSET")
+			{
+				localSend("250 OK\r\n");
+			}
+			else if (cmd == "QUIT")
+			{
+				m_quitSent = true;
+
+				localSend("221 test.vmime.org Service closing transmission channel\r\n");
+			}
+			else
+			{
+				localSend("502 Command not implemented\r\n");
+			}
+
+			break;
+		}
+		case STATE_DATA:
+		{
+			if (line == ".")
+			{
+				VASSERT_EQ("Data", "Message data\r\n", m_msgData);
+
+				++m_messageCount;
+
+				localSend("250 Message accepted for delivery\r\n");
+				m_state = STATE_COMMAND;
+			}
+			else
+			{
+				m_msgData += line + "\r\n";
+			}
+
+			break;
+		}
+
+		}
+
+		processCommand();
+	}
+
+private:
+
+	enum State
+	{
+		STATE_NOT_CONNECTED,
+		STATE_COMMAND,
+		STATE_DATA
+	};
+
+	int m_state;
+	int m_mailCount, m_messageCount, m_recipientCount;
+
+	std::string m_msgData;
+
+	bool m_quitSent;
+};
+
+
+/** SMTP test server 5.
+  *
+  * Test PIPELINING extension with a server which accepts DATA although
+  * no recipient was accepted, then closes the connection with a 421
+  * reply when it receives the (empty) message.
+  */
+class dataAfterRejectSMTPTestSocket : public lineBasedTestSocket
+{
+public:
+
+	dataAfterRejectSMTPTestSocket()
+	{
+		m_inData = false;
+		m_mailCount = 0;
+	}
+
+	~dataAfterRejectSMTPTestSocket()
+	{
+		VASSERT_EQ("One MAIL command", 1, m_mailCount);
+	}
+
+	void onConnected()
+	{
+		localSend("220 test.vmime.org Service ready\r\n");
+		processCommand();
+	}
+
+	void processCommand()
+	{
+		if (!haveMoreLines())
+			return;
+
+		vmime::string line = getNextLine();
+
+		if (m_inData)
+		{
+			if (line == ".")
+			{
+				m_inData = false;
+				localSend("421 4.3.0 Service shutting down\r\n");
+			}
+		}
+		else
+		{
+			std::istringstream iss(line);
+
+			std::string cmd;
+			iss >> cmd;
+
+			// Without PIPELINING, DATA is not sent if no recipient was accepted
+			if (cmd == "EHLO")
+			{
+				localSend("250-test.vmime.org\r\n");
+				localSend("250 PIPELINING\r\n");
+			}
+			else if (cmd == "MAIL")
+			{
+				++m_mailCount;
+				localSend("250 OK\r\n");
+			}
+			else if (cmd == "RCPT")
+			{
+				localSend("550 5.1.1 Unknown user\r\n");
+			}
+			else if (cmd == "DATA")
+			{
+				m_inData = true;
+				localSend("354 Ready to accept data; end with <CRLF>.<CRLF>\r\n");
+			}
+			else if (cmd == "QUIT")
+			{
+				localSend("221 test.vmime.org Service closing transmission channel\r\n");
+			}
+			else
+			{
+				localSend("502 Command not implemented\r\n");
+			}
+		}
+
+		processCommand();
+	}
+
+private:
+
+	bool m_inData;
+	int m_mailCount;
+};
+
+
+class SMTPSmallTestMessage : public vmime::message
+{
+public:
+
+	void generateImpl(const vmime::generationContext& /* ctx */,
+		 vmime::utility::outputStream& outputStream,
+		 const vmime::string::size_type /* curLinePos */ = 0,
+		 vmime::string::size_type* /* newLinePos */ = NULL) const
+	{
+		outputStream.write("Message data", 12);
+	}
+};
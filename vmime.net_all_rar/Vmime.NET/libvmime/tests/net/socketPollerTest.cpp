@@ -0,0 +1,267 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/socketPoller.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(socketPollerTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testAddRemove)
+		VMIME_TEST(testNoData)
+		VMIME_TEST(testBufferedData)
+		VMIME_TEST(testLayeredBufferedData)
+		VMIME_TEST(testCancelledBeforeWait)
+		VMIME_TEST(testCancelWhileWaiting)
+		VMIME_TEST(testResetAfterCancel)
+	VMIME_TEST_LIST_END
+
+
+	// Socket layered on another one, which holds data that the lower
+	// socket does not see (like decrypted TLS records)
+	class layeredTestSocket : public testSocket
+	{
+	public:
+
+		layeredTestSocket(vmime::ref <vmime::net::socket> sok)
+			: m_wrapped(sok), m_buffered(false)
+		{
+		}
+
+		void setBuffered(const bool buffered)
+		{
+			m_buffered = buffered;
+		}
+
+		bool hasBufferedData() const
+		{
+			return m_buffered;
+		}
+
+		vmime::ref <vmime::net::socket> getUnderlyingSocket() const
+		{
+			return m_wrapped;
+		}
+
+	private:
+
+		vmime::ref <vmime::net::socket> m_wrapped;
+		bool m_buffered;
+	};
+
+
+	// Socket which cancels a token when the poller looks at it, that is
+	// after the poller has checked the token and before it waits
+	class cancellingTestSocket : public testSocket
+	{
+	public:
+
+		cancellingTestSocket(vmime::ref <vmime::utility::cancellationToken> token)
+			: m_token(token)
+		{
+		}
+
+		bool hasBufferedData() const
+		{
+			m_token->cancel();
+			return false;
+		}
+
+	private:
+
+		mutable vmime::ref <vmime::utility::cancellationToken> m_token;
+	};
+
+
+	void testAddRemove()
+	{
+		vmime::ref <vmime::net::socketPoller> poller =
+			vmime::platform::getHandler()->createSocketPoller();
+
+		vmime::ref <testSocket> sok1 = vmime::create <testSocket>();
+		vmime::ref <testSocket> sok2 = vmime::create <testSocket>();
+
+		VASSERT_EQ("1", 0, poller->getSocketCount());
+
+		poller->addSocket(sok1);
+		poller->addSocket(sok2);
+
+		VASSERT_EQ("2", 2, poller->getSocketCount());
+
+		poller->removeSocket(sok1);
+
+		VASSERT_EQ("3", 1, poller->getSocketCount());
+
+		// Data on a removed socket is not reported
+		sok1->localSend("data");
+
+		std::vector <vmime::ref <vmime::net::socket> > ready;
+
+		VASSERT_EQ("4", 0, poller->waitForReadable(10, ready));
+	}
+
+	void testNoData()
+	{
+		vmime::ref <vmime::net::socketPoller> poller =
+			vmime::platform::getHandler()->createSocketPoller();
+
+		poller->addSocket(vmime::create <testSocket>());
+		poller->addSocket(vmime::create <testSocket>());
+
+		std::vector <vmime::ref <vmime::net::socket> > ready;
+		ready.push_back(vmime::create <testSocket>());
+
+		VASSERT_EQ("Count", 0, poller->waitForReadable(10, ready));
+		VASSERT_EQ("Ready", 0, ready.size());
+	}
+
+	void testBufferedData()
+	{
+		vmime::ref <vmime::net::socketPoller> poller =
+			vmime::platform::getHandler()->createSocketPoller();
+
+		vmime::ref <testSocket> sok1 = vmime::create <testSocket>();
+		vmime::ref <testSocket> sok2 = vmime::create <testSocket>();
+		vmime::ref <testSocket> sok3 = vmime::create <testSocket>();
+
+		poller->addSocket(sok1);
+		poller->addSocket(sok2);
+		poller->addSocket(sok3);
+
+		sok2->localSend("data");
+
+		std::vector <vmime::ref <vmime::net::socket> > ready;
+
+		// Would time out after one minute if buffered data was ignored
+		VASSERT_EQ("Count", 1, poller->waitForReadable(60000, ready));
+		VASSERT_EQ("Ready", 1, ready.size());
+		VASSERT("Socket", ready[0] == sok2);
+
+		// Data is reported until it is read
+		sok3->localSend("data");
+
+		VASSERT_EQ("Count 2", 2, poller->waitForReadable(60000, ready));
+		VASSERT("Socket 2", ready[0] == sok2);
+		VASSERT("Socket 3", ready[1] == sok3);
+
+		vmime::string buffer;
+		sok2->receive(buffer);
+
+		VASSERT_EQ("Count 3", 1, poller->waitForReadable(60000, ready));
+		VASSERT("Socket 3 only", ready[0] == sok3);
+	}
+
+	void testLayeredBufferedData()
+	{
+		vmime::ref <vmime::net::socketPoller> poller =
+			vmime::platform::getHandler()->createSocketPoller();
+
+		vmime::ref <vmime::net::socket> lower = vmime::create <testSocket>();
+		vmime::ref <layeredTestSocket> upper = vmime::create <layeredTestSocket>(lower);
+
+		poller->addSocket(upper);
+
+		std::vector <vmime::ref <vmime::net::socket> > ready;
+
+		VASSERT_EQ("1", 0, poller->waitForReadable(10, ready));
+
+		// The layered socket is reported, not the socket under it
+		upper->setBuffered(true);
+
+		VASSERT_EQ("2", 1, poller->waitForReadable(60000, ready));
+		VASSERT("3", ready[0] == upper);
+	}
+
+	void testCancelledBeforeWait()
+	{
+		vmime::ref <vmime::net::socketPoller> poller =
+			vmime::platform::getHandler()->createSocketPoller();
+
+		vmime::ref <vmime::utility::cancellationToken> token =
+			vmime::platform::getHandler()->createCancellationToken();
+
+		poller->setCancellationToken(token);
+		poller->addSocket(vmime::create <testSocket>());
+
+		VASSERT("Token", poller->getCancellationToken() == token);
+
+		token->cancel();
+
+		std::vector <vmime::ref <vmime::net::socket> > ready;
+
+		VASSERT_THROW("Cancelled", poller->waitForReadable(60000, ready),
+			vmime::exceptions::operation_cancelled);
+	}
+
+	void testCancelWhileWaiting()
+	{
+		vmime::ref <vmime::net::socketPoller> poller =
+			vmime::platform::getHandler()->createSocketPoller();
+
+		vmime::ref <vmime::utility::cancellationToken> token =
+			vmime::platform::getHandler()->createCancellationToken();
+
+		poller->setCancellationToken(token);
+		poller->addSocket(vmime::create <cancellingTestSocket>(token));
+
+		std::vector <vmime::ref <vmime::net::socket> > ready;
+
+		// The wait is woken up by the token: without it, this would
+		// return 0 after one minute
+		VASSERT_THROW("Cancelled", poller->waitForReadable(60000, ready),
+			vmime::exceptions::operation_cancelled);
+	}
+
+	void testResetAfterCancel()
+	{
+		vmime::ref <vmime::net::socketPoller> poller =
+			vmime::platform::getHandler()->createSocketPoller();
+
+		vmime::ref <vmime::utility::cancellationToken> token =
+			vmime::platform::getHandler()->createCancellationToken();
+
+		poller->setCancellationToken(token);
+
+		vmime::ref <testSocket> sok = vmime::create <testSocket>();
+		poller->addSocket(sok);
+
+		std::vector <vmime::ref <vmime::net::socket> > ready;
+
+		token->cancel();
+
+		VASSERT_THROW("Cancelled", poller->waitForReadable(10, ready),
+			vmime::exceptions::operation_cancelled);
+
+		token->reset();
+
+		VASSERT_EQ("No data", 0, poller->waitForReadable(10, ready));
+
+		sok->localSend("data");
+
+		VASSERT_EQ("Data", 1, poller->waitForReadable(60000, ready));
+	}
+
+VMIME_TEST_SUITE_END
+
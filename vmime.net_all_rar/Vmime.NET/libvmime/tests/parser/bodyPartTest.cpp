@@ -38,6 +38,9 @@ VMIME_TEST_SUITE_BEGIN(bodyPartTest)
 		VMIME_TEST(testTransportPaddingInBoundary)
 		VMIME_TEST(testGenerate7bit)
 		VMIME_TEST(testTextUsageForQPEncoding)
+		VMIME_TEST(testGenerate8bitTransport)
+		VMIME_TEST(testGenerateBinaryMultipart)
+		VMIME_TEST(testGeneratedSizeRelabelledHeader)
 		VMIME_TEST(testParseVeryBigMessage)
 	VMIME_TEST_LIST_END
 
@@ -233,6 +236,85 @@ VMIME_TEST_SUITE_BEGIN(bodyPartTest)
 		VASSERT_EQ("1", "7bit", header1->ContentTransferEncoding()->getValue()->generate());
 	}
 
+	void testGenerate8bitTransport()
+	{
+		vmime::ref <vmime::plainTextPart> p1 = vmime::create <vmime::plainTextPart>();
+		p1->setText(vmime::create <vmime::stringContentHandler>("Line1\r\nLine2 \x89\r\n"));
+
+		vmime::ref <vmime::message> msg = vmime::create <vmime::message>();
+		p1->generateIn(msg, msg);
+
+		vmime::ref <vmime::bodyPart> part = msg->getBody()->getPartAt(0);
+
+		vmime::generationContext ctx(vmime::generationContext::getDefaultContext());
+		ctx.setTransferEncodingSupport(vmime::generationContext::TRANSFER_8BIT);
+
+		std::ostringstream oss;
+		vmime::utility::outputStreamAdapter os(oss);
+		part->generate(ctx, os);
+
+		const vmime::string out = oss.str();
+
+		VASSERT("1", out.find("Content-Transfer-Encoding: 8bit\r\n") != vmime::string::npos);
+		VASSERT("2", out.find("\r\n\r\nLine1\r\nLine2 \x89\r\n") != vmime::string::npos);
+
+		// The part itself is not modified
+		VASSERT_EQ("3", "quoted-printable", part->getHeader()->ContentTransferEncoding()->getValue()->generate());
+	}
+
+	void testGenerateBinaryMultipart()
+	{
+		vmime::ref <vmime::message> msg = vmime::create <vmime::message>();
+		msg->parse(
+			"Content-Type: multipart/mixed; boundary=\"xyz\"\r\n"
+			"Content-Transfer-Encoding: 8bit\r\n"
+			"\r\n"
+			"--xyz\r\n"
+			"Content-Type: application/octet-stream\r\n"
+			"Content-Transfer-Encoding: base64\r\n"
+			"\r\n"
+			"AAECAwQF\r\n"
+			"--xyz--\r\n");
+
+		vmime::generationContext ctx(vmime::generationContext::getDefaultContext());
+		ctx.setTransferEncodingSupport(vmime::generationContext::TRANSFER_BINARY);
+
+		std::ostringstream oss;
+		vmime::utility::outputStreamAdapter os(oss);
+		msg->generate(ctx, os);
+
+		const vmime::string out = oss.str();
+		const vmime::string::size_type partPos = out.find("--xyz");
+
+		// A multipart entity declared "8bit" which contains binary
+		// data must be declared "binary" (RFC-2045, 6.4)
+		VASSERT("1", out.find("Content-Transfer-Encoding: binary\r\n") < partPos);
+		VASSERT("2", out.find("Content-Transfer-Encoding: binary\r\n", partPos) != vmime::string::npos);
+		VASSERT_EQ("3", vmime::string::npos, out.find("8bit"));
+	}
+
+	void testGeneratedSizeRelabelledHeader()
+	{
+		vmime::ref <vmime::bodyPart> part = vmime::create <vmime::bodyPart>();
+		part->parse(
+			"Content-Type: text/plain\r\n"
+			"Content-Transfer-Encoding: quoted-printable\r\n"
+			"\r\n"
+			"Line =E9\r\n");
+
+		vmime::generationContext ctx(vmime::generationContext::getDefaultContext());
+		ctx.setTransferEncodingSupport(vmime::generationContext::TRANSFER_BINARY);
+
+		// The size is the one of the header which is actually written
+		vmime::ref <vmime::header> hdr = part->getHeader()->clone().dynamicCast <vmime::header>();
+		hdr->ContentTransferEncoding()->setValue(vmime::encoding(vmime::encodingTypes::BINARY));
+
+		const vmime::utility::stream::size_type bodySize = part->getBody()->getGeneratedSize(ctx);
+
+		VASSERT_EQ("1", hdr->getGeneratedSize(ctx) + 2 + bodySize, part->getGeneratedSize(ctx));
+		VASSERT("2", part->getGeneratedSize(ctx) < part->getHeader()->getGeneratedSize(ctx) + 2 + bodySize);
+	}
+
 	void testTextUsageForQPEncoding()
 	{
 		vmime::ref <vmime::plainTextPart> part = vmime::create <vmime::plainTextPart>();
@@ -23,15 +23,24 @@
 
 #include "testUtils.hpp"
 
+#include <ctime>
+
 
 
 // testSocket
 
+testSocket::testSocket()
+	: m_port(0), m_connected(false), m_closed(false)
+{
+}
+
+
 void testSocket::connect(const vmime::string& address, const vmime::port_t port)
 {
 	m_address = address;
 	m_port = port;
 	m_connected = true;
+	m_closed = false;
 
 	onConnected();
 }
@@ -42,6 +51,7 @@ void testSocket::disconnect()
 	m_address.clear();
 	m_port = 0;
 	m_connected = false;
+	m_closed = true;
 }
 
 
@@ -75,8 +85,42 @@ const vmime::string testSocket::getPeerAddress() const
 }
 
 
+vmime::port_t testSocket::getPeerPort() const
+{
+	return 0;
+}
+
+
+void testSocket::setCancellationToken(vmime::ref <vmime::utility::cancellationToken> token)
+{
+	m_cancelToken = token;
+}
+
+
+vmime::ref <vmime::utility::cancellationToken> testSocket::getCancellationToken() const
+{
+	return m_cancelToken;
+}
+
+
+bool testSocket::hasBufferedData() const
+{
+	return !m_inBuffer.empty();
+}
+
+
+vmime::ref <vmime::net::socket> testSocket::getUnderlyingSocket() const
+{
+	return NULL;
+}
+
+
 void testSocket::receive(vmime::string& buffer)
 {
+	// Data sent before the test server disconnected can still be read
+	if (m_inBuffer.empty() && m_closed)
+		throw vmime::exceptions::socket_exception("Connection closed by test server");
+
 	buffer = m_inBuffer;
 	m_inBuffer.clear();
 }
@@ -92,6 +136,9 @@ void testSocket::send(const vmime::string& buffer)
 
 testSocket::size_type testSocket::receiveRaw(char* buffer, const size_type count)
 {
+	if (m_inBuffer.empty() && m_closed)
+		throw vmime::exceptions::socket_exception("Connection closed by test server");
+
 	const size_type n = std::min(count, static_cast <size_type>(m_inBuffer.size()));
 
 	std::copy(m_inBuffer.begin(), m_inBuffer.begin() + n, buffer);
@@ -101,6 +148,13 @@ testSocket::size_type testSocket::receiveRaw(char* buffer, const size_type count
 }
 
 
+bool testSocket::waitForReadable(const unsigned int /* msecs */)
+{
+	// Data is sent synchronously by the test: do not wait
+	return !m_inBuffer.empty();
+}
+
+
 void testSocket::sendRaw(const char* buffer, const size_type count)
 {
 	send(vmime::string(buffer, count));
@@ -241,6 +295,12 @@ bool testTimeoutHandler::handleTimeOut()
 }
 
 
+void testTimeoutHandler::ModifyInterval(int s32_Timeout)
+{
+	m_delay = s32_Timeout;
+}
+
+
 // testTimeoutHandlerFactory : public vmime::net::timeoutHandlerFactory
 
 vmime::ref <vmime::net::timeoutHandler> testTimeoutHandlerFactory::create()
@@ -250,6 +310,75 @@ vmime::ref <vmime::net::timeoutHandler> testTimeoutHandlerFactory::create()
 
 
 
+// testTempDirectory
+
+testTempDirectory::testTempDirectory()
+{
+	m_path = vmime::utility::file::path() / vmime::utility::file::path::component("tmp")
+		/ vmime::utility::file::path::component("vmime"
+			+ vmime::utility::stringUtils::toString(std::time(NULL))
+			+ vmime::utility::stringUtils::toString(std::rand()));
+}
+
+
+testTempDirectory::~testTempDirectory()
+{
+	remove();
+}
+
+
+const vmime::utility::file::path& testTempDirectory::getPath() const
+{
+	return m_path;
+}
+
+
+void testTempDirectory::remove()
+{
+	vmime::ref <vmime::utility::fileSystemFactory> fsf =
+		vmime::platform::getHandler()->getFileSystemFactory();
+
+	recursiveDelete(fsf->create(m_path));
+}
+
+
+// static
+void testTempDirectory::recursiveDelete(vmime::ref <vmime::utility::file> dir)
+{
+	if (!dir->exists() || !dir->isDirectory())
+		return;
+
+	vmime::ref <vmime::utility::fileIterator> files = dir->getFiles();
+
+	while (files->hasMoreElements())
+	{
+		vmime::ref <vmime::utility::file> file = files->nextElement();
+
+		try
+		{
+			if (file->isDirectory())
+				recursiveDelete(file);
+			else
+				file->remove();
+		}
+		catch (vmime::exceptions::filesystem_exception&)
+		{
+			// Ignore
+		}
+	}
+
+	try
+	{
+		dir->remove();
+	}
+	catch (vmime::exceptions::filesystem_exception&)
+	{
+		// Ignore
+	}
+}
+
+
+
 // Exception helper
 std::ostream& operator<<(std::ostream& os, const vmime::exception& e)
 {
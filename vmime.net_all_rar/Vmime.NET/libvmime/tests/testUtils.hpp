@@ -243,6 +243,8 @@ class testSocket : public vmime::net::socket
 {
 public:
 
+	testSocket();
+
 	void connect(const vmime::string& address, const vmime::port_t port);
 	void disconnect();
 
@@ -252,6 +254,7 @@ public:
 	void send(const vmime::string& buffer);
 
 	size_type receiveRaw(char* buffer, const size_type count);
+	bool waitForReadable(const unsigned int msecs);
 	void sendRaw(const char* buffer, const size_type count);
 	size_type sendRawNonBlocking(const char* buffer, const size_type count);
 
@@ -261,6 +264,13 @@ public:
 
 	const vmime::string getPeerName() const;
 	const vmime::string getPeerAddress() const;
+	vmime::port_t getPeerPort() const;
+
+	void setCancellationToken(vmime::ref <vmime::utility::cancellationToken> token);
+	vmime::ref <vmime::utility::cancellationToken> getCancellationToken() const;
+
+	bool hasBufferedData() const;
+	vmime::ref <vmime::net::socket> getUnderlyingSocket() const;
 
 	/** Send data to client.
 	  *
@@ -304,9 +314,12 @@ private:
 	vmime::string m_address;
 	vmime::port_t m_port;
 	bool m_connected;
+	bool m_closed;  // disconnected after having been connected
 
 	vmime::string m_inBuffer;
 	vmime::string m_outBuffer;
+
+	vmime::ref <vmime::utility::cancellationToken> m_cancelToken;
 };
 
 
@@ -354,6 +367,7 @@ public:
 	bool isTimeOut();
 	void resetTimeOut();
 	bool handleTimeOut();
+	void ModifyInterval(int s32_Timeout);
 
 private:
 
@@ -370,6 +384,30 @@ public:
 };
 
 
+// Used to test file system features.
+//
+// A directory with a unique name in /tmp. It is not created by the
+// constructor, and it is deleted with all its contents on destruction.
+
+class testTempDirectory
+{
+public:
+
+	testTempDirectory();
+	~testTempDirectory();
+
+	const vmime::utility::file::path& getPath() const;
+
+	void remove();
+
+private:
+
+	static void recursiveDelete(vmime::ref <vmime::utility::file> dir);
+
+	vmime::utility::file::path m_path;
+};
+
+
 // Exception helper
 std::ostream& operator<<(std::ostream& os, const vmime::exception& e);
 
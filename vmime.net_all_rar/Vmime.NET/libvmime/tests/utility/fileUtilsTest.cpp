@@ -0,0 +1,109 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/utility/fileUtils.hpp"
+#include "vmime/utility/outputStreamAdapter.hpp"
+#include "vmime/utility/streamUtils.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(fileUtilsTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testEscapeName)
+		VMIME_TEST(testEscapeName_Dots)
+		VMIME_TEST(testEscapeName_Empty)
+		VMIME_TEST(testWriteFileAtomically)
+	VMIME_TEST_LIST_END
+
+
+	typedef vmime::utility::fileUtils fileUtils;
+
+
+	static const vmime::string readFile(const vmime::utility::file::path& path)
+	{
+		vmime::ref <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
+		vmime::ref <vmime::utility::file> file = fsf->create(path);
+		vmime::ref <vmime::utility::fileReader> reader = file->getFileReader();
+		vmime::ref <vmime::utility::inputStream> is = reader->getInputStream();
+
+		std::ostringstream oss;
+		vmime::utility::outputStreamAdapter os(oss);
+
+		vmime::utility::bufferedStreamCopy(*is, os);
+
+		return oss.str();
+	}
+
+
+	void testEscapeName()
+	{
+		VASSERT_EQ("1", "INBOX", fileUtils::escapeName("INBOX").getBuffer());
+		VASSERT_EQ("2", "a.b-c_d", fileUtils::escapeName("a.b-c_d").getBuffer());
+		VASSERT_EQ("3", "a%2Fb%5Cc", fileUtils::escapeName("a/b\\c").getBuffer());
+		VASSERT_EQ("4", "user%40host%3A993", fileUtils::escapeName("user@host:993").getBuffer());
+		VASSERT_EQ("5", "%C3%A9", fileUtils::escapeName("\xc3\xa9").getBuffer());
+	}
+
+	void testEscapeName_Dots()
+	{
+		// Must never designate the current or the parent directory
+		VASSERT_EQ("1", "%2E", fileUtils::escapeName(".").getBuffer());
+		VASSERT_EQ("2", "%2E.", fileUtils::escapeName("..").getBuffer());
+		VASSERT_EQ("3", "%2E..", fileUtils::escapeName("...").getBuffer());
+		VASSERT_EQ("4", "%2Ehidden", fileUtils::escapeName(".hidden").getBuffer());
+		VASSERT_EQ("5", "name.", fileUtils::escapeName("name.").getBuffer());
+	}
+
+	void testEscapeName_Empty()
+	{
+		VASSERT_THROW("empty", fileUtils::escapeName(""), vmime::exceptions::invalid_argument);
+	}
+
+	void testWriteFileAtomically()
+	{
+		testTempDirectory tempDir;
+
+		vmime::ref <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
+		// The parent directory is created
+		const vmime::utility::file::path path = tempDir.getPath()
+			/ vmime::utility::file::path::component("dir")
+			/ vmime::utility::file::path::component("file");
+
+		fileUtils::writeFileAtomically(path, "first contents");
+
+		VASSERT_EQ("write", "first contents", readFile(path));
+
+		// An existing file is replaced
+		fileUtils::writeFileAtomically(path, "second");
+
+		VASSERT_EQ("replace", "second", readFile(path));
+		VASSERT_FALSE("temporary file", fsf->create(fileUtils::getTemporaryPath(path))->exists());
+	}
+
+VMIME_TEST_SUITE_END
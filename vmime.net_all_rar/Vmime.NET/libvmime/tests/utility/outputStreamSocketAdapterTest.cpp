@@ -32,6 +32,8 @@ VMIME_TEST_SUITE_BEGIN(outputStreamSocketAdapterTest)
 		VMIME_TEST(testWrite)
 		VMIME_TEST(testWriteBinary)
 		VMIME_TEST(testWriteCRLF)
+		VMIME_TEST(testWriteBuffered)
+		VMIME_TEST(testDestroyWithoutFlush)
 	VMIME_TEST_LIST_END
 
 
@@ -84,5 +86,48 @@ VMIME_TEST_SUITE_BEGIN(outputStreamSocketAdapterTest)
 		VASSERT_EQ("Write", "some data\nmore\r\ndata\r", buffer);
 	}
 
+	void testWriteBuffered()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+
+		vmime::utility::outputStreamSocketAdapter stream(*socket);
+		stream << "some data";
+
+		vmime::string buffer;
+		socket->localReceive(buffer);
+
+		VASSERT_EQ("Buffered", "", buffer);
+
+		// Whole blocks are sent immediately, the rest on flush
+		const vmime::string block(socket->getBlockSize() + 10, 'x');
+		stream << block;
+
+		socket->localReceive(buffer);
+
+		VASSERT_EQ("Block size", socket->getBlockSize(), buffer.length());
+		VASSERT_EQ("Block", "some data", buffer.substr(0, 9));
+
+		stream.flush();
+		socket->localReceive(buffer);
+
+		VASSERT_EQ("Flush", block.length() + 9 - socket->getBlockSize(), buffer.length());
+	}
+
+	void testDestroyWithoutFlush()
+	{
+		vmime::ref <testSocket> socket = vmime::create <testSocket>();
+
+		{
+			vmime::utility::outputStreamSocketAdapter stream(*socket);
+			stream << "some data";
+		}
+
+		// Callers flush explicitly: nothing is sent from the destructor
+		vmime::string buffer;
+		socket->localReceive(buffer);
+
+		VASSERT_EQ("Destroy", "", buffer);
+	}
+
 VMIME_TEST_SUITE_END
 
@@ -32,7 +32,7 @@ void Common::SetTraceCallback(delTrace* f_Callback)
     #endif
 }
 
-// Abort any communication with the server -> throws exception
+// Abort the communication of all Imap, Pop3 and Smtp instances with the server -> throws exception
 // This function must be called from another thread!
 void Common::CancelOperation()
 {
@@ -160,6 +160,20 @@ void Imap::Close()
     }
 }
 
+// Abort the current communication of this instance with the server -> throws exception
+// This function must be called from another thread!
+void Imap::Cancel()
+{
+    try
+    {
+        if (mpi_Imap) mpi_Imap->Cancel();
+    }
+    catch (std::exception& Ex)
+    {
+        throw new Exception(UNI(Ex.what()).c_str());
+    }
+}
+
 } // namespace vmimeNET
 
 #endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
\ No newline at end of file
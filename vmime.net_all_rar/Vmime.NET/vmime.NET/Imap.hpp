@@ -38,6 +38,7 @@ namespace vmimeNET
         int          GetEmailCount();
         EmailParser* FetchEmailAt(int s32_Index);
         void         Close();
+        void         Cancel();
 
     private:
         cImap* mpi_Imap;
@@ -103,6 +103,20 @@ void Pop3::Close()
     }
 }
 
+// Abort the current communication of this instance with the server -> throws exception
+// This function must be called from another thread!
+void Pop3::Cancel()
+{
+    try
+    {
+        if (mpi_Pop3) mpi_Pop3->Cancel();
+    }
+    catch (std::exception& Ex)
+    {
+        throw new Exception(UNI(Ex.what()).c_str());
+    }
+}
+
 } // namespace vmimeNET
 
 #endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_POP3
\ No newline at end of file
@@ -34,6 +34,7 @@ namespace vmimeNET
         int          GetEmailCount();
         EmailParser* FetchEmailAt(int s32_Index);
         void         Close();
+        void         Cancel();
 
     private:
         cPop3* mpi_Pop3;
@@ -71,6 +71,20 @@ void Smtp::Send(EmailBuilder* i_Email)
     }
 }
 
+// Abort the current communication of this instance with the server -> throws exception
+// This function must be called from another thread!
+void Smtp::Cancel()
+{
+    try
+    {
+        if (mpi_Smtp) mpi_Smtp->Cancel();
+    }
+    catch (std::exception& Ex)
+    {
+        throw new Exception(UNI(Ex.what()).c_str());
+    }
+}
+
 } // namespace vmimeNET
 
 #endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_SMTP
\ No newline at end of file
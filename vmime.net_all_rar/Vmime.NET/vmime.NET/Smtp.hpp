@@ -31,6 +31,7 @@ namespace vmimeNET
 
         void SetAuthData(String* s_User, String* s_Password);
         void Send(EmailBuilder* i_Email);
+        void Cancel();
 
     private:
         cSmtp* mpi_Smtp;